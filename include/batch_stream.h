@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_BATCH_STREAM_H
+#define DISTRIBUTED_BATCH_STREAM_H
+
+#include "types.h"
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+#include <stdint.h>
+
+namespace distributed {
+
+/**
+ * @brief Destino de los bytes de un stream de lotes
+ */
+class IChunkWriter {
+public:
+    virtual ~IChunkWriter() {}
+
+    /**
+     * @brief Escribir un bloque completo
+     * @return false si el destino falló; el stream queda inutilizable
+     */
+    virtual bool write(const char* data, size_t size) = 0;
+};
+
+/**
+ * @brief Escritor sobre un socket conectado (reintenta envíos parciales)
+ */
+class SocketChunkWriter : public IChunkWriter {
+private:
+    int socket_fd;
+
+public:
+    explicit SocketChunkWriter(int fd) : socket_fd(fd) {}
+    virtual bool write(const char* data, size_t size);
+};
+
+/**
+ * @brief Escritor que acumula en memoria (tests y reenvíos)
+ */
+class BufferChunkWriter : public IChunkWriter {
+private:
+    std::vector<char>& buffer;
+
+public:
+    explicit BufferChunkWriter(std::vector<char>& out) : buffer(out) {}
+    virtual bool write(const char* data, size_t size);
+};
+
+/**
+ * @brief Escritor sobre un FILE* abierto para escritura
+ */
+class FileChunkWriter : public IChunkWriter {
+private:
+    FILE* file;
+
+public:
+    explicit FileChunkWriter(FILE* f) : file(f) {}
+    virtual bool write(const char* data, size_t size);
+};
+
+/**
+ * @brief Serializa un lote como un header de stream seguido de chunks
+ *
+ * Cada chunk es un lote compacto completo (con su CRC) de hasta
+ * chunk_rows registros, opcionalmente con columnas codificadas y
+ * comprimido. La memoria usada es la de un chunk, sin importar el tamaño
+ * del lote.
+ */
+class BatchStreamWriter {
+private:
+    IChunkWriter* sink;
+    size_t chunk_rows;
+    bool column_encoding;
+    bool compression;
+    uint64_t bytes_written;
+    std::vector<char> chunk;
+    std::vector<char> scratch;
+
+    bool write_chunk(const DatabaseRecord* records, size_t count, int batch_id);
+
+public:
+    static const size_t DEFAULT_CHUNK_ROWS = 4096;
+    /// Límite de filas por chunk: acota la memoria del parser
+    static const size_t MAX_CHUNK_ROWS = 65536;
+
+    BatchStreamWriter(IChunkWriter* writer, size_t rows_per_chunk = DEFAULT_CHUNK_ROWS);
+
+    void set_column_encoding(bool enabled) { column_encoding = enabled; }
+    void set_compression(bool enabled) { compression = enabled; }
+
+    /**
+     * @brief Escribir el lote completo
+     * @return false si el lote no es válido o el destino falla
+     */
+    bool write_batch(const RecordBatch* batch);
+
+    uint64_t get_bytes_written() const { return bytes_written; }
+};
+
+/**
+ * @brief Parser incremental de un stream de BatchStreamWriter
+ *
+ * Acepta los bytes en trozos de cualquier tamaño; solo retiene el chunk
+ * en curso, acotado por el chunk_rows del header. Los registros se
+ * descomprimen directamente en el lote destino.
+ */
+class BatchStreamParser {
+public:
+    enum Status {
+        NEED_MORE,      ///< Faltan bytes
+        HEADER_READY,   ///< Header leído y sin destino: llamar a set_target()
+        NEED_CAPACITY,  ///< Chunk recibido que no cabe en un destino ampliable
+        COMPLETE,       ///< Lote completo en el destino
+        FAILED          ///< Stream inválido o destino insuficiente
+    };
+
+    /// Registros máximos que se aceptan en un stream
+    static const uint64_t MAX_RECORDS = 1u << 24;
+
+private:
+    enum Phase { READ_HEADER, READ_CHUNK_HEADER, READ_CHUNK, DONE, BROKEN };
+
+    Phase phase;
+    std::vector<char> pending;
+    size_t pending_needed;
+    uint64_t total_count;
+    uint64_t received_count;
+    int batch_id;
+    size_t chunk_rows;
+    size_t next_chunk_rows;  ///< Registros que anuncia el chunk en curso
+    size_t max_chunk_bytes;
+    bool compressed_chunks;
+    bool encoded_chunks;
+    RecordBatch* target;
+    bool growable_target;
+
+    Status fail();
+    bool finish_header();
+    bool finish_chunk_header();
+    bool finish_chunk();
+
+public:
+    BatchStreamParser();
+
+    /**
+     * @brief Volver al estado inicial (sin destino)
+     */
+    void reset();
+
+    /**
+     * @brief Consumir bytes del stream
+     * @param consumed Bytes usados; tras HEADER_READY o COMPLETE pueden sobrar
+     */
+    Status feed(const char* data, size_t size, size_t& consumed);
+
+    /**
+     * @brief Fijar el lote destino (capacidad suficiente para get_total_count())
+     * @param growable Aceptar menos capacidad: cada chunk recibido que no
+     *        quepa devuelve NEED_CAPACITY para que el llamador amplíe el lote
+     *        (records y capacity, conservando count) antes de seguir. Así la
+     *        memoria crece con los datos recibidos y no con el total que
+     *        anuncia el emisor.
+     * @return false si la capacidad no alcanza
+     */
+    bool set_target(RecordBatch* batch, bool growable = false);
+
+    /**
+     * @brief Capacidad que necesita el destino tras NEED_CAPACITY
+     */
+    size_t get_required_capacity() const { return static_cast<size_t>(received_count) + next_chunk_rows; }
+
+    bool has_header() const { return phase != READ_HEADER && phase != BROKEN; }
+    uint64_t get_total_count() const { return total_count; }
+    uint64_t get_received_count() const { return received_count; }
+    int get_batch_id() const { return batch_id; }
+
+    /// Algún chunk recibido venía comprimido / con columnas codificadas
+    bool has_compressed_chunks() const { return compressed_chunks; }
+    bool has_encoded_chunks() const { return encoded_chunks; }
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_BATCH_STREAM_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_BLOCK_CODEC_H
+#define DISTRIBUTED_BLOCK_CODEC_H
+
+#include <cstddef>
+
+namespace distributed {
+
+/**
+ * @brief Compresor de bloques rápido (formato de bloque LZ4), sin dependencias
+ *
+ * Cada bloque se comprime de forma independiente: secuencias de literales
+ * más una coincidencia (desplazamiento de 16 bits, longitud mínima 4). El
+ * compresor usa una tabla hash de una sola entrada y avanza cada vez más
+ * rápido cuando no encuentra coincidencias, así que los datos
+ * incompresibles cuestan poco. El descompresor valida todos los límites y
+ * rechaza entradas corruptas sin leer ni escribir fuera de los buffers.
+ */
+class BlockCodec {
+public:
+    /// Tamaño máximo de entrada de un bloque
+    static const size_t MAX_INPUT_SIZE = 0x7E000000;
+
+    /**
+     * @brief Peor caso de salida para una entrada de input_size bytes
+     */
+    static size_t max_compressed_size(size_t input_size) {
+        return input_size + input_size / 255 + 16;
+    }
+
+    /**
+     * @brief Comprimir un bloque
+     * @param capacity Bytes disponibles en dst; con menos de
+     *        max_compressed_size() la compresión puede abortar
+     * @return Bytes escritos, 0 si la salida no cabe en capacity
+     */
+    static size_t compress(const char* src, size_t size, char* dst, size_t capacity);
+
+    /**
+     * @brief Descomprimir un bloque de tamaño original conocido
+     * @param size Bytes exactos que debe producir el bloque
+     * @return false si el bloque está corrupto o no produce size bytes
+     */
+    static bool decompress(const char* src, size_t compressed_size, char* dst, size_t size);
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_BLOCK_CODEC_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_COLUMN_CODEC_H
+#define DISTRIBUTED_COLUMN_CODEC_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace distributed {
+
+/**
+ * @brief Codificaciones ligeras para columnas numéricas del wire
+ *
+ * - Deltas: enteros casi secuenciales (ids) como diferencias zigzag en
+ *   varint; un id consecutivo ocupa un byte.
+ * - Bits: enteros de dominio pequeño (categorías) como desplazamiento
+ *   sobre el mínimo, empaquetados con el ancho justo.
+ * - XOR: doubles al estilo Gorilla; cada valor se guarda como XOR con el
+ *   anterior, sin los ceros iniciales y finales.
+ *
+ * Las columnas se leen y escriben con memcpy, así que no necesitan
+ * alineación. Los codificadores fallan si la salida no cabe en la
+ * capacidad dada; los decodificadores validan límites y exigen consumir
+ * exactamente la entrada.
+ */
+class ColumnCodec {
+public:
+    /**
+     * @brief Codificar una columna int32 como deltas zigzag varint
+     * @param written Bytes escritos en out
+     * @return false si no caben en capacity
+     */
+    static bool encode_deltas(const char* column, size_t count, unsigned char* out, size_t capacity,
+                              size_t& written);
+
+    /**
+     * @brief Decodificar deltas (SSE2 para tramos de deltas de un byte)
+     */
+    static bool decode_deltas(const unsigned char* in, size_t size, char* column, size_t count);
+
+    /**
+     * @brief Variante escalar de decode_deltas, siempre disponible
+     */
+    static bool decode_deltas_portable(const unsigned char* in, size_t size, char* column, size_t count);
+
+    /**
+     * @brief Bytes que ocupan count valores de bits bits empaquetados
+     */
+    static size_t packed_size(size_t count, uint32_t bits) {
+        return (count * bits + 7) / 8;
+    }
+
+    /**
+     * @brief Empaquetar una columna int32 con el ancho mínimo sobre su mínimo
+     * @param base Mínimo de la columna (salida)
+     * @param bits Bits por valor, 0 a 32 (salida)
+     * @param written Bytes escritos en out, packed_size(count, bits)
+     * @return false si no caben en capacity
+     */
+    static bool pack_bits(const char* column, size_t count, unsigned char* out, size_t capacity,
+                          int32_t& base, uint32_t& bits, size_t& written);
+
+    static bool unpack_bits(const unsigned char* in, size_t size, int32_t base, uint32_t bits,
+                            char* column, size_t count);
+
+    /**
+     * @brief Codificar una columna double con XOR respecto al valor anterior
+     * @param written Bytes escritos en out
+     * @return false si no caben en capacity
+     */
+    static bool encode_xor(const char* column, size_t count, unsigned char* out, size_t capacity,
+                           size_t& written);
+
+    static bool decode_xor(const unsigned char* in, size_t size, char* column, size_t count);
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_COLUMN_CODEC_H
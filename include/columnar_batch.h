@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISTRIBUTED_COLUMNAR_BATCH_H
+#define DISTRIBUTED_COLUMNAR_BATCH_H
+
+#include "interfaces.h"
+#include "types.h"
+#include "plugin_api.h"
+#include <stdint.h>
+#include <vector>
+
+namespace distributed {
+
+/**
+ * @brief Lote de registros en formato columnar (struct-of-arrays)
+ *
+ * Cada campo de DatabaseRecord vive en su propio arreglo contiguo, así que
+ * una etapa que solo lee value recorre 8 bytes por registro en lugar de
+ * los 120 del registro completo. Los nombres son de longitud variable: un
+ * arreglo de desplazamientos sobre un arena de bytes sin terminadores, el
+ * mismo formato que usa el serializador compacto.
+ *
+ * Opcionalmente los nombres se codifican con diccionario: cada fila guarda
+ * un código de 4 bytes y el arena contiene una sola copia de cada nombre
+ * distinto. Sin diccionario la entrada i es simplemente el nombre de la
+ * fila i.
+ */
+class ColumnarBatch {
+public:
+    /**
+     * @brief Longitud máxima de un nombre al convertir a DatabaseRecord
+     */
+    static const size_t MAX_NAME_LENGTH = sizeof(((DatabaseRecord*)0)->name) - 1;
+
+private:
+    char* buffer;
+    IMemoryPool* pool;      ///< Origen de la memoria (NULL = new[])
+    int* ids;
+    double* values;
+    int* categories;
+    uint32_t* name_codes;   ///< Código de diccionario por fila
+    uint32_t* name_offsets; ///< name_offsets[e]..name_offsets[e + 1] delimitan la entrada e
+    size_t offset_capacity;
+    char* name_data;
+    size_t name_bytes;
+    size_t name_capacity;
+    size_t name_entries;
+    bool dictionary_names;
+    std::vector<uint32_t> name_index;  ///< Hash abierto de entradas (código + 1, 0 = vacío)
+    size_t indexed_entries;
+    size_t count;
+    size_t capacity;
+    int batch_id;
+
+    // No copiable
+    ColumnarBatch(const ColumnarBatch&);
+    ColumnarBatch& operator=(const ColumnarBatch&);
+
+    char* allocate_bytes(size_t bytes);
+    void release_bytes(char* ptr);
+    bool reserve_entries(size_t entries);
+    bool append_entry(const char* name, size_t length, uint32_t& code);
+    bool intern_name(const char* name, size_t length, uint32_t& code);
+    void index_entry(uint32_t code);
+    void reset_names();
+
+    static int plugin_set_name(PluginColumnarBatch* view, size_t row, const char* name, size_t length);
+
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Número máximo de filas
+     * @param memory_pool Pool del que tomar la memoria (opcional)
+     * @param name_capacity Bytes iniciales del arena de nombres
+     */
+    explicit ColumnarBatch(size_t capacity, IMemoryPool* memory_pool = NULL, size_t name_capacity = 0);
+    ~ColumnarBatch();
+
+    /**
+     * @brief Verificar si el buffer de columnas se pudo asignar
+     */
+    bool is_valid() const { return buffer != NULL; }
+
+    // Acceso a columnas
+    int* id_column() { return ids; }
+    const int* id_column() const { return ids; }
+    double* value_column() { return values; }
+    const double* value_column() const { return values; }
+    int* category_column() { return categories; }
+    const int* category_column() const { return categories; }
+    const uint32_t* name_code_column() const { return dictionary_names ? name_codes : NULL; }
+    const uint32_t* name_offset_column() const { return name_offsets; }
+    const char* name_bytes_data() const { return name_data; }
+
+    /**
+     * @brief Entrada de nombres que usa una fila
+     */
+    size_t name_entry(size_t row) const { return dictionary_names ? name_codes[row] : row; }
+
+    /**
+     * @brief Nombre de una fila (no terminado en '\0')
+     */
+    const char* name_at(size_t row) const { return name_data + name_offsets[name_entry(row)]; }
+    size_t name_length(size_t row) const {
+        size_t entry = name_entry(row);
+        return name_offsets[entry + 1] - name_offsets[entry];
+    }
+
+    /**
+     * @brief Copiar el nombre de una fila terminado en '\0' (truncado a size - 1)
+     */
+    void copy_name(size_t row, char* out, size_t size) const;
+
+    size_t get_count() const { return count; }
+    size_t get_capacity() const { return capacity; }
+    size_t get_name_bytes() const { return name_bytes; }
+    size_t get_name_entries() const { return name_entries; }
+    bool has_name_dictionary() const { return dictionary_names; }
+    int get_batch_id() const { return batch_id; }
+    void set_batch_id(int id) { batch_id = id; }
+
+    /**
+     * @brief Asegurar espacio para bytes adicionales de nombres
+     */
+    bool reserve_name_bytes(size_t additional);
+
+    /**
+     * @brief Agregar una fila (con diccionario, el nombre se interna)
+     */
+    bool append(int id, double value, int category, const char* name, size_t name_length);
+    bool append(const DatabaseRecord& record);
+
+    /**
+     * @brief Cambiar el nombre de una fila
+     *
+     * Pasa el lote a codificación con diccionario si no lo estaba: sin
+     * diccionario los nombres son contiguos y no pueden reescribirse.
+     */
+    bool set_name(size_t row, const char* name, size_t name_length);
+
+    /**
+     * @brief Codificar los nombres con diccionario (no hace nada si ya lo están)
+     */
+    bool encode_name_dictionary();
+
+    /**
+     * @brief Reconstruir el registro de una fila (nombre truncado a MAX_NAME_LENGTH)
+     */
+    void get_record(size_t row, DatabaseRecord& record) const;
+
+    /**
+     * @brief Vaciar el lote sin liberar memoria (conserva la codificación)
+     */
+    void clear() { count = 0; reset_names(); }
+
+    /**
+     * @brief Reemplazar el contenido con columnas ya armadas (p. ej. desde el wire)
+     *
+     * Con codes != NULL los nombres quedan codificados con diccionario de
+     * entries entradas; si no, entries debe ser igual a rows. Los
+     * desplazamientos deben empezar en 0, ser no decrecientes y terminar en
+     * names_size; si algo no cuadra el lote queda vacío y se devuelve false.
+     */
+    bool load_columns(size_t rows, const int* id_values, const double* value_values,
+                      const int* category_values, const uint32_t* codes, size_t entries,
+                      const uint32_t* offsets, const char* names, size_t names_size);
+
+    /**
+     * @brief Convertir desde el formato de filas (reemplaza el contenido)
+     * @param dictionary Codificar los nombres con diccionario
+     * @return false si el lote no cabe
+     */
+    bool from_record_batch(const RecordBatch& batch, bool dictionary = false);
+
+    /**
+     * @brief Convertir al formato de filas
+     * @return false si el lote destino no tiene capacidad suficiente
+     */
+    bool to_record_batch(RecordBatch& batch) const;
+
+    /**
+     * @brief Vista C de las columnas para plugins (ver plugin_api.h)
+     *
+     * La vista permite modificar los bytes de los nombres en sitio, así que
+     * el índice de internado se descarta y se reconstruye si hace falta.
+     */
+    void get_plugin_view(PluginColumnarBatch& view);
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_COLUMNAR_BATCH_H
@@ -58,6 +58,16 @@ private:
      */
     static std::string policy_to_string(FailoverPolicy policy);
 
+    /**
+     * @brief Convertir aislamiento de string ("process", "none") a enum
+     */
+    static StageIsolation string_to_isolation(const std::string& isolation_str);
+
+    /**
+     * @brief Convertir aislamiento de enum a string
+     */
+    static std::string isolation_to_string(StageIsolation isolation);
+
 public:
     /**
      * @brief Constructor
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_CRC32C_H
+#define DISTRIBUTED_CRC32C_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace distributed {
+
+/**
+ * @brief CRC32C (Castagnoli) para verificar la integridad de lotes
+ *
+ * Usa la instrucción crc32 de SSE4.2 cuando la CPU la ofrece, en tres
+ * flujos intercalados para ocultar su latencia, y slicing-by-8 por
+ * software en otro caso. La implementación se elige una vez en tiempo de
+ * ejecución; ambas producen el mismo resultado.
+ */
+class Crc32c {
+public:
+    /**
+     * @brief CRC32C de un buffer
+     */
+    static uint32_t compute(const void* data, size_t length) { return extend(0, data, length); }
+
+    /**
+     * @brief Continuar un CRC32C con más datos
+     * @param crc Resultado de una llamada anterior (0 para empezar)
+     */
+    static uint32_t extend(uint32_t crc, const void* data, size_t length);
+
+    /**
+     * @brief Variante por software (slicing-by-8), siempre disponible
+     */
+    static uint32_t extend_software(uint32_t crc, const void* data, size_t length);
+
+    /**
+     * @brief Verificar si extend() usa la instrucción de hardware
+     */
+    static bool is_hardware_accelerated();
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_CRC32C_H
@@ -45,6 +45,13 @@ private:
     std::map<std::string, NodeInfo> cluster_nodes;
     mutable pthread_mutex_t cluster_mutex;
 
+    // Compresión y codificación de columnas de lotes salientes: valor por
+    // defecto y excepciones por nodo
+    bool compression_default;
+    std::map<std::string, bool> link_compression;
+    bool column_encoding_default;
+    std::map<std::string, bool> link_column_encoding;
+
     // Servidor para recibir conexiones
     int server_socket;
     pthread_t server_thread;
@@ -70,6 +77,11 @@ private:
      */
     void handle_distributed_batch(int client_socket, size_t data_size);
 
+    /**
+     * @brief Manejar batch distribuido enviado como stream de chunks
+     */
+    void handle_distributed_stream(int client_socket);
+
     /**
      * @brief Parsear información del cluster
      */
@@ -111,6 +123,37 @@ public:
      */
     bool send_batch_to_node(const std::string& target_node, RecordBatch* batch);
 
+    /**
+     * @brief Comprimir (o no) los lotes enviados a cualquier nodo sin ajuste propio
+     */
+    void set_compression(bool enabled);
+
+    /**
+     * @brief Comprimir (o no) los lotes enviados a un nodo concreto
+     */
+    void set_link_compression(const std::string& target_node, bool enabled);
+
+    /**
+     * @brief Verificar si los lotes hacia un nodo se envían comprimidos
+     */
+    bool is_compression_enabled(const std::string& target_node) const;
+
+    /**
+     * @brief Codificar (o no) las columnas numéricas de los lotes enviados
+     *        a cualquier nodo sin ajuste propio
+     */
+    void set_column_encoding(bool enabled);
+
+    /**
+     * @brief Codificar (o no) las columnas numéricas de los lotes enviados a un nodo concreto
+     */
+    void set_link_column_encoding(const std::string& target_node, bool enabled);
+
+    /**
+     * @brief Verificar si los lotes hacia un nodo llevan columnas codificadas
+     */
+    bool is_column_encoding_enabled(const std::string& target_node) const;
+
     /**
      * @brief Obtener información de todos los nodos
      */
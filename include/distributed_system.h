@@ -68,6 +68,11 @@ private:
      */
     bool load_and_configure_plugins();
 
+    /**
+     * @brief Callback de presión de memoria del pool
+     */
+    static void on_memory_pressure(DistributedMemoryPool* pool, size_t reserved_bytes, void* user_data);
+
     /**
      * @brief Configurar nodo distribuido
      */
@@ -158,9 +163,17 @@ public:
 
     /**
      * @brief Forzar garbage collection del sistema
+     *
+     * Devuelve al sistema operativo la memoria libre del pool por encima
+     * de su marca de retención. Se invoca también ante presión de memoria.
      */
     void force_system_cleanup();
 
+    /**
+     * @brief Límite de memoria reservada que dispara force_system_cleanup (0 lo desactiva)
+     */
+    void set_memory_pressure_limit(size_t limit_bytes);
+
     /**
      * @brief Exportar configuración actual
      */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_IN_PROCESS_PLUGIN_H
+#define DISTRIBUTED_IN_PROCESS_PLUGIN_H
+
+#include "interfaces.h"
+#include "plugin_api.h"
+#include "scratch_arena.h"
+#include "types.h"
+#include <string>
+
+namespace distributed {
+
+/**
+ * @brief Plugin de confianza cargado con dlopen en el proceso del nodo
+ *
+ * Adaptador de IProcessingComponent para etapas con isolation=none: cada
+ * lote es una llamada directa a process_batch, sin fork, shared memory ni
+ * IPC. A cambio, un crash o un cuelgue del plugin afecta al nodo entero,
+ * así que solo debe usarse con plugins revisados.
+ */
+class InProcessPlugin : public IProcessingComponent {
+private:
+    typedef int (*ProcessBatchFunc)(RecordBatch* batch, PluginContext* context);
+    typedef void (*CleanupPluginFunc)(PluginContext* context);
+
+    std::string plugin_name;
+    std::string library_path;
+    std::string config_params;
+    void* lib_handle;
+    ProcessBatchFunc process_func;
+    CleanupPluginFunc cleanup_func;
+    PluginContext context;
+    ScratchArena scratch_arena;
+    ComponentMetrics metrics;
+
+    // No copiable: posee el handle de dlopen
+    InProcessPlugin(const InProcessPlugin&);
+    InProcessPlugin& operator=(const InProcessPlugin&);
+
+public:
+    /**
+     * @brief Constructor
+     * @param name Nombre del plugin
+     * @param lib_path Ruta a la biblioteca compartida
+     * @param params Parámetros de configuración
+     */
+    InProcessPlugin(const std::string& name,
+                    const std::string& lib_path,
+                    const std::string& params);
+
+    virtual ~InProcessPlugin();
+
+    /**
+     * @brief Cargar la biblioteca y ejecutar init_plugin
+     */
+    bool load();
+
+    /**
+     * @brief Ejecutar cleanup_plugin y descargar la biblioteca
+     */
+    void unload();
+
+    /**
+     * @brief Descargar y volver a cargar (equivalente a reiniciar el proceso)
+     */
+    bool reload();
+
+    bool is_loaded() const { return lib_handle != NULL; }
+
+    // Implementación de IProcessingComponent
+    virtual int process_batch(RecordBatch* batch);
+    virtual const std::string& get_name() const { return plugin_name; }
+    virtual bool is_healthy() const { return is_loaded(); }
+    virtual const ComponentMetrics* get_metrics() const { return &metrics; }
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_IN_PROCESS_PLUGIN_H
@@ -21,10 +21,14 @@
 #define DISTRIBUTED_INTERFACES_H
 
 #include "types.h"
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace distributed {
 
+class ShmRing;
+
 // =============================================================================
 // INTERFACES PRINCIPALES DEL SISTEMA
 // =============================================================================
@@ -59,6 +63,54 @@ public:
     virtual const ComponentMetrics* get_metrics() const = 0;
 };
 
+/**
+ * @brief Componente que admite varios lotes en vuelo
+ *
+ * submit_batch() envía sin esperar y collect_completion() devuelve los
+ * lotes en el orden en que terminan, no en el de envío.
+ */
+class IPipelinedComponent : public IProcessingComponent {
+public:
+    /**
+     * @brief Enviar un lote sin esperar su resultado
+     * @return Identificador de la petición (> 0), o 0 si no se admite
+     */
+    virtual uint32_t submit_batch(RecordBatch* batch) = 0;
+
+    /**
+     * @brief Recoger el siguiente lote terminado
+     * @param timeout_ms Espera máxima; -1 espera indefinidamente
+     * @return Identificador de la petición, o 0 si ninguna terminó a tiempo
+     */
+    virtual uint32_t collect_completion(int timeout_ms, RecordBatch** batch, int* result) = 0;
+
+    /**
+     * @brief Renunciar a los lotes en vuelo (sus respuestas se descartan)
+     * @param touched Si no es NULL, recibe los lotes abandonados que el
+     *        plugin pudo modificar en sitio: repetir la etapa sobre ellos
+     *        la aplicaría dos veces
+     */
+    virtual void abandon_in_flight(std::vector<RecordBatch*>* touched = NULL) = 0;
+
+    /**
+     * @brief Lotes enviados cuya respuesta no se ha recogido
+     */
+    virtual size_t get_in_flight() const = 0;
+
+    /**
+     * @brief Lotes en vuelo que admite el componente
+     */
+    virtual size_t get_max_in_flight() const = 0;
+
+    /**
+     * @brief Añadir a rings los anillos por los que llegan sus respuestas
+     *
+     * Solo para esperar a varios componentes con ShmRing::wait_any(); las
+     * respuestas se consumen con collect_completion().
+     */
+    virtual void get_response_rings(std::vector<ShmRing*>& rings) = 0;
+};
+
 /**
  * @brief Interfaz para supervisores
  */
@@ -21,7 +21,9 @@
 #define DISTRIBUTED_IPC_H
 
 #include <string>
+#include <cstddef>
 #include <pthread.h>
+#include <stdint.h>
 
 namespace distributed {
 
@@ -78,7 +80,11 @@ struct IPCMessage {
         SHUTDOWN,
         SUPERVISOR_CMD,
         NODE_DISCOVERY,
-        LOAD_BALANCE
+        LOAD_BALANCE,
+        PROCESS_SHARED_BATCH,  ///< Lote residente en la región compartida del pool
+        PROCESS_BATCH_STREAM,  ///< Lote en chunks de BatchStreamWriter, sin data_size
+        EXPORT_STATE,          ///< Mover el estado parcial de una etapa al slot (reduce)
+        MERGE_STATE            ///< Sumar al de la etapa el estado del slot (reduce)
     };
 
     MessageType type;
@@ -118,6 +124,12 @@ public:
      */
     bool receive_message(IPCMessage** msg, size_t max_size);
 
+    /**
+     * @brief Esperar a que haya datos para leer
+     * @param timeout_ms Tiempo máximo de espera (-1 espera indefinidamente)
+     */
+    bool wait_readable(int timeout_ms);
+
     /**
      * @brief Cerrar canal
      */
@@ -130,6 +142,121 @@ public:
     int get_write_fd() const { return write_fd; }
 };
 
+/**
+ * @brief Descriptor de lote que viaja por un ShmRing
+ *
+ * Los datos del lote quedan en memoria compartida; solo viajan su
+ * ubicación y tamaño, en ninguna dirección se copian registros. La
+ * respuesta reutiliza la estructura con el count actualizado y el código
+ * devuelto por el plugin; sequence la empareja con su petición.
+ */
+struct BatchDescriptor {
+    uint32_t type;          ///< IPCMessage::MessageType
+    uint32_t sequence;
+    int32_t batch_id;
+    int32_t result;
+    uint64_t offset;        ///< Desplazamiento dentro de la región de datos
+    uint64_t size;          ///< Bytes serializados (0 si los registros están en sitio)
+    uint64_t count;
+    uint64_t capacity;
+};
+
+/**
+ * @brief Cola SPSC sin locks sobre memoria compartida
+ *
+ * Un productor y un consumidor, posiblemente en procesos distintos (la
+ * memoria y el eventfd deben existir antes del fork). Encolar y
+ * desencolar son un par de stores/loads con barrera. El productor solo
+ * hace la syscall de aviso cuando el consumidor declaró que va a dormir,
+ * así que con el consumidor ocupado el traspaso no entra al kernel.
+ */
+class ShmRing {
+private:
+    struct Control;
+
+    Control* control;
+    BatchDescriptor* slots;
+    uint32_t mask;
+    int event_fd;
+
+    bool has_data() const;
+
+public:
+    ShmRing();
+    ~ShmRing();
+
+    /**
+     * @brief Bytes de memoria compartida para una capacidad dada
+     * @param capacity Potencia de 2
+     */
+    static size_t required_size(size_t capacity);
+
+    /**
+     * @brief Inicializar la cola sobre memoria compartida y crear su eventfd
+     * @return false si la memoria no alcanza o la capacidad no es potencia de 2
+     */
+    bool init(void* memory, size_t size, size_t capacity);
+
+    /**
+     * @brief Encolar (solo el productor)
+     * @return false si la cola está llena
+     */
+    bool push(const BatchDescriptor& descriptor);
+
+    /**
+     * @brief Desencolar sin esperar (solo el consumidor)
+     */
+    bool pop(BatchDescriptor& descriptor);
+
+    enum WaitResult {
+        WAIT_TIMEOUT,
+        WAIT_READY,       ///< Hay descriptores para pop()
+        WAIT_FD_READY     ///< other_fd es legible y la cola sigue vacía
+    };
+
+    /**
+     * @brief Desencolar esperando hasta timeout_ms (-1 indefinidamente)
+     */
+    bool wait_pop(BatchDescriptor& descriptor, int timeout_ms);
+
+    /**
+     * @brief Dormir hasta que haya descriptores, other_fd sea legible o venza el plazo
+     *
+     * Un solo poll() sobre el eventfd de la cola y other_fd (p. ej. un pipe
+     * de control): esperando no se consume CPU y ningún evento espera a
+     * un intervalo de sondeo. Solo el consumidor puede llamarlo.
+     * @param timeout_ms Plazo total (-1 indefinidamente)
+     * @param other_fd Descriptor adicional a vigilar (-1 ninguno)
+     */
+    WaitResult wait(int timeout_ms, int other_fd = -1);
+
+    /**
+     * @brief Dormir hasta que alguna de varias colas tenga descriptores
+     *
+     * Para un consumidor que atiende varias colas (p. ej. las respuestas
+     * de varias réplicas): un solo poll() sobre todos los eventfd.
+     * @return Índice de una cola con descriptores, o -1 si venció el plazo
+     */
+    static int wait_any(ShmRing* const* rings, size_t count, int timeout_ms);
+
+    /**
+     * @brief Vaciar la cola conservando memoria y eventfd
+     *
+     * Solo con ambos extremos parados, p. ej. para reutilizarla con un
+     * proceso nuevo tras la muerte del anterior.
+     */
+    void reset();
+
+    /**
+     * @brief Liberar el eventfd y desasociar la memoria
+     */
+    void close();
+
+    bool is_valid() const { return control != NULL; }
+    size_t get_capacity() const { return control ? mask + 1 : 0; }
+    int get_event_fd() const { return event_fd; }
+};
+
 } // namespace distributed
 
 #endif // DISTRIBUTED_IPC_H
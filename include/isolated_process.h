@@ -24,28 +24,79 @@
 #include "ipc.h"
 #include "types.h"
 #include <sys/types.h>
+#include <sys/time.h>
 #include <string>
+#include <vector>
 
 namespace distributed {
 
+class ColumnarBatch;
+
+/**
+ * @brief Biblioteca de plugin que carga el proceso hijo
+ */
+struct HostedStage {
+    std::string name;
+    std::string library_path;
+    std::string config_params;
+};
+
 /**
  * @brief Proceso aislado para ejecutar plugins de forma segura
  * 
  * Cada plugin ejecuta en su propio proceso con memoria completamente
  * aislada. Comunicación via IPC y shared memory para performance.
+ *
+ * start() crea primero un zygote: un proceso que hereda pipes, shm y
+ * rings, precarga las bibliotecas y se queda esperando. Los hijos que
+ * procesan lotes salen de él con un fork, así que restart() solo tiene
+ * que pedir otro hijo: nada de crear recursos ni cargar bibliotecas
+ * desde disco. El fin de un hijo se detecta con un pidfd, sin sondeos
+ * ni sleeps.
  */
-class IsolatedPluginProcess : public IProcessingComponent {
+class IsolatedPluginProcess : public IPipelinedComponent {
+public:
+    /// Lotes en vuelo admitidos por proceso (slots de shared memory)
+    static const size_t MAX_PIPELINE_DEPTH = 16;
+
 private:
+    /**
+     * @brief Lote enviado al hijo cuya respuesta aún no se ha recogido
+     */
+    struct InFlightBatch {
+        uint32_t sequence;
+        RecordBatch* batch;        ///< NULL si se abandonó: la respuesta solo libera el slot
+        size_t slot;               ///< Slot de shared_memory; NO_SLOT en el camino compartido
+        bool synchronous;          ///< Enviado por process_batch
+        struct timeval start_time;
+    };
+
     pid_t process_id;
     std::string plugin_name;
-    std::string library_path;
-    std::string config_params;
+    std::vector<HostedStage> hosted_stages;  ///< Etapas que ejecuta el hijo, en orden
     IPCChannel* parent_channel;
     IPCChannel* child_channel;
     SharedMemoryRegion* shared_memory;
+    SharedMemoryRegion* ring_memory;  ///< Aloja request_ring y response_ring
+    std::string shm_name;             ///< Nombre base de shared_memory (ring_memory añade "_ring")
+    ShmRing request_ring;             ///< Padre -> hijo: lotes a procesar
+    ShmRing response_ring;            ///< Hijo -> padre: resultados
+    uint32_t next_sequence;
+    size_t pipeline_depth;
+    size_t slot_size;                 ///< shared_memory se reparte en pipeline_depth slots
+    std::vector<InFlightBatch> in_flight;
+    std::vector<size_t> free_slots;
+    const SharedMemoryRegion* batch_region;  ///< Región del pool heredada por el hijo (no propia)
+    bool name_dictionary;
+    ColumnarBatch* dictionary_batch;  ///< Reutilizado para codificar lotes con diccionario
     bool is_running;
     time_t last_heartbeat;
     ComponentMetrics metrics;
+    int exit_fd;                      ///< pidfd del hijo: legible al terminar (-1 sin soporte)
+    pid_t zygote_pid;
+    int zygote_exit_fd;
+    int zygote_request_fd;            ///< Padre -> zygote: 'S' crea un hijo, 'A' confirma su pidfd
+    int zygote_reply_fd;              ///< Zygote -> padre: PID del hijo creado
 
     /**
      * @brief Función que ejecuta el proceso hijo
@@ -53,9 +104,71 @@ private:
     void execute_plugin_process();
 
     /**
-     * @brief Cargar biblioteca del plugin en proceso hijo
+     * @brief Bucle del zygote: precarga las bibliotecas y crea hijos a petición
+     *
+     * Un hijo solo se recoge cuando el padre confirma que tiene su pidfd:
+     * hasta entonces queda zombi y su PID no puede reutilizarse.
+     */
+    void run_zygote(int request_fd, int reply_fd);
+
+    /**
+     * @brief Crear el zygote con los pipes, la shm y los rings ya preparados
+     */
+    bool start_zygote();
+
+    /**
+     * @brief Pedir al zygote un hijo nuevo, esperar su PID y abrir su pidfd
+     *
+     * Si el PID no llega a tiempo se detiene el zygote, para que su
+     * respuesta tardía no se tome por la del siguiente hijo.
      */
-    bool load_plugin_library();
+    bool spawn_child();
+
+    /**
+     * @brief Terminar el hijo: SHUTDOWN y, si no sale a tiempo, SIGTERM y SIGKILL
+     */
+    void stop_child();
+
+    /**
+     * @brief Terminar el zygote
+     */
+    void stop_zygote();
+
+    /**
+     * @brief Dejar pipes y rings como nuevos para el siguiente hijo
+     */
+    void reset_channels();
+
+    /**
+     * @brief Serializar un lote en un slot libre y enviar su descriptor
+     */
+    bool submit_serialized_batch(RecordBatch* batch, BatchDescriptor& descriptor, size_t& slot);
+
+    /**
+     * @brief Enviar el descriptor de un lote residente en batch_region
+     */
+    bool submit_shared_batch(RecordBatch* batch, BatchDescriptor& descriptor);
+
+    /**
+     * @brief Aplicar la respuesta del hijo al lote y liberar su slot
+     * @return true si el lote quedó procesado
+     */
+    bool complete_batch(const InFlightBatch& entry, const BatchDescriptor& response);
+
+    /**
+     * @brief Renunciar a los lotes en vuelo (solo los de process_batch si synchronous_only)
+     *
+     * Un lote en la región del pool no tiene copia: si el hijo sigue vivo
+     * podría escribirlo después de que el llamador lo reutilice o lo
+     * libere, así que en ese caso se mata al hijo y se reinicia. Esos
+     * lotes se añaden a touched si no es NULL.
+     */
+    void abandon_entries(bool synchronous_only, std::vector<RecordBatch*>* touched = NULL);
+
+    /**
+     * @brief Enviar un descriptor de control que usa el slot 0 y esperar su respuesta
+     */
+    bool exchange_control(BatchDescriptor& descriptor);
 
 public:
     /**
@@ -68,8 +181,107 @@ public:
                          const std::string& lib_path, 
                          const std::string& params);
 
+    /**
+     * @brief Constructor de un proceso que aloja varias etapas fusionadas
+     *
+     * El hijo carga todas las bibliotecas y las ejecuta una tras otra sobre
+     * el mismo lote: una sola serialización y un solo viaje de IPC por lote
+     * en lugar de uno por etapa. Un crash de cualquier etapa sigue sin
+     * afectar al nodo, pero reinicia a todas.
+     * @param name Nombre del proceso
+     * @param stages Etapas en orden de ejecución
+     */
+    IsolatedPluginProcess(const std::string& name, const std::vector<HostedStage>& stages);
+
     virtual ~IsolatedPluginProcess();
 
+    /**
+     * @brief Asociar la región compartida de un pool de lotes
+     *
+     * Debe llamarse antes de start() para que el hijo herede el mapeo.
+     * Los lotes cuyos registros estén dentro de la región se procesan en
+     * sitio; el resto sigue el camino de serialización.
+     */
+    void attach_batch_region(const SharedMemoryRegion* region) { batch_region = region; }
+
+    /**
+     * @brief Codificar los nombres con diccionario en el camino serializado
+     *
+     * Conviene cuando los nombres se repiten mucho: cada repetición cuesta
+     * 4 bytes y los plugins columnares procesan cada nombre distinto una
+     * sola vez.
+     */
+    void set_name_dictionary(bool enabled) { name_dictionary = enabled; }
+
+    /**
+     * @brief Fijar cuántos lotes pueden estar en vuelo a la vez
+     *
+     * Debe llamarse antes de start(): la shared memory se reparte en un
+     * slot por lote. Con profundidad 1 el proceso se comporta como antes;
+     * con más, el hijo encadena lotes sin esperar al padre y la latencia
+     * de IPC se solapa con el procesamiento.
+     */
+    void set_pipeline_depth(size_t depth);
+    size_t get_pipeline_depth() const { return pipeline_depth; }
+
+    /**
+     * @brief Lotes enviados cuya respuesta no se ha recogido
+     */
+    virtual size_t get_in_flight() const { return in_flight.size(); }
+    virtual size_t get_max_in_flight() const { return pipeline_depth; }
+    virtual void get_response_rings(std::vector<ShmRing*>& rings) { rings.push_back(&response_ring); }
+
+    /**
+     * @brief Enviar un lote sin esperar su resultado
+     *
+     * El lote no debe tocarse hasta recogerlo con collect_completion().
+     * @return Identificador de la petición (> 0), o 0 si no hay slot libre
+     *         o el lote no pudo serializarse
+     */
+    virtual uint32_t submit_batch(RecordBatch* batch);
+
+    /**
+     * @brief Recoger el siguiente lote terminado, en el orden en que termine
+     * @param timeout_ms Espera máxima; -1 espera indefinidamente
+     * @param batch Lote terminado
+     * @param result 0 si el lote se procesó; si falló, el código del plugin o -1
+     * @return Identificador devuelto por submit_batch(), o 0 si no terminó
+     *         ningún lote a tiempo
+     */
+    virtual uint32_t collect_completion(int timeout_ms, RecordBatch** batch, int* result);
+
+    /**
+     * @brief Renunciar a los lotes en vuelo
+     *
+     * Sus respuestas tardías solo liberan el slot; los lotes quedan en
+     * manos del llamador. Si alguno se procesaba en sitio y el hijo sigue
+     * vivo, el hijo se reinicia antes de volver.
+     */
+    virtual void abandon_in_flight(std::vector<RecordBatch*>* touched = NULL);
+
+    /**
+     * @brief Cola de respuestas, para esperar a varios procesos con ShmRing::wait_any
+     *
+     * Solo para esperar: los descriptores se consumen con collect_completion().
+     */
+    ShmRing* get_response_ring() { return &response_ring; }
+
+    /**
+     * @brief Mover fuera el estado parcial de una etapa (export_plugin_state)
+     *
+     * Solo sin lotes en vuelo. Si la etapa no exporta el hook el estado
+     * queda vacío y la llamada tiene éxito.
+     * @param stage Índice de la etapa en get_hosted_stages()
+     */
+    bool export_stage_state(size_t stage, std::vector<char>& state);
+
+    /**
+     * @brief Sumar a una etapa un estado exportado por otra réplica (merge_plugin_state)
+     *
+     * Solo sin lotes en vuelo.
+     */
+    bool merge_stage_state(size_t stage, const std::vector<char>& state);
+
     /**
      * @brief Iniciar el proceso aislado
      */
@@ -90,7 +302,14 @@ public:
      */
     pid_t get_pid() const { return process_id; }
 
-    // Implementación de IProcessingComponent
+    /**
+     * @brief Etapas que ejecuta el proceso, en orden
+     */
+    const std::vector<HostedStage>& get_hosted_stages() const { return hosted_stages; }
+
+    // Implementación de IProcessingComponent. process_batch es el camino
+    // síncrono: no debe mezclarse con submit_batch() mientras haya lotes
+    // propios en vuelo, porque sus respuestas se descartarían
     virtual int process_batch(RecordBatch* batch);
     virtual const std::string& get_name() const { return plugin_name; }
     virtual bool is_healthy() const { return is_alive(); }
@@ -103,6 +322,9 @@ public:
 
     /**
      * @brief Reiniciar proceso si ha fallado
+     *
+     * Con el zygote vivo el hijo nuevo reutiliza pipes, shm y bibliotecas
+     * ya cargadas; si el zygote murió se rehace todo con start().
      */
     bool restart();
 };
@@ -22,41 +22,479 @@
 
 #include "interfaces.h"
 #include <pthread.h>
+#include <stdint.h>
 
 namespace distributed {
 
+class SharedMemoryRegion;
+
+/**
+ * @brief Opciones de respaldo de memoria del pool
+ *
+ * Por defecto los slabs salen del heap. En modo arena cada nodo NUMA
+ * reserva una única región mmap (opcionalmente con huge pages) de la que
+ * se recortan los slabs; si el arena se agota se vuelve al heap. En modo
+ * memoria compartida los registros de los lotes salen de un SharedMemoryRegion
+ * heredado por los procesos de plugin, de modo que nacen ya compartidos.
+ * Cabeceras de lote, slabs y demás metadatos del pool siguen en memoria
+ * privada: un plugin solo puede escribir registros.
+ */
+struct MemoryPoolBacking {
+    enum Mode {
+        HEAP_BACKING,   ///< Slabs con new[]
+        ARENA_BACKING,          ///< Slabs recortados de un arena mmap por nodo
+        SHARED_MEMORY_BACKING   ///< Registros de los lotes en un SharedMemoryRegion
+    };
+
+    enum HugePageMode {
+        NO_HUGE_PAGES,           ///< Páginas normales
+        TRANSPARENT_HUGE_PAGES,  ///< madvise(MADV_HUGEPAGE)
+        EXPLICIT_HUGE_PAGES      ///< MAP_HUGETLB, con THP como respaldo
+    };
+
+    Mode mode;
+    HugePageMode huge_pages;
+    size_t arena_size;  ///< Bytes reservados por nodo (o de la región compartida)
+    bool numa_aware;    ///< Un arena y listas libres por nodo NUMA (mbind)
+
+    MemoryPoolBacking();
+};
+
+class DistributedMemoryPool;
+
+/**
+ * @brief Callback de presión de memoria
+ * @param pool Pool que superó su límite
+ * @param reserved_bytes Bytes reservados en el momento del aviso
+ * @param user_data Dato opaco registrado con el callback
+ *
+ * Se invoca sin ningún lock del pool tomado, por lo que puede llamar a trim().
+ */
+typedef void (*MemoryPressureCallback)(DistributedMemoryPool* pool, size_t reserved_bytes, void* user_data);
+
+/**
+ * @brief Estadísticas de memoria reservada por el pool
+ *
+ * Los bytes reservados incluyen slabs y objetos grandes; las marcas alta
+ * y baja se reinician con reset_watermarks().
+ */
+struct MemoryPoolUsage {
+    size_t reserved_bytes;
+    size_t high_water_bytes;
+    size_t low_water_bytes;
+    size_t released_bytes;  ///< Total devuelto al sistema por trim()
+    size_t trim_count;
+
+    MemoryPoolUsage();
+};
+
 /**
  * @brief Pool de memoria thread-safe para alta performance
  * 
- * Implementa un pool de memoria que pre-asigna bloques para evitar
- * llamadas frecuentes a malloc/free. Es thread-safe y optimizado
- * para alto throughput.
+ * Implementa un allocator tipo slab con clases de tamaño potencia de dos
+ * (de MIN_CLASS_SIZE a MAX_CLASS_SIZE). Cada clase pre-asigna bloques en
+ * slabs para evitar llamadas frecuentes a malloc/free; las peticiones
+ * mayores que la clase más grande siguen un camino de objetos grandes.
+ * Es thread-safe y optimizado para alto throughput.
  */
 class DistributedMemoryPool : public IMemoryPool {
+public:
+    /**
+     * @brief Tamaño de la clase más pequeña (2^MIN_CLASS_SHIFT bytes)
+     */
+    static const size_t MIN_CLASS_SHIFT = 6;
+
+    /**
+     * @brief Tamaño de la clase más grande (2^MAX_CLASS_SHIFT bytes)
+     */
+    static const size_t MAX_CLASS_SHIFT = 26;
+
+    static const size_t NUM_SIZE_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static const size_t MIN_CLASS_SIZE = static_cast<size_t>(1) << MIN_CLASS_SHIFT;
+    static const size_t MAX_CLASS_SIZE = static_cast<size_t>(1) << MAX_CLASS_SHIFT;
+
+    /**
+     * @brief Profundidad por defecto de la cache por hilo
+     */
+    static const size_t DEFAULT_THREAD_CACHE_DEPTH = 32;
+
+    /**
+     * @brief Máximo de nodos NUMA con listas libres propias
+     */
+    static const size_t MAX_NUMA_NODES = 64;
+
+    /**
+     * @brief Bytes libres que cada clase conserva por defecto tras un trim
+     */
+    static const size_t DEFAULT_TRIM_WATERMARK = 1024 * 1024;
+
+    static const size_t MAX_PRESSURE_CALLBACKS = 8;
+
 private:
+    /**
+     * @brief Cabecera inline que precede a los datos de cada bloque
+     *
+     * Permite que deallocate() recupere el bloque, su clase y su nodo a
+     * partir del puntero de datos en O(1), sin recorrer ninguna lista.
+     */
+    struct Slab;
+
     struct Block {
         char* data;
         size_t size;
+        unsigned int magic;
+        unsigned short size_class;  ///< LARGE_OBJECT_CLASS para objetos grandes
+        unsigned char node;         ///< Nodo NUMA dueño del bloque
         bool in_use;
-        Block* next;
+        Block* next;  ///< Siguiente bloque en la lista libre (o de objetos grandes)
+        Block* prev;  ///< Solo para objetos grandes
+        Slab* slab;   ///< Slab que contiene el bloque (NULL para objetos grandes)
+
+        Block(size_t s, unsigned short cls, unsigned char owner_node);
+
+        static size_t header_size();
+        static Block* from_data(void* ptr);
+    };
+
+    /**
+     * @brief Región de memoria contigua que contiene uno o más bloques
+     *
+     * Cuenta cuántos de sus bloques están en la lista libre de la clase;
+     * cuando lo están todos, trim() puede devolver el slab al sistema.
+     */
+    struct Slab {
+        Slab* next;  ///< Lista de slabs de la clase
+        Slab* prev;
+        size_t bytes;
+        size_t block_count;
+        size_t free_count;
+        bool from_arena;
+        bool releasing;
 
-        Block(size_t s);
-        ~Block();
+        static size_t header_size();
     };
 
-    Block* free_blocks;
-    Block* used_blocks;
-    mutable pthread_mutex_t mutex;
+    /**
+     * @brief Lista libre compartida de una clase de tamaño
+     */
+    struct SizeClass {
+        size_t block_size;
+        size_t blocks_per_slab;
+        size_t thread_cache_depth;
+        Block* free_blocks;
+        size_t free_count;
+        size_t total_blocks;
+        Slab* slabs;          ///< Slabs activos
+        Slab* dormant_slabs;  ///< Slabs del arena ya devueltos al sistema, reutilizables
+        pthread_mutex_t mutex;
+    };
+
+    /**
+     * @brief Cache (magazine) de bloques libres de una clase
+     */
+    struct Magazine {
+        Block** blocks;  ///< Se asigna al primer uso de la clase
+        volatile size_t count;
+        size_t capacity;
+    };
+
+    /**
+     * @brief Cache por hilo con un magazine por clase de tamaño
+     *
+     * Sirve la mayoría de allocate/deallocate sin tomar ningún mutex.
+     * Cada magazine se rellena y se vacía contra la lista de su clase
+     * en lotes de la mitad de su capacidad. Solo retiene bloques del
+     * nodo del hilo; los de otros nodos vuelven directamente a su lista.
+     */
+    struct ThreadCache {
+        Magazine magazines[NUM_SIZE_CLASSES];
+        size_t node;
+        DistributedMemoryPool* pool;
+        ThreadCache* next;  ///< Registro de caches del pool
+
+        ThreadCache(DistributedMemoryPool* owner, size_t home_node);
+        ~ThreadCache();
+    };
+
+    /**
+     * @brief Lote reciclable: cabecera RecordBatch y registros en un solo bloque
+     *
+     * Las unidades libres se guardan en una pila de Treiber por clase, de
+     * modo que create_batch/free_batch no toman locks ni llaman a malloc
+     * en régimen estacionario. Con memoria compartida la cabecera queda en
+     * un bloque privado y los registros en un trozo de la región.
+     */
+    struct BatchUnit {
+        RecordBatch batch;  ///< Primer miembro: RecordBatch* == BatchUnit*
+        unsigned int magic;
+        unsigned int index;                ///< Posición en la tabla de unidades
+        volatile unsigned int next_index;  ///< Enlace de la pila libre (índice + 1, 0 = fin)
+        size_t size_class;                 ///< NUM_SIZE_CLASSES para lotes no reciclables
+        size_t node;
+        size_t max_capacity;
+        char* shared_payload;  ///< Registros en la región compartida (NULL si siguen a la cabecera)
+        size_t shared_bytes;
+
+        static size_t header_size();
+    };
+
+    /**
+     * @brief Pila de Treiber con protección ABA
+     *
+     * La cabeza combina un contador de versión (32 bits altos) con el
+     * índice de la unidad (32 bits bajos), de modo que un CAS de 64 bits
+     * detecta cualquier pop/push intermedio.
+     */
+    struct BatchStack {
+        volatile uint64_t head;
+        volatile size_t depth;
+        char padding[64 - sizeof(uint64_t) - sizeof(size_t)];
+    };
+
+    /**
+     * @brief Listas libres, pilas de lotes y arena de un nodo NUMA
+     */
+    struct NodeHeap {
+        SizeClass classes[NUM_SIZE_CLASSES];
+        BatchStack batch_stacks[NUM_SIZE_CLASSES];
+        char* arena_base;
+        size_t arena_size;
+        size_t arena_used;  ///< Protegido por el mutex del pool
+    };
+
+    /**
+     * @brief Directorio de direcciones de las unidades vivas del pool
+     *
+     * Tabla hash abierta (0 = vacía, 1 = borrada) que free_batch() consulta
+     * sin locks antes de tocar la unidad, de modo que un RecordBatch ajeno
+     * al pool se descarta sin leer fuera de su objeto. Se modifica con el
+     * mutex del pool; al crecer se publica una tabla nueva y la anterior
+     * queda en la lista de retiradas hasta el destructor, por si algún
+     * lector la sigue recorriendo.
+     */
+    struct UnitDirectory {
+        volatile uintptr_t* slots;
+        size_t capacity;  ///< Potencia de dos
+        size_t used;      ///< Entradas ocupadas más borradas
+        size_t live;
+        UnitDirectory* retired;
+    };
+
+    /**
+     * @brief Trozos de registros libres de una clase en la región compartida
+     */
+    struct SharedPayloadList {
+        char** chunks;
+        size_t count;
+        size_t capacity;
+    };
+
+    static const size_t UNIT_SEGMENT_SIZE = 1024;
+    static const size_t MAX_UNIT_SEGMENTS = 4096;
+
+    MemoryPoolBacking backing;
+    MemoryPoolBacking::HugePageMode effective_huge_pages;
+    mutable NodeHeap* heaps;
+    size_t node_count;
+    int* cpu_nodes;  ///< CPU -> nodo (NULL si hay un solo nodo)
+    size_t cpu_count;
+    SharedMemoryRegion* shared_region;  ///< Registros de lotes (solo SHARED_MEMORY_BACKING)
+    SharedPayloadList shared_payloads[NUM_SIZE_CLASSES];  ///< Protegidas por el mutex del pool
+    size_t shared_used;  ///< Bytes de la región ya repartidos
+
+    BatchUnit** unit_segments[MAX_UNIT_SEGMENTS];  ///< Tabla índice -> unidad (solo crece)
+    size_t unit_count;
+    unsigned int* retired_units;  ///< Índices liberados por trim() para reutilizar
+    size_t retired_unit_count;
+    size_t retired_unit_capacity;
+    UnitDirectory* volatile unit_directory;
+
+    // Épocas de reclamación: trim() no libera una unidad sacada de una pila
+    // hasta que salen los pop_batch_unit que pudieron verla
+    volatile unsigned int reclaim_epoch;
+    volatile size_t epoch_readers[2];
+    pthread_mutex_t reclaim_mutex;
+
+    volatile int next_batch_id;
+    Block* large_objects;
+    size_t large_object_count;
+    mutable pthread_mutex_t mutex;  ///< Protege arenas, objetos grandes, tabla de unidades y registro de caches
     size_t block_size;
-    size_t total_blocks;
+    size_t default_class;
+
+    // Caches por hilo
+    size_t thread_cache_depth;
+    bool thread_cache_enabled;
+    pthread_key_t thread_cache_key;
+    ThreadCache* thread_caches;
+
+    // Trim y presión de memoria
+    volatile size_t reserved_bytes;
+    volatile size_t high_water_bytes;
+    volatile size_t low_water_bytes;
+    volatile size_t released_bytes;
+    volatile size_t trim_count;
+    size_t trim_watermark;
+    size_t pressure_limit;
+    volatile int pressure_signaled;
+    MemoryPressureCallback pressure_callbacks[MAX_PRESSURE_CALLBACKS];
+    void* pressure_user_data[MAX_PRESSURE_CALLBACKS];
+    size_t pressure_callback_count;
+    pthread_t trim_thread;
+    bool trim_thread_running;
+    volatile bool trim_thread_stop;
+    unsigned int trim_interval_ms;
+    pthread_mutex_t trim_mutex;
+    pthread_cond_t trim_cond;
+
+    /**
+     * @brief Inicialización común a todos los constructores
+     */
+    void initialize(size_t initial_blocks);
+
+    /**
+     * @brief Detectar la topología NUMA y reservar los arenas
+     */
+    void setup_numa_topology();
+    void setup_arena(size_t node);
+    void setup_shared_arena();
+
+    /**
+     * @brief Nodo NUMA de la CPU actual
+     */
+    size_t current_node() const;
+
+    /**
+     * @brief Índice de la clase que sirve un tamaño (NUM_SIZE_CLASSES si es grande)
+     */
+    static size_t size_class_for(size_t size);
+
+    /**
+     * @brief Obtener memoria para un slab, del arena del nodo o del heap
+     */
+    char* allocate_slab_memory(size_t node, size_t bytes, bool& from_arena);
+
+    /**
+     * @brief Asignar un slab nuevo y dejar sus bloques en la lista de la clase
+     * (requiere el mutex de la clase tomado)
+     */
+    void grow_class_locked(size_t node, size_t class_index);
+
+    /**
+     * @brief Devolver al sistema los slabs completamente libres de una clase
+     * (requiere el mutex de la clase tomado)
+     * @return Bytes liberados
+     */
+    size_t trim_class_locked(size_t node, size_t class_index, size_t retain_blocks);
+
+    /**
+     * @brief Liberar unidades de lote retenidas por encima de retain_units
+     * @return Bytes de registros compartidos devueltos al sistema
+     */
+    size_t trim_batch_stack(size_t node, size_t class_index, size_t retain_units);
+
+    /**
+     * @brief Tomar/devolver un trozo de registros de la región compartida
+     *
+     * take devuelve NULL si la región está agotada; release devuelve al
+     * sistema las páginas enteras del trozo y lo deja para reutilizar.
+     */
+    char* take_shared_payload(size_t class_index);
+    size_t release_shared_payload(char* payload, size_t bytes);
+
+    /**
+     * @brief Contabilidad de bytes reservados y marcas alta/baja
+     */
+    void add_reserved(size_t bytes);
+    void remove_reserved(size_t bytes);
+
+    /**
+     * @brief Invocar los callbacks de presión si se cruzó el límite (sin locks tomados)
+     */
+    void notify_pressure();
+
+    static void* trim_thread_function(void* arg);
+
+    /**
+     * @brief Sacar/devolver un bloque de la lista compartida de su clase
+     */
+    Block* take_block(size_t node, size_t class_index);
+    void return_block(Block* block);
+
+    /**
+     * @brief Registrar una unidad nueva en la tabla (camino lento, con mutex)
+     */
+    bool register_unit(BatchUnit* unit);
+
+    /**
+     * @brief Alta/baja de una unidad en el directorio (requieren el mutex del pool)
+     */
+    void track_unit_locked(BatchUnit* unit);
+    void untrack_unit_locked(BatchUnit* unit);
+
+    /**
+     * @brief Verificar sin locks si batch es la cabecera de una unidad del pool
+     */
+    bool owns_unit(const RecordBatch* batch) const;
+
+    BatchUnit* unit_at(unsigned int index) const;
+    BatchUnit* pop_batch_unit(size_t node, size_t class_index);
+
+    /**
+     * @brief Entrar/salir de la época actual (lectores de las pilas, sin locks)
+     * @return Paridad de la época a pasar a leave_reclaim_epoch()
+     */
+    size_t enter_reclaim_epoch();
+    void leave_reclaim_epoch(size_t parity);
+
+    /**
+     * @brief Avanzar la época y esperar a los lectores de la anterior
+     */
+    void synchronize_reclaim();
+    void push_batch_unit(BatchUnit* unit);
+
+    /**
+     * @brief Camino de objetos mayores que MAX_CLASS_SIZE
+     */
+    void* allocate_large(size_t size);
+    void deallocate_large(Block* block);
+
+    /**
+     * @brief Obtener (o crear) la cache del hilo actual
+     */
+    ThreadCache* get_thread_cache();
+
+    /**
+     * @brief Rellenar un magazine vacío desde la lista de su clase
+     */
+    void refill_magazine(Magazine* magazine, size_t node, size_t class_index);
+
+    /**
+     * @brief Devolver bloques de un magazine a la lista de su clase
+     */
+    void drain_magazine(Magazine* magazine, size_t node, size_t class_index, size_t keep);
+
+    /**
+     * @brief Destructor de TLS: devuelve los bloques cacheados al terminar el hilo
+     */
+    static void release_thread_cache(void* arg);
 
 public:
     /**
      * @brief Constructor
-     * @param block_size Tamaño de cada bloque en bytes
+     * @param block_size Tamaño de bloque habitual; su clase se pre-asigna
      * @param initial_blocks Número inicial de bloques a pre-asignar
+     * @param thread_cache_depth Bloques cacheados por hilo y clase (0 desactiva la cache)
      */
-    DistributedMemoryPool(size_t block_size, size_t initial_blocks = 10);
+    DistributedMemoryPool(size_t block_size, size_t initial_blocks = 10,
+                          size_t thread_cache_depth = DEFAULT_THREAD_CACHE_DEPTH);
+
+    /**
+     * @brief Constructor con respaldo de memoria configurable
+     * @param backing Arena mmap, huge pages y afinidad NUMA
+     */
+    DistributedMemoryPool(size_t block_size, size_t initial_blocks,
+                          size_t thread_cache_depth, const MemoryPoolBacking& backing);
 
     virtual ~DistributedMemoryPool();
 
@@ -69,13 +507,102 @@ public:
 
     /**
      * @brief Obtener estadísticas detalladas del pool
+     *
+     * Suma todas las clases de todos los nodos más los objetos grandes
+     * vivos. Los bloques en caches por hilo y los lotes retenidos para
+     * reciclaje cuentan como libres, por lo que la consulta es O(hilos).
      */
     void get_statistics(size_t& total, size_t& free, size_t& used) const;
 
     /**
-     * @brief Expandir el pool con más bloques
+     * @brief Lotes libres retenidos para reciclaje
+     */
+    size_t get_cached_batch_count() const;
+
+    /**
+     * @brief Expandir el pool con más bloques de la clase de block_size
      */
     void expand_pool(size_t additional_blocks);
+
+    /**
+     * @brief Obtener la profundidad de la cache por hilo (0 si está desactivada)
+     */
+    size_t get_thread_cache_depth() const { return thread_cache_enabled ? thread_cache_depth : 0; }
+
+    /**
+     * @brief Número de nodos NUMA con listas libres propias
+     */
+    size_t get_numa_node_count() const { return node_count; }
+
+    /**
+     * @brief Modo de huge pages efectivamente obtenido del kernel
+     */
+    MemoryPoolBacking::HugePageMode get_effective_huge_pages() const { return effective_huge_pages; }
+
+    /**
+     * @brief Bytes de arena consumidos por slabs (todos los nodos)
+     */
+    size_t get_arena_bytes_used() const;
+
+    /**
+     * @brief Devolver al sistema la memoria libre por encima de la marca de retención
+     *
+     * Vacía la cache del hilo llamante, libera lotes retenidos y devuelve los
+     * slabs completamente libres de cada clase que supere la marca. Las caches
+     * de otros hilos no se tocan (están acotadas por su profundidad).
+     * @return Bytes devueltos al sistema
+     */
+    size_t trim();
+
+    /**
+     * @brief Bytes libres que cada clase conserva tras trim()
+     */
+    void set_trim_watermark(size_t bytes) { trim_watermark = bytes; }
+    size_t get_trim_watermark() const { return trim_watermark; }
+
+    /**
+     * @brief Ejecutar trim() periódicamente en un hilo de fondo
+     */
+    bool start_background_trim(unsigned int interval_ms);
+    void stop_background_trim();
+
+    /**
+     * @brief Registrar un callback para cuando la memoria reservada supere limit_bytes
+     *
+     * El aviso se emite una vez por cruce; se rearma cuando un trim deja la
+     * memoria reservada por debajo del límite. El límite es común a todos
+     * los callbacks.
+     */
+    bool add_pressure_callback(MemoryPressureCallback callback, void* user_data);
+    void set_pressure_limit(size_t limit_bytes) { pressure_limit = limit_bytes; }
+
+    /**
+     * @brief Obtener bytes reservados y marcas alta/baja
+     */
+    void get_usage(MemoryPoolUsage& usage) const;
+
+    /**
+     * @brief Reiniciar las marcas alta y baja al valor actual
+     */
+    void reset_watermarks();
+
+    /**
+     * @brief Región compartida con los registros de los lotes (NULL si no es SHARED_MEMORY_BACKING)
+     *
+     * Se crea antes de cualquier fork(), por lo que los procesos hijos la
+     * heredan mapeada y pueden acceder a los lotes por desplazamiento.
+     */
+    const SharedMemoryRegion* get_shared_region() const { return shared_region; }
+
+    /**
+     * @brief Verificar si [ptr, ptr + bytes) está dentro de la región compartida
+     */
+    bool is_shared(const void* ptr, size_t bytes) const;
+
+    /**
+     * @brief Capacidad utilizable del bloque que contiene ptr (0 si no es del pool)
+     */
+    static size_t usable_size(void* ptr);
 };
 
 } // namespace distributed
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISTRIBUTED_PLUGIN_API_H
+#define DISTRIBUTED_PLUGIN_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// =============================================================================
+// ABI DE PLUGINS
+// =============================================================================
+//
+// Cabecera autocontenida que los plugins pueden incluir en lugar de
+// redeclarar PluginContext. Los campos nuevos se agregan siempre al final,
+// de modo que los plugins compilados con la declaración antigua ven un
+// prefijo válido de la estructura.
+
+/**
+ * @brief Arena de scratch por lote
+ *
+ * El host lo reinicia en O(1) cuando process_batch retorna, así que todo
+ * lo asignado es válido solo durante la llamada actual (o durante
+ * init_plugin). El camino rápido es un bump de puntero inline; solo
+ * cuando el bloque actual se agota se llama al host.
+ */
+struct PluginScratch {
+    char* cursor;
+    char* limit;
+    void* (*allocate_slow)(PluginScratch* scratch, size_t size);  ///< Implementado por el host
+    void* host_state;
+};
+
+/**
+ * @brief Contexto que el host entrega a init_plugin, process_batch y cleanup_plugin
+ */
+struct PluginContext {
+    void* user_data;
+    const char* config_params;
+    void (*log_info)(const char* message);
+    void (*log_error)(const char* message);
+    PluginScratch* scratch;  ///< NULL en hosts sin soporte de scratch
+};
+
+/**
+ * @brief Vista columnar de un lote
+ *
+ * Punto de entrada opcional para plugins que solo tocan algunas columnas:
+ *
+ *     extern "C" int process_columnar_batch(PluginColumnarBatch* batch, PluginContext* context);
+ *
+ * Si el plugin lo exporta, el host lo prefiere a process_batch. Las
+ * columnas numéricas se modifican en sitio y count es de solo lectura.
+ *
+ * Los nombres son entradas de un arena, no terminadas en '\0': la entrada
+ * e ocupa name_data[name_offsets[e]] .. name_data[name_offsets[e + 1]].
+ * Si name_codes no es NULL los nombres están codificados con diccionario:
+ * hay name_entries nombres distintos y la fila i usa la entrada
+ * name_codes[i], de modo que el trabajo por nombre puede hacerse una vez
+ * por entrada. Sin diccionario name_entries == count y la fila i usa la
+ * entrada i.
+ *
+ * Los bytes de una entrada pueden reescribirse en sitio sin cambiar su
+ * longitud. Para cambiar el nombre de una fila se usa set_name, que puede
+ * reubicar las columnas de nombres (y activar el diccionario), así que
+ * tras llamarlo hay que releer name_codes, name_offsets y name_data.
+ */
+struct PluginColumnarBatch {
+    size_t count;
+    int batch_id;
+    int* ids;
+    double* values;
+    int* categories;
+    const uint32_t* name_offsets;  ///< name_entries + 1 entradas
+    char* name_data;
+    const uint32_t* name_codes;    ///< NULL sin diccionario
+    size_t name_entries;
+    int (*set_name)(PluginColumnarBatch* batch, size_t row, const char* name, size_t length);  ///< Implementado por el host
+    void* host_state;
+};
+
+/*
+ * Reduce de estado entre réplicas (opcional)
+ *
+ * Una etapa con varias réplicas reparte sus lotes entre procesos, así que
+ * el estado que el plugin acumula (totales, contadores) queda partido.
+ * Si el plugin exporta
+ *
+ *     extern "C" size_t export_plugin_state(PluginContext* context, void* buffer, size_t capacity);
+ *     extern "C" int merge_plugin_state(PluginContext* context, const void* state, size_t size);
+ *
+ * el host mueve el estado parcial de cada réplica a la principal:
+ * export_plugin_state lo copia al buffer, lo reinicia y devuelve los bytes
+ * escritos (0 si no hay nada que mover o no cabe, sin reiniciar), y
+ * merge_plugin_state lo suma al propio y devuelve 0 si lo aceptó. El
+ * formato es privado del plugin: solo viaja entre réplicas de la misma
+ * biblioteca.
+ */
+
+/**
+ * @brief Entrada de nombres que usa una fila de la vista columnar
+ */
+static inline size_t plugin_columnar_name_entry(const PluginColumnarBatch* batch, size_t row) {
+    return batch->name_codes ? batch->name_codes[row] : row;
+}
+
+/**
+ * @brief Alineación de todas las asignaciones de scratch
+ */
+#define PLUGIN_SCRATCH_ALIGNMENT 16
+
+/**
+ * @brief Asignar memoria de scratch (NULL si el host no la ofrece)
+ */
+static inline void* plugin_scratch_alloc(PluginContext* context, size_t size) {
+    if (!context || !context->scratch) return NULL;
+    
+    PluginScratch* scratch = context->scratch;
+    size = (size + PLUGIN_SCRATCH_ALIGNMENT - 1) & ~static_cast<size_t>(PLUGIN_SCRATCH_ALIGNMENT - 1);
+    
+    if (static_cast<size_t>(scratch->limit - scratch->cursor) >= size) {
+        void* ptr = scratch->cursor;
+        scratch->cursor += size;
+        return ptr;
+    }
+    return scratch->allocate_slow(scratch, size);
+}
+
+/**
+ * @brief Copiar una cadena al scratch
+ */
+static inline char* plugin_scratch_strdup(PluginContext* context, const char* text) {
+    if (!text) return NULL;
+    
+    size_t length = strlen(text) + 1;
+    char* copy = static_cast<char*>(plugin_scratch_alloc(context, length));
+    if (copy) {
+        memcpy(copy, text, length);
+    }
+    return copy;
+}
+
+/**
+ * @brief Formatear con printf en el scratch, sin límite fijo de longitud
+ */
+static inline char* plugin_scratch_format(PluginContext* context, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (length < 0) return NULL;
+    
+    char* buffer = static_cast<char*>(plugin_scratch_alloc(context, static_cast<size_t>(length) + 1));
+    if (!buffer) return NULL;
+    
+    va_start(args, format);
+    vsnprintf(buffer, static_cast<size_t>(length) + 1, format, args);
+    va_end(args);
+    return buffer;
+}
+
+#endif // DISTRIBUTED_PLUGIN_API_H
@@ -22,9 +22,12 @@
 
 #include "interfaces.h"
 #include "isolated_process.h"
+#include "in_process_plugin.h"
+#include "replicated_stage.h"
 #include "types.h"
 #include <vector>
 #include <string>
+#include <algorithm>
 
 namespace distributed {
 
@@ -44,6 +47,14 @@ struct FailoverConfig {
     FailoverConfig();
 };
 
+/**
+ * @brief Dónde se ejecuta el plugin de una etapa
+ */
+enum StageIsolation {
+    ISOLATION_PROCESS,  ///< Proceso hijo aislado (por defecto)
+    ISOLATION_NONE      ///< dlopen en el proceso del nodo: solo plugins de confianza
+};
+
 /**
  * @brief Configuración de una etapa del pipeline
  */
@@ -53,10 +64,21 @@ struct PipelineStageConfig {
     std::string parameters;
     bool enabled;
     FailoverConfig failover_config;
+    int pipeline_depth;          ///< Lotes en vuelo hacia el proceso del plugin
+    StageIsolation isolation;
+    int replicas;                ///< Procesos idénticos que atienden la etapa
 
     PipelineStageConfig();
 };
 
+/**
+ * @brief Cómo reparte el gestor las etapas del pipeline en procesos
+ */
+enum PipelineExecutionMode {
+    PROCESS_PER_STAGE,  ///< Un proceso aislado por etapa (por defecto)
+    FUSED_PROCESS       ///< Un solo proceso aislado ejecuta todas las etapas
+};
+
 /**
  * @brief Gestor de plugins con capacidades de failover
  * 
@@ -65,28 +87,32 @@ struct PipelineStageConfig {
  */
 class ResilientPluginManager {
 private:
-    std::vector<IsolatedPluginProcess*> plugins;
+    std::vector<IProcessingComponent*> plugins;
     std::vector<PipelineStageConfig> pipeline_config;
     IMemoryPool* memory_pool;
+    PipelineExecutionMode execution_mode;
+    std::vector<PipelineStageConfig> fused_configs;  ///< Etapas sintéticas de los procesos fusionados
+    size_t stage_queue_capacity;     ///< Lotes que una etapa acepta por delante de la siguiente
+    bool preserve_order;             ///< Entregar los lotes a cada etapa en el orden de entrada
 
     /**
      * @brief Ejecutar plugin con manejo de timeouts
      */
-    int execute_plugin_with_timeout(IsolatedPluginProcess* plugin, 
+    int execute_plugin_with_timeout(IProcessingComponent* plugin, 
                                    RecordBatch* batch, 
                                    int timeout_ms);
 
     /**
      * @brief Aplicar política de retry
      */
-    int apply_retry_policy(IsolatedPluginProcess* plugin, 
+    int apply_retry_policy(IProcessingComponent* plugin, 
                           RecordBatch* batch, 
                           const FailoverConfig& config);
 
     /**
      * @brief Ejecutar plugin con manejo de fallos
      */
-    int execute_plugin_with_failover(IsolatedPluginProcess* plugin, 
+    int execute_plugin_with_failover(IProcessingComponent* plugin, 
                           RecordBatch* batch, 
                           const FailoverConfig& config);
 
@@ -97,6 +123,36 @@ private:
                              RecordBatch* batch, 
                              const FailoverConfig& config);
 
+    /**
+     * @brief Arrancar un proceso que aloja varias etapas consecutivas
+     */
+    bool start_fused_host(const std::vector<const PipelineStageConfig*>& stages);
+
+    /**
+     * @brief Crear el proceso (o las réplicas) de unas etapas y arrancarlo
+     *
+     * Asocia la región compartida del pool. Devuelve NULL si no arranca.
+     */
+    IProcessingComponent* start_plugin_process(const std::vector<HostedStage>& stages,
+                                               const PipelineStageConfig& config);
+
+    /**
+     * @brief Configuración de la etapa de un plugin, NULL si no existe
+     */
+    const PipelineStageConfig* find_stage_config(const std::string& plugin_name) const;
+
+    /**
+     * @brief Pasar un lote por una etapa con reintentos y política de failover
+     * @return false si el lote falló y la política es FAIL_FAST
+     */
+    bool run_stage_with_failover(IProcessingComponent* plugin, const PipelineStageConfig& config,
+                                 RecordBatch* batch);
+
+    /**
+     * @brief Hilo de una etapa en proceso en process_batches_through_pipeline
+     */
+    static void* stage_worker_function(void* arg);
+
 public:
     /**
      * @brief Constructor
@@ -106,6 +162,18 @@ public:
 
     virtual ~ResilientPluginManager();
 
+    /**
+     * @brief Elegir cómo se reparten las etapas en procesos
+     *
+     * Se aplica en el siguiente load_pipeline_config(). En FUSED_PROCESS
+     * cada tramo de etapas aisladas consecutivas es un único componente:
+     * sus timeouts se suman, sus reintentos son los máximos de las etapas
+     * y basta una etapa FAIL_FAST para que el tramo lo sea. Las etapas con
+     * isolation=none siguen en el proceso del nodo.
+     */
+    void set_execution_mode(PipelineExecutionMode mode) { execution_mode = mode; }
+    PipelineExecutionMode get_execution_mode() const { return execution_mode; }
+
     /**
      * @brief Cargar configuración del pipeline
      */
@@ -126,6 +194,39 @@ public:
      */
     bool process_batch_through_pipeline(RecordBatch* batch);
 
+    /**
+     * @brief Procesar varios lotes a través de todo el pipeline
+     *
+     * Las etapas trabajan a la vez sobre lotes distintos: mientras el lote
+     * k está en enrichment el k+1 ya está en validation, y el rendimiento
+     * tiende al de la etapa más lenta en vez de a la suma de todas. Cada
+     * etapa tiene su cola y mantiene hasta pipeline_depth lotes en vuelo
+     * hacia su proceso; una etapa no toma más lotes si ella y la cola de la
+     * siguiente ya retienen stage_queue_capacity. Las etapas en proceso
+     * corren en un hilo propio, de lote en lote, con sus reintentos. Los
+     * lotes que fallen en el camino encadenado se reintentan uno a uno con
+     * la política de failover de la etapa.
+     * @param completed Si no es NULL, recibe los lotes según salen del pipeline
+     */
+    bool process_batches_through_pipeline(const std::vector<RecordBatch*>& batches,
+                                          std::vector<RecordBatch*>* completed = NULL);
+
+    /**
+     * @brief Límite de lotes retenidos entre una etapa y la cola de la siguiente
+     */
+    void set_stage_queue_capacity(size_t capacity) { stage_queue_capacity = std::max(capacity, static_cast<size_t>(1)); }
+    size_t get_stage_queue_capacity() const { return stage_queue_capacity; }
+
+    /**
+     * @brief Mantener el orden de entrada entre etapas y a la salida
+     *
+     * Activado por defecto, para que los plugins con estado vean los lotes
+     * en orden. Desactivado, cada lote avanza en cuanto su etapa lo termina
+     * (con réplicas o fallos reintentados, el orden puede cambiar).
+     */
+    void set_preserve_order(bool preserve) { preserve_order = preserve; }
+    bool get_preserve_order() const { return preserve_order; }
+
     /**
      * @brief Obtener estado de todos los plugins
      */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_RECORD_SCHEMA_H
+#define DISTRIBUTED_RECORD_SCHEMA_H
+
+#include "types.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace distributed {
+
+// =============================================================================
+// DESCRIPTORES DE CAMPOS
+// =============================================================================
+
+enum SchemaFieldType {
+    SCHEMA_INT32 = 1,
+    SCHEMA_FLOAT64 = 2,
+    SCHEMA_CHARS = 3     ///< char[N], terminado en '\0'
+};
+
+// El tipo de un miembro se deduce en compilación por sobrecarga: sizeof
+// del resultado es el SchemaFieldType. Un tipo no soportado no compila.
+char (&schema_field_tag(int32_t*))[SCHEMA_INT32];
+char (&schema_field_tag(double*))[SCHEMA_FLOAT64];
+template <size_t N> char (&schema_field_tag(char (*)[N]))[SCHEMA_CHARS];
+
+/**
+ * @brief Campo de un registro tal como lo declara RecordSchemaTraits
+ */
+struct SchemaFieldDescriptor {
+    const char* name;
+    uint32_t type;
+    uint32_t offset;
+    uint32_t size;
+};
+
+/**
+ * @brief Descriptor de un miembro: nombre, tipo, offset y tamaño en compilación
+ */
+#define SCHEMA_FIELD(Record, member) \
+    { #member, sizeof(::distributed::schema_field_tag(&((Record*)0)->member)), \
+      offsetof(Record, member), sizeof(((Record*)0)->member) }
+
+/**
+ * @brief Lista de campos de un tipo de registro
+ *
+ * Cada tipo serializable la especializa con un arreglo de SCHEMA_FIELD:
+ *
+ *     template <> struct RecordSchemaTraits<MyRecord> {
+ *         static const SchemaFieldDescriptor fields[];
+ *         static const size_t field_count;
+ *     };
+ */
+template <typename Record> struct RecordSchemaTraits;
+
+template <> struct RecordSchemaTraits<DatabaseRecord> {
+    static const SchemaFieldDescriptor fields[];
+    static const size_t field_count;
+};
+
+// =============================================================================
+// ESQUEMA
+// =============================================================================
+
+/**
+ * @brief Layout de un registro con su forma canónica para el wire
+ *
+ * La forma codificada es little-endian sin importar el host y su CRC32C
+ * es la huella del esquema: dos nodos con la misma huella tienen el mismo
+ * layout binario y pueden copiar registros con memcpy.
+ */
+class RecordSchema {
+public:
+    struct Field {
+        std::string name;
+        uint32_t type;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    static const size_t MAX_FIELDS = 64;
+    static const size_t MAX_NAME_LENGTH = 32;
+    static const size_t MAX_RECORD_SIZE = 65536;
+
+private:
+    std::vector<Field> fields;
+    uint32_t record_size;
+    std::vector<char> encoded;
+    uint32_t fingerprint;
+
+    bool seal();
+
+public:
+    RecordSchema();
+
+    /**
+     * @brief Esquema a partir de una tabla de descriptores (inválido si no cuadra)
+     */
+    RecordSchema(const SchemaFieldDescriptor* descriptors, size_t count, size_t size);
+
+    /**
+     * @brief Esquema de un tipo con RecordSchemaTraits, construido una vez
+     */
+    template <typename Record>
+    static const RecordSchema& of() {
+        static const RecordSchema schema(RecordSchemaTraits<Record>::fields,
+                                         RecordSchemaTraits<Record>::field_count, sizeof(Record));
+        return schema;
+    }
+
+    /**
+     * @brief Esquema de DatabaseRecord en este binario
+     */
+    static const RecordSchema& native() { return of<DatabaseRecord>(); }
+
+    /**
+     * @brief Leer la forma codificada que envió otro nodo
+     * @return false si no es un esquema válido
+     */
+    bool decode(const char* data, size_t size);
+
+    bool is_valid() const { return !encoded.empty(); }
+    const char* get_encoded() const { return encoded.empty() ? NULL : &encoded[0]; }
+    size_t get_encoded_size() const { return encoded.size(); }
+    uint32_t get_fingerprint() const { return fingerprint; }
+    size_t get_record_size() const { return record_size; }
+    size_t get_field_count() const { return fields.size(); }
+    const Field& get_field(size_t index) const { return fields[index]; }
+
+    /**
+     * @brief Campo por nombre (NULL si no existe)
+     */
+    const Field* find_field(const std::string& name) const;
+};
+
+// =============================================================================
+// CONVERSIÓN
+// =============================================================================
+
+/**
+ * @brief Plan para convertir registros de un esquema a otro
+ *
+ * Se construye una vez por par de esquemas. Los campos se emparejan por
+ * nombre; los que faltan en el origen quedan en cero y los que sobran se
+ * descartan. int32 y float64 se convierten entre sí, los char[] se
+ * truncan o rellenan, y con swap_bytes los números se invierten de orden.
+ */
+class RecordConverter {
+private:
+    enum StepKind {
+        STEP_COPY,
+        STEP_SWAP32,
+        STEP_SWAP64,
+        STEP_INT_TO_DOUBLE,
+        STEP_DOUBLE_TO_INT,
+        STEP_CHARS
+    };
+
+    struct Step {
+        uint32_t kind;
+        uint32_t source_offset;
+        uint32_t target_offset;
+        uint32_t source_size;
+        uint32_t target_size;
+        bool swap;
+    };
+
+    std::vector<Step> steps;
+    size_t source_size;
+    size_t target_size;
+    bool identity;
+
+public:
+    RecordConverter();
+
+    /**
+     * @brief Preparar la conversión
+     * @param swap_bytes El origen usa el orden de bytes opuesto al del host
+     * @return false si algún campo común tiene tipos incompatibles
+     */
+    bool build(const RecordSchema& source, const RecordSchema& target, bool swap_bytes);
+
+    /**
+     * @brief Los layouts coinciden: convert() es un memcpy
+     */
+    bool is_identity() const { return identity; }
+
+    /**
+     * @brief Convertir count registros contiguos (origen y destino no se solapan)
+     */
+    void convert(const char* source, size_t count, char* target) const;
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_RECORD_SCHEMA_H
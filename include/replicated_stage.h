@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DISTRIBUTED_REPLICATED_STAGE_H
+#define DISTRIBUTED_REPLICATED_STAGE_H
+
+#include "interfaces.h"
+#include "isolated_process.h"
+#include "types.h"
+#include <string>
+#include <vector>
+
+namespace distributed {
+
+/**
+ * @brief Etapa servida por varias réplicas de IsolatedPluginProcess
+ *
+ * Un solo proceso de plugin limita una etapa pesada a un núcleo. Aquí la
+ * etapa arranca N procesos idénticos y cada lote va a la réplica con
+ * menos peticiones pendientes (empates en round robin), así que con N
+ * lotes en vuelo trabajan N núcleos. El estado que el plugin acumula
+ * queda repartido entre réplicas; reduce_state() lo reúne en la réplica
+ * principal con los hooks export/merge_plugin_state.
+ */
+class ReplicatedStage : public IPipelinedComponent {
+private:
+    /**
+     * @brief Petición propia y dónde se está procesando
+     */
+    struct PendingRequest {
+        uint32_t request;
+        size_t replica;
+        uint32_t replica_request;
+    };
+
+    std::string stage_name;
+    std::vector<IsolatedPluginProcess*> replicas;
+    std::vector<PendingRequest> pending;
+    std::vector<ShmRing*> response_rings;  ///< Para esperar a todas las réplicas a la vez
+    uint32_t next_request;
+    size_t next_replica;                   ///< Desempate round robin
+    mutable ComponentMetrics metrics;      ///< Suma de las réplicas, recalculada al leerla
+
+    // No copiable: posee los procesos
+    ReplicatedStage(const ReplicatedStage&);
+    ReplicatedStage& operator=(const ReplicatedStage&);
+
+public:
+    static const size_t MAX_REPLICAS = 64;
+
+    /**
+     * @brief Constructor
+     * @param name Nombre de la etapa
+     * @param stages Etapas que ejecuta cada réplica (una, o varias fusionadas)
+     * @param replica_count Procesos a arrancar (al menos 1)
+     */
+    ReplicatedStage(const std::string& name, const std::vector<HostedStage>& stages,
+                    size_t replica_count);
+
+    virtual ~ReplicatedStage();
+
+    /**
+     * @brief Lotes en vuelo por réplica (antes de start())
+     */
+    void set_pipeline_depth(size_t depth);
+
+    /**
+     * @brief Región del pool que heredan las réplicas (antes de start())
+     */
+    void attach_batch_region(const SharedMemoryRegion* region);
+
+    /**
+     * @brief Arrancar todas las réplicas
+     */
+    bool start();
+
+    /**
+     * @brief Reunir el estado y terminar todas las réplicas
+     */
+    void terminate();
+
+    /**
+     * @brief Reiniciar las réplicas caídas
+     */
+    bool restart();
+
+    /**
+     * @brief Mover el estado parcial de cada réplica a la principal
+     *
+     * Solo sin lotes en vuelo. Las etapas sin hooks de reduce se saltan.
+     */
+    bool reduce_state();
+
+    size_t get_replica_count() const { return replicas.size(); }
+    IsolatedPluginProcess* get_replica(size_t index) const { return replicas[index]; }
+
+    // Implementación de IPipelinedComponent
+    virtual uint32_t submit_batch(RecordBatch* batch);
+    virtual uint32_t collect_completion(int timeout_ms, RecordBatch** batch, int* result);
+    virtual void abandon_in_flight(std::vector<RecordBatch*>* touched = NULL);
+    virtual size_t get_in_flight() const { return pending.size(); }
+    virtual size_t get_max_in_flight() const;
+    virtual void get_response_rings(std::vector<ShmRing*>& rings);
+
+    // Implementación de IProcessingComponent
+    virtual int process_batch(RecordBatch* batch);
+    virtual const std::string& get_name() const { return stage_name; }
+    virtual bool is_healthy() const;
+    virtual const ComponentMetrics* get_metrics() const;
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_REPLICATED_STAGE_H
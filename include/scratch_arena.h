@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISTRIBUTED_SCRATCH_ARENA_H
+#define DISTRIBUTED_SCRATCH_ARENA_H
+
+#include "plugin_api.h"
+
+namespace distributed {
+
+/**
+ * @brief Arena bump que respalda el PluginScratch de un proceso de plugin
+ *
+ * Los plugins asignan con un incremento de puntero; reset() se llama al
+ * terminar cada process_batch y solo reposiciona el cursor. Si un lote
+ * desborda el bloque principal se encadenan bloques extra, y en el
+ * siguiente reset() el bloque principal crece para que los próximos lotes
+ * vuelvan al camino rápido sin asignar.
+ */
+class ScratchArena {
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    PluginScratch scratch;
+    Chunk* primary;
+    Chunk* overflow;        ///< Bloques extra del lote en curso
+    size_t overflow_bytes;
+    char* chunk_start;      ///< Inicio del bloque en uso
+    size_t retired_bytes;   ///< Bytes usados en bloques ya agotados durante el lote
+    size_t high_water;
+    size_t slow_allocations;
+
+    static Chunk* new_chunk(size_t size);
+    static char* chunk_data(Chunk* chunk);
+
+    /**
+     * @brief Camino lento invocado desde plugin_scratch_alloc
+     */
+    static void* allocate_slow(PluginScratch* scratch, size_t size);
+
+public:
+    static const size_t DEFAULT_SIZE = 256 * 1024;
+
+    /**
+     * @brief Constructor
+     * @param initial_size Tamaño inicial del bloque principal
+     */
+    explicit ScratchArena(size_t initial_size = DEFAULT_SIZE);
+    ~ScratchArena();
+
+    /**
+     * @brief Descriptor que se publica en PluginContext::scratch
+     */
+    PluginScratch* get_scratch() { return &scratch; }
+
+    /**
+     * @brief Descartar todo lo asignado (O(1) salvo tras un desborde)
+     */
+    void reset();
+
+    /**
+     * @brief Bytes asignados desde el último reset
+     */
+    size_t get_used() const;
+
+    /**
+     * @brief Tamaño del bloque principal
+     */
+    size_t get_capacity() const { return primary->size; }
+
+    /**
+     * @brief Máximo de bytes usados por un solo lote
+     */
+    size_t get_high_water() const { return high_water; }
+
+    /**
+     * @brief Asignaciones que tuvieron que salir del camino rápido
+     */
+    size_t get_slow_allocations() const { return slow_allocations; }
+};
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_SCRATCH_ARENA_H
@@ -22,9 +22,14 @@
 
 #include "types.h"
 #include <cstddef>
+#include <vector>
+#include <stdint.h>
 
 namespace distributed {
 
+class ColumnarBatch;
+class RecordSchema;
+
 /**
  * @brief Serializador eficiente para comunicación entre procesos
  * 
@@ -33,6 +38,10 @@ namespace distributed {
  */
 class Serializer {
 public:
+    // Los dos formatos de lote llevan un header versionado con CRC32C del
+    // payload y del propio header; la deserialización rechaza cualquier byte
+    // alterado. Ver Crc32c para el costo (acelerado por hardware en x86-64).
+
     /**
      * @brief Serializar un lote de registros
      * @param batch Lote a serializar
@@ -69,6 +78,289 @@ public:
      * @brief Validar integridad de datos serializados
      */
     static bool validate_serialized_data(const char* buffer, size_t size);
+
+    // El formato de registros lleva el esquema de sus registros (ver
+    // RecordSchema). Si coincide con el de este binario los registros se
+    // copian tal cual; si no (otra versión del nodo u otro orden de bytes)
+    // deserialize_batch los convierte campo a campo. También se aceptan
+    // lotes de la versión anterior, sin esquema.
+
+    /**
+     * @brief Tamaño de count registros con un esquema dado
+     */
+    static size_t calculate_record_batch_size(size_t count, const RecordSchema& schema);
+
+    /**
+     * @brief Serializar registros de cualquier tipo descrito por un RecordSchema
+     * @param records count registros contiguos con el layout de schema
+     * @return Bytes escritos, 0 si error
+     */
+    static size_t serialize_records(const void* records, size_t count, size_t capacity, int batch_id,
+                                    const RecordSchema& schema, char* buffer, size_t buffer_size);
+
+    // =========================================================================
+    // FORMATO COMPACTO (COLUMNAR, NOMBRES DE LONGITUD VARIABLE)
+    // =========================================================================
+    //
+    // [header][values][ids][categories][name_codes?][name_offsets][name_data]
+    //
+    // Cada nombre ocupa solo sus bytes reales en lugar de los 100 fijos de
+    // DatabaseRecord::name, así que un registro típico pasa de 120 a unos
+    // 30 bytes. Los lotes filas y columnares producen el mismo wire. Un
+    // lote columnar con diccionario agrega name_codes y envía cada nombre
+    // distinto una sola vez; los lectores de filas resuelven los códigos.
+
+    /**
+     * @brief Calcular tamaño del formato compacto para un lote de filas
+     */
+    static size_t calculate_compact_batch_size(const RecordBatch* batch);
+
+    /**
+     * @brief Serializar un lote de filas en formato compacto
+     * @return Bytes escritos, 0 si error
+     */
+    static size_t serialize_batch_compact(const RecordBatch* batch, char* buffer, size_t buffer_size);
+
+    /**
+     * @brief Deserializar formato compacto a filas (nombres truncados a 99 bytes)
+     * @param size Bytes disponibles en buffer
+     */
+    static bool deserialize_batch_compact(const char* buffer, size_t size, RecordBatch* batch);
+
+    /**
+     * @brief Calcular tamaño del formato compacto para un lote columnar
+     */
+    static size_t calculate_columnar_batch_size(const ColumnarBatch& batch);
+
+    /**
+     * @brief Serializar un lote columnar (una copia por columna)
+     * @return Bytes escritos, 0 si error
+     */
+    static size_t serialize_columnar_batch(const ColumnarBatch& batch, char* buffer, size_t buffer_size);
+
+    /**
+     * @brief Deserializar formato compacto a un lote columnar
+     */
+    static bool deserialize_columnar_batch(const char* buffer, size_t size, ColumnarBatch& batch);
+
+    /**
+     * @brief Verificar si un buffer contiene un lote en formato compacto
+     */
+    static bool is_compact_batch(const char* buffer, size_t size);
+
+    /**
+     * @brief Número de filas de un lote compacto (0 si el header no es válido)
+     */
+    static size_t get_compact_batch_count(const char* buffer, size_t size);
+
+    /**
+     * @brief Tamaño total de un lote compacto a partir de su header
+     *
+     * Basta con los primeros get_compact_header_size() bytes, lo que permite
+     * leer el resto de un socket sin prefijo de longitud.
+     * @return 0 si el header no es válido
+     */
+    static size_t get_compact_batch_size(const char* buffer, size_t size);
+
+    /**
+     * @brief Bytes del header del formato compacto
+     */
+    static size_t get_compact_header_size();
+
+    /**
+     * @brief Recalcular los CRC de un lote compacto modificado en sitio
+     *
+     * Para quien edita columnas o bytes de nombres directamente en el
+     * buffer sin cambiar el layout (p. ej. un plugin columnar sobre la
+     * memoria compartida).
+     * @return false si el header no es válido o el buffer es más corto
+     */
+    static bool reseal_compact_batch(char* buffer, size_t size);
+
+    // =========================================================================
+    // COMPRESIÓN DE BLOQUE (FORMATO COMPACTO)
+    // =========================================================================
+    //
+    // Un lote compacto puede viajar con su payload comprimido por BlockCodec;
+    // el header lo indica con una bandera y conserva los tamaños originales.
+    // Los deserializadores compactos aceptan ambos y descomprimen solos; la
+    // vista sin copia solo acepta lotes sin comprimir. El receptor responde
+    // con la misma codificación que recibió.
+
+    /**
+     * @brief Comprimir un lote compacto sin comprimir
+     *
+     * Si el payload no baja al menos 1/8 se abandona la compresión en
+     * cuanto se sabe, y el lote debe enviarse tal cual.
+     * @param out_size Con size bytes siempre alcanza
+     * @return Bytes escritos en out, 0 si no compensa o el lote no es válido
+     */
+    static size_t compress_compact_batch(const char* buffer, size_t size, char* out, size_t out_size);
+
+    /**
+     * @brief Descomprimir un lote compacto comprimido
+     * @param out_size Al menos get_uncompressed_batch_size() bytes
+     * @return Bytes del lote sin comprimir, 0 si error
+     */
+    static size_t decompress_compact_batch(const char* buffer, size_t size, char* out, size_t out_size);
+
+    /**
+     * @brief Verificar si un lote compacto viaja comprimido (basta el header)
+     */
+    static bool is_compressed_batch(const char* buffer, size_t size);
+
+    /**
+     * @brief Tamaño sin comprimir de un lote compacto (0 si el header no es válido)
+     */
+    static size_t get_uncompressed_batch_size(const char* buffer, size_t size);
+
+    // =========================================================================
+    // COLUMNAS NUMÉRICAS CODIFICADAS (FORMATO COMPACTO)
+    // =========================================================================
+    //
+    // Para enlaces de red: ids como deltas varint, categorías empaquetadas
+    // en bits sobre su mínimo y, opcionalmente, values con XOR estilo
+    // Gorilla (ver ColumnCodec). Nombres, códigos y desplazamientos viajan
+    // igual. Se puede comprimir encima; expand_compact_batch deshace ambas
+    // etapas y los deserializadores compactos lo hacen solos.
+
+    /**
+     * @brief Codificar las columnas numéricas de un lote compacto sin comprimir
+     * @param xor_values Probar XOR en values (se descarta si no ahorra)
+     * @param out_size Con size bytes siempre alcanza
+     * @return Bytes escritos en out, 0 si no ahorra o el lote no es válido
+     */
+    static size_t encode_compact_batch(const char* buffer, size_t size, char* out, size_t out_size,
+                                       bool xor_values = true);
+
+    /**
+     * @brief Decodificar un lote con columnas codificadas (sin comprimir)
+     * @param out_size Al menos get_decoded_batch_size() bytes
+     * @return Bytes del lote decodificado, 0 si error
+     */
+    static size_t decode_compact_batch(const char* buffer, size_t size, char* out, size_t out_size);
+
+    /**
+     * @brief Verificar si un lote compacto lleva columnas codificadas (basta el header)
+     */
+    static bool is_encoded_batch(const char* buffer, size_t size);
+
+    /**
+     * @brief Tamaño del lote una vez descomprimido y decodificado (0 si el header no es válido)
+     */
+    static size_t get_decoded_batch_size(const char* buffer, size_t size);
+
+    /**
+     * @brief Deshacer compresión y codificación de columnas de un lote compacto
+     * @param storage Recibe el lote expandido si hubo algo que deshacer
+     * @param plain_size Bytes del lote expandido
+     * @return El propio buffer si ya estaba expandido, &storage[0] si no,
+     *         NULL si algún paso falla
+     */
+    static const char* expand_compact_batch(const char* buffer, size_t size, std::vector<char>& storage,
+                                            size_t& plain_size);
+};
+
+/**
+ * @brief Vista de solo lectura sobre un lote serializado, sin copiar registros
+ *
+ * open() valida el header, el CRC32C del payload y los límites de todas
+ * las secciones (en el formato compacto también desplazamientos y códigos
+ * de nombres), así que después cada acceso por fila solo comprueba el
+ * índice. Acepta el formato de registros fijos de serialize_batch y el
+ * compacto expandido (ver expand_compact_batch). Los punteros a
+ * registros y columnas solo se exponen si el buffer está alineado a 8; los
+ * accesos por fila funcionan con cualquier alineación. El buffer debe
+ * sobrevivir a la vista.
+ */
+class SerializedBatchView {
+public:
+    enum Format {
+        NO_FORMAT,
+        RECORD_FORMAT,     ///< serialize_batch: DatabaseRecord[] tras el header
+        COMPACT_FORMAT     ///< serialize_batch_compact / serialize_columnar_batch
+    };
+
+private:
+    const char* buffer;
+    size_t serialized_size;
+    Format format;
+    size_t count;
+    int batch_id;
+    bool aligned;
+    const char* records;
+    const char* values;
+    const char* ids;
+    const char* categories;
+    const char* codes;
+    const char* offsets;
+    const char* names;
+    size_t name_entries;
+
+    bool open_record_format(const char* data, size_t size);
+    bool open_compact_format(const char* data, size_t size);
+    size_t name_entry(size_t row) const;
+
+public:
+    SerializedBatchView();
+    SerializedBatchView(const char* data, size_t size);
+
+    /**
+     * @brief Validar un buffer y apuntar la vista a él
+     * @return false si el buffer no contiene un lote válido completo
+     */
+    bool open(const char* data, size_t size);
+
+    /**
+     * @brief Dejar la vista vacía
+     */
+    void reset();
+
+    bool is_valid() const { return format != NO_FORMAT; }
+    Format get_format() const { return format; }
+    size_t get_count() const { return count; }
+    int get_batch_id() const { return batch_id; }
+    bool is_aligned() const { return aligned; }
+
+    /**
+     * @brief Bytes del buffer que ocupa el lote
+     */
+    size_t get_serialized_size() const { return serialized_size; }
+
+    /**
+     * @brief Registros en sitio (RECORD_FORMAT alineado; NULL en otro caso)
+     */
+    const DatabaseRecord* get_records() const;
+
+    // Columnas en sitio (COMPACT_FORMAT alineado; NULL en otro caso)
+    const double* value_column() const;
+    const int* id_column() const;
+    const int* category_column() const;
+    const uint32_t* name_code_column() const;   ///< NULL también sin diccionario
+    const uint32_t* name_offset_column() const;
+    const char* name_bytes_data() const;
+    size_t get_name_entries() const { return name_entries; }
+
+    // Acceso por fila (cualquier formato y alineación; 0/NULL fuera de rango)
+    int id_at(size_t row) const;
+    double value_at(size_t row) const;
+    int category_at(size_t row) const;
+
+    /**
+     * @brief Nombre de una fila (no necesariamente terminado en '\0')
+     */
+    const char* name_at(size_t row, size_t& length) const;
+
+    /**
+     * @brief Reconstruir el registro de una fila
+     * @return false si row está fuera de rango
+     */
+    bool get_record(size_t row, DatabaseRecord& record) const;
+
+    /**
+     * @brief Materializar la vista en un lote de filas
+     */
+    bool copy_to(RecordBatch* batch) const;
 };
 
 } // namespace distributed
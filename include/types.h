@@ -40,6 +40,11 @@ struct DatabaseRecord {
     int category;
 
     DatabaseRecord();
+
+    /**
+     * @brief Copiar un nombre no terminado, truncado a sizeof(name) - 1
+     */
+    void set_name(const char* text, size_t length);
 };
 
 /**
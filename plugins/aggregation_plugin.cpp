@@ -26,6 +26,7 @@
 #include <cmath>
 #include <memory>
 #include <pthread.h>
+#include "plugin_api.h"
 
 struct DatabaseRecord {
     int id;
@@ -40,13 +41,6 @@ struct RecordBatch {
     size_t capacity;
 };
 
-struct PluginContext {
-    void* user_data;
-    const char* config_params;
-    void (*log_info)(const char* message);
-    void (*log_error)(const char* message);
-};
-
 struct AggregationData {
     double total_sum;
     double total_sum_squared;
@@ -57,6 +51,28 @@ struct AggregationData {
     pthread_mutex_t mutex;
 };
 
+// Estado parcial que una réplica entrega a la principal en el reduce
+struct AggregationState {
+    double total_sum;
+    double total_sum_squared;
+    uint64_t total_count;
+    double min_value;
+    double max_value;
+};
+
+// Acumular estadísticas de un lote en las globales de forma thread-safe
+static void accumulate_batch(AggregationData* data, double batch_sum, double batch_sum_squared,
+                             double batch_min, double batch_max, size_t count) {
+    pthread_mutex_lock(&data->mutex);
+    data->total_sum += batch_sum;
+    data->total_sum_squared += batch_sum_squared;
+    data->total_count += count;
+    
+    if (batch_min < data->min_value) data->min_value = batch_min;
+    if (batch_max > data->max_value) data->max_value = batch_max;
+    pthread_mutex_unlock(&data->mutex);
+}
+
 static void parse_config(const char* params, AggregationData* data) {
     data->compute_stats = true;
     
@@ -150,16 +166,73 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
         if (value > batch_max) batch_max = value;
     }
     
-    // Actualizar estadísticas globales de forma thread-safe
-    pthread_mutex_lock(&data->mutex);
-    data->total_sum += batch_sum;
-    data->total_sum_squared += batch_sum_squared;
-    data->total_count += batch->count;
+    accumulate_batch(data, batch_sum, batch_sum_squared, batch_min, batch_max, batch->count);
+    return 0;
+}
+
+// Solo lee la columna de valores: 8 bytes por registro en lugar de 120
+int process_columnar_batch(PluginColumnarBatch* batch, PluginContext* context) {
+    if (!batch || !context || !context->user_data) return -1;
     
-    if (batch_min < data->min_value) data->min_value = batch_min;
-    if (batch_max > data->max_value) data->max_value = batch_max;
+    AggregationData* data = static_cast<AggregationData*>(context->user_data);
+    
+    if (!data->compute_stats) return 0;
+    
+    double batch_sum = 0.0;
+    double batch_sum_squared = 0.0;
+    double batch_min = 1e9;
+    double batch_max = -1e9;
+    
+    const double* values = batch->values;
+    for (size_t i = 0; i < batch->count; i++) {
+        double value = values[i];
+        batch_sum += value;
+        batch_sum_squared += value * value;
+        
+        if (value < batch_min) batch_min = value;
+        if (value > batch_max) batch_max = value;
+    }
+    
+    accumulate_batch(data, batch_sum, batch_sum_squared, batch_min, batch_max, batch->count);
+    return 0;
+}
+
+size_t export_plugin_state(PluginContext* context, void* buffer, size_t capacity) {
+    if (!context || !context->user_data || !buffer || capacity < sizeof(AggregationState)) return 0;
+    
+    AggregationData* data = static_cast<AggregationData*>(context->user_data);
+    
+    pthread_mutex_lock(&data->mutex);
+    size_t written = 0;
+    if (data->total_count > 0) {
+        AggregationState state;
+        state.total_sum = data->total_sum;
+        state.total_sum_squared = data->total_sum_squared;
+        state.total_count = data->total_count;
+        state.min_value = data->min_value;
+        state.max_value = data->max_value;
+        memcpy(buffer, &state, sizeof(state));
+        written = sizeof(state);
+        
+        // Lo exportado pasa a la réplica principal: aquí se empieza de cero
+        data->total_sum = 0.0;
+        data->total_sum_squared = 0.0;
+        data->total_count = 0;
+        data->min_value = 1e9;
+        data->max_value = -1e9;
+    }
     pthread_mutex_unlock(&data->mutex);
+    return written;
+}
+
+int merge_plugin_state(PluginContext* context, const void* buffer, size_t size) {
+    if (!context || !context->user_data || !buffer || size != sizeof(AggregationState)) return -1;
     
+    AggregationData* data = static_cast<AggregationData*>(context->user_data);
+    AggregationState state;
+    memcpy(&state, buffer, sizeof(state));
+    accumulate_batch(data, state.total_sum, state.total_sum_squared,
+                     state.min_value, state.max_value, static_cast<size_t>(state.total_count));
     return 0;
 }
 
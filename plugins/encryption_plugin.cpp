@@ -23,6 +23,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include "plugin_api.h"
 
 struct DatabaseRecord {
     int id;
@@ -37,13 +38,6 @@ struct RecordBatch {
     size_t capacity;
 };
 
-struct PluginContext {
-    void* user_data;
-    const char* config_params;
-    void (*log_info)(const char* message);
-    void (*log_error)(const char* message);
-};
-
 struct EncryptionData {
     char algorithm[20];
     int shift_key;
@@ -51,8 +45,8 @@ struct EncryptionData {
 };
 
 // Encriptación César simple (solo para demostración)
-static void caesar_encrypt(char* text, int shift) {
-    for (int i = 0; text[i] != '\0'; i++) {
+static void caesar_encrypt(char* text, size_t length, int shift) {
+    for (size_t i = 0; i < length; i++) {
         if (text[i] >= 'A' && text[i] <= 'Z') {
             text[i] = ((text[i] - 'A' + shift) % 26) + 'A';
         } else if (text[i] >= 'a' && text[i] <= 'z') {
@@ -136,7 +130,7 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
         
         // Encriptar solo el nombre (ejemplo)
         if (strcmp(data->algorithm, "CAESAR") == 0) {
-            caesar_encrypt(record.name, data->shift_key);
+            caesar_encrypt(record.name, strlen(record.name), data->shift_key);
         }
         
         data->records_encrypted++;
@@ -145,6 +139,23 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
     return 0;
 }
 
+// César conserva la longitud, así que cada entrada se cifra en sitio una sola vez
+int process_columnar_batch(PluginColumnarBatch* batch, PluginContext* context) {
+    if (!batch || !context || !context->user_data) return -1;
+    
+    EncryptionData* data = static_cast<EncryptionData*>(context->user_data);
+    
+    if (strcmp(data->algorithm, "CAESAR") == 0) {
+        for (size_t e = 0; e < batch->name_entries; e++) {
+            caesar_encrypt(batch->name_data + batch->name_offsets[e],
+                           batch->name_offsets[e + 1] - batch->name_offsets[e], data->shift_key);
+        }
+    }
+    
+    data->records_encrypted += batch->count;
+    return 0;
+}
+
 const char* get_plugin_info(const char* info_type) {
     if (!info_type) return NULL;
     
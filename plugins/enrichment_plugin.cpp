@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
+#include "plugin_api.h"
 
 struct DatabaseRecord {
     int id;
@@ -38,13 +39,6 @@ struct RecordBatch {
     size_t capacity;
 };
 
-struct PluginContext {
-    void* user_data;
-    const char* config_params;
-    void (*log_info)(const char* message);
-    void (*log_error)(const char* message);
-};
-
 struct EnrichmentData {
     double multiplication_factor;
     char suffix_format[50];
@@ -52,7 +46,9 @@ struct EnrichmentData {
     size_t records_enriched;
 };
 
-static void parse_config(const char* params, EnrichmentData* data) {
+static void parse_config(PluginContext* context, EnrichmentData* data) {
+    const char* params = context->config_params;
+    
     data->multiplication_factor = 1.1;
     strcpy(data->suffix_format, "_CAT%d");
     data->add_timestamp = false;
@@ -60,8 +56,16 @@ static void parse_config(const char* params, EnrichmentData* data) {
     
     if (!params) return;
     
-    char* params_copy = new char[strlen(params) + 1];
-    strcpy(params_copy, params);
+    // strtok necesita una copia modificable; el scratch se descarta al volver
+    // y sin él (hosts anteriores) la copia va al heap
+    char* heap_copy = NULL;
+    char* params_copy = plugin_scratch_strdup(context, params);
+    if (!params_copy) {
+        heap_copy = static_cast<char*>(malloc(strlen(params) + 1));
+        if (!heap_copy) return;
+        strcpy(heap_copy, params);
+        params_copy = heap_copy;
+    }
     
     char* token = strtok(params_copy, ",");
     while (token != NULL) {
@@ -83,7 +87,7 @@ static void parse_config(const char* params, EnrichmentData* data) {
         token = strtok(NULL, ",");
     }
     
-    delete[] params_copy;
+    free(heap_copy);
 }
 
 extern "C" {
@@ -92,7 +96,7 @@ int init_plugin(PluginContext* context) {
     if (!context) return -1;
     
     EnrichmentData* data = new EnrichmentData();
-    parse_config(context->config_params, data);
+    parse_config(context, data);
     context->user_data = data;
     
     if (context->log_info) {
@@ -124,6 +128,7 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
     if (!batch || !context || !context->user_data) return -1;
     
     EnrichmentData* data = static_cast<EnrichmentData*>(context->user_data);
+    char local_suffix[sizeof(batch->records[0].name)];
     
     for (size_t i = 0; i < batch->count; i++) {
         DatabaseRecord& record = batch->records[i];
@@ -131,9 +136,19 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
         // Aplicar factor de multiplicación al valor
         record.value *= data->multiplication_factor;
         
-        // Agregar sufijo al nombre
-        char suffix[20];
-        sprintf(suffix, data->suffix_format, record.category);
+        // Agregar sufijo al nombre; el formato es configurable, así que su
+        // longitud no está acotada y se formatea en el scratch del lote
+        const char* suffix = plugin_scratch_format(context, data->suffix_format, record.category);
+        if (!suffix) {
+            // Sin scratch basta un buffer del tamaño del nombre: un sufijo
+            // más largo tampoco cabría en el registro
+            int length = snprintf(local_suffix, sizeof(local_suffix), data->suffix_format, record.category);
+            if (length < 0 || static_cast<size_t>(length) >= sizeof(local_suffix)) {
+                data->records_enriched++;
+                continue;
+            }
+            suffix = local_suffix;
+        }
         
         size_t name_len = strlen(record.name);
         size_t suffix_len = strlen(suffix);
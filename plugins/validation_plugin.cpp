@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cctype>
+#include "plugin_api.h"
 
 // Definiciones de las estructuras (deben coincidir con el sistema principal)
 struct DatabaseRecord {
@@ -39,13 +40,6 @@ struct RecordBatch {
     size_t capacity;
 };
 
-struct PluginContext {
-    void* user_data;
-    const char* config_params;
-    void (*log_info)(const char* message);
-    void (*log_error)(const char* message);
-};
-
 // Estructura para datos privados del plugin
 struct ValidationData {
     bool strict_mode;
@@ -101,14 +95,14 @@ static void parse_config_params(const char* params, ValidationData* data) {
 }
 
 // Función para validar el formato del nombre
-static bool is_valid_name(const char* name) {
-    if (!name || strlen(name) == 0) return false;
+static bool is_valid_name(const char* name, size_t length) {
+    if (!name || length == 0) return false;
     
     // El nombre debe empezar con una letra
     if (!isalpha(name[0])) return false;
     
     // Solo puede contener letras, números y guiones bajos
-    for (size_t i = 1; i < strlen(name); i++) {
+    for (size_t i = 1; i < length; i++) {
         if (!isalnum(name[i]) && name[i] != '_') {
             return false;
         }
@@ -190,7 +184,7 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
         }
         
         // Validar nombre
-        if (!is_valid_name(record.name)) {
+        if (!is_valid_name(record.name, strlen(record.name))) {
             if (data->strict_mode) {
                 if (context->log_error) {
                     char msg[128];
@@ -246,6 +240,133 @@ int process_batch(RecordBatch* batch, PluginContext* context) {
     return 0; // Éxito
 }
 
+// Con nombres codificados con diccionario is_valid_name corre una vez por nombre distinto
+int process_columnar_batch(PluginColumnarBatch* batch, PluginContext* context) {
+    if (!batch || !context || !context->user_data) {
+        return -1; // Error: parámetros inválidos
+    }
+    
+    ValidationData* data = static_cast<ValidationData*>(context->user_data);
+    
+    // Estado por entrada: 0 = sin evaluar, 1 = válido, 2 = inválido
+    size_t entries = batch->name_entries;
+    size_t state_capacity = entries + 64;
+    unsigned char* name_state = static_cast<unsigned char*>(plugin_scratch_alloc(context, state_capacity));
+    if (!name_state) return -1;
+    memset(name_state, 0, state_capacity);
+    
+    for (size_t i = 0; i < batch->count; i++) {
+        data->records_validated++;
+        bool corrected = false;
+        
+        // Validar ID
+        int& id = batch->ids[i];
+        if (id < data->min_id || id > data->max_id) {
+            if (data->strict_mode) {
+                if (context->log_error) {
+                    char msg[128];
+                    sprintf(msg, "ID fuera de rango en registro %zu: %d", i, id);
+                    context->log_error(msg);
+                }
+                return -2; // Error: ID fuera de rango en modo estricto
+            } else {
+                // Corregir ID
+                if (id < data->min_id) id = data->min_id;
+                if (id > data->max_id) id = data->max_id;
+                corrected = true;
+            }
+        }
+        
+        // Validar nombre
+        size_t entry = plugin_columnar_name_entry(batch, i);
+        const char* name = batch->name_data + batch->name_offsets[entry];
+        size_t length = batch->name_offsets[entry + 1] - batch->name_offsets[entry];
+        if (name_state[entry] == 0) {
+            name_state[entry] = is_valid_name(name, length) ? 1 : 2;
+        }
+        if (name_state[entry] == 2) {
+            if (data->strict_mode) {
+                if (context->log_error) {
+                    char msg[160];
+                    snprintf(msg, sizeof(msg), "Nombre inválido en registro %zu: %.*s",
+                             i, static_cast<int>(length), name);
+                    context->log_error(msg);
+                }
+                return -3; // Error: nombre inválido en modo estricto
+            } else {
+                // Corregir nombre
+                char fixed[32];
+                int fixed_length = snprintf(fixed, sizeof(fixed), "Record_%d", id);
+                const uint32_t* codes_before = batch->name_codes;
+                if (!batch->set_name || batch->set_name(batch, i, fixed, fixed_length) != 0) {
+                    return -1;
+                }
+                
+                // set_name puede agregar entradas (sin estado aún) o activar el
+                // diccionario, que renumera todas las entradas
+                if (batch->name_codes != codes_before) {
+                    memset(name_state, 0, state_capacity);
+                }
+                if (batch->name_entries > state_capacity) {
+                    size_t grown_capacity = batch->name_entries * 2;
+                    unsigned char* grown = static_cast<unsigned char*>(
+                        plugin_scratch_alloc(context, grown_capacity));
+                    if (!grown) return -1;
+                    memset(grown, 0, grown_capacity);
+                    if (batch->name_codes == codes_before) {
+                        memcpy(grown, name_state, entries);
+                    }
+                    name_state = grown;
+                    state_capacity = grown_capacity;
+                }
+                entries = batch->name_entries;
+                corrected = true;
+            }
+        }
+        
+        // Validar valor
+        double& value = batch->values[i];
+        if (value < data->min_value || value > data->max_value) {
+            if (data->strict_mode) {
+                if (context->log_error) {
+                    char msg[128];
+                    sprintf(msg, "Valor fuera de rango en registro %zu: %.2f", i, value);
+                    context->log_error(msg);
+                }
+                return -4; // Error: valor fuera de rango en modo estricto
+            } else {
+                // Corregir valor
+                if (value < data->min_value) value = data->min_value;
+                if (value > data->max_value) value = data->max_value;
+                corrected = true;
+            }
+        }
+        
+        // Validar categoría
+        int& category = batch->categories[i];
+        if (category < 1 || category > 10) {
+            if (data->strict_mode) {
+                if (context->log_error) {
+                    char msg[128];
+                    sprintf(msg, "Categoría inválida en registro %zu: %d", i, category);
+                    context->log_error(msg);
+                }
+                return -5; // Error: categoría inválida en modo estricto
+            } else {
+                // Corregir categoría
+                category = 1; // Categoría por defecto
+                corrected = true;
+            }
+        }
+        
+        if (corrected) {
+            data->records_corrected++;
+        }
+    }
+    
+    return 0; // Éxito
+}
+
 const char* get_plugin_info(const char* info_type) {
     if (!info_type) return NULL;
     
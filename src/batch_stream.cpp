@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/batch_stream.cpp
+#include "batch_stream.h"
+#include "serialization.h"
+#include "crc32c.h"
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstddef>
+
+namespace distributed {
+
+const size_t BatchStreamWriter::DEFAULT_CHUNK_ROWS;
+const size_t BatchStreamWriter::MAX_CHUNK_ROWS;
+const uint64_t BatchStreamParser::MAX_RECORDS;
+
+namespace {
+
+const uint32_t STREAM_MAGIC = 0x48534244; // "DBSH"
+const uint16_t STREAM_VERSION = 1;
+
+struct BatchStreamHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint64_t total_count;
+    int32_t batch_id;
+    uint32_t chunk_rows;
+    uint32_t reserved;
+    uint32_t header_crc;
+};
+
+uint32_t stream_header_crc(const BatchStreamHeader& header) {
+    return Crc32c::compute(&header, offsetof(BatchStreamHeader, header_crc));
+}
+
+// Cota de un chunk compacto sin comprimir: columnas, offsets, códigos de
+// diccionario y nombres de longitud máxima
+size_t max_chunk_size(size_t rows) {
+    const size_t per_row = sizeof(double) + 2 * sizeof(int32_t) + 2 * sizeof(uint32_t) +
+                           (sizeof(((DatabaseRecord*)0)->name) - 1);
+    return Serializer::get_compact_header_size() + sizeof(uint32_t) + rows * per_row;
+}
+
+} // namespace
+
+// =============================================================================
+// Writers
+// =============================================================================
+
+bool SocketChunkWriter::write(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(socket_fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && errno == EINTR) continue;
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool BufferChunkWriter::write(const char* data, size_t size) {
+    buffer.insert(buffer.end(), data, data + size);
+    return true;
+}
+
+bool FileChunkWriter::write(const char* data, size_t size) {
+    return file && fwrite(data, 1, size, file) == size;
+}
+
+// =============================================================================
+// BatchStreamWriter
+// =============================================================================
+
+BatchStreamWriter::BatchStreamWriter(IChunkWriter* writer, size_t rows_per_chunk)
+    : sink(writer), chunk_rows(std::max<size_t>(1, std::min(rows_per_chunk, MAX_CHUNK_ROWS))),
+      column_encoding(false), compression(false), bytes_written(0) {
+}
+
+bool BatchStreamWriter::write_batch(const RecordBatch* batch) {
+    if (!sink || !batch || batch->count > batch->capacity) return false;
+    if (batch->count > 0 && !batch->records) return false;
+    if (batch->count > BatchStreamParser::MAX_RECORDS) return false;
+    
+    BatchStreamHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = STREAM_MAGIC;
+    header.version = STREAM_VERSION;
+    header.total_count = batch->count;
+    header.batch_id = batch->batch_id;
+    header.chunk_rows = static_cast<uint32_t>(chunk_rows);
+    header.header_crc = stream_header_crc(header);
+    
+    if (!sink->write(reinterpret_cast<const char*>(&header), sizeof(header))) return false;
+    bytes_written += sizeof(header);
+    
+    for (size_t offset = 0; offset < batch->count; offset += chunk_rows) {
+        size_t rows = std::min(chunk_rows, batch->count - offset);
+        if (!write_chunk(batch->records + offset, rows, batch->batch_id)) return false;
+    }
+    return true;
+}
+
+bool BatchStreamWriter::write_chunk(const DatabaseRecord* records, size_t count, int batch_id) {
+    // Ventana sobre el lote original: no se copian registros
+    RecordBatch window;
+    window.records = const_cast<DatabaseRecord*>(records);
+    window.count = count;
+    window.capacity = count;
+    window.batch_id = batch_id;
+    
+    // chunk y scratch conservan su capacidad entre llamadas
+    chunk.resize(Serializer::calculate_compact_batch_size(&window));
+    size_t size = Serializer::serialize_batch_compact(&window, &chunk[0], chunk.size());
+    if (size == 0) return false;
+    
+    if (column_encoding) {
+        scratch.resize(size);
+        size_t encoded = Serializer::encode_compact_batch(&chunk[0], size, &scratch[0], scratch.size());
+        if (encoded > 0) {
+            chunk.swap(scratch);
+            size = encoded;
+        }
+    }
+    if (compression) {
+        scratch.resize(size);
+        size_t compressed = Serializer::compress_compact_batch(&chunk[0], size, &scratch[0], scratch.size());
+        if (compressed > 0) {
+            chunk.swap(scratch);
+            size = compressed;
+        }
+    }
+    
+    if (!sink->write(&chunk[0], size)) return false;
+    bytes_written += size;
+    return true;
+}
+
+// =============================================================================
+// BatchStreamParser
+// =============================================================================
+
+BatchStreamParser::BatchStreamParser() {
+    reset();
+}
+
+void BatchStreamParser::reset() {
+    phase = READ_HEADER;
+    pending.clear();
+    pending_needed = sizeof(BatchStreamHeader);
+    total_count = 0;
+    received_count = 0;
+    batch_id = 0;
+    chunk_rows = 0;
+    next_chunk_rows = 0;
+    max_chunk_bytes = 0;
+    compressed_chunks = false;
+    encoded_chunks = false;
+    target = NULL;
+    growable_target = false;
+}
+
+BatchStreamParser::Status BatchStreamParser::fail() {
+    phase = BROKEN;
+    pending.clear();
+    return FAILED;
+}
+
+bool BatchStreamParser::set_target(RecordBatch* batch, bool growable) {
+    if (phase != READ_CHUNK_HEADER || target || !batch) return false;
+    if (!growable && total_count > 0 && (!batch->records || batch->capacity < total_count)) return false;
+    
+    target = batch;
+    growable_target = growable;
+    target->count = 0;
+    target->batch_id = batch_id;
+    return true;
+}
+
+BatchStreamParser::Status BatchStreamParser::feed(const char* data, size_t size, size_t& consumed) {
+    consumed = 0;
+    
+    for (;;) {
+        if (phase == BROKEN) return FAILED;
+        if (phase == READ_CHUNK_HEADER) {
+            if (!target) return HEADER_READY;
+            if (received_count == total_count) phase = DONE;
+        }
+        if (phase == DONE) return COMPLETE;
+        
+        size_t take = std::min(pending_needed - pending.size(), size - consumed);
+        pending.insert(pending.end(), data + consumed, data + consumed + take);
+        consumed += take;
+        if (pending.size() < pending_needed) return NEED_MORE;
+        
+        // El chunk ya llegó entero: solo entonces se pide sitio para él
+        if (phase == READ_CHUNK && target->capacity < get_required_capacity()) {
+            if (!growable_target) return fail();
+            return NEED_CAPACITY;
+        }
+        
+        bool ok;
+        switch (phase) {
+            case READ_HEADER:       ok = finish_header(); break;
+            case READ_CHUNK_HEADER: ok = finish_chunk_header(); break;
+            case READ_CHUNK:        ok = finish_chunk(); break;
+            default:                ok = false; break;
+        }
+        if (!ok) return fail();
+    }
+}
+
+bool BatchStreamParser::finish_header() {
+    BatchStreamHeader header;
+    memcpy(&header, &pending[0], sizeof(header));
+    
+    if (header.magic != STREAM_MAGIC || header.version != STREAM_VERSION) return false;
+    if (header.header_crc != stream_header_crc(header)) return false;
+    if (header.total_count > MAX_RECORDS) return false;
+    if (header.chunk_rows == 0 || header.chunk_rows > BatchStreamWriter::MAX_CHUNK_ROWS) return false;
+    
+    total_count = header.total_count;
+    batch_id = header.batch_id;
+    chunk_rows = header.chunk_rows;
+    max_chunk_bytes = max_chunk_size(chunk_rows);
+    
+    phase = READ_CHUNK_HEADER;
+    pending.clear();
+    pending_needed = Serializer::get_compact_header_size();
+    return true;
+}
+
+bool BatchStreamParser::finish_chunk_header() {
+    const size_t header_size = pending.size();
+    size_t chunk_size = Serializer::get_compact_batch_size(&pending[0], header_size);
+    size_t rows = Serializer::get_compact_batch_count(&pending[0], header_size);
+    
+    if (chunk_size < header_size || chunk_size > max_chunk_bytes) return false;
+    if (rows == 0 || rows > chunk_rows || rows > total_count - received_count) return false;
+    
+    compressed_chunks = compressed_chunks || Serializer::is_compressed_batch(&pending[0], header_size);
+    encoded_chunks = encoded_chunks || Serializer::is_encoded_batch(&pending[0], header_size);
+    
+    next_chunk_rows = rows;
+    phase = READ_CHUNK;
+    pending_needed = chunk_size;
+    return true;
+}
+
+bool BatchStreamParser::finish_chunk() {
+    // Cada chunk se expande directamente sobre su tramo del lote destino
+    RecordBatch window;
+    window.records = target->records + received_count;
+    window.capacity = next_chunk_rows;
+    
+    bool ok = Serializer::deserialize_batch_compact(&pending[0], pending.size(), &window) &&
+              window.batch_id == batch_id && window.count > 0 &&
+              window.count <= window.capacity;
+    if (!ok) return false;
+    
+    received_count += window.count;
+    target->count = static_cast<size_t>(received_count);
+    
+    phase = READ_CHUNK_HEADER;
+    pending.clear();
+    pending_needed = Serializer::get_compact_header_size();
+    return true;
+}
+
+} // namespace distributed
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/block_codec.cpp
+#include "block_codec.h"
+#include <cstring>
+#include <stdint.h>
+
+namespace distributed {
+
+const size_t BlockCodec::MAX_INPUT_SIZE;
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t LAST_LITERALS = 5;     // El bloque siempre termina en literales
+const size_t MATCH_FIND_LIMIT = 12; // Ninguna coincidencia empieza en los últimos 12 bytes
+const size_t MAX_DISTANCE = 65535;
+const int HASH_LOG = 13;
+const int SKIP_TRIGGER = 6;         // Tras 2^6 fallos el paso de búsqueda crece
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash_sequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_LOG);
+}
+
+// Longitud en el nibble del token más bytes de 255 para el resto
+inline unsigned char* write_length(unsigned char* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+inline bool read_length(const unsigned char*& ip, const unsigned char* iend, size_t& length) {
+    unsigned char byte;
+    do {
+        if (ip >= iend) return false;
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // anonymous namespace
+
+size_t BlockCodec::compress(const char* src, size_t size, char* dst, size_t capacity) {
+    if (!src || !dst || size > MAX_INPUT_SIZE) return 0;
+    
+    const unsigned char* const base = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* const iend = base + size;
+    const unsigned char* ip = base;
+    const unsigned char* anchor = base;
+    unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+    unsigned char* const oend = op + capacity;
+    
+    if (size >= MATCH_FIND_LIMIT + 1) {
+        const unsigned char* const mflimit = iend - MATCH_FIND_LIMIT;
+        const unsigned char* const matchlimit = iend - LAST_LITERALS;
+        uint32_t table[1 << HASH_LOG];
+        memset(table, 0, sizeof(table));
+        
+        table[hash_sequence(read32(ip))] = 0;
+        ip++;
+        
+        while (true) {
+            // Buscar una coincidencia; el paso crece con los fallos
+            const unsigned char* ref;
+            const unsigned char* forward = ip;
+            unsigned search = 1u << SKIP_TRIGGER;
+            do {
+                ip = forward;
+                forward = ip + (search++ >> SKIP_TRIGGER);
+                if (forward > mflimit) goto last_literals;
+                
+                uint32_t h = hash_sequence(read32(ip));
+                ref = base + table[h];
+                table[h] = static_cast<uint32_t>(ip - base);
+            } while (static_cast<size_t>(ip - ref) > MAX_DISTANCE || read32(ref) != read32(ip));
+            
+            // Extender hacia atrás sobre los literales pendientes
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            
+            {
+                size_t literals = ip - anchor;
+                if (static_cast<size_t>(oend - op) < 1 + literals + literals / 255 + 1 + 2 + LAST_LITERALS) {
+                    return 0;
+                }
+                unsigned char* token = op++;
+                if (literals >= 15) {
+                    *token = 15 << 4;
+                    op = write_length(op, literals - 15);
+                } else {
+                    *token = static_cast<unsigned char>(literals << 4);
+                }
+                memcpy(op, anchor, literals);
+                op += literals;
+                
+                while (true) {
+                    size_t offset = ip - ref;
+                    *op++ = static_cast<unsigned char>(offset);
+                    *op++ = static_cast<unsigned char>(offset >> 8);
+                    
+                    // Extender la coincidencia de 8 en 8 bytes
+                    const unsigned char* match_start = ip;
+                    ip += MIN_MATCH;
+                    ref += MIN_MATCH;
+                    while (ip + 8 <= matchlimit && read64(ip) == read64(ref)) {
+                        ip += 8;
+                        ref += 8;
+                    }
+                    while (ip < matchlimit && *ip == *ref) {
+                        ip++;
+                        ref++;
+                    }
+                    
+                    size_t match_length = ip - match_start - MIN_MATCH;
+                    if (static_cast<size_t>(oend - op) < match_length / 255 + 1 + LAST_LITERALS) {
+                        return 0;
+                    }
+                    if (match_length >= 15) {
+                        *token |= 15;
+                        op = write_length(op, match_length - 15);
+                    } else {
+                        *token |= static_cast<unsigned char>(match_length);
+                    }
+                    anchor = ip;
+                    
+                    if (ip > mflimit) goto last_literals;
+                    
+                    table[hash_sequence(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - base);
+                    
+                    // Probar en seguida la posición actual: evita un token vacío
+                    uint32_t h = hash_sequence(read32(ip));
+                    ref = base + table[h];
+                    table[h] = static_cast<uint32_t>(ip - base);
+                    if (static_cast<size_t>(ip - ref) > MAX_DISTANCE || read32(ref) != read32(ip)) {
+                        break;
+                    }
+                    if (static_cast<size_t>(oend - op) < 1 + 2 + LAST_LITERALS) {
+                        return 0;
+                    }
+                    token = op++;
+                    *token = 0;
+                }
+                ip++;
+            }
+        }
+    }
+    
+last_literals:
+    {
+        size_t literals = iend - anchor;
+        if (static_cast<size_t>(oend - op) < 1 + literals + literals / 255 + 1) {
+            return 0;
+        }
+        if (literals >= 15) {
+            *op++ = 15 << 4;
+            op = write_length(op, literals - 15);
+        } else {
+            *op++ = static_cast<unsigned char>(literals << 4);
+        }
+        memcpy(op, anchor, literals);
+        op += literals;
+    }
+    
+    return op - reinterpret_cast<unsigned char*>(dst);
+}
+
+bool BlockCodec::decompress(const char* src, size_t compressed_size, char* dst, size_t size) {
+    if (!src || !dst) return false;
+    
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* const iend = ip + compressed_size;
+    unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+    unsigned char* const ostart = op;
+    unsigned char* const oend = op + size;
+    
+    while (true) {
+        if (ip >= iend) return false;
+        const unsigned token = *ip++;
+        
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(ip, iend, literals)) return false;
+        if (literals > static_cast<size_t>(iend - ip) || literals > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+        
+        // La última secuencia solo lleva literales
+        if (ip == iend) {
+            return op == oend;
+        }
+        
+        if (iend - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - ostart)) return false;
+        
+        size_t match_length = token & 15;
+        if (match_length == 15 && !read_length(ip, iend, match_length)) return false;
+        match_length += MIN_MATCH;
+        if (match_length > static_cast<size_t>(oend - op)) return false;
+        
+        // Las coincidencias pueden solaparse con su propio destino
+        const unsigned char* match = op - offset;
+        if (offset >= 8 && static_cast<size_t>(oend - op) >= match_length + 8) {
+            unsigned char* const copy_end = op + match_length;
+            do {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < copy_end);
+            op = copy_end;
+        } else {
+            for (size_t i = 0; i < match_length; ++i) {
+                op[i] = match[i];
+            }
+            op += match_length;
+        }
+    }
+}
+
+} // namespace distributed
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/column_codec.cpp
+#include "column_codec.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace distributed {
+
+namespace {
+
+// Flujo de bits LSB primero; los valores se escriben de a lo sumo 32 bits
+class BitWriter {
+private:
+    unsigned char* ptr;
+    unsigned char* const end;
+    uint64_t acc;
+    unsigned fill;
+    bool overflow;
+
+    void flush_word() {
+        if (end - ptr < 8) {
+            overflow = true;
+            return;
+        }
+        for (int k = 0; k < 8; ++k) {
+            ptr[k] = static_cast<unsigned char>(acc >> (8 * k));
+        }
+        ptr += 8;
+    }
+
+public:
+    BitWriter(unsigned char* out, size_t capacity)
+        : ptr(out), end(out + capacity), acc(0), fill(0), overflow(false) {}
+
+    void put(uint32_t value, unsigned bits) {
+        acc |= static_cast<uint64_t>(value) << fill;
+        if (fill + bits >= 64) {
+            flush_word();
+            acc = static_cast<uint64_t>(value) >> (64 - fill);
+            fill = fill + bits - 64;
+        } else {
+            fill += bits;
+        }
+    }
+
+    void put64(uint64_t value, unsigned bits) {
+        if (bits > 32) {
+            put(static_cast<uint32_t>(value), 32);
+            put(static_cast<uint32_t>(value >> 32), bits - 32);
+        } else {
+            put(static_cast<uint32_t>(value), bits);
+        }
+    }
+
+    // Vacía los bits pendientes; false si en algún momento faltó espacio
+    bool finish(unsigned char* start, size_t& written) {
+        size_t tail = (fill + 7) / 8;
+        if (overflow || static_cast<size_t>(end - ptr) < tail) return false;
+        for (size_t k = 0; k < tail; ++k) {
+            ptr[k] = static_cast<unsigned char>(acc >> (8 * k));
+        }
+        written = (ptr - start) + tail;
+        return true;
+    }
+};
+
+class BitReader {
+private:
+    const unsigned char* ptr;
+    const unsigned char* const end;
+    uint64_t acc;
+    unsigned avail;
+    bool overrun;
+
+public:
+    BitReader(const unsigned char* in, size_t size)
+        : ptr(in), end(in + size), acc(0), avail(0), overrun(false) {}
+
+    uint32_t get(unsigned bits) {
+        if (avail < bits) {
+            while (avail <= 56 && ptr < end) {
+                acc |= static_cast<uint64_t>(*ptr++) << avail;
+                avail += 8;
+            }
+            if (avail < bits) {
+                overrun = true;
+                return 0;
+            }
+        }
+        uint32_t value = static_cast<uint32_t>(bits == 32 ? acc : acc & ((1ULL << bits) - 1));
+        acc >>= bits;
+        avail -= bits;
+        return value;
+    }
+
+    uint64_t get64(unsigned bits) {
+        if (bits > 32) {
+            uint64_t low = get(32);
+            return low | (static_cast<uint64_t>(get(bits - 32)) << 32);
+        }
+        return get(bits);
+    }
+
+    // Todo consumido salvo el relleno del último byte
+    bool exhausted() const {
+        return !overrun && ptr == end && avail < 8;
+    }
+
+    bool failed() const { return overrun; }
+};
+
+inline int32_t load_int32(const char* column, size_t row) {
+    int32_t value;
+    memcpy(&value, column + row * sizeof(int32_t), sizeof(value));
+    return value;
+}
+
+inline void store_int32(char* column, size_t row, uint32_t value) {
+    memcpy(column + row * sizeof(int32_t), &value, sizeof(value));
+}
+
+inline uint32_t zigzag_encode(uint32_t delta) {
+    return (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31);
+}
+
+inline uint32_t zigzag_decode(uint32_t value) {
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+inline bool read_varint(const unsigned char*& p, const unsigned char* end, uint32_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift <= 28; shift += 7) {
+        if (p >= end) return false;
+        unsigned char byte = *p++;
+        if (shift == 28 && byte > 0x0F) return false;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool decode_deltas_impl(const unsigned char* in, size_t size, char* column, size_t count, bool vector) {
+    const unsigned char* p = in;
+    const unsigned char* const end = in + size;
+    uint32_t previous = 0;
+    size_t row = 0;
+    
+#if defined(__SSE2__)
+    // Ocho deltas de un byte seguidos (ids casi secuenciales): zigzag y suma
+    // prefija en dos registros de cuatro lanes
+    if (vector) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi32(1);
+        while (row + 8 <= count && end - p >= 8) {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            if (word & 0x8080808080808080ULL) {
+                uint32_t value;
+                if (!read_varint(p, end, value)) return false;
+                previous += zigzag_decode(value);
+                store_int32(column, row++, previous);
+                continue;
+            }
+            
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+            __m128i words = _mm_unpacklo_epi8(bytes, zero);
+            __m128i low = _mm_unpacklo_epi16(words, zero);
+            __m128i high = _mm_unpackhi_epi16(words, zero);
+            low = _mm_xor_si128(_mm_srli_epi32(low, 1), _mm_sub_epi32(zero, _mm_and_si128(low, one)));
+            high = _mm_xor_si128(_mm_srli_epi32(high, 1), _mm_sub_epi32(zero, _mm_and_si128(high, one)));
+            
+            low = _mm_add_epi32(low, _mm_slli_si128(low, 4));
+            low = _mm_add_epi32(low, _mm_slli_si128(low, 8));
+            high = _mm_add_epi32(high, _mm_slli_si128(high, 4));
+            high = _mm_add_epi32(high, _mm_slli_si128(high, 8));
+            low = _mm_add_epi32(low, _mm_set1_epi32(static_cast<int>(previous)));
+            high = _mm_add_epi32(high, _mm_shuffle_epi32(low, 0xFF));
+            
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(column + row * sizeof(int32_t)), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(column + (row + 4) * sizeof(int32_t)), high);
+            previous = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_shuffle_epi32(high, 0xFF)));
+            p += 8;
+            row += 8;
+        }
+    }
+#else
+    (void)vector;
+#endif
+    
+    for (; row < count; ++row) {
+        uint32_t value;
+        if (!read_varint(p, end, value)) return false;
+        previous += zigzag_decode(value);
+        store_int32(column, row, previous);
+    }
+    return p == end;
+}
+
+} // anonymous namespace
+
+bool ColumnCodec::encode_deltas(const char* column, size_t count, unsigned char* out, size_t capacity,
+                                size_t& written) {
+    unsigned char* p = out;
+    unsigned char* const end = out + capacity;
+    uint32_t previous = 0;
+    
+    for (size_t row = 0; row < count; ++row) {
+        uint32_t current = static_cast<uint32_t>(load_int32(column, row));
+        uint32_t value = zigzag_encode(current - previous);
+        previous = current;
+        
+        while (value >= 0x80) {
+            if (p >= end) return false;
+            *p++ = static_cast<unsigned char>(value | 0x80);
+            value >>= 7;
+        }
+        if (p >= end) return false;
+        *p++ = static_cast<unsigned char>(value);
+    }
+    
+    written = p - out;
+    return true;
+}
+
+bool ColumnCodec::decode_deltas(const unsigned char* in, size_t size, char* column, size_t count) {
+    return decode_deltas_impl(in, size, column, count, true);
+}
+
+bool ColumnCodec::decode_deltas_portable(const unsigned char* in, size_t size, char* column, size_t count) {
+    return decode_deltas_impl(in, size, column, count, false);
+}
+
+bool ColumnCodec::pack_bits(const char* column, size_t count, unsigned char* out, size_t capacity,
+                            int32_t& base, uint32_t& bits, size_t& written) {
+    int32_t minimum = 0;
+    int32_t maximum = 0;
+    for (size_t row = 0; row < count; ++row) {
+        int32_t value = load_int32(column, row);
+        if (row == 0 || value < minimum) minimum = value;
+        if (row == 0 || value > maximum) maximum = value;
+    }
+    
+    uint32_t range = static_cast<uint32_t>(maximum) - static_cast<uint32_t>(minimum);
+    base = minimum;
+    bits = range == 0 ? 0 : 32 - __builtin_clz(range);
+    if (packed_size(count, bits) > capacity) return false;
+    
+    BitWriter writer(out, capacity);
+    for (size_t row = 0; row < count; ++row) {
+        writer.put(static_cast<uint32_t>(load_int32(column, row)) - static_cast<uint32_t>(base), bits);
+    }
+    return writer.finish(out, written);
+}
+
+bool ColumnCodec::unpack_bits(const unsigned char* in, size_t size, int32_t base, uint32_t bits,
+                              char* column, size_t count) {
+    if (bits > 32 || size != packed_size(count, bits)) return false;
+    
+    BitReader reader(in, size);
+    for (size_t row = 0; row < count; ++row) {
+        store_int32(column, row, static_cast<uint32_t>(base) + reader.get(bits));
+    }
+    return reader.exhausted();
+}
+
+// Cada valor: '0' si repite el anterior; '10' + bits significativos si el
+// XOR cabe en la ventana anterior; '11' + 5 bits de ceros iniciales +
+// 6 bits de longitud + bits significativos en otro caso
+bool ColumnCodec::encode_xor(const char* column, size_t count, unsigned char* out, size_t capacity,
+                             size_t& written) {
+    BitWriter writer(out, capacity);
+    uint64_t previous = 0;
+    unsigned previous_leading = 0;
+    unsigned previous_trailing = 0;
+    bool window = false;
+    
+    for (size_t row = 0; row < count; ++row) {
+        uint64_t current;
+        memcpy(&current, column + row * sizeof(double), sizeof(current));
+        if (row == 0) {
+            writer.put64(current, 64);
+            previous = current;
+            continue;
+        }
+        
+        uint64_t delta = current ^ previous;
+        previous = current;
+        if (delta == 0) {
+            writer.put(0, 1);
+            continue;
+        }
+        
+        unsigned leading = __builtin_clzll(delta);
+        unsigned trailing = __builtin_ctzll(delta);
+        if (leading > 31) leading = 31;
+        
+        if (window && leading >= previous_leading && trailing >= previous_trailing) {
+            writer.put(1, 2);   // '1' y luego '0'
+            writer.put64(delta >> previous_trailing, 64 - previous_leading - previous_trailing);
+        } else {
+            unsigned significant = 64 - leading - trailing;
+            writer.put(3, 2);
+            writer.put(leading, 5);
+            writer.put(significant - 1, 6);
+            writer.put64(delta >> trailing, significant);
+            previous_leading = leading;
+            previous_trailing = trailing;
+            window = true;
+        }
+    }
+    return writer.finish(out, written);
+}
+
+bool ColumnCodec::decode_xor(const unsigned char* in, size_t size, char* column, size_t count) {
+    BitReader reader(in, size);
+    uint64_t previous = 0;
+    unsigned previous_leading = 0;
+    unsigned previous_trailing = 0;
+    bool window = false;
+    
+    for (size_t row = 0; row < count; ++row) {
+        if (row == 0) {
+            previous = reader.get64(64);
+        } else if (reader.get(1)) {
+            if (reader.get(1)) {
+                unsigned leading = reader.get(5);
+                unsigned significant = reader.get(6) + 1;
+                if (leading + significant > 64) return false;
+                previous_leading = leading;
+                previous_trailing = 64 - leading - significant;
+                window = true;
+            } else if (!window) {
+                return false;
+            }
+            unsigned significant = 64 - previous_leading - previous_trailing;
+            previous ^= reader.get64(significant) << previous_trailing;
+        }
+        if (reader.failed()) return false;
+        memcpy(column + row * sizeof(double), &previous, sizeof(previous));
+    }
+    return reader.exhausted();
+}
+
+} // namespace distributed
@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// src/columnar_batch.cpp
+#include "columnar_batch.h"
+#include <cstring>
+
+namespace distributed {
+
+const size_t ColumnarBatch::MAX_NAME_LENGTH;
+
+// Alineación de cada columna dentro del buffer
+static const size_t COLUMN_ALIGNMENT = 64;
+
+// Bytes de nombre por fila que se reservan si no se indica otra cosa
+static const size_t DEFAULT_NAME_BYTES_PER_ROW = 16;
+
+static size_t align_column(size_t offset) {
+    return (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+}
+
+// FNV-1a: barato y suficiente para nombres cortos
+static uint32_t hash_name(const char* name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+ColumnarBatch::ColumnarBatch(size_t capacity, IMemoryPool* memory_pool, size_t name_capacity) 
+    : buffer(NULL), pool(memory_pool), ids(NULL), values(NULL), categories(NULL),
+      name_codes(NULL), name_offsets(NULL), offset_capacity(0), name_data(NULL),
+      name_bytes(0), name_capacity(0), name_entries(0), dictionary_names(false),
+      indexed_entries(0), count(0), capacity(capacity), batch_id(0) {
+    
+    // Un solo buffer: [ids][values][categories][name_codes], cada columna alineada
+    size_t ids_offset = 0;
+    size_t values_offset = align_column(ids_offset + capacity * sizeof(int));
+    size_t categories_offset = align_column(values_offset + capacity * sizeof(double));
+    size_t codes_offset = align_column(categories_offset + capacity * sizeof(int));
+    size_t total = codes_offset + capacity * sizeof(uint32_t) + COLUMN_ALIGNMENT;
+    
+    char* raw = allocate_bytes(total);
+    if (!raw) {
+        this->capacity = 0;
+        return;
+    }
+    buffer = raw;
+    
+    char* base = reinterpret_cast<char*>(align_column(reinterpret_cast<size_t>(raw)));
+    ids = reinterpret_cast<int*>(base + ids_offset);
+    values = reinterpret_cast<double*>(base + values_offset);
+    categories = reinterpret_cast<int*>(base + categories_offset);
+    name_codes = reinterpret_cast<uint32_t*>(base + codes_offset);
+    
+    // Desplazamientos y arena crecen aparte; con diccionario puede haber
+    // más entradas que filas si se renombran filas
+    if (!reserve_entries(capacity)) {
+        release_bytes(buffer);
+        buffer = NULL;
+        this->capacity = 0;
+        return;
+    }
+    reserve_name_bytes(name_capacity ? name_capacity : capacity * DEFAULT_NAME_BYTES_PER_ROW);
+}
+
+ColumnarBatch::~ColumnarBatch() {
+    release_bytes(name_data);
+    release_bytes(reinterpret_cast<char*>(name_offsets));
+    release_bytes(buffer);
+}
+
+char* ColumnarBatch::allocate_bytes(size_t bytes) {
+    if (pool) {
+        return static_cast<char*>(pool->allocate(bytes));
+    }
+    return new char[bytes];
+}
+
+void ColumnarBatch::release_bytes(char* ptr) {
+    if (!ptr) return;
+    if (pool) {
+        pool->deallocate(ptr);
+    } else {
+        delete[] ptr;
+    }
+}
+
+bool ColumnarBatch::reserve_entries(size_t entries) {
+    if (entries + 1 <= offset_capacity) return true;
+    
+    size_t new_capacity = offset_capacity ? offset_capacity * 2 : 64;
+    while (new_capacity < entries + 1) {
+        new_capacity *= 2;
+    }
+    
+    uint32_t* grown = reinterpret_cast<uint32_t*>(allocate_bytes(new_capacity * sizeof(uint32_t)));
+    if (!grown) return false;
+    
+    if (name_offsets) {
+        memcpy(grown, name_offsets, (name_entries + 1) * sizeof(uint32_t));
+        release_bytes(reinterpret_cast<char*>(name_offsets));
+    } else {
+        grown[0] = 0;
+    }
+    name_offsets = grown;
+    offset_capacity = new_capacity;
+    return true;
+}
+
+bool ColumnarBatch::reserve_name_bytes(size_t additional) {
+    size_t needed = name_bytes + additional;
+    if (needed <= name_capacity) return true;
+    
+    // Los desplazamientos son de 32 bits
+    if (needed > 0xFFFFFFFFu) return false;
+    
+    size_t new_capacity = name_capacity ? name_capacity * 2 : 256;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    
+    char* grown = allocate_bytes(new_capacity);
+    if (!grown) return false;
+    
+    if (name_bytes > 0) {
+        memcpy(grown, name_data, name_bytes);
+    }
+    release_bytes(name_data);
+    name_data = grown;
+    name_capacity = new_capacity;
+    return true;
+}
+
+void ColumnarBatch::reset_names() {
+    name_bytes = 0;
+    name_entries = 0;
+    name_offsets[0] = 0;
+    name_index.clear();
+    indexed_entries = 0;
+}
+
+bool ColumnarBatch::append_entry(const char* name, size_t length, uint32_t& code) {
+    if (!reserve_entries(name_entries + 1) || !reserve_name_bytes(length)) return false;
+    
+    if (length > 0) {
+        memcpy(name_data + name_bytes, name, length);
+    }
+    name_bytes += length;
+    code = static_cast<uint32_t>(name_entries);
+    name_entries++;
+    name_offsets[name_entries] = static_cast<uint32_t>(name_bytes);
+    return true;
+}
+
+void ColumnarBatch::index_entry(uint32_t code) {
+    size_t mask = name_index.size() - 1;
+    size_t slot = hash_name(name_data + name_offsets[code],
+                            name_offsets[code + 1] - name_offsets[code]) & mask;
+    while (name_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    name_index[slot] = code + 1;
+}
+
+bool ColumnarBatch::intern_name(const char* name, size_t length, uint32_t& code) {
+    // Mantener el factor de carga por debajo de 1/2; al crecer se rehace el índice
+    if ((name_entries + 1) * 2 > name_index.size()) {
+        size_t slots = name_index.empty() ? 256 : name_index.size();
+        while ((name_entries + 1) * 2 > slots) {
+            slots *= 2;
+        }
+        name_index.assign(slots, 0);
+        indexed_entries = 0;
+    }
+    while (indexed_entries < name_entries) {
+        index_entry(static_cast<uint32_t>(indexed_entries++));
+    }
+    
+    size_t mask = name_index.size() - 1;
+    size_t slot = hash_name(name, length) & mask;
+    while (name_index[slot] != 0) {
+        uint32_t candidate = name_index[slot] - 1;
+        size_t candidate_length = name_offsets[candidate + 1] - name_offsets[candidate];
+        if (candidate_length == length &&
+            memcmp(name_data + name_offsets[candidate], name, length) == 0) {
+            code = candidate;
+            return true;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    if (!append_entry(name, length, code)) return false;
+    name_index[slot] = code + 1;
+    indexed_entries = name_entries;
+    return true;
+}
+
+void ColumnarBatch::copy_name(size_t row, char* out, size_t size) const {
+    if (size == 0) return;
+    
+    size_t length = name_length(row);
+    if (length > size - 1) length = size - 1;
+    memcpy(out, name_at(row), length);
+    out[length] = '\0';
+}
+
+bool ColumnarBatch::append(int id, double value, int category, const char* name, size_t length) {
+    if (count >= capacity) return false;
+    
+    uint32_t code;
+    if (dictionary_names ? !intern_name(name, length, code) : !append_entry(name, length, code)) {
+        return false;
+    }
+    
+    ids[count] = id;
+    values[count] = value;
+    categories[count] = category;
+    name_codes[count] = code;
+    count++;
+    return true;
+}
+
+bool ColumnarBatch::append(const DatabaseRecord& record) {
+    return append(record.id, record.value, record.category,
+                  record.name, strnlen(record.name, sizeof(record.name)));
+}
+
+bool ColumnarBatch::encode_name_dictionary() {
+    if (dictionary_names) return true;
+    
+    // Copia de los nombres actuales; el arena se reconstruye con una entrada por nombre distinto
+    size_t old_bytes = name_bytes;
+    char* old_names = old_bytes > 0 ? allocate_bytes(old_bytes) : NULL;
+    uint32_t* old_offsets = reinterpret_cast<uint32_t*>(allocate_bytes((count + 1) * sizeof(uint32_t)));
+    if ((old_bytes > 0 && !old_names) || !old_offsets) {
+        release_bytes(old_names);
+        release_bytes(reinterpret_cast<char*>(old_offsets));
+        return false;
+    }
+    if (old_bytes > 0) {
+        memcpy(old_names, name_data, old_bytes);
+    }
+    memcpy(old_offsets, name_offsets, (count + 1) * sizeof(uint32_t));
+    
+    reset_names();
+    dictionary_names = true;
+    
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; ++i) {
+        ok = intern_name(old_names + old_offsets[i], old_offsets[i + 1] - old_offsets[i], name_codes[i]);
+    }
+    
+    release_bytes(old_names);
+    release_bytes(reinterpret_cast<char*>(old_offsets));
+    if (!ok) {
+        count = 0;
+        reset_names();
+    }
+    return ok;
+}
+
+bool ColumnarBatch::set_name(size_t row, const char* name, size_t length) {
+    if (row >= count || !encode_name_dictionary()) return false;
+    return intern_name(name, length, name_codes[row]);
+}
+
+void ColumnarBatch::get_record(size_t row, DatabaseRecord& record) const {
+    record.id = ids[row];
+    record.value = values[row];
+    record.category = categories[row];
+    record.set_name(name_at(row), name_length(row));
+}
+
+bool ColumnarBatch::load_columns(size_t rows, const int* id_values, const double* value_values,
+                                 const int* category_values, const uint32_t* codes, size_t entries,
+                                 const uint32_t* offsets, const char* names, size_t names_size) {
+    count = 0;
+    reset_names();
+    if (rows > capacity || (!codes && entries != rows)) return false;
+    if (offsets[0] != 0 || offsets[entries] != names_size) return false;
+    for (size_t e = 0; e < entries; ++e) {
+        if (offsets[e] > offsets[e + 1]) return false;
+    }
+    if (codes) {
+        for (size_t i = 0; i < rows; ++i) {
+            if (codes[i] >= entries) return false;
+        }
+    }
+    if (!reserve_entries(entries) || !reserve_name_bytes(names_size)) return false;
+    
+    memcpy(ids, id_values, rows * sizeof(int));
+    memcpy(values, value_values, rows * sizeof(double));
+    memcpy(categories, category_values, rows * sizeof(int));
+    if (codes) {
+        memcpy(name_codes, codes, rows * sizeof(uint32_t));
+    }
+    memcpy(name_offsets, offsets, (entries + 1) * sizeof(uint32_t));
+    if (names_size > 0) {
+        memcpy(name_data, names, names_size);
+    }
+    
+    count = rows;
+    name_entries = entries;
+    name_bytes = names_size;
+    dictionary_names = (codes != NULL);
+    return true;
+}
+
+bool ColumnarBatch::from_record_batch(const RecordBatch& batch, bool dictionary) {
+    count = 0;
+    reset_names();
+    dictionary_names = dictionary;
+    if (batch.count > capacity) return false;
+    
+    // Una pasada por columna: cada escritura es secuencial
+    const DatabaseRecord* records = batch.records;
+    for (size_t i = 0; i < batch.count; ++i) {
+        ids[i] = records[i].id;
+    }
+    for (size_t i = 0; i < batch.count; ++i) {
+        values[i] = records[i].value;
+    }
+    for (size_t i = 0; i < batch.count; ++i) {
+        categories[i] = records[i].category;
+    }
+    
+    if (dictionary) {
+        for (size_t i = 0; i < batch.count; ++i) {
+            if (!intern_name(records[i].name, strnlen(records[i].name, sizeof(records[i].name)),
+                             name_codes[i])) {
+                reset_names();
+                return false;
+            }
+        }
+    } else {
+        size_t total_name_bytes = 0;
+        for (size_t i = 0; i < batch.count; ++i) {
+            total_name_bytes += strnlen(records[i].name, sizeof(records[i].name));
+        }
+        if (!reserve_entries(batch.count) || !reserve_name_bytes(total_name_bytes)) return false;
+        
+        for (size_t i = 0; i < batch.count; ++i) {
+            size_t length = strnlen(records[i].name, sizeof(records[i].name));
+            memcpy(name_data + name_bytes, records[i].name, length);
+            name_bytes += length;
+            name_offsets[i + 1] = static_cast<uint32_t>(name_bytes);
+        }
+        name_entries = batch.count;
+    }
+    
+    count = batch.count;
+    batch_id = batch.batch_id;
+    return true;
+}
+
+bool ColumnarBatch::to_record_batch(RecordBatch& batch) const {
+    if (!batch.records || count > batch.capacity) return false;
+    
+    for (size_t i = 0; i < count; ++i) {
+        get_record(i, batch.records[i]);
+    }
+    
+    batch.count = count;
+    batch.batch_id = batch_id;
+    return true;
+}
+
+void ColumnarBatch::get_plugin_view(PluginColumnarBatch& view) {
+    // El plugin puede reescribir bytes de nombres: el índice ya no es fiable
+    name_index.clear();
+    indexed_entries = 0;
+    
+    view.count = count;
+    view.batch_id = batch_id;
+    view.ids = ids;
+    view.values = values;
+    view.categories = categories;
+    view.name_offsets = name_offsets;
+    view.name_data = name_data;
+    view.name_codes = name_code_column();
+    view.name_entries = name_entries;
+    view.set_name = plugin_set_name;
+    view.host_state = this;
+}
+
+int ColumnarBatch::plugin_set_name(PluginColumnarBatch* view, size_t row, const char* name, size_t length) {
+    ColumnarBatch* batch = static_cast<ColumnarBatch*>(view->host_state);
+    if (!batch->set_name(row, name, length)) return -1;
+    
+    // set_name puede haber reubicado el arena o activado el diccionario
+    view->name_offsets = batch->name_offsets;
+    view->name_data = batch->name_data;
+    view->name_codes = batch->name_code_column();
+    view->name_entries = batch->name_entries;
+    return 0;
+}
+
+} // namespace distributed
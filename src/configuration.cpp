@@ -35,7 +35,7 @@ FailoverConfig::FailoverConfig() {
     enable_circuit_breaker = true;
 }
 
-PipelineStageConfig::PipelineStageConfig() : enabled(true) {}
+PipelineStageConfig::PipelineStageConfig() : enabled(true), pipeline_depth(1), isolation(ISOLATION_PROCESS), replicas(1) {}
 
 ConfigurationManager::ConfigurationManager(const std::string& config_path) 
     : config_file_path(config_path) {}
@@ -93,6 +93,18 @@ bool ConfigurationManager::parse_config_line(const std::string& line, PipelineSt
     if (parts.size() > 6 && !parts[6].empty()) {
         config.failover_config.timeout_ms = atoi(parts[6].c_str());
     }
+    // Lotes en vuelo hacia el proceso del plugin (opcional)
+    if (parts.size() > 7 && !parts[7].empty()) {
+        config.pipeline_depth = atoi(parts[7].c_str());
+    }
+    // isolation=none: el plugin se carga en el proceso del nodo (opcional)
+    if (parts.size() > 8 && !parts[8].empty()) {
+        config.isolation = string_to_isolation(parts[8]);
+    }
+    // Réplicas del proceso del plugin (opcional)
+    if (parts.size() > 9 && !parts[9].empty()) {
+        config.replicas = atoi(parts[9].c_str());
+    }
     
     return true;
 }
@@ -117,6 +129,15 @@ std::string ConfigurationManager::policy_to_string(FailoverPolicy policy) {
     }
 }
 
+StageIsolation ConfigurationManager::string_to_isolation(const std::string& isolation_str) {
+    if (isolation_str == "none") return ISOLATION_NONE;
+    return ISOLATION_PROCESS; // Default: aislado
+}
+
+std::string ConfigurationManager::isolation_to_string(StageIsolation isolation) {
+    return isolation == ISOLATION_NONE ? "none" : "process";
+}
+
 bool ConfigurationManager::validate_configuration() const {
     // Validaciones básicas
     for (size_t i = 0; i < pipeline_stages.size(); ++i) {
@@ -130,6 +151,16 @@ bool ConfigurationManager::validate_configuration() const {
             stage.failover_config.timeout_ms <= 0) {
             return false;
         }
+        
+        if (stage.pipeline_depth < 1 ||
+            stage.pipeline_depth > static_cast<int>(IsolatedPluginProcess::MAX_PIPELINE_DEPTH)) {
+            return false;
+        }
+        
+        if (stage.replicas < 1 ||
+            stage.replicas > static_cast<int>(ReplicatedStage::MAX_REPLICAS)) {
+            return false;
+        }
     }
     
     return true;
@@ -146,7 +177,7 @@ bool ConfigurationManager::save_configuration(const std::string& filename) const
     }
     
     file << "# Configuración del Pipeline de Procesamiento Distribuido" << std::endl;
-    file << "# Formato: nombre|biblioteca|parámetros|habilitado|política_failover|max_retries|timeout_ms" << std::endl;
+    file << "# Formato: nombre|biblioteca|parámetros|habilitado|política_failover|max_retries|timeout_ms|pipeline_depth|isolation|replicas" << std::endl;
     file << "#" << std::endl;
     
     for (size_t i = 0; i < pipeline_stages.size(); ++i) {
@@ -158,7 +189,10 @@ bool ConfigurationManager::save_configuration(const std::string& filename) const
              << (stage.enabled ? "true" : "false") << "|"
              << policy_to_string(stage.failover_config.policy) << "|"
              << stage.failover_config.max_retries << "|"
-             << stage.failover_config.timeout_ms << std::endl;
+             << stage.failover_config.timeout_ms << "|"
+             << stage.pipeline_depth << "|"
+             << isolation_to_string(stage.isolation) << "|"
+             << stage.replicas << std::endl;
     }
     
     file.close();
@@ -176,9 +210,9 @@ bool ConfigurationManager::create_sample_config(const std::string& filename) {
     }
     
     file << "# Configuración de ejemplo del pipeline distribuido" << std::endl;
-    file << "validation|./plugins/libvalidation.so|strict_mode=false|true|RETRY_WITH_BACKOFF|3|10000" << std::endl;
-    file << "enrichment|./plugins/libenrichment.so|factor=1.1|true|SKIP_AND_CONTINUE|2|5000" << std::endl;
-    file << "aggregation|./plugins/libaggregation.so|compute_stats=true|true|ISOLATE_AND_CONTINUE|1|15000" << std::endl;
+    file << "validation|./plugins/libvalidation.so|strict_mode=false|true|RETRY_WITH_BACKOFF|3|10000|4" << std::endl;
+    file << "enrichment|./plugins/libenrichment.so|factor=1.1|true|SKIP_AND_CONTINUE|2|5000|4" << std::endl;
+    file << "aggregation|./plugins/libaggregation.so|compute_stats=true|true|ISOLATE_AND_CONTINUE|1|15000|1" << std::endl;
     
     file.close();
     return true;
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/crc32c.cpp
+#include "crc32c.h"
+#include <pthread.h>
+#include <cstring>
+
+namespace distributed {
+
+namespace {
+
+// Polinomio de Castagnoli reflejado
+const uint32_t CRC32C_POLY = 0x82F63B78;
+
+// Longitudes de bloque para los tres flujos intercalados por hardware
+const size_t CRC32C_LONG = 8192;
+const size_t CRC32C_SHORT = 256;
+
+uint32_t crc32c_table[8][256];
+uint32_t crc32c_long[4][256];
+uint32_t crc32c_short[4][256];
+bool crc32c_hardware = false;
+pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+// Multiplicar un vector por una matriz sobre GF(2)
+uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+void gf2_matrix_square(uint32_t* square, const uint32_t* mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+// Operador que avanza un CRC sobre len bytes en cero (len potencia de 2)
+void crc32c_zeros_op(uint32_t* even, size_t len) {
+    uint32_t odd[32];
+    odd[0] = CRC32C_POLY;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    gf2_matrix_square(even, odd);   // 2 bits
+    gf2_matrix_square(odd, even);   // 4 bits
+    do {
+        gf2_matrix_square(even, odd);
+        len >>= 1;
+        if (len == 0) {
+            return;
+        }
+        gf2_matrix_square(odd, even);
+        len >>= 1;
+    } while (len);
+
+    for (int n = 0; n < 32; n++) {
+        even[n] = odd[n];
+    }
+}
+
+// Tablas por byte del operador, para aplicarlo con cuatro consultas
+void crc32c_zeros(uint32_t zeros[][256], size_t len) {
+    uint32_t op[32];
+    crc32c_zeros_op(op, len);
+    for (uint32_t n = 0; n < 256; n++) {
+        zeros[0][n] = gf2_matrix_times(op, n);
+        zeros[1][n] = gf2_matrix_times(op, n << 8);
+        zeros[2][n] = gf2_matrix_times(op, n << 16);
+        zeros[3][n] = gf2_matrix_times(op, n << 24);
+    }
+}
+
+inline uint32_t crc32c_shift(uint32_t zeros[][256], uint32_t crc) {
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+           zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+void crc32c_init() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = n;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        crc32c_table[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t crc = crc32c_table[0][n];
+        for (int k = 1; k < 8; k++) {
+            crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+            crc32c_table[k][n] = crc;
+        }
+    }
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    crc32c_hardware = __builtin_cpu_supports("sse4.2");
+#endif
+    if (crc32c_hardware) {
+        crc32c_zeros(crc32c_long, CRC32C_LONG);
+        crc32c_zeros(crc32c_short, CRC32C_SHORT);
+    }
+}
+
+inline uint64_t load_le64(const unsigned char* p) {
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+           ((uint64_t)p[3] << 24) | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) |
+           ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+uint32_t crc32c_software(uint32_t crc, const unsigned char* next, size_t length) {
+    uint64_t crc0 = crc ^ 0xffffffff;
+
+    while (length && ((uintptr_t)next & 7) != 0) {
+        crc0 = crc32c_table[0][(crc0 ^ *next++) & 0xff] ^ (crc0 >> 8);
+        length--;
+    }
+    while (length >= 8) {
+        crc0 ^= load_le64(next);
+        crc0 = crc32c_table[7][crc0 & 0xff] ^
+               crc32c_table[6][(crc0 >> 8) & 0xff] ^
+               crc32c_table[5][(crc0 >> 16) & 0xff] ^
+               crc32c_table[4][(crc0 >> 24) & 0xff] ^
+               crc32c_table[3][(crc0 >> 32) & 0xff] ^
+               crc32c_table[2][(crc0 >> 40) & 0xff] ^
+               crc32c_table[1][(crc0 >> 48) & 0xff] ^
+               crc32c_table[0][crc0 >> 56];
+        next += 8;
+        length -= 8;
+    }
+    while (length) {
+        crc0 = crc32c_table[0][(crc0 ^ *next++) & 0xff] ^ (crc0 >> 8);
+        length--;
+    }
+    return (uint32_t)crc0 ^ 0xffffffff;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hardware_extend(uint32_t crc, const unsigned char* next, size_t length) {
+    uint64_t crc0 = crc ^ 0xffffffff;
+    uint64_t crc1;
+    uint64_t crc2;
+    uint64_t word;
+
+    while (length && ((uintptr_t)next & 7) != 0) {
+        crc0 = __builtin_ia32_crc32qi((uint32_t)crc0, *next++);
+        length--;
+    }
+
+    // Tres flujos independientes ocultan la latencia de 3 ciclos de crc32;
+    // los parciales se combinan desplazándolos sobre la longitud del bloque
+    while (length >= CRC32C_LONG * 3) {
+        crc1 = 0;
+        crc2 = 0;
+        const unsigned char* end = next + CRC32C_LONG;
+        do {
+            memcpy(&word, next, 8);
+            crc0 = __builtin_ia32_crc32di(crc0, word);
+            memcpy(&word, next + CRC32C_LONG, 8);
+            crc1 = __builtin_ia32_crc32di(crc1, word);
+            memcpy(&word, next + CRC32C_LONG * 2, 8);
+            crc2 = __builtin_ia32_crc32di(crc2, word);
+            next += 8;
+        } while (next < end);
+        crc0 = crc32c_shift(crc32c_long, (uint32_t)crc0) ^ crc1;
+        crc0 = crc32c_shift(crc32c_long, (uint32_t)crc0) ^ crc2;
+        next += CRC32C_LONG * 2;
+        length -= CRC32C_LONG * 3;
+    }
+
+    while (length >= CRC32C_SHORT * 3) {
+        crc1 = 0;
+        crc2 = 0;
+        const unsigned char* end = next + CRC32C_SHORT;
+        do {
+            memcpy(&word, next, 8);
+            crc0 = __builtin_ia32_crc32di(crc0, word);
+            memcpy(&word, next + CRC32C_SHORT, 8);
+            crc1 = __builtin_ia32_crc32di(crc1, word);
+            memcpy(&word, next + CRC32C_SHORT * 2, 8);
+            crc2 = __builtin_ia32_crc32di(crc2, word);
+            next += 8;
+        } while (next < end);
+        crc0 = crc32c_shift(crc32c_short, (uint32_t)crc0) ^ crc1;
+        crc0 = crc32c_shift(crc32c_short, (uint32_t)crc0) ^ crc2;
+        next += CRC32C_SHORT * 2;
+        length -= CRC32C_SHORT * 3;
+    }
+
+    while (length >= 8) {
+        memcpy(&word, next, 8);
+        crc0 = __builtin_ia32_crc32di(crc0, word);
+        next += 8;
+        length -= 8;
+    }
+    while (length) {
+        crc0 = __builtin_ia32_crc32qi((uint32_t)crc0, *next++);
+        length--;
+    }
+    return (uint32_t)crc0 ^ 0xffffffff;
+}
+#endif
+
+} // anonymous namespace
+
+uint32_t Crc32c::extend(uint32_t crc, const void* data, size_t length) {
+    pthread_once(&crc32c_once, crc32c_init);
+    const unsigned char* next = static_cast<const unsigned char*>(data);
+#if defined(__x86_64__)
+    if (crc32c_hardware) {
+        return crc32c_hardware_extend(crc, next, length);
+    }
+#endif
+    return crc32c_software(crc, next, length);
+}
+
+uint32_t Crc32c::extend_software(uint32_t crc, const void* data, size_t length) {
+    pthread_once(&crc32c_once, crc32c_init);
+    return crc32c_software(crc, static_cast<const unsigned char*>(data), length);
+}
+
+bool Crc32c::is_hardware_accelerated() {
+    pthread_once(&crc32c_once, crc32c_init);
+    return crc32c_hardware;
+}
+
+} // namespace distributed
@@ -20,17 +20,95 @@
 // src/distributed_node.cpp
 #include "distributed_node.h"
 #include "serialization.h"
+#include "batch_stream.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cerrno>
 
 namespace distributed {
 
+// Un lote compacto de varios cientos de KB no cabe en un solo segmento
+static bool send_all(int socket_fd, const void* data, size_t size) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(socket_fd, ptr, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && errno == EINTR) continue;
+            return false;
+        }
+        ptr += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+static bool recv_all(int socket_fd, void* data, size_t size) {
+    char* ptr = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = recv(socket_fd, ptr, size, 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) continue;
+            return false;
+        }
+        ptr += received;
+        size -= received;
+    }
+    return true;
+}
+
+// Leer un stream de lotes completo. Con storage, los registros se alojan
+// ahí a medida que llegan los chunks (el total del header lo elige el
+// emisor y no se reserva por adelantado); si no, van al lote ya provisto
+// por el llamador
+static bool recv_batch_stream(int socket_fd, BatchStreamParser& parser, RecordBatch* batch,
+                              std::vector<DatabaseRecord>* storage) {
+    char buffer[64 * 1024];
+    size_t filled = 0;
+    size_t offset = 0;
+    
+    for (;;) {
+        size_t consumed = 0;
+        BatchStreamParser::Status status = parser.feed(buffer + offset, filled - offset, consumed);
+        offset += consumed;
+        
+        if (status == BatchStreamParser::COMPLETE) return true;
+        if (status == BatchStreamParser::FAILED) return false;
+        if (status == BatchStreamParser::HEADER_READY) {
+            if (storage) {
+                storage->clear();
+                batch->records = NULL;
+                batch->capacity = 0;
+            }
+            if (!parser.set_target(batch, storage != NULL)) return false;
+            continue;
+        }
+        if (status == BatchStreamParser::NEED_CAPACITY) {
+            // Crecimiento geométrico, acotado por el total anunciado
+            size_t total = static_cast<size_t>(parser.get_total_count());
+            size_t capacity = std::min(total, std::max(parser.get_required_capacity(), storage->size() * 2));
+            storage->resize(capacity);
+            batch->records = &(*storage)[0];
+            batch->capacity = capacity;
+            continue;
+        }
+        
+        ssize_t received = recv(socket_fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) continue;
+            return false;
+        }
+        filled = static_cast<size_t>(received);
+        offset = 0;
+    }
+}
+
 DistributedNode::DistributedNode(const std::string& id, const std::string& ip, int port)
-    : node_id(id), local_ip(ip), local_port(port), server_socket(-1), server_active(true) {
+    : node_id(id), local_ip(ip), local_port(port), compression_default(false),
+      column_encoding_default(false), server_socket(-1), server_active(true) {
     pthread_mutex_init(&cluster_mutex, NULL);
 }
 
@@ -85,8 +163,11 @@ void DistributedNode::shutdown() {
     server_active = false;
     
     if (server_socket != -1) {
+        // close() no despierta a un accept() bloqueado; shutdown() sí
+        ::shutdown(server_socket, SHUT_RDWR);
         close(server_socket);
         pthread_join(server_thread, NULL);
+        server_socket = -1;
     }
 }
 
@@ -175,26 +256,24 @@ bool DistributedNode::send_batch_to_node(const std::string& target_node, RecordB
     target_addr.sin_port = htons(target_info.port);
     
     if (connect(client_socket, (struct sockaddr*)&target_addr, sizeof(target_addr)) == 0) {
-        // Serializar y enviar batch
-        char serialized_buffer[64 * 1024];
-        size_t serialized_size = Serializer::serialize_batch(batch, serialized_buffer, sizeof(serialized_buffer));
+        IPCMessage batch_msg;
+        batch_msg.type = IPCMessage::PROCESS_BATCH_STREAM;
+        batch_msg.sender_id = 0;
+        batch_msg.receiver_id = 0;
+        batch_msg.data_size = 0;
         
-        if (serialized_size > 0) {
-            IPCMessage batch_msg;
-            batch_msg.type = IPCMessage::PROCESS_BATCH;
-            batch_msg.sender_id = 0;
-            batch_msg.receiver_id = 0;
-            batch_msg.data_size = serialized_size;
-            
-            send(client_socket, &batch_msg, sizeof(IPCMessage), 0);
-            send(client_socket, serialized_buffer, serialized_size, 0);
-            
-            // Recibir respuesta
-            char response_buffer[64 * 1024];
-            ssize_t received = recv(client_socket, response_buffer, sizeof(response_buffer), 0);
-            
-            if (received > 0) {
-                Serializer::deserialize_batch(response_buffer, batch);
+        // El lote viaja en chunks compactos acotados: ni el emisor ni el
+        // receptor necesitan un buffer del tamaño del lote serializado.
+        // Cada chunk se codifica y comprime solo si el enlace lo pide
+        SocketChunkWriter socket_writer(client_socket);
+        BatchStreamWriter writer(&socket_writer);
+        writer.set_column_encoding(is_column_encoding_enabled(target_node));
+        writer.set_compression(is_compression_enabled(target_node));
+        
+        if (send_all(client_socket, &batch_msg, sizeof(IPCMessage)) && writer.write_batch(batch)) {
+            // La respuesta se expande directamente sobre el mismo lote
+            BatchStreamParser parser;
+            if (recv_batch_stream(client_socket, parser, batch, NULL)) {
                 close(client_socket);
                 return true;
             }
@@ -217,6 +296,46 @@ bool DistributedNode::process_batch_distributed(RecordBatch* batch) {
     }
 }
 
+void DistributedNode::set_compression(bool enabled) {
+    pthread_mutex_lock(&cluster_mutex);
+    compression_default = enabled;
+    pthread_mutex_unlock(&cluster_mutex);
+}
+
+void DistributedNode::set_link_compression(const std::string& target_node, bool enabled) {
+    pthread_mutex_lock(&cluster_mutex);
+    link_compression[target_node] = enabled;
+    pthread_mutex_unlock(&cluster_mutex);
+}
+
+bool DistributedNode::is_compression_enabled(const std::string& target_node) const {
+    pthread_mutex_lock(&cluster_mutex);
+    std::map<std::string, bool>::const_iterator it = link_compression.find(target_node);
+    bool enabled = (it != link_compression.end()) ? it->second : compression_default;
+    pthread_mutex_unlock(&cluster_mutex);
+    return enabled;
+}
+
+void DistributedNode::set_column_encoding(bool enabled) {
+    pthread_mutex_lock(&cluster_mutex);
+    column_encoding_default = enabled;
+    pthread_mutex_unlock(&cluster_mutex);
+}
+
+void DistributedNode::set_link_column_encoding(const std::string& target_node, bool enabled) {
+    pthread_mutex_lock(&cluster_mutex);
+    link_column_encoding[target_node] = enabled;
+    pthread_mutex_unlock(&cluster_mutex);
+}
+
+bool DistributedNode::is_column_encoding_enabled(const std::string& target_node) const {
+    pthread_mutex_lock(&cluster_mutex);
+    std::map<std::string, bool>::const_iterator it = link_column_encoding.find(target_node);
+    bool enabled = (it != link_column_encoding.end()) ? it->second : column_encoding_default;
+    pthread_mutex_unlock(&cluster_mutex);
+    return enabled;
+}
+
 std::vector<NodeInfo> DistributedNode::get_all_nodes() const {
     pthread_mutex_lock(&cluster_mutex);
     
@@ -329,6 +448,8 @@ void DistributedNode::handle_client(int client_socket) {
         send_cluster_info(client_socket);
     } else if (msg_header.type == IPCMessage::PROCESS_BATCH) {
         handle_distributed_batch(client_socket, msg_header.data_size);
+    } else if (msg_header.type == IPCMessage::PROCESS_BATCH_STREAM) {
+        handle_distributed_stream(client_socket);
     }
 }
 
@@ -351,15 +472,49 @@ void DistributedNode::send_cluster_info(int client_socket) {
 }
 
 void DistributedNode::handle_distributed_batch(int client_socket, size_t data_size) {
-    char* batch_buffer = (char*)malloc(data_size);
-    ssize_t received = recv(client_socket, batch_buffer, data_size, 0);
-    
-    if (received == (ssize_t)data_size) {
-        // Procesar batch localmente (simplificado)
-        send(client_socket, batch_buffer, data_size, 0);
+    std::vector<char> batch_buffer(data_size);
+    
+    if (data_size > 0 && recv_all(client_socket, &batch_buffer[0], data_size)) {
+        // Un lote comprimido o codificado se valida sobre su copia expandida
+        const char* plain = &batch_buffer[0];
+        size_t plain_size = data_size;
+        std::vector<char> plain_buffer;
+        if (Serializer::is_compact_batch(plain, plain_size)) {
+            plain = Serializer::expand_compact_batch(&batch_buffer[0], data_size, plain_buffer, plain_size);
+        }
+        
+        // Validar en sitio: sin copiar los registros a un RecordBatch
+        SerializedBatchView view(plain, plain_size);
+        if (view.is_valid()) {
+            // Procesar batch localmente (simplificado); la respuesta usa la
+            // misma codificación que la petición
+            send_all(client_socket, &batch_buffer[0], data_size);
+        } else {
+            std::cerr << "Lote distribuido inválido (" << data_size << " bytes)" << std::endl;
+        }
+    }
+}
+
+void DistributedNode::handle_distributed_stream(int client_socket) {
+    BatchStreamParser parser;
+    RecordBatch batch;
+    std::vector<DatabaseRecord> records;
+    
+    // La respuesta se envía cuando la petición está completa: emisor y
+    // receptor nunca escriben a la vez sobre el socket
+    if (!recv_batch_stream(client_socket, parser, &batch, &records)) {
+        std::cerr << "Stream de lote distribuido inválido (" << parser.get_received_count()
+                  << "/" << parser.get_total_count() << " registros)" << std::endl;
+        return;
     }
     
-    free(batch_buffer);
+    // Procesar batch localmente (simplificado); la respuesta usa la misma
+    // codificación que la petición
+    SocketChunkWriter socket_writer(client_socket);
+    BatchStreamWriter writer(&socket_writer);
+    writer.set_column_encoding(parser.has_encoded_chunks());
+    writer.set_compression(parser.has_compressed_chunks());
+    writer.write_batch(&batch);
 }
 
 void DistributedNode::parse_cluster_info(const char* buffer, size_t size) {
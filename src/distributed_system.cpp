@@ -20,6 +20,7 @@
 // src/distributed_system.cpp
 #include "distributed_system.h"
 #include <iostream>
+#include <algorithm>
 #include <unistd.h>
 #include <signal.h>
 #include <setjmp.h>
@@ -35,6 +36,9 @@
 
 namespace distributed {
 
+// Intervalo del trim de fondo del pool de memoria
+static const unsigned int MEMORY_TRIM_INTERVAL_MS = 30000;
+
 DistributedProcessingSystem::DistributedProcessingSystem(const std::string& node_id,
                                                        const std::string& ip,
                                                        int port,
@@ -44,7 +48,12 @@ DistributedProcessingSystem::DistributedProcessingSystem(const std::string& node
     : system_running(false), system_id(node_id), health_monitoring_active(true) {
     
     // Inicializar componentes principales
-    memory_pool = new DistributedMemoryPool(memory_block_size, initial_blocks);
+    // Los lotes nacen en memoria compartida para que los plugins los procesen en sitio
+    MemoryPoolBacking backing;
+    backing.mode = MemoryPoolBacking::SHARED_MEMORY_BACKING;
+    memory_pool = new DistributedMemoryPool(memory_block_size, initial_blocks,
+                                            DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH, backing);
+    memory_pool->add_pressure_callback(on_memory_pressure, this);
     config_manager = new ConfigurationManager(config_file);
     
     // Crear supervisor root
@@ -98,6 +107,9 @@ bool DistributedProcessingSystem::start_system() {
         std::cerr << "Advertencia: No se pudo iniciar monitor de salud" << std::endl;
     }
     
+    // Devolver periódicamente al sistema la memoria de ráfagas pasadas
+    memory_pool->start_background_trim(MEMORY_TRIM_INTERVAL_MS);
+    
     system_running = true;
     std::cout << "Sistema distribuido iniciado exitosamente" << std::endl;
     return true;
@@ -115,6 +127,8 @@ void DistributedProcessingSystem::stop_system() {
         root_supervisor->stop_all_components();
     }
     
+    memory_pool->stop_background_trim();
+    
     system_running = false;
     std::cout << "Sistema distribuido detenido" << std::endl;
 }
@@ -126,6 +140,7 @@ bool DistributedProcessingSystem::initialize_supervision_tree() {
 
 bool DistributedProcessingSystem::load_and_configure_plugins() {
     const std::vector<PipelineStageConfig>& stages = config_manager->get_pipeline_stages();
+    bool all_loaded = true;
     
     for (size_t i = 0; i < stages.size(); ++i) {
         const PipelineStageConfig& stage = stages[i];
@@ -134,15 +149,44 @@ bool DistributedProcessingSystem::load_and_configure_plugins() {
         
         std::cout << "Cargando plugin: " << stage.name << " desde " << stage.library_path << std::endl;
         
+        // Plugin de confianza: se carga aquí mismo, sin proceso que arrancar
+        if (stage.isolation == ISOLATION_NONE) {
+            InProcessPlugin* in_process = new InProcessPlugin(
+                stage.name, stage.library_path, stage.parameters);
+            if (!in_process->load()) {
+                delete in_process;
+                all_loaded = false;
+                continue;
+            }
+            root_supervisor->add_component(in_process);
+            continue;
+        }
+        
+        // Etapa pesada: varios procesos idénticos atienden sus lotes
+        if (stage.replicas > 1) {
+            HostedStage hosted;
+            hosted.name = stage.name;
+            hosted.library_path = stage.library_path;
+            hosted.config_params = stage.parameters;
+            ReplicatedStage* replicated = new ReplicatedStage(
+                stage.name, std::vector<HostedStage>(1, hosted), static_cast<size_t>(stage.replicas));
+            replicated->set_pipeline_depth(static_cast<size_t>(std::max(stage.pipeline_depth, 1)));
+            replicated->attach_batch_region(memory_pool->get_shared_region());
+            root_supervisor->add_component(replicated);
+            continue;
+        }
+        
         // Crear proceso aislado para el plugin
         IsolatedPluginProcess* plugin = new IsolatedPluginProcess(
             stage.name, stage.library_path, stage.parameters);
+        plugin->set_pipeline_depth(static_cast<size_t>(std::max(stage.pipeline_depth, 1)));
+        plugin->attach_batch_region(memory_pool->get_shared_region());
         
         // Agregar al supervisor
         root_supervisor->add_component(plugin);
     }
     
-    return true;
+    return all_loaded;
 }
 
 bool DistributedProcessingSystem::process_batch(RecordBatch* batch) {
@@ -201,6 +245,30 @@ bool DistributedProcessingSystem::join_cluster(const std::string& seed_ip, int s
     return local_node->join_cluster(seed_ip, seed_port);
 }
 
+void DistributedProcessingSystem::force_system_cleanup() {
+    MemoryPoolUsage before;
+    memory_pool->get_usage(before);
+    
+    size_t released = memory_pool->trim();
+    
+    std::cout << "Limpieza del sistema: " << released / 1024 << " KB devueltos, "
+              << before.reserved_bytes / 1024 << " KB reservados antes (pico "
+              << before.high_water_bytes / 1024 << " KB)" << std::endl;
+}
+
+void DistributedProcessingSystem::set_memory_pressure_limit(size_t limit_bytes) {
+    memory_pool->set_pressure_limit(limit_bytes);
+}
+
+void DistributedProcessingSystem::on_memory_pressure(DistributedMemoryPool* pool, size_t reserved_bytes, 
+                                                     void* user_data) {
+    (void)pool;
+    DistributedProcessingSystem* system = static_cast<DistributedProcessingSystem*>(user_data);
+    
+    std::cout << "Presión de memoria: " << reserved_bytes / 1024 << " KB reservados" << std::endl;
+    system->force_system_cleanup();
+}
+
 void* DistributedProcessingSystem::health_monitor_function(void* arg) {
     DistributedProcessingSystem* system = static_cast<DistributedProcessingSystem*>(arg);
     
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/in_process_plugin.cpp
+#include "in_process_plugin.h"
+#include <dlfcn.h>
+#include <sys/time.h>
+#include <iostream>
+
+namespace distributed {
+
+// Plugin en curso, para los callbacks de log (cada etapa en proceso
+// corre en un solo hilo, pero varias pueden correr a la vez)
+static __thread const std::string* g_current_plugin_name = NULL;
+
+static void in_process_log_info(const char* message) {
+    std::cout << "[" << (g_current_plugin_name ? *g_current_plugin_name : "") << "] "
+              << message << std::endl;
+}
+
+static void in_process_log_error(const char* message) {
+    std::cerr << "[" << (g_current_plugin_name ? *g_current_plugin_name : "") << "] "
+              << message << std::endl;
+}
+
+InProcessPlugin::InProcessPlugin(const std::string& name,
+                                 const std::string& lib_path,
+                                 const std::string& params)
+    : plugin_name(name), library_path(lib_path), config_params(params),
+      lib_handle(NULL), process_func(NULL), cleanup_func(NULL) {
+    context.user_data = NULL;
+    context.config_params = config_params.c_str();
+    context.log_info = in_process_log_info;
+    context.log_error = in_process_log_error;
+    context.scratch = scratch_arena.get_scratch();
+}
+
+InProcessPlugin::~InProcessPlugin() {
+    unload();
+}
+
+bool InProcessPlugin::load() {
+    if (lib_handle) return true;
+    
+    // RTLD_LOCAL: varios plugins exportan los mismos símbolos
+    void* handle = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << "Error cargando " << library_path << ": " << dlerror() << std::endl;
+        return false;
+    }
+    
+    typedef int (*InitPluginFunc)(PluginContext* context);
+    ProcessBatchFunc process = (ProcessBatchFunc) dlsym(handle, "process_batch");
+    InitPluginFunc init_func = (InitPluginFunc) dlsym(handle, "init_plugin");
+    if (!process) {
+        std::cerr << "Función process_batch no encontrada en " << library_path << std::endl;
+        dlclose(handle);
+        return false;
+    }
+    
+    g_current_plugin_name = &plugin_name;
+    context.user_data = NULL;
+    if (init_func && init_func(&context) != 0) {
+        std::cerr << "init_plugin falló en " << library_path << std::endl;
+        dlclose(handle);
+        return false;
+    }
+    scratch_arena.reset();
+    
+    lib_handle = handle;
+    process_func = process;
+    cleanup_func = (CleanupPluginFunc) dlsym(handle, "cleanup_plugin");
+    std::cout << "Plugin cargado en proceso: " << plugin_name << std::endl;
+    return true;
+}
+
+void InProcessPlugin::unload() {
+    if (!lib_handle) return;
+    
+    g_current_plugin_name = &plugin_name;
+    if (cleanup_func) {
+        cleanup_func(&context);
+    }
+    dlclose(lib_handle);
+    lib_handle = NULL;
+    process_func = NULL;
+    cleanup_func = NULL;
+}
+
+bool InProcessPlugin::reload() {
+    unload();
+    return load();
+}
+
+int InProcessPlugin::process_batch(RecordBatch* batch) {
+    if (!process_func || !batch) return -1;
+    
+    struct timeval start_time, end_time;
+    gettimeofday(&start_time, NULL);
+    
+    g_current_plugin_name = &plugin_name;
+    int result = process_func(batch, &context);
+    scratch_arena.reset();
+    
+    gettimeofday(&end_time, NULL);
+    double execution_time = (end_time.tv_sec - start_time.tv_sec) * 1000.0 +
+                          (end_time.tv_usec - start_time.tv_usec) / 1000.0;
+    
+    if (result == 0) {
+        metrics.record_success(execution_time);
+    } else {
+        metrics.record_failure(execution_time);
+    }
+    
+    return result;
+}
+
+} // namespace distributed
@@ -20,10 +20,15 @@
 // src/ipc.cpp
 #include "ipc.h"
 #include <sys/mman.h>
+#include <sys/eventfd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 #include <unistd.h>
 #include <cstring>
+#include <ctime>
 #include <iostream>
+#include <vector>
 
 namespace distributed {
 
@@ -137,6 +142,22 @@ bool IPCChannel::receive_message(IPCMessage** msg, size_t max_size) {
     return true;
 }
 
+bool IPCChannel::wait_readable(int timeout_ms) {
+    if (read_fd == -1) return false;
+    
+    struct pollfd pfd;
+    pfd.fd = read_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    
+    return ready > 0 && (pfd.revents & POLLIN);
+}
+
 void IPCChannel::close() {
     if (read_fd != -1) {
         ::close(read_fd);
@@ -148,4 +169,257 @@ void IPCChannel::close() {
     }
 }
 
+// =============================================================================
+// ShmRing
+// =============================================================================
+
+// head y tail en líneas de caché distintas: productor y consumidor no se
+// invalidan la línea en cada operación
+struct ShmRing::Control {
+    volatile uint32_t head;              ///< Escrito solo por el productor
+    char head_padding[60];
+    volatile uint32_t tail;              ///< Escrito solo por el consumidor
+    volatile uint32_t consumer_waiting;  ///< El consumidor va a dormir en el eventfd
+    char tail_padding[56];
+    uint32_t capacity;
+    char capacity_padding[60];
+};
+
+// Vueltas de espera activa antes de dormir: un lote que llega en pocos
+// microsegundos se recoge sin syscalls. Con una sola CPU esperar así solo
+// le quita tiempo al otro proceso, así que no se hace
+static const int RING_SPIN_ITERATIONS = 200;
+
+static int ring_spin_iterations() {
+    static const int iterations = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? RING_SPIN_ITERATIONS : 0;
+    return iterations;
+}
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static long monotonic_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000L + now.tv_nsec / 1000000L;
+}
+
+ShmRing::ShmRing() : control(NULL), slots(NULL), mask(0), event_fd(-1) {
+}
+
+ShmRing::~ShmRing() {
+    close();
+}
+
+size_t ShmRing::required_size(size_t capacity) {
+    return sizeof(Control) + capacity * sizeof(BatchDescriptor);
+}
+
+bool ShmRing::init(void* memory, size_t size, size_t capacity) {
+    close();
+    if (!memory || capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > 0x80000000u ||
+        size < required_size(capacity)) {
+        return false;
+    }
+    
+    event_fd = eventfd(0, EFD_NONBLOCK);
+    if (event_fd == -1) return false;
+    
+    control = static_cast<Control*>(memory);
+    memset(control, 0, sizeof(Control));
+    control->capacity = static_cast<uint32_t>(capacity);
+    slots = reinterpret_cast<BatchDescriptor*>(static_cast<char*>(memory) + sizeof(Control));
+    mask = static_cast<uint32_t>(capacity - 1);
+    return true;
+}
+
+void ShmRing::reset() {
+    if (!control) return;
+    
+    uint32_t capacity = control->capacity;
+    memset(control, 0, sizeof(Control));
+    control->capacity = capacity;
+    
+    // Un aviso pendiente del proceso anterior despertaría en falso
+    uint64_t value;
+    ssize_t ignored = read(event_fd, &value, sizeof(value));
+    (void)ignored;
+}
+
+void ShmRing::close() {
+    if (event_fd != -1) {
+        ::close(event_fd);
+        event_fd = -1;
+    }
+    control = NULL;
+    slots = NULL;
+    mask = 0;
+}
+
+bool ShmRing::has_data() const {
+    return control->tail != control->head;
+}
+
+bool ShmRing::push(const BatchDescriptor& descriptor) {
+    if (!control) return false;
+    
+    uint32_t head = control->head;
+    if (head - control->tail > mask) return false;
+    
+    slots[head & mask] = descriptor;
+    __sync_synchronize();   // El descriptor es visible antes que el nuevo head
+    control->head = head + 1;
+    
+    // El head publicado debe verse antes de leer consumer_waiting; del
+    // otro lado el consumidor publica consumer_waiting antes de releer head
+    __sync_synchronize();
+    if (control->consumer_waiting) {
+        uint64_t one = 1;
+        ssize_t written;
+        do {
+            written = write(event_fd, &one, sizeof(one));
+        } while (written < 0 && errno == EINTR);
+    }
+    return true;
+}
+
+bool ShmRing::pop(BatchDescriptor& descriptor) {
+    if (!control) return false;
+    
+    uint32_t tail = control->tail;
+    if (tail == control->head) return false;
+    
+    __sync_synchronize();   // Leer el descriptor después de ver el head
+    descriptor = slots[tail & mask];
+    __sync_synchronize();   // Liberar el slot después de copiarlo
+    control->tail = tail + 1;
+    return true;
+}
+
+bool ShmRing::wait_pop(BatchDescriptor& descriptor, int timeout_ms) {
+    if (!control) return false;
+    
+    const long deadline = timeout_ms < 0 ? 0 : monotonic_ms() + timeout_ms;
+    while (!pop(descriptor)) {
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            long left = deadline - monotonic_ms();
+            if (left <= 0) return false;
+            remaining = static_cast<int>(left);
+        }
+        // Un despertar sin descriptor (aviso sobrante) solo da otra vuelta
+        if (wait(remaining) == WAIT_TIMEOUT) return pop(descriptor);
+    }
+    return true;
+}
+
+ShmRing::WaitResult ShmRing::wait(int timeout_ms, int other_fd) {
+    if (!control) return WAIT_TIMEOUT;
+    
+    const int spins = ring_spin_iterations();
+    for (int spin = 0; spin < spins; ++spin) {
+        if (has_data()) return WAIT_READY;
+        cpu_relax();
+    }
+    
+    const long deadline = timeout_ms < 0 ? 0 : monotonic_ms() + timeout_ms;
+    while (true) {
+        if (has_data()) return WAIT_READY;
+        
+        control->consumer_waiting = 1;
+        __sync_synchronize();
+        if (has_data()) {
+            control->consumer_waiting = 0;
+            return WAIT_READY;
+        }
+        
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            long remaining = deadline - monotonic_ms();
+            if (remaining <= 0) {
+                control->consumer_waiting = 0;
+                return has_data() ? WAIT_READY : WAIT_TIMEOUT;
+            }
+            wait_ms = static_cast<int>(remaining);
+        }
+        
+        struct pollfd pfds[2];
+        pfds[0].fd = event_fd;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        pfds[1].fd = other_fd;
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+        int ready = poll(pfds, other_fd >= 0 ? 2 : 1, wait_ms);
+        control->consumer_waiting = 0;
+        
+        if (ready > 0 && (pfds[0].revents & POLLIN)) {
+            // Un aviso sobrante solo provoca una vuelta extra
+            uint64_t value;
+            ssize_t ignored = read(event_fd, &value, sizeof(value));
+            (void)ignored;
+        }
+        if (has_data()) return WAIT_READY;
+        if (ready > 0 && other_fd >= 0 && (pfds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+            return WAIT_FD_READY;
+        }
+    }
+}
+
+int ShmRing::wait_any(ShmRing* const* rings, size_t count, int timeout_ms) {
+    std::vector<struct pollfd> pfds(count);
+    const long deadline = timeout_ms < 0 ? 0 : monotonic_ms() + timeout_ms;
+    
+    while (true) {
+        for (size_t i = 0; i < count; ++i) {
+            if (rings[i]->has_data()) return static_cast<int>(i);
+        }
+        
+        // Mismo protocolo que wait(): anunciar la espera y volver a mirar
+        for (size_t i = 0; i < count; ++i) {
+            rings[i]->control->consumer_waiting = 1;
+        }
+        __sync_synchronize();
+        int ready_ring = -1;
+        for (size_t i = 0; i < count && ready_ring < 0; ++i) {
+            if (rings[i]->has_data()) ready_ring = static_cast<int>(i);
+        }
+        
+        int wait_ms = -1;
+        if (ready_ring < 0 && timeout_ms >= 0) {
+            long remaining = deadline - monotonic_ms();
+            wait_ms = remaining > 0 ? static_cast<int>(remaining) : 0;
+        }
+        
+        int ready = 0;
+        if (ready_ring < 0) {
+            for (size_t i = 0; i < count; ++i) {
+                pfds[i].fd = rings[i]->event_fd;
+                pfds[i].events = POLLIN;
+                pfds[i].revents = 0;
+            }
+            ready = poll(count > 0 ? &pfds[0] : NULL, count, wait_ms);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            rings[i]->control->consumer_waiting = 0;
+            if (ready > 0 && (pfds[i].revents & POLLIN)) {
+                uint64_t value;
+                ssize_t ignored = read(rings[i]->event_fd, &value, sizeof(value));
+                (void)ignored;
+            }
+        }
+        
+        if (ready_ring >= 0) return ready_ring;
+        if (ready <= 0 && wait_ms == 0) {
+            for (size_t i = 0; i < count; ++i) {
+                if (rings[i]->has_data()) return static_cast<int>(i);
+            }
+            return -1;
+        }
+    }
+}
+
 } // namespace distributed
@@ -22,20 +22,252 @@
 #include "types.h"
 #include "isolated_process.h"
 #include "serialization.h"
+#include "plugin_api.h"
+#include "scratch_arena.h"
+#include "columnar_batch.h"
 #include <dlfcn.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <errno.h>
 #include <signal.h>
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 namespace distributed {
 
+// Espera máxima de la respuesta de un plugin a un lote
+static const int BATCH_RESPONSE_TIMEOUT_MS = 30000;
+
+// Descriptores en vuelo por dirección: cubre la profundidad máxima
+static const size_t BATCH_RING_CAPACITY = IsolatedPluginProcess::MAX_PIPELINE_DEPTH;
+
+// Bytes de shared memory por lote en vuelo
+static const size_t BATCH_SLOT_SIZE = 1024 * 1024;
+
+// Marca de los lotes del camino compartido, que no ocupan slot
+static const size_t NO_SLOT = static_cast<size_t>(-1);
+
+// Espera máxima a que un proceso salga por sí mismo antes de forzarlo
+static const int SHUTDOWN_GRACE_MS = 1000;
+
+const size_t IsolatedPluginProcess::MAX_PIPELINE_DEPTH;
+
+static double elapsed_ms(const struct timeval& start_time) {
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+    return (end_time.tv_sec - start_time.tv_sec) * 1000.0 +
+           (end_time.tv_usec - start_time.tv_usec) / 1000.0;
+}
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// pidfd: legible cuando el proceso termina, sea hijo o nieto (-1 sin soporte)
+static int open_exit_fd(pid_t pid) {
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
+static void close_fd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// Esperar a que termine un proceso; timeout_ms 0 solo consulta
+static bool wait_for_exit(pid_t pid, int exit_fd, int timeout_ms) {
+    if (exit_fd >= 0) {
+        struct pollfd pfd;
+        pfd.fd = exit_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready;
+        do {
+            ready = poll(&pfd, 1, timeout_ms);
+        } while (ready < 0 && errno == EINTR);
+        return ready > 0;
+    }
+    
+    // Kernel sin pidfd: sondear cada milisegundo. waitpid recoge a un hijo
+    // propio; un nieto ya lo recoge el zygote
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+    while (true) {
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid || kill(pid, 0) != 0) return true;
+        if (timeout_ms >= 0 && elapsed_ms(start_time) >= timeout_ms) return false;
+        usleep(1000);
+    }
+}
+
+// Nombre del plugin del proceso hijo actual, para los callbacks de log
+static std::string g_child_plugin_name;
+
+static void plugin_log_info(const char* message) {
+    std::cout << "[" << g_child_plugin_name << "] " << message << std::endl;
+}
+
+static void plugin_log_error(const char* message) {
+    std::cerr << "[" << g_child_plugin_name << "] " << message << std::endl;
+}
+
+// Estado del set_name de una vista columnar que apunta al wire en sitio
+struct InPlaceColumnarState {
+    const char* wire;
+    size_t wire_size;
+    ColumnarBatch** columns;
+};
+
+// Un nombre nuevo no cabe en el wire: se materializa el lote (con lo que
+// el plugin ya modificó en sitio) y la vista pasa a apuntar al ColumnarBatch
+static int in_place_set_name(PluginColumnarBatch* view, size_t row, const char* name, size_t length) {
+    InPlaceColumnarState* state = static_cast<InPlaceColumnarState*>(view->host_state);
+    ColumnarBatch*& columns = *state->columns;
+    
+    if (!columns || columns->get_capacity() < view->count) {
+        delete columns;
+        columns = new ColumnarBatch(std::max(view->count, static_cast<size_t>(1)));
+    }
+    if (!Serializer::deserialize_columnar_batch(state->wire, state->wire_size, *columns)) {
+        return -1;
+    }
+    
+    columns->get_plugin_view(*view);
+    return view->set_name(view, row, name, length);
+}
+
+static void in_place_columnar_view(const SerializedBatchView& wire, InPlaceColumnarState* state,
+                                   PluginColumnarBatch& view) {
+    // La vista es de solo lectura, pero la shared memory es del host y escribible
+    view.count = wire.get_count();
+    view.batch_id = wire.get_batch_id();
+    view.ids = const_cast<int*>(wire.id_column());
+    view.values = const_cast<double*>(wire.value_column());
+    view.categories = const_cast<int*>(wire.category_column());
+    view.name_offsets = wire.name_offset_column();
+    view.name_data = const_cast<char*>(wire.name_bytes_data());
+    view.name_codes = wire.name_code_column();
+    view.name_entries = wire.get_name_entries();
+    view.set_name = in_place_set_name;
+    view.host_state = state;
+}
+
+typedef int (*ProcessBatchFunc)(RecordBatch* batch, PluginContext* context);
+typedef int (*InitPluginFunc)(PluginContext* context);
+typedef void (*CleanupPluginFunc)(PluginContext* context);
+typedef int (*ProcessColumnarFunc)(PluginColumnarBatch* batch, PluginContext* context);
+typedef size_t (*ExportStateFunc)(PluginContext* context, void* buffer, size_t capacity);
+typedef int (*MergeStateFunc)(PluginContext* context, const void* state, size_t size);
+
+// Etapa cargada en el proceso hijo
+struct LoadedStage {
+    std::string name;
+    std::string library_path;
+    void* handle;
+    ProcessBatchFunc process_func;
+    ProcessColumnarFunc columnar_func;
+    CleanupPluginFunc cleanup_func;
+    ExportStateFunc export_state_func;  ///< Hooks de reduce entre réplicas (opcionales)
+    MergeStateFunc merge_state_func;
+    PluginContext context;
+};
+
+static bool load_stage(const HostedStage& spec, ScratchArena& scratch_arena, LoadedStage& stage) {
+    // Cargar biblioteca del plugin. RTLD_LOCAL: las etapas exportan los
+    // mismos símbolos y cada una debe resolver los suyos
+    void* lib_handle = dlopen(spec.library_path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+    if (!lib_handle) {
+        std::cerr << "Error cargando " << spec.library_path << ": " << dlerror() << std::endl;
+        return false;
+    }
+    
+    // Obtener funciones del plugin
+    ProcessBatchFunc process_func = (ProcessBatchFunc) dlsym(lib_handle, "process_batch");
+    InitPluginFunc init_func = (InitPluginFunc) dlsym(lib_handle, "init_plugin");
+    
+    if (!process_func) {
+        std::cerr << "Función process_batch no encontrada en " << spec.library_path << std::endl;
+        dlclose(lib_handle);
+        return false;
+    }
+    
+    stage.name = spec.name;
+    stage.library_path = spec.library_path;
+    stage.handle = lib_handle;
+    stage.process_func = process_func;
+    stage.columnar_func = (ProcessColumnarFunc) dlsym(lib_handle, "process_columnar_batch");
+    stage.cleanup_func = (CleanupPluginFunc) dlsym(lib_handle, "cleanup_plugin");
+    stage.export_state_func = (ExportStateFunc) dlsym(lib_handle, "export_plugin_state");
+    stage.merge_state_func = (MergeStateFunc) dlsym(lib_handle, "merge_plugin_state");
+    
+    // Contexto del plugin con scratch por lote; spec vive en hosted_stages
+    g_child_plugin_name = spec.name;
+    stage.context.user_data = NULL;
+    stage.context.config_params = spec.config_params.c_str();
+    stage.context.log_info = plugin_log_info;
+    stage.context.log_error = plugin_log_error;
+    stage.context.scratch = scratch_arena.get_scratch();
+    
+    if (init_func && init_func(&stage.context) != 0) {
+        std::cerr << "init_plugin falló en " << spec.library_path << std::endl;
+        dlclose(lib_handle);
+        return false;
+    }
+    return true;
+}
+
+static void unload_stages(std::vector<LoadedStage>& stages) {
+    // En orden inverso a la carga
+    for (size_t i = stages.size(); i > 0; --i) {
+        LoadedStage& stage = stages[i - 1];
+        g_child_plugin_name = stage.name;
+        if (stage.cleanup_func) {
+            stage.cleanup_func(&stage.context);
+        }
+        dlclose(stage.handle);
+    }
+    stages.clear();
+}
+
+// Ejecuta las etapas una tras otra sobre el mismo lote y se detiene en la
+// primera que falle, como el pipeline por etapas; devuelve su resultado
+static int run_stages(std::vector<LoadedStage>& stages, ScratchArena& scratch_arena, RecordBatch* batch) {
+    for (size_t i = 0; i < stages.size(); ++i) {
+        g_child_plugin_name = stages[i].name;
+        int result = stages[i].process_func(batch, &stages[i].context);
+        scratch_arena.reset();
+        if (result != 0) return result;
+    }
+    return 0;
+}
+
 IsolatedPluginProcess::IsolatedPluginProcess(const std::string& name, 
                                            const std::string& lib_path, 
                                            const std::string& params)
-    : process_id(-1), plugin_name(name), library_path(lib_path), config_params(params),
-      parent_channel(NULL), child_channel(NULL), shared_memory(NULL), is_running(false) {
+    : process_id(-1), plugin_name(name),
+      parent_channel(NULL), child_channel(NULL), shared_memory(NULL), ring_memory(NULL),
+      next_sequence(0), pipeline_depth(1), slot_size(BATCH_SLOT_SIZE), batch_region(NULL),
+      name_dictionary(false), dictionary_batch(NULL), is_running(false),
+      exit_fd(-1), zygote_pid(-1), zygote_exit_fd(-1), zygote_request_fd(-1), zygote_reply_fd(-1) {
+    HostedStage stage;
+    stage.name = name;
+    stage.library_path = lib_path;
+    stage.config_params = params;
+    hosted_stages.push_back(stage);
+    last_heartbeat = time(NULL);
+}
+
+IsolatedPluginProcess::IsolatedPluginProcess(const std::string& name,
+                                           const std::vector<HostedStage>& stages)
+    : process_id(-1), plugin_name(name), hosted_stages(stages),
+      parent_channel(NULL), child_channel(NULL), shared_memory(NULL), ring_memory(NULL),
+      next_sequence(0), pipeline_depth(1), slot_size(BATCH_SLOT_SIZE), batch_region(NULL),
+      name_dictionary(false), dictionary_batch(NULL), is_running(false),
+      exit_fd(-1), zygote_pid(-1), zygote_exit_fd(-1), zygote_request_fd(-1), zygote_reply_fd(-1) {
     last_heartbeat = time(NULL);
 }
 
@@ -44,10 +276,14 @@ IsolatedPluginProcess::~IsolatedPluginProcess() {
     delete parent_channel;
     delete child_channel;
     delete shared_memory;
+    delete ring_memory;
+    delete dictionary_batch;
 }
 
 bool IsolatedPluginProcess::start() {
     // Crear canales de comunicación
+    delete parent_channel;
+    delete child_channel;
     parent_channel = new IPCChannel();
     child_channel = new IPCChannel();
     
@@ -56,76 +292,263 @@ bool IsolatedPluginProcess::start() {
         return false;
     }
     
-    // Crear shared memory
-    std::ostringstream shm_name;
-    shm_name << "/plugin_" << plugin_name << "_" << getpid();
-    shared_memory = new SharedMemoryRegion(shm_name.str(), 1024 * 1024); // 1MB
+    // Crear shared memory: un slot por lote en vuelo
+    // El nombre lleva un número de instancia: dos etapas con el mismo nombre en
+    // managers distintos no deben compartir slots ni rings
+    static unsigned int instance_count = 0;
+    std::ostringstream name;
+    name << "/plugin_" << plugin_name << "_" << getpid() << "_"
+         << __sync_add_and_fetch(&instance_count, 1);
+    shm_name = name.str();
+    delete shared_memory;
+    shared_memory = new SharedMemoryRegion(shm_name, pipeline_depth * slot_size);
     
     if (!shared_memory->is_valid()) {
         std::cerr << "Error creando shared memory para " << plugin_name << std::endl;
         return false;
     }
     
-    // Fork proceso
-    process_id = fork();
+    // Rings de descriptores: los lotes no pasan por los pipes
+    const size_t ring_size = ShmRing::required_size(BATCH_RING_CAPACITY);
+    delete ring_memory;
+    ring_memory = new SharedMemoryRegion(shm_name + "_ring", 2 * ring_size);
+    char* ring_base = static_cast<char*>(ring_memory->get_memory());
+    if (!ring_memory->is_valid() ||
+        !request_ring.init(ring_base, ring_size, BATCH_RING_CAPACITY) ||
+        !response_ring.init(ring_base + ring_size, ring_size, BATCH_RING_CAPACITY)) {
+        std::cerr << "Error creando rings de lotes para " << plugin_name << std::endl;
+        return false;
+    }
     
-    if (process_id == 0) {
-        // Proceso hijo
-        execute_plugin_process();
-        exit(0);
-    } else if (process_id > 0) {
-        // Proceso padre
-        is_running = true;
-        std::cout << "Plugin process iniciado: " << plugin_name 
-                  << " (PID: " << process_id << ")" << std::endl;
-        return true;
-    } else {
+    // Un hijo nuevo no conoce las peticiones del anterior
+    in_flight.clear();
+    free_slots.clear();
+    for (size_t slot = pipeline_depth; slot > 0; --slot) {
+        free_slots.push_back(slot - 1);
+    }
+    
+    // El zygote hereda todo lo anterior; los hijos salen de él
+    if (!start_zygote()) {
         std::cerr << "Error en fork() para " << plugin_name << std::endl;
         return false;
     }
+    return spawn_child();
 }
 
-void IsolatedPluginProcess::terminate() {
-    if (is_running && process_id > 0) {
-        // Enviar señal de shutdown
-        IPCMessage msg;
-        msg.type = IPCMessage::SHUTDOWN;
-        msg.sender_id = getpid();
-        msg.receiver_id = process_id;
-        msg.data_size = 0;
+bool IsolatedPluginProcess::start_zygote() {
+    int request_pipe[2], reply_pipe[2];
+    if (pipe(request_pipe) != 0) return false;
+    if (pipe(reply_pipe) != 0) {
+        close(request_pipe[0]);
+        close(request_pipe[1]);
+        return false;
+    }
+    
+    zygote_pid = fork();
+    if (zygote_pid == 0) {
+        close(request_pipe[1]);
+        close(reply_pipe[0]);
+        run_zygote(request_pipe[0], reply_pipe[1]);
+        exit(0);
+    }
+    
+    close(request_pipe[0]);
+    close(reply_pipe[1]);
+    if (zygote_pid < 0) {
+        close(request_pipe[1]);
+        close(reply_pipe[0]);
+        return false;
+    }
+    zygote_request_fd = request_pipe[1];
+    zygote_reply_fd = reply_pipe[0];
+    zygote_exit_fd = open_exit_fd(zygote_pid);
+    return true;
+}
+
+// Solo interrumpe el ppoll del zygote; los hijos se recogen en su bucle
+static void zygote_child_exited(int) {
+}
+
+void IsolatedPluginProcess::run_zygote(int request_fd, int reply_fd) {
+    // SIGCHLD bloqueado salvo dentro de ppoll: un hijo que muere entre dos
+    // vueltas despierta la siguiente espera en lugar de perderse
+    sigset_t child_mask, original_mask;
+    sigemptyset(&child_mask);
+    sigaddset(&child_mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &child_mask, &original_mask);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = zygote_child_exited;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, NULL);
+    
+    // Precargar sin inicializar: el dlopen de cada hijo encuentra la
+    // biblioteca ya mapeada y relocada, y init_plugin corre en el hijo
+    std::vector<void*> handles;
+    for (size_t i = 0; i < hosted_stages.size(); ++i) {
+        void* handle = dlopen(hosted_stages[i].library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle) handles.push_back(handle);
+    }
+    
+    // Un byte por orden; EOF cuando el padre cierra o muere. Recoger a un
+    // hijo antes de que el padre abra su pidfd liberaría su PID, y el padre
+    // acabaría vigilando a otro proceso
+    pid_t unconfirmed = -1;
+    std::vector<pid_t> confirmed;
+    while (true) {
+        for (size_t i = confirmed.size(); i-- > 0; ) {
+            int status;
+            if (waitpid(confirmed[i], &status, WNOHANG) != 0) {
+                confirmed.erase(confirmed.begin() + i);
+            }
+        }
         
-        parent_channel->send_message(&msg);
+        struct pollfd pfd;
+        pfd.fd = request_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ready = ppoll(&pfd, 1, NULL, &original_mask);
+        if (ready < 0 && errno == EINTR) continue;
         
-        // Esperar y force kill si es necesario
-        sleep(1);
+        char command;
+        if (ready <= 0 || read(request_fd, &command, 1) != 1) break;
         
-        int status;
-        if (waitpid(process_id, &status, WNOHANG) == 0) {
+        if (command == 'A') {
+            if (unconfirmed > 0) confirmed.push_back(unconfirmed);
+            unconfirmed = -1;
+            continue;
+        }
+        
+        // Un hijo sin confirmar es uno por el que el padre dejó de esperar
+        if (unconfirmed > 0) confirmed.push_back(unconfirmed);
+        pid_t child = fork();
+        if (child == 0) {
+            close(request_fd);
+            close(reply_fd);
+            signal(SIGCHLD, SIG_DFL);
+            sigprocmask(SIG_SETMASK, &original_mask, NULL);
+            execute_plugin_process();
+            exit(0);
+        }
+        unconfirmed = child;
+        if (write(reply_fd, &child, sizeof(child)) != static_cast<ssize_t>(sizeof(child))) break;
+    }
+    
+    for (size_t i = 0; i < handles.size(); ++i) {
+        dlclose(handles[i]);
+    }
+}
+
+bool IsolatedPluginProcess::spawn_child() {
+    if (zygote_request_fd < 0) return false;
+    
+    char command = 'S';
+    pid_t child = -1;
+    struct pollfd pfd;
+    pfd.fd = zygote_reply_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (write(zygote_request_fd, &command, 1) != 1 ||
+        poll(&pfd, 1, SHUTDOWN_GRACE_MS) <= 0 ||
+        read(zygote_reply_fd, &child, sizeof(child)) != static_cast<ssize_t>(sizeof(child)) ||
+        child <= 0) {
+        std::cerr << "Error en fork() para " << plugin_name << std::endl;
+        // Un PID tardío quedaría en el pipe y lo leería el siguiente 'S'
+        // como si fuera su hijo: sin zygote, restart() rehace todo
+        stop_zygote();
+        return false;
+    }
+    
+    process_id = child;
+    exit_fd = open_exit_fd(child);
+    
+    // Con el pidfd abierto (o sin soporte) el zygote ya puede recogerlo
+    command = 'A';
+    if (write(zygote_request_fd, &command, 1) != 1) {
+        std::cerr << "Zygote no disponible para " << plugin_name << std::endl;
+    }
+    is_running = true;
+    last_heartbeat = time(NULL);
+    std::cout << "Plugin process iniciado: " << plugin_name 
+              << " (PID: " << process_id << ")" << std::endl;
+    return true;
+}
+
+void IsolatedPluginProcess::stop_child() {
+    if (!is_running || process_id <= 0) return;
+    
+    // Enviar señal de shutdown
+    IPCMessage msg;
+    msg.type = IPCMessage::SHUTDOWN;
+    msg.sender_id = getpid();
+    msg.receiver_id = process_id;
+    msg.data_size = 0;
+    
+    // Esperar lo justo: el pidfd despierta en cuanto el hijo sale
+    if (!wait_for_exit(process_id, exit_fd, 0)) {
+        parent_channel->send_message(&msg);
+        if (!wait_for_exit(process_id, exit_fd, SHUTDOWN_GRACE_MS)) {
             kill(process_id, SIGTERM);
-            sleep(1);
-            if (waitpid(process_id, &status, WNOHANG) == 0) {
+            if (!wait_for_exit(process_id, exit_fd, SHUTDOWN_GRACE_MS)) {
                 kill(process_id, SIGKILL);
-                waitpid(process_id, &status, 0);
+                wait_for_exit(process_id, exit_fd, -1);
             }
         }
-        
-        is_running = false;
-        std::cout << "Plugin process terminado: " << plugin_name << std::endl;
     }
     
+    // No hay waitpid: el hijo es del zygote, que lo recoge
+    close_fd(exit_fd);
+    is_running = false;
+    std::cout << "Plugin process terminado: " << plugin_name << std::endl;
+}
+
+void IsolatedPluginProcess::stop_zygote() {
+    if (zygote_pid <= 0) return;
+    
+    // El zygote no guarda estado: no hace falta que salga por las buenas.
+    // Esperar su EOF tampoco serviría, otros hijos heredan el pipe
+    close_fd(zygote_request_fd);
+    kill(zygote_pid, SIGKILL);
+    int status;
+    waitpid(zygote_pid, &status, 0);
+    close_fd(zygote_reply_fd);
+    close_fd(zygote_exit_fd);
+    zygote_pid = -1;
+}
+
+void IsolatedPluginProcess::reset_channels() {
+    // Un SHUTDOWN que el hijo muerto no llegó a leer detendría al siguiente
+    while (parent_channel->wait_readable(0)) {
+        IPCMessage* msg = NULL;
+        if (!parent_channel->receive_message(&msg, 1024)) break;
+        free(msg);
+    }
+    request_ring.reset();
+    response_ring.reset();
+    
+    in_flight.clear();
+    free_slots.clear();
+    for (size_t slot = pipeline_depth; slot > 0; --slot) {
+        free_slots.push_back(slot - 1);
+    }
+}
+
+void IsolatedPluginProcess::terminate() {
+    stop_child();
+    stop_zygote();
+    
     // Cleanup shared memory
     if (shared_memory) {
-        std::ostringstream shm_name;
-        shm_name << "/plugin_" << plugin_name << "_" << getpid();
-        SharedMemoryRegion::cleanup(shm_name.str());
+        SharedMemoryRegion::cleanup(shm_name);
+        SharedMemoryRegion::cleanup(shm_name + "_ring");
     }
 }
 
 bool IsolatedPluginProcess::is_alive() const {
     if (!is_running || process_id <= 0) return false;
     
-    // Verificar si el proceso existe
-    if (kill(process_id, 0) != 0) {
+    // Verificar si el proceso existe (con pidfd, también si es un zombi)
+    if (exit_fd >= 0 ? wait_for_exit(process_id, exit_fd, 0) : kill(process_id, 0) != 0) {
         return false;
     }
     
@@ -134,135 +557,391 @@ bool IsolatedPluginProcess::is_alive() const {
     return (now - last_heartbeat) < 60; // 60 segundos timeout
 }
 
+void IsolatedPluginProcess::set_pipeline_depth(size_t depth) {
+    pipeline_depth = std::max(static_cast<size_t>(1), std::min(depth, MAX_PIPELINE_DEPTH));
+}
+
 int IsolatedPluginProcess::process_batch(RecordBatch* batch) {
     if (!is_running || !batch) return -1;
     
-    struct timeval start_time, end_time;
+    // Un process_batch interrumpido (p.ej. por la alarma del manager) dejó
+    // su petición en vuelo: su lote ya no es nuestro
+    std::vector<RecordBatch*> touched;
+    abandon_entries(true, &touched);
+    if (!is_running) return -1;
+    
+    // Reintentar ese mismo lote en sitio podría aplicar el plugin dos veces
+    if (std::find(touched.begin(), touched.end(), batch) != touched.end()) return -1;
+    
+    // Sin slots libres por lotes abandonados: sus respuestas tardías los liberan
+    if (free_slots.empty()) {
+        collect_completion(BATCH_RESPONSE_TIMEOUT_MS, NULL, NULL);
+    }
+    
+    uint32_t sequence = submit_batch(batch);
+    if (sequence == 0) return -1;
+    in_flight.back().synchronous = true;
+    
+    struct timeval start_time;
     gettimeofday(&start_time, NULL);
     
-    // Serializar batch a shared memory
-    char* shm_ptr = (char*)shared_memory->get_memory();
-    size_t serialized_size = Serializer::serialize_batch(batch, shm_ptr, shared_memory->get_size());
+    int elapsed = 0;
+    while (elapsed < BATCH_RESPONSE_TIMEOUT_MS) {
+        RecordBatch* done = NULL;
+        int result = -1;
+        uint32_t completed = collect_completion(BATCH_RESPONSE_TIMEOUT_MS - elapsed, &done, &result);
+        if (completed == sequence) return result;
+        if (completed == 0) break;
+        elapsed = static_cast<int>(elapsed_ms(start_time));
+    }
     
-    if (serialized_size == 0) {
-        metrics.record_failure(0.0);
-        return -1;
+    // Sin respuesta: el slot queda reservado hasta que llegue una tardía
+    // (o el hijo se reinicia si el lote se procesaba en sitio)
+    abandon_entries(true);
+    metrics.record_failure(elapsed_ms(start_time));
+    return -1;
+}
+
+uint32_t IsolatedPluginProcess::submit_batch(RecordBatch* batch) {
+    if (!is_running || !batch || in_flight.size() >= pipeline_depth) return 0;
+    
+    InFlightBatch entry;
+    gettimeofday(&entry.start_time, NULL);
+    entry.batch = batch;
+    entry.slot = NO_SLOT;
+    entry.synchronous = false;
+    
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.batch_id = batch->batch_id;
+    if (++next_sequence == 0) ++next_sequence;
+    descriptor.sequence = next_sequence;
+    
+    // Lotes nacidos en la región del pool: sin serializar ni copiar
+    bool shared = false;
+    if (batch_region && batch->records) {
+        const char* base = static_cast<const char*>(batch_region->get_memory());
+        const char* records = reinterpret_cast<const char*>(batch->records);
+        size_t bytes = batch->capacity * sizeof(DatabaseRecord);
+        shared = records >= base && bytes <= batch_region->get_size() &&
+                 static_cast<size_t>(records - base) <= batch_region->get_size() - bytes;
     }
     
-    // Enviar mensaje de procesamiento
-    IPCMessage msg;
-    msg.type = IPCMessage::PROCESS_BATCH;
-    msg.sender_id = getpid();
-    msg.receiver_id = process_id;
-    msg.data_size = sizeof(size_t);
+    bool submitted = shared ? submit_shared_batch(batch, descriptor)
+                            : submit_serialized_batch(batch, descriptor, entry.slot);
+    if (!submitted) {
+        if (entry.slot != NO_SLOT) free_slots.push_back(entry.slot);
+        metrics.record_failure(elapsed_ms(entry.start_time));
+        return 0;
+    }
     
-    char* msg_buffer = (char*)malloc(sizeof(IPCMessage) + msg.data_size);
-    memcpy(msg_buffer, &msg, sizeof(IPCMessage));
-    memcpy(msg_buffer + sizeof(IPCMessage), &serialized_size, sizeof(size_t));
+    entry.sequence = descriptor.sequence;
+    in_flight.push_back(entry);
+    return entry.sequence;
+}
+
+bool IsolatedPluginProcess::submit_serialized_batch(RecordBatch* batch, BatchDescriptor& descriptor,
+                                                    size_t& slot) {
+    if (free_slots.empty()) return false;
+    slot = free_slots.back();
+    free_slots.pop_back();
     
-    bool sent = parent_channel->send_message((IPCMessage*)msg_buffer);
-    free(msg_buffer);
+    // Serializar batch en su slot de shared memory (nombres de longitud variable)
+    char* slot_ptr = static_cast<char*>(shared_memory->get_memory()) + slot * slot_size;
+    size_t serialized_size = 0;
+    if (name_dictionary) {
+        if (!dictionary_batch || dictionary_batch->get_capacity() < batch->count) {
+            delete dictionary_batch;
+            dictionary_batch = new ColumnarBatch(std::max(batch->count, static_cast<size_t>(1)));
+        }
+        if (dictionary_batch->from_record_batch(*batch, true)) {
+            serialized_size = Serializer::serialize_columnar_batch(*dictionary_batch, slot_ptr, slot_size);
+        }
+    } else {
+        serialized_size = Serializer::serialize_batch_compact(batch, slot_ptr, slot_size);
+    }
     
-    if (!sent) {
-        metrics.record_failure(0.0);
-        return -1;
+    if (serialized_size == 0) return false;
+    
+    // Solo el descriptor viaja al hijo; el lote ya está en shared memory
+    descriptor.type = IPCMessage::PROCESS_BATCH;
+    descriptor.offset = slot * slot_size;
+    descriptor.size = serialized_size;
+    descriptor.count = batch->count;
+    return request_ring.push(descriptor);
+}
+
+bool IsolatedPluginProcess::submit_shared_batch(RecordBatch* batch, BatchDescriptor& descriptor) {
+    descriptor.type = IPCMessage::PROCESS_SHARED_BATCH;
+    descriptor.offset = reinterpret_cast<char*>(batch->records) -
+                        static_cast<const char*>(batch_region->get_memory());
+    descriptor.count = batch->count;
+    descriptor.capacity = batch->capacity;
+    return request_ring.push(descriptor);
+}
+
+uint32_t IsolatedPluginProcess::collect_completion(int timeout_ms, RecordBatch** batch, int* result) {
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+    
+    while (!in_flight.empty()) {
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            remaining = timeout_ms - static_cast<int>(elapsed_ms(start_time));
+            if (remaining < 0) remaining = 0;
+        }
+        
+        BatchDescriptor response;
+        if (!response_ring.wait_pop(response, remaining)) return 0;
+        
+        // Las respuestas se emparejan por secuencia, no por orden de llegada
+        size_t index = 0;
+        while (index < in_flight.size() && in_flight[index].sequence != response.sequence) {
+            ++index;
+        }
+        if (index == in_flight.size()) continue;
+        
+        InFlightBatch entry = in_flight[index];
+        in_flight.erase(in_flight.begin() + index);
+        bool success = complete_batch(entry, response);
+        if (!entry.batch) continue;
+        
+        if (success) {
+            metrics.record_success(elapsed_ms(entry.start_time));
+            last_heartbeat = time(NULL);
+        } else {
+            metrics.record_failure(elapsed_ms(entry.start_time));
+        }
+        
+        if (batch) *batch = entry.batch;
+        if (result) *result = success ? 0 : (response.result != 0 ? response.result : -1);
+        return entry.sequence;
     }
+    return 0;
+}
+
+bool IsolatedPluginProcess::complete_batch(const InFlightBatch& entry, const BatchDescriptor& response) {
+    bool success = false;
     
-    // Esperar respuesta
-    IPCMessage* response = NULL;
-    if (child_channel->receive_message(&response, 1024)) {
-        if (response->type == IPCMessage::BATCH_RESULT) {
+    // Un código distinto de 0 es un fallo del plugin: el lote no se da por
+    // procesado ni se copia su salida parcial
+    bool processed = response.type == IPCMessage::BATCH_RESULT && response.result == 0;
+    
+    if (entry.slot != NO_SLOT) {
+        if (entry.batch && processed && response.size > 0) {
             // Deserializar resultado
-            bool success = Serializer::deserialize_batch(shm_ptr, batch);
-            
-            gettimeofday(&end_time, NULL);
-            double execution_time = (end_time.tv_sec - start_time.tv_sec) * 1000.0 +
-                                  (end_time.tv_usec - start_time.tv_usec) / 1000.0;
-            
-            if (success) {
-                metrics.record_success(execution_time);
-                last_heartbeat = time(NULL);
-            } else {
-                metrics.record_failure(execution_time);
-            }
-            
-            free(response);
-            return success ? 0 : -1;
+            const char* slot_ptr = static_cast<const char*>(shared_memory->get_memory()) +
+                                   entry.slot * slot_size;
+            success = Serializer::deserialize_batch_compact(slot_ptr, slot_size, entry.batch);
         }
-        free(response);
+        free_slots.push_back(entry.slot);
+    } else if (entry.batch && processed) {
+        // El plugin ya escribió los registros en sitio; solo vuelve el count
+        entry.batch->count = std::min(static_cast<size_t>(response.count), entry.batch->capacity);
+        success = true;
     }
     
-    gettimeofday(&end_time, NULL);
-    double execution_time = (end_time.tv_sec - start_time.tv_sec) * 1000.0 +
-                          (end_time.tv_usec - start_time.tv_usec) / 1000.0;
-    metrics.record_failure(execution_time);
+    return success;
+}
+
+void IsolatedPluginProcess::abandon_in_flight(std::vector<RecordBatch*>* touched) {
+    abandon_entries(false, touched);
+}
+
+void IsolatedPluginProcess::abandon_entries(bool synchronous_only, std::vector<RecordBatch*>* touched) {
+    bool in_place = false;
+    for (size_t i = 0; i < in_flight.size(); ++i) {
+        if (synchronous_only && !in_flight[i].synchronous) continue;
+        if (in_flight[i].batch && in_flight[i].slot == NO_SLOT) {
+            in_place = true;
+            if (touched) touched->push_back(in_flight[i].batch);
+        }
+        in_flight[i].batch = NULL;
+    }
     
-    return -1;
+    // Un hijo muerto ya no escribe: reiniciarlo queda a cargo del llamador
+    if (!in_place || !is_alive()) return;
+    
+    std::cerr << "Lote en sitio abandonado en " << plugin_name << ": reiniciando el proceso" << std::endl;
+    kill(process_id, SIGKILL);
+    restart();
 }
 
-void IsolatedPluginProcess::execute_plugin_process() {
-    std::cout << "Proceso plugin iniciado: " << plugin_name << " (PID: " << getpid() << ")" << std::endl;
+bool IsolatedPluginProcess::exchange_control(BatchDescriptor& descriptor) {
+    // El slot 0 solo está libre sin lotes en vuelo
+    if (!is_running || !in_flight.empty()) return false;
     
-    // Cargar biblioteca del plugin
-    void* lib_handle = dlopen(library_path.c_str(), RTLD_LAZY);
-    if (!lib_handle) {
-        std::cerr << "Error cargando " << library_path << ": " << dlerror() << std::endl;
-        return;
+    if (++next_sequence == 0) ++next_sequence;
+    descriptor.sequence = next_sequence;
+    descriptor.offset = 0;
+    if (!request_ring.push(descriptor)) return false;
+    
+    BatchDescriptor response;
+    while (response_ring.wait_pop(response, BATCH_RESPONSE_TIMEOUT_MS)) {
+        if (response.sequence == descriptor.sequence) {
+            descriptor = response;
+            return descriptor.type == IPCMessage::BATCH_RESULT && descriptor.result == 0;
+        }
     }
+    return false;
+}
+
+bool IsolatedPluginProcess::export_stage_state(size_t stage, std::vector<char>& state) {
+    state.clear();
+    if (stage >= hosted_stages.size()) return false;
     
-    // Obtener funciones del plugin
-    typedef int (*ProcessBatchFunc)(RecordBatch* batch, void* context);
-    ProcessBatchFunc process_func = (ProcessBatchFunc) dlsym(lib_handle, "process_batch");
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.type = IPCMessage::EXPORT_STATE;
+    descriptor.count = stage;
+    if (!exchange_control(descriptor) || descriptor.size > slot_size) return false;
     
-    if (!process_func) {
-        std::cerr << "Función process_batch no encontrada en " << library_path << std::endl;
-        dlclose(lib_handle);
-        return;
+    const char* slot_ptr = static_cast<const char*>(shared_memory->get_memory());
+    state.assign(slot_ptr, slot_ptr + descriptor.size);
+    return true;
+}
+
+bool IsolatedPluginProcess::merge_stage_state(size_t stage, const std::vector<char>& state) {
+    if (stage >= hosted_stages.size() || state.size() > slot_size) return false;
+    if (state.empty()) return true;
+    
+    memcpy(shared_memory->get_memory(), &state[0], state.size());
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.type = IPCMessage::MERGE_STATE;
+    descriptor.count = stage;
+    descriptor.size = state.size();
+    return exchange_control(descriptor);
+}
+
+void IsolatedPluginProcess::execute_plugin_process() {
+    std::cout << "Proceso plugin iniciado: " << plugin_name << " (PID: " << getpid() << ")" << std::endl;
+    
+    // Cargar las bibliotecas de todas las etapas alojadas, en orden
+    ScratchArena scratch_arena;
+    std::vector<LoadedStage> stages;
+    bool all_columnar = true;
+    for (size_t i = 0; i < hosted_stages.size(); ++i) {
+        LoadedStage stage;
+        if (!load_stage(hosted_stages[i], scratch_arena, stage)) {
+            unload_stages(stages);
+            return;
+        }
+        scratch_arena.reset();
+        all_columnar = all_columnar && stage.columnar_func;
+        stages.push_back(stage);
     }
     
-    // Preparar espacio de trabajo
+    // Espacio de trabajo privado: el payload compacto de cada slot se
+    // expande aquí y el resultado se vuelve a escribir sobre él
     char* shm_ptr = (char*)shared_memory->get_memory();
-    RecordBatch working_batch;
-    working_batch.records = (DatabaseRecord*)(shm_ptr + 1024); // Offset para metadata
-    working_batch.capacity = (shared_memory->get_size() - 1024) / sizeof(DatabaseRecord);
+    size_t shm_size = shared_memory->get_size();
+    std::vector<DatabaseRecord> working_records;
+    ColumnarBatch* working_columns = NULL;
     
-    // Loop principal del proceso
+    // Loop principal del proceso: los lotes llegan por request_ring y los
+    // mensajes de control (SHUTDOWN) por el pipe. Ambos se esperan en un
+    // solo poll, así que un plugin ocioso no despierta nunca
     while (true) {
-        IPCMessage* msg = NULL;
-        if (parent_channel->receive_message(&msg, 1024)) {
-            if (msg->type == IPCMessage::SHUTDOWN) {
-                free(msg);
-                break;
-            } else if (msg->type == IPCMessage::PROCESS_BATCH) {
-                // Deserializar y procesar batch
-                if (Serializer::deserialize_batch(shm_ptr, &working_batch)) {
-                    int result = process_func(&working_batch, NULL);
-                    
-                    // Serializar resultado
-                    Serializer::serialize_batch(&working_batch, shm_ptr, shared_memory->get_size());
-                    
-                    // Enviar respuesta
-                    IPCMessage response;
-                    response.type = IPCMessage::BATCH_RESULT;
-                    response.sender_id = getpid();
-                    response.receiver_id = msg->sender_id;
-                    response.data_size = sizeof(int);
+        ShmRing::WaitResult ready = request_ring.wait(-1, parent_channel->get_read_fd());
+        
+        BatchDescriptor request;
+        while (request_ring.pop(request)) {
+            BatchDescriptor response = request;
+            response.type = IPCMessage::BATCH_RESULT;
+            response.result = -1;
+            response.size = 0;
+            
+            if (request.type == IPCMessage::PROCESS_BATCH && request.offset % slot_size == 0 &&
+                request.offset < shm_size) {
+                char* slot_ptr = shm_ptr + request.offset;
+                SerializedBatchView wire(slot_ptr, slot_size);
+                size_t count = wire.get_count();
+                bool loaded = false;
+                int result = -1;
+                
+                if (all_columnar && wire.get_format() == SerializedBatchView::COMPACT_FORMAT &&
+                    wire.is_aligned()) {
+                    // Las etapas trabajan sobre las columnas del wire en sitio; solo
+                    // si renombran filas se materializa un ColumnarBatch
+                    InPlaceColumnarState state;
+                    state.wire = slot_ptr;
+                    state.wire_size = slot_size;
+                    state.columns = &working_columns;
                     
-                    char* resp_buffer = (char*)malloc(sizeof(IPCMessage) + sizeof(int));
-                    memcpy(resp_buffer, &response, sizeof(IPCMessage));
-                    memcpy(resp_buffer + sizeof(IPCMessage), &result, sizeof(int));
+                    PluginColumnarBatch view;
+                    in_place_columnar_view(wire, &state, view);
+                    loaded = true;
+                    result = 0;
+                    for (size_t i = 0; i < stages.size() && result == 0; ++i) {
+                        g_child_plugin_name = stages[i].name;
+                        result = stages[i].columnar_func(&view, &stages[i].context);
+                        scratch_arena.reset();
+                    }
                     
-                    child_channel->send_message((IPCMessage*)resp_buffer);
-                    free(resp_buffer);
+                    if (view.host_state != &state) {
+                        response.size = Serializer::serialize_columnar_batch(*working_columns, slot_ptr, slot_size);
+                    } else {
+                        Serializer::reseal_compact_batch(slot_ptr, slot_size);
+                        response.size = wire.get_serialized_size();
+                    }
+                } else if (wire.is_valid()) {
+                    if (working_records.size() < std::max(count, static_cast<size_t>(1))) {
+                        working_records.resize(std::max(count, static_cast<size_t>(1)));
+                    }
+                    RecordBatch working_batch;
+                    working_batch.records = &working_records[0];
+                    working_batch.capacity = working_records.size();
+                    loaded = wire.copy_to(&working_batch);
+                    if (loaded) {
+                        result = run_stages(stages, scratch_arena, &working_batch);
+                        response.size = Serializer::serialize_batch_compact(&working_batch, slot_ptr, slot_size);
+                        response.count = working_batch.count;
+                    }
+                }
+                
+                // size 0: el lote no pudo cargarse o el resultado no cabe
+                if (!loaded) response.size = 0;
+                response.result = result;
+            } else if ((request.type == IPCMessage::EXPORT_STATE || request.type == IPCMessage::MERGE_STATE) &&
+                       request.count < stages.size() && request.size <= slot_size) {
+                // Reduce entre réplicas: el estado viaja por el slot 0
+                LoadedStage& stage = stages[request.count];
+                g_child_plugin_name = stage.name;
+                if (request.type == IPCMessage::EXPORT_STATE) {
+                    // Sin hook no hay estado que mover
+                    response.size = stage.export_state_func ?
+                        stage.export_state_func(&stage.context, shm_ptr, slot_size) : 0;
+                    response.result = 0;
+                } else if (stage.merge_state_func) {
+                    response.result = stage.merge_state_func(&stage.context, shm_ptr, request.size);
                 }
+            } else if (request.type == IPCMessage::PROCESS_SHARED_BATCH && batch_region) {
+                // El mapeo heredado del pool permite trabajar sobre los registros en sitio
+                RecordBatch shared_batch;
+                shared_batch.records = reinterpret_cast<DatabaseRecord*>(
+                    static_cast<char*>(batch_region->get_memory()) + request.offset);
+                shared_batch.count = static_cast<size_t>(request.count);
+                shared_batch.capacity = static_cast<size_t>(request.capacity);
+                shared_batch.batch_id = request.batch_id;
+                
+                response.result = run_stages(stages, scratch_arena, &shared_batch);
+                response.count = shared_batch.count;
             }
+            
+            response_ring.push(response);
+        }
+        
+        IPCMessage* msg = NULL;
+        if (ready == ShmRing::WAIT_FD_READY && parent_channel->receive_message(&msg, 1024)) {
+            bool shutdown = msg->type == IPCMessage::SHUTDOWN;
             free(msg);
-        } else {
-            usleep(10000); // 10ms
+            if (shutdown) break;
         }
     }
     
-    dlclose(lib_handle);
+    delete working_columns;
+    unload_stages(stages);
     std::cout << "Proceso plugin terminado: " << plugin_name << std::endl;
 }
 
@@ -279,9 +958,14 @@ bool IsolatedPluginProcess::send_heartbeat() {
 }
 
 bool IsolatedPluginProcess::restart() {
-    if (is_running) {
-        terminate();
+    // Con el zygote vivo basta otro fork: pipes, shm y bibliotecas ya están
+    if (zygote_pid > 0 && !wait_for_exit(zygote_pid, zygote_exit_fd, 0)) {
+        stop_child();
+        reset_channels();
+        if (spawn_child()) return true;
     }
+    
+    terminate();
     return start();
 }
 
@@ -20,159 +20,1440 @@
 // src/memory_pool.cpp
 #include "types.h"
 #include "memory_pool.h"
+#include "ipc.h"
 #include <algorithm>
 #include <iostream>
+#include <cstdlib>
+#include <new>
+#include <cstdio>
+#include <sstream>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <malloc.h>
+#include <errno.h>
 
 namespace distributed {
 
-DistributedMemoryPool::Block::Block(size_t s) : size(s), in_use(false), next(NULL) {
-    data = new char[size];
+const size_t DistributedMemoryPool::MIN_CLASS_SHIFT;
+const size_t DistributedMemoryPool::MAX_CLASS_SHIFT;
+const size_t DistributedMemoryPool::NUM_SIZE_CLASSES;
+const size_t DistributedMemoryPool::MIN_CLASS_SIZE;
+const size_t DistributedMemoryPool::MAX_CLASS_SIZE;
+const size_t DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH;
+const size_t DistributedMemoryPool::MAX_NUMA_NODES;
+const size_t DistributedMemoryPool::DEFAULT_TRIM_WATERMARK;
+const size_t DistributedMemoryPool::MAX_PRESSURE_CALLBACKS;
+
+// Marca para reconocer bloques propios del pool en deallocate()
+static const unsigned int BLOCK_MAGIC = 0xB10C4EADu;
+
+// Marca para reconocer lotes creados por create_batch()
+static const unsigned int BATCH_MAGIC = 0xBA7C4EADu;
+
+// Índice de unidades que no caben en la tabla (no se reciclan)
+static const unsigned int UNREGISTERED_UNIT = 0xFFFFFFFFu;
+
+// Entradas del directorio de unidades: hueco nunca usado y unidad dada de baja
+static const uintptr_t EMPTY_UNIT_SLOT = 0;
+static const uintptr_t REMOVED_UNIT_SLOT = 1;
+
+// Unidades que trim() saca de una pila antes de esperar a los lectores
+static const size_t TRIM_UNIT_BATCH = 64;
+
+// Capacidad inicial del directorio de unidades
+static const size_t MIN_UNIT_DIRECTORY = 64;
+
+// Clase reservada para el camino de objetos grandes
+static const unsigned short LARGE_OBJECT_CLASS = 0xFFFF;
+
+// Tamaño objetivo de un slab; las clases grandes usan un bloque por slab
+static const size_t SLAB_TARGET_BYTES = 64 * 1024;
+
+// Memoria máxima por clase que una cache por hilo puede retener
+static const size_t THREAD_CACHE_CLASS_BYTES = 4 * 1024 * 1024;
+
+// Tamaño de huge page de x86-64; los arenas se alinean a este tamaño
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Arena por defecto de cada nodo
+static const size_t DEFAULT_ARENA_BYTES = 64 * 1024 * 1024;
+
+// Valor de MPOL_BIND en <linux/mempolicy.h> (evita depender de libnuma)
+static const int MPOL_BIND_POLICY = 2;
+
+static size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
 }
 
-DistributedMemoryPool::Block::~Block() {
-    delete[] data;
+/**
+ * @brief Posición inicial de una dirección en el directorio de unidades
+ */
+static size_t unit_slot(uintptr_t address, size_t capacity) {
+    uint64_t hash = static_cast<uint64_t>(address >> 4) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash >> 32) & (capacity - 1);
 }
 
-DistributedMemoryPool::DistributedMemoryPool(size_t block_size, size_t initial_blocks) 
-    : free_blocks(NULL), used_blocks(NULL), block_size(block_size), total_blocks(0) {
-    
+/**
+ * @brief Parsear una lista de CPUs del kernel ("0-3,8,10-11") sobre el mapa CPU -> nodo
+ */
+static void parse_cpulist(const char* list, int node, int* cpu_nodes, size_t cpu_count) {
+    const char* cursor = list;
+    while (*cursor && *cursor != '\n') {
+        char* end = NULL;
+        long first = strtol(cursor, &end, 10);
+        if (end == cursor) break;
+        long last = first;
+        cursor = end;
+        if (*cursor == '-') {
+            last = strtol(cursor + 1, &end, 10);
+            cursor = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            if (cpu >= 0 && static_cast<size_t>(cpu) < cpu_count) {
+                cpu_nodes[cpu] = node;
+            }
+        }
+        if (*cursor == ',') cursor++;
+    }
+}
+
+MemoryPoolUsage::MemoryPoolUsage() 
+    : reserved_bytes(0), high_water_bytes(0), low_water_bytes(0), released_bytes(0), trim_count(0) {}
+
+MemoryPoolBacking::MemoryPoolBacking() 
+    : mode(HEAP_BACKING), huge_pages(NO_HUGE_PAGES), arena_size(DEFAULT_ARENA_BYTES), numa_aware(true) {}
+
+DistributedMemoryPool::Block::Block(size_t s, unsigned short cls, unsigned char owner_node) 
+    : data(NULL), size(s), magic(BLOCK_MAGIC), size_class(cls), node(owner_node), in_use(false),
+      next(NULL), prev(NULL), slab(NULL) {}
+
+size_t DistributedMemoryPool::Block::header_size() {
+    // Redondeado a 16 bytes para mantener los datos alineados
+    return (sizeof(Block) + 15) & ~static_cast<size_t>(15);
+}
+
+DistributedMemoryPool::Block* DistributedMemoryPool::Block::from_data(void* ptr) {
+    Block* block = reinterpret_cast<Block*>(static_cast<char*>(ptr) - header_size());
+    if (block->magic != BLOCK_MAGIC || block->data != ptr) {
+        return NULL;
+    }
+    return block;
+}
+
+size_t DistributedMemoryPool::Slab::header_size() {
+    return (sizeof(Slab) + 15) & ~static_cast<size_t>(15);
+}
+
+size_t DistributedMemoryPool::BatchUnit::header_size() {
+    return (sizeof(BatchUnit) + 15) & ~static_cast<size_t>(15);
+}
+
+DistributedMemoryPool::ThreadCache::ThreadCache(DistributedMemoryPool* owner, size_t home_node) 
+    : node(home_node), pool(owner), next(NULL) {
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        magazines[i].blocks = NULL;
+        magazines[i].count = 0;
+        magazines[i].capacity = owner->heaps[home_node].classes[i].thread_cache_depth;
+    }
+}
+
+DistributedMemoryPool::ThreadCache::~ThreadCache() {
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        delete[] magazines[i].blocks;
+    }
+}
+
+DistributedMemoryPool::DistributedMemoryPool(size_t block_size, size_t initial_blocks,
+                                             size_t thread_cache_depth) 
+    : effective_huge_pages(MemoryPoolBacking::NO_HUGE_PAGES), heaps(NULL), node_count(1),
+      cpu_nodes(NULL), cpu_count(0), shared_region(NULL), shared_used(0), unit_count(0), next_batch_id(0), 
+      large_objects(NULL), large_object_count(0), block_size(block_size),
+      thread_cache_depth(thread_cache_depth), thread_cache_enabled(false), thread_caches(NULL) {
+    initialize(initial_blocks);
+}
+
+DistributedMemoryPool::DistributedMemoryPool(size_t block_size, size_t initial_blocks,
+                                             size_t thread_cache_depth, const MemoryPoolBacking& backing) 
+    : backing(backing), effective_huge_pages(MemoryPoolBacking::NO_HUGE_PAGES), heaps(NULL), node_count(1),
+      cpu_nodes(NULL), cpu_count(0), shared_region(NULL), shared_used(0), unit_count(0), next_batch_id(0), 
+      large_objects(NULL), large_object_count(0), block_size(block_size),
+      thread_cache_depth(thread_cache_depth), thread_cache_enabled(false), thread_caches(NULL) {
+    initialize(initial_blocks);
+}
+
+void DistributedMemoryPool::initialize(size_t initial_blocks) {
     pthread_mutex_init(&mutex, NULL);
     
-    // Pre-asignar bloques iniciales
-    for (size_t i = 0; i < initial_blocks; ++i) {
-        Block* block = new Block(block_size);
-        block->next = free_blocks;
-        free_blocks = block;
-        total_blocks++;
+    retired_units = NULL;
+    retired_unit_count = 0;
+    retired_unit_capacity = 0;
+    
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        shared_payloads[i].chunks = NULL;
+        shared_payloads[i].count = 0;
+        shared_payloads[i].capacity = 0;
     }
+    
+    UnitDirectory* directory = new UnitDirectory();
+    directory->slots = new uintptr_t[MIN_UNIT_DIRECTORY]();
+    directory->capacity = MIN_UNIT_DIRECTORY;
+    directory->used = 0;
+    directory->live = 0;
+    directory->retired = NULL;
+    unit_directory = directory;
+    
+    reclaim_epoch = 0;
+    epoch_readers[0] = 0;
+    epoch_readers[1] = 0;
+    pthread_mutex_init(&reclaim_mutex, NULL);
+    
+    reserved_bytes = 0;
+    high_water_bytes = 0;
+    low_water_bytes = 0;
+    released_bytes = 0;
+    trim_count = 0;
+    trim_watermark = DEFAULT_TRIM_WATERMARK;
+    pressure_limit = 0;
+    pressure_signaled = 0;
+    pressure_callback_count = 0;
+    trim_thread_running = false;
+    trim_thread_stop = false;
+    trim_interval_ms = 0;
+    pthread_mutex_init(&trim_mutex, NULL);
+    pthread_cond_init(&trim_cond, NULL);
+    
+    if (backing.mode == MemoryPoolBacking::ARENA_BACKING && backing.numa_aware) {
+        setup_numa_topology();
+    }
+    
+    heaps = new NodeHeap[node_count];
+    for (size_t node = 0; node < node_count; ++node) {
+        NodeHeap& heap = heaps[node];
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            SizeClass& size_class = heap.classes[i];
+            size_class.block_size = MIN_CLASS_SIZE << i;
+            size_t stride = Block::header_size() + size_class.block_size;
+            size_class.blocks_per_slab = std::max(SLAB_TARGET_BYTES / stride, static_cast<size_t>(1));
+            size_class.thread_cache_depth = std::min(thread_cache_depth, 
+                std::max(THREAD_CACHE_CLASS_BYTES / size_class.block_size, static_cast<size_t>(2)));
+            size_class.free_blocks = NULL;
+            size_class.free_count = 0;
+            size_class.total_blocks = 0;
+            size_class.slabs = NULL;
+            size_class.dormant_slabs = NULL;
+            pthread_mutex_init(&size_class.mutex, NULL);
+            
+            heap.batch_stacks[i].head = 0;
+            heap.batch_stacks[i].depth = 0;
+        }
+        
+        heap.arena_base = NULL;
+        heap.arena_size = 0;
+        heap.arena_used = 0;
+    }
+    
+    if (backing.mode == MemoryPoolBacking::ARENA_BACKING) {
+        effective_huge_pages = backing.huge_pages;
+        for (size_t node = 0; node < node_count; ++node) {
+            setup_arena(node);
+        }
+    } else if (backing.mode == MemoryPoolBacking::SHARED_MEMORY_BACKING) {
+        setup_shared_arena();
+    }
+    
+    for (size_t i = 0; i < MAX_UNIT_SEGMENTS; ++i) {
+        unit_segments[i] = NULL;
+    }
+    
+    // Sin claves TLS disponibles el pool funciona igual, solo que siempre con mutex
+    if (thread_cache_depth > 0 &&
+        pthread_key_create(&thread_cache_key, release_thread_cache) == 0) {
+        thread_cache_enabled = true;
+    }
+    
+    // Pre-asignar bloques iniciales en la clase del tamaño habitual
+    default_class = size_class_for(block_size);
+    if (default_class < NUM_SIZE_CLASSES) {
+        expand_pool(initial_blocks);
+    }
+    reset_watermarks();
 }
 
 DistributedMemoryPool::~DistributedMemoryPool() {
-    while (free_blocks) {
-        Block* next = free_blocks->next;
-        delete free_blocks;
-        free_blocks = next;
+    stop_background_trim();
+    
+    if (thread_cache_enabled) {
+        pthread_key_delete(thread_cache_key);
+        while (thread_caches) {
+            ThreadCache* next = thread_caches->next;
+            delete thread_caches;
+            thread_caches = next;
+        }
     }
-    while (used_blocks) {
-        Block* next = used_blocks->next;
-        delete used_blocks;
-        used_blocks = next;
+    
+    for (size_t i = 0; i < MAX_UNIT_SEGMENTS && unit_segments[i]; ++i) {
+        delete[] unit_segments[i];
+    }
+    
+    while (large_objects) {
+        Block* next = large_objects->next;
+        delete[] reinterpret_cast<char*>(large_objects);
+        large_objects = next;
     }
+    
+    // Los slabs del arena desaparecen con el munmap de su nodo
+    for (size_t node = 0; node < node_count; ++node) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            Slab* lists[2] = { heaps[node].classes[i].slabs, heaps[node].classes[i].dormant_slabs };
+            for (int l = 0; l < 2; ++l) {
+                Slab* slab = lists[l];
+                while (slab) {
+                    Slab* next = slab->next;
+                    if (!slab->from_arena) {
+                        delete[] reinterpret_cast<char*>(slab);
+                    }
+                    slab = next;
+                }
+            }
+        }
+    }
+    
+    for (size_t node = 0; node < node_count; ++node) {
+        if (heaps[node].arena_base) {
+            munmap(heaps[node].arena_base, heaps[node].arena_size);
+        }
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            pthread_mutex_destroy(&heaps[node].classes[i].mutex);
+        }
+    }
+    // La región compartida se desmapea al destruirla; los hijos conservan su mapeo
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        delete[] shared_payloads[i].chunks;
+    }
+    delete shared_region;
+    delete[] heaps;
+    delete[] cpu_nodes;
+    delete[] retired_units;
+    UnitDirectory* directory = unit_directory;
+    while (directory) {
+        UnitDirectory* retired = directory->retired;
+        delete[] directory->slots;
+        delete directory;
+        directory = retired;
+    }
+    pthread_cond_destroy(&trim_cond);
+    pthread_mutex_destroy(&trim_mutex);
+    pthread_mutex_destroy(&reclaim_mutex);
     pthread_mutex_destroy(&mutex);
 }
 
-void* DistributedMemoryPool::allocate(size_t size) {
+void DistributedMemoryPool::setup_numa_topology() {
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    if (configured <= 0) return;
+    
+    cpu_count = static_cast<size_t>(configured);
+    cpu_nodes = new int[cpu_count];
+    for (size_t i = 0; i < cpu_count; ++i) {
+        cpu_nodes[i] = 0;
+    }
+    
+    size_t highest_node = 0;
+    for (size_t node = 0; node < MAX_NUMA_NODES; ++node) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%lu/cpulist",
+                 static_cast<unsigned long>(node));
+        
+        FILE* file = fopen(path, "r");
+        if (!file) continue;
+        
+        char list[1024];
+        if (fgets(list, sizeof(list), file)) {
+            parse_cpulist(list, static_cast<int>(node), cpu_nodes, cpu_count);
+            highest_node = node;
+        }
+        fclose(file);
+    }
+    
+    // Con un solo nodo no hace falta consultar la CPU en cada operación
+    node_count = highest_node + 1;
+    if (node_count == 1) {
+        delete[] cpu_nodes;
+        cpu_nodes = NULL;
+        cpu_count = 0;
+    }
+}
+
+void DistributedMemoryPool::setup_arena(size_t node) {
+    NodeHeap& heap = heaps[node];
+    size_t bytes = round_up(std::max(backing.arena_size, HUGE_PAGE_SIZE), HUGE_PAGE_SIZE);
+    MemoryPoolBacking::HugePageMode mode = backing.huge_pages;
+    char* base = NULL;
+    
+    if (mode == MemoryPoolBacking::EXPLICIT_HUGE_PAGES) {
+        void* mapped = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_HUGETLB, -1, 0);
+        if (mapped != MAP_FAILED) {
+            base = static_cast<char*>(mapped);
+        } else {
+            // Sin huge pages reservadas (vm.nr_hugepages) se recurre a THP
+            mode = MemoryPoolBacking::TRANSPARENT_HUGE_PAGES;
+        }
+    }
+    
+    if (!base && mode == MemoryPoolBacking::TRANSPARENT_HUGE_PAGES) {
+        // Reservar de más para poder alinear el arena a 2 MB
+        size_t reserved = bytes + HUGE_PAGE_SIZE;
+        void* mapped = mmap(NULL, reserved, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapped != MAP_FAILED) {
+            char* raw = static_cast<char*>(mapped);
+            char* aligned = reinterpret_cast<char*>(
+                round_up(reinterpret_cast<uintptr_t>(raw), HUGE_PAGE_SIZE));
+            if (aligned > raw) {
+                munmap(raw, aligned - raw);
+            }
+            size_t tail = (raw + reserved) - (aligned + bytes);
+            if (tail > 0) {
+                munmap(aligned + bytes, tail);
+            }
+            base = aligned;
+            
+            if (madvise(base, bytes, MADV_HUGEPAGE) != 0) {
+                mode = MemoryPoolBacking::NO_HUGE_PAGES;
+            }
+        }
+    }
+    
+    if (!base) {
+        void* mapped = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapped == MAP_FAILED) {
+            // Sin arena los slabs de este nodo salen del heap
+            effective_huge_pages = MemoryPoolBacking::NO_HUGE_PAGES;
+            return;
+        }
+        base = static_cast<char*>(mapped);
+        mode = MemoryPoolBacking::NO_HUGE_PAGES;
+    }
+    
+    // Fijar las páginas al nodo antes del primer acceso; si el kernel no
+    // soporta mbind se mantiene la política por defecto (first touch)
+    if (node_count > 1) {
+        unsigned long node_mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {0};
+        node_mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, base, bytes, MPOL_BIND_POLICY, node_mask, MAX_NUMA_NODES + 1, 0);
+    }
+    
+    heap.arena_base = base;
+    heap.arena_size = bytes;
+    heap.arena_used = 0;
+    
+    if (mode < effective_huge_pages) {
+        effective_huge_pages = mode;
+    }
+}
+
+void DistributedMemoryPool::setup_shared_arena() {
+    static volatile int region_sequence = 0;
+    
+    std::ostringstream name;
+    name << "/dps_pool_" << getpid() << "_" << __sync_add_and_fetch(&region_sequence, 1);
+    
+    size_t bytes = round_up(std::max(backing.arena_size, HUGE_PAGE_SIZE), HUGE_PAGE_SIZE);
+    shared_region = new SharedMemoryRegion(name.str(), bytes);
+    
+    // El nombre no hace falta una vez mapeada: los hijos heredan el mapeo
+    // con fork() y así no quedan objetos huérfanos en /dev/shm
+    SharedMemoryRegion::cleanup(name.str());
+    
+    // La región solo guarda registros (take_shared_payload): slabs y
+    // cabeceras quedan en memoria privada, fuera del alcance de los plugins
+    if (!shared_region->is_valid()) {
+        std::cerr << "Error creando región compartida del pool; se usará el heap" << std::endl;
+        delete shared_region;
+        shared_region = NULL;
+    }
+}
+
+size_t DistributedMemoryPool::current_node() const {
+    if (node_count == 1) {
+        return 0;
+    }
+    
+    int cpu = sched_getcpu();
+    if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_count) {
+        return 0;
+    }
+    return static_cast<size_t>(cpu_nodes[cpu]);
+}
+
+size_t DistributedMemoryPool::size_class_for(size_t size) {
+    if (size > MAX_CLASS_SIZE) {
+        return NUM_SIZE_CLASSES;
+    }
+    
+    size_t class_index = 0;
+    size_t class_size = MIN_CLASS_SIZE;
+    while (class_size < size) {
+        class_size <<= 1;
+        class_index++;
+    }
+    return class_index;
+}
+
+char* DistributedMemoryPool::allocate_slab_memory(size_t node, size_t bytes, bool& from_arena) {
+    NodeHeap& heap = heaps[node];
+    size_t rounded = round_up(bytes, 64);
+    
     pthread_mutex_lock(&mutex);
+    if (heap.arena_base && heap.arena_used + rounded <= heap.arena_size) {
+        char* memory = heap.arena_base + heap.arena_used;
+        heap.arena_used += rounded;
+        pthread_mutex_unlock(&mutex);
+        from_arena = true;
+        return memory;
+    }
+    pthread_mutex_unlock(&mutex);
+    
+    // Arena agotado (o modo heap): el slab sale del heap normal
+    from_arena = false;
+    return new char[bytes];
+}
+
+void DistributedMemoryPool::grow_class_locked(size_t node, size_t class_index) {
+    SizeClass& size_class = heaps[node].classes[class_index];
+    size_t stride = Block::header_size() + size_class.block_size;
+    size_t bytes = Slab::header_size() + stride * size_class.blocks_per_slab;
+    
+    // Un slab del arena devuelto por trim() se reutiliza antes de tomar más arena
+    Slab* slab = size_class.dormant_slabs;
+    if (slab) {
+        size_class.dormant_slabs = slab->next;
+    } else {
+        bool from_arena = false;
+        slab = reinterpret_cast<Slab*>(allocate_slab_memory(node, bytes, from_arena));
+        slab->bytes = bytes;
+        slab->from_arena = from_arena;
+    }
+    slab->block_count = size_class.blocks_per_slab;
+    slab->free_count = size_class.blocks_per_slab;
+    slab->releasing = false;
+    
+    slab->prev = NULL;
+    slab->next = size_class.slabs;
+    if (size_class.slabs) size_class.slabs->prev = slab;
+    size_class.slabs = slab;
+    
+    char* cursor = reinterpret_cast<char*>(slab) + Slab::header_size();
+    for (size_t i = 0; i < size_class.blocks_per_slab; ++i) {
+        Block* block = new (cursor) Block(size_class.block_size, static_cast<unsigned short>(class_index),
+                                          static_cast<unsigned char>(node));
+        block->data = cursor + Block::header_size();
+        block->slab = slab;
+        block->next = size_class.free_blocks;
+        size_class.free_blocks = block;
+        cursor += stride;
+    }
+    
+    size_class.free_count += size_class.blocks_per_slab;
+    size_class.total_blocks += size_class.blocks_per_slab;
+    add_reserved(bytes);
+}
+
+size_t DistributedMemoryPool::trim_class_locked(size_t node, size_t class_index, size_t retain_blocks) {
+    SizeClass& size_class = heaps[node].classes[class_index];
+    if (size_class.free_count <= retain_blocks) {
+        return 0;
+    }
+    
+    // Marcar slabs completamente libres hasta bajar a la marca de retención
+    size_t releasing_blocks = 0;
+    for (Slab* slab = size_class.slabs; slab; slab = slab->next) {
+        if (size_class.free_count - releasing_blocks <= retain_blocks) break;
+        if (slab->free_count == slab->block_count) {
+            slab->releasing = true;
+            releasing_blocks += slab->block_count;
+        }
+    }
+    if (releasing_blocks == 0) {
+        return 0;
+    }
     
-    if (size > block_size) {
+    // Sacar de la lista libre los bloques de los slabs marcados
+    Block** link = &size_class.free_blocks;
+    while (*link) {
+        if ((*link)->slab->releasing) {
+            *link = (*link)->next;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    size_class.free_count -= releasing_blocks;
+    size_class.total_blocks -= releasing_blocks;
+    
+    size_t released = 0;
+    Slab* slab = size_class.slabs;
+    while (slab) {
+        Slab* next = slab->next;
+        if (slab->releasing) {
+            if (slab->prev) slab->prev->next = slab->next;
+            else size_class.slabs = slab->next;
+            if (slab->next) slab->next->prev = slab->prev;
+            
+            released += slab->bytes;
+            if (slab->from_arena) {
+                // El arena no se puede achicar: se devuelven sus páginas y el
+                // slab queda latente (la cabecera sigue en la primera página)
+                long page = sysconf(_SC_PAGESIZE);
+                size_t page_size = page > 0 ? static_cast<size_t>(page) : 4096;
+                uintptr_t first = round_up(reinterpret_cast<uintptr_t>(slab) + Slab::header_size(), page_size);
+                uintptr_t last = (reinterpret_cast<uintptr_t>(slab) + slab->bytes) & ~(page_size - 1);
+                if (last > first) {
+                    madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+                }
+                slab->releasing = false;
+                slab->next = size_class.dormant_slabs;
+                size_class.dormant_slabs = slab;
+            } else {
+                delete[] reinterpret_cast<char*>(slab);
+            }
+        }
+        slab = next;
+    }
+    
+    remove_reserved(released);
+    return released;
+}
+
+DistributedMemoryPool::Block* DistributedMemoryPool::take_block(size_t node, size_t class_index) {
+    SizeClass& size_class = heaps[node].classes[class_index];
+    pthread_mutex_lock(&size_class.mutex);
+    
+    if (!size_class.free_blocks) {
+        grow_class_locked(node, class_index);
+    }
+    Block* block = size_class.free_blocks;
+    size_class.free_blocks = block->next;
+    size_class.free_count--;
+    block->slab->free_count--;
+    
+    pthread_mutex_unlock(&size_class.mutex);
+    return block;
+}
+
+void DistributedMemoryPool::return_block(Block* block) {
+    SizeClass& size_class = heaps[block->node].classes[block->size_class];
+    pthread_mutex_lock(&size_class.mutex);
+    
+    block->next = size_class.free_blocks;
+    size_class.free_blocks = block;
+    size_class.free_count++;
+    block->slab->free_count++;
+    
+    pthread_mutex_unlock(&size_class.mutex);
+}
+
+void* DistributedMemoryPool::allocate_large(size_t size) {
+    char* raw = new char[Block::header_size() + size];
+    Block* block = new (raw) Block(size, LARGE_OBJECT_CLASS, 0);
+    block->data = raw + Block::header_size();
+    block->in_use = true;
+    
+    pthread_mutex_lock(&mutex);
+    block->next = large_objects;
+    if (large_objects) large_objects->prev = block;
+    large_objects = block;
+    large_object_count++;
+    pthread_mutex_unlock(&mutex);
+    
+    add_reserved(Block::header_size() + size);
+    notify_pressure();
+    return block->data;
+}
+
+void DistributedMemoryPool::deallocate_large(Block* block) {
+    pthread_mutex_lock(&mutex);
+    if (!block->in_use) {
         pthread_mutex_unlock(&mutex);
-        return NULL;
+        return;
+    }
+    block->in_use = false;
+    if (block->prev) block->prev->next = block->next;
+    else large_objects = block->next;
+    if (block->next) block->next->prev = block->prev;
+    large_object_count--;
+    pthread_mutex_unlock(&mutex);
+    
+    remove_reserved(Block::header_size() + block->size);
+    block->magic = 0;
+    delete[] reinterpret_cast<char*>(block);
+}
+
+DistributedMemoryPool::ThreadCache* DistributedMemoryPool::get_thread_cache() {
+    ThreadCache* cache = static_cast<ThreadCache*>(pthread_getspecific(thread_cache_key));
+    if (!cache) {
+        cache = new ThreadCache(this, current_node());
+        
+        pthread_mutex_lock(&mutex);
+        cache->next = thread_caches;
+        thread_caches = cache;
+        pthread_mutex_unlock(&mutex);
+        
+        pthread_setspecific(thread_cache_key, cache);
+    }
+    return cache;
+}
+
+void DistributedMemoryPool::refill_magazine(Magazine* magazine, size_t node, size_t class_index) {
+    SizeClass& size_class = heaps[node].classes[class_index];
+    size_t target = std::max(magazine->capacity / 2, static_cast<size_t>(1));
+    
+    if (!magazine->blocks) {
+        magazine->blocks = new Block*[magazine->capacity];
+    }
+    
+    pthread_mutex_lock(&size_class.mutex);
+    
+    if (!size_class.free_blocks) {
+        grow_class_locked(node, class_index);
+    }
+    
+    while (magazine->count < target && size_class.free_blocks) {
+        Block* block = size_class.free_blocks;
+        size_class.free_blocks = block->next;
+        size_class.free_count--;
+        block->slab->free_count--;
+        magazine->blocks[magazine->count++] = block;
+    }
+    
+    pthread_mutex_unlock(&size_class.mutex);
+}
+
+void DistributedMemoryPool::drain_magazine(Magazine* magazine, size_t node, size_t class_index, size_t keep) {
+    SizeClass& size_class = heaps[node].classes[class_index];
+    
+    pthread_mutex_lock(&size_class.mutex);
+    
+    while (magazine->count > keep) {
+        Block* block = magazine->blocks[--magazine->count];
+        block->next = size_class.free_blocks;
+        size_class.free_blocks = block;
+        size_class.free_count++;
+        block->slab->free_count++;
+    }
+    
+    pthread_mutex_unlock(&size_class.mutex);
+}
+
+void DistributedMemoryPool::release_thread_cache(void* arg) {
+    ThreadCache* cache = static_cast<ThreadCache*>(arg);
+    DistributedMemoryPool* pool = cache->pool;
+    
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        if (cache->magazines[i].count > 0) {
+            pool->drain_magazine(&cache->magazines[i], cache->node, i, 0);
+        }
+    }
+    
+    pthread_mutex_lock(&pool->mutex);
+    ThreadCache** link = &pool->thread_caches;
+    while (*link && *link != cache) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = cache->next;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    
+    delete cache;
+}
+
+void* DistributedMemoryPool::allocate(size_t size) {
+    size_t class_index = size_class_for(size);
+    if (class_index == NUM_SIZE_CLASSES) {
+        return allocate_large(size);
     }
     
     Block* block = NULL;
     
-    if (free_blocks) {
-        block = free_blocks;
-        free_blocks = free_blocks->next;
+    if (thread_cache_enabled) {
+        ThreadCache* cache = get_thread_cache();
+        Magazine* magazine = &cache->magazines[class_index];
+        if (magazine->count == 0) {
+            refill_magazine(magazine, cache->node, class_index);
+        }
+        block = magazine->blocks[--magazine->count];
     } else {
-        block = new Block(block_size);
-        total_blocks++;
+        block = take_block(current_node(), class_index);
     }
     
     block->in_use = true;
-    block->next = used_blocks;
-    used_blocks = block;
+    block->next = NULL;
     
-    pthread_mutex_unlock(&mutex);
+    // Con el bloque ya tomado, los callbacks pueden vaciar la cache sin riesgo
+    notify_pressure();
     return block->data;
 }
 
 void DistributedMemoryPool::deallocate(void* ptr) {
     if (!ptr) return;
     
+    // La cabecera inline evita buscar el bloque en una lista
+    Block* block = Block::from_data(ptr);
+    if (!block) return;
+    
+    if (block->size_class == LARGE_OBJECT_CLASS) {
+        deallocate_large(block);
+        return;
+    }
+    
+    size_t class_index = block->size_class;
+    
+    if (thread_cache_enabled) {
+        if (!block->in_use) return;
+        block->in_use = false;
+        
+        // Los bloques de otro nodo vuelven a su dueño para no mezclar memoria remota
+        ThreadCache* cache = get_thread_cache();
+        if (block->node != cache->node) {
+            return_block(block);
+            return;
+        }
+        
+        Magazine* magazine = &cache->magazines[class_index];
+        if (!magazine->blocks) {
+            magazine->blocks = new Block*[magazine->capacity];
+        }
+        if (magazine->count == magazine->capacity) {
+            drain_magazine(magazine, cache->node, class_index, magazine->capacity / 2);
+        }
+        magazine->blocks[magazine->count++] = block;
+        return;
+    }
+    
+    SizeClass& size_class = heaps[block->node].classes[class_index];
+    pthread_mutex_lock(&size_class.mutex);
+    
+    if (block->in_use) {
+        block->in_use = false;
+        block->next = size_class.free_blocks;
+        size_class.free_blocks = block;
+        size_class.free_count++;
+        block->slab->free_count++;
+    }
+    
+    pthread_mutex_unlock(&size_class.mutex);
+}
+
+bool DistributedMemoryPool::register_unit(BatchUnit* unit) {
     pthread_mutex_lock(&mutex);
     
-    Block* prev = NULL;
-    Block* current = used_blocks;
+    // Reutilizar índices de unidades liberadas por trim(); el contador de
+    // versión de las pilas protege a los lectores que aún vean el índice viejo
+    if (retired_unit_count > 0) {
+        unsigned int index = retired_units[--retired_unit_count];
+        unit_segments[index / UNIT_SEGMENT_SIZE][index % UNIT_SEGMENT_SIZE] = unit;
+        unit->index = index;
+        pthread_mutex_unlock(&mutex);
+        return true;
+    }
     
-    while (current && current->data != ptr) {
-        prev = current;
-        current = current->next;
+    size_t segment = unit_count / UNIT_SEGMENT_SIZE;
+    if (segment >= MAX_UNIT_SEGMENTS) {
+        pthread_mutex_unlock(&mutex);
+        return false;
     }
     
-    if (current) {
-        if (prev) {
-            prev->next = current->next;
-        } else {
-            used_blocks = current->next;
+    if (!unit_segments[segment]) {
+        unit_segments[segment] = new BatchUnit*[UNIT_SEGMENT_SIZE];
+    }
+    unit_segments[segment][unit_count % UNIT_SEGMENT_SIZE] = unit;
+    unit->index = static_cast<unsigned int>(unit_count);
+    unit_count++;
+    
+    pthread_mutex_unlock(&mutex);
+    return true;
+}
+
+void DistributedMemoryPool::track_unit_locked(BatchUnit* unit) {
+    UnitDirectory* directory = unit_directory;
+    
+    // Rehacer la tabla antes de pasar de la mitad de ocupación (borradas incluidas)
+    if ((directory->used + 1) * 2 > directory->capacity) {
+        size_t capacity = MIN_UNIT_DIRECTORY;
+        while (capacity < (directory->live + 1) * 4) {
+            capacity <<= 1;
+        }
+        
+        UnitDirectory* grown = new UnitDirectory();
+        grown->slots = new uintptr_t[capacity]();
+        grown->capacity = capacity;
+        grown->used = directory->live;
+        grown->live = directory->live;
+        grown->retired = directory;
+        for (size_t i = 0; i < directory->capacity; ++i) {
+            uintptr_t address = directory->slots[i];
+            if (address == EMPTY_UNIT_SLOT || address == REMOVED_UNIT_SLOT) continue;
+            size_t slot = unit_slot(address, capacity);
+            while (grown->slots[slot] != EMPTY_UNIT_SLOT) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            grown->slots[slot] = address;
         }
         
-        current->in_use = false;
-        current->next = free_blocks;
-        free_blocks = current;
+        // La tabla nueva queda completa antes de que un lector pueda verla
+        __sync_synchronize();
+        unit_directory = grown;
+        directory = grown;
     }
     
-    pthread_mutex_unlock(&mutex);
+    uintptr_t address = reinterpret_cast<uintptr_t>(unit);
+    size_t slot = unit_slot(address, directory->capacity);
+    while (directory->slots[slot] != EMPTY_UNIT_SLOT && directory->slots[slot] != REMOVED_UNIT_SLOT) {
+        slot = (slot + 1) & (directory->capacity - 1);
+    }
+    if (directory->slots[slot] == EMPTY_UNIT_SLOT) {
+        directory->used++;
+    }
+    directory->live++;
+    __sync_synchronize();
+    directory->slots[slot] = address;
+}
+
+void DistributedMemoryPool::untrack_unit_locked(BatchUnit* unit) {
+    UnitDirectory* directory = unit_directory;
+    uintptr_t address = reinterpret_cast<uintptr_t>(unit);
+    
+    size_t slot = unit_slot(address, directory->capacity);
+    while (directory->slots[slot] != EMPTY_UNIT_SLOT) {
+        if (directory->slots[slot] == address) {
+            directory->slots[slot] = REMOVED_UNIT_SLOT;
+            directory->live--;
+            return;
+        }
+        slot = (slot + 1) & (directory->capacity - 1);
+    }
+}
+
+bool DistributedMemoryPool::owns_unit(const RecordBatch* batch) const {
+    // Las tablas retiradas siguen vivas, así que basta con leer el puntero
+    const UnitDirectory* directory = unit_directory;
+    uintptr_t address = reinterpret_cast<uintptr_t>(batch);
+    if (address == EMPTY_UNIT_SLOT || address == REMOVED_UNIT_SLOT) return false;
+    
+    size_t slot = unit_slot(address, directory->capacity);
+    for (size_t probes = 0; probes < directory->capacity; ++probes) {
+        uintptr_t entry = directory->slots[slot];
+        if (entry == address) return true;
+        if (entry == EMPTY_UNIT_SLOT) return false;
+        slot = (slot + 1) & (directory->capacity - 1);
+    }
+    return false;
+}
+
+DistributedMemoryPool::BatchUnit* DistributedMemoryPool::unit_at(unsigned int index) const {
+    // Los segmentos nunca se mueven ni se liberan mientras vive el pool
+    return unit_segments[index / UNIT_SEGMENT_SIZE][index % UNIT_SEGMENT_SIZE];
+}
+
+size_t DistributedMemoryPool::enter_reclaim_epoch() {
+    while (true) {
+        unsigned int epoch = reclaim_epoch;
+        size_t parity = epoch & 1;
+        __sync_fetch_and_add(&epoch_readers[parity], 1);
+        
+        // Si la época avanzó entre la lectura y el registro, synchronize_reclaim
+        // pudo no vernos: reintentar con la nueva
+        if (reclaim_epoch == epoch) {
+            return parity;
+        }
+        __sync_fetch_and_sub(&epoch_readers[parity], 1);
+    }
+}
+
+void DistributedMemoryPool::leave_reclaim_epoch(size_t parity) {
+    __sync_fetch_and_sub(&epoch_readers[parity], 1);
+}
+
+void DistributedMemoryPool::synchronize_reclaim() {
+    pthread_mutex_lock(&reclaim_mutex);
+    
+    // Los lectores nuevos entran en la otra paridad; basta esperar a que
+    // salgan los que ya estaban dentro
+    size_t parity = __sync_fetch_and_add(&reclaim_epoch, 1) & 1;
+    while (epoch_readers[parity] != 0) {
+        sched_yield();
+    }
+    
+    pthread_mutex_unlock(&reclaim_mutex);
+}
+
+DistributedMemoryPool::BatchUnit* DistributedMemoryPool::pop_batch_unit(size_t node, size_t class_index) {
+    BatchStack& stack = heaps[node].batch_stacks[class_index];
+    size_t parity = enter_reclaim_epoch();
+    
+    while (true) {
+        uint64_t old_head = stack.head;
+        unsigned int top = static_cast<unsigned int>(old_head & 0xFFFFFFFFu);
+        if (top == 0) {
+            leave_reclaim_epoch(parity);
+            return NULL;
+        }
+        
+        // Otro hilo puede haber sacado la unidad: el contador de versión hace
+        // fallar el CAS, y trim() no la libera mientras sigamos en la época
+        BatchUnit* unit = unit_at(top - 1);
+        uint64_t version = (old_head >> 32) + 1;
+        uint64_t new_head = (version << 32) | unit->next_index;
+        
+        if (__sync_bool_compare_and_swap(&stack.head, old_head, new_head)) {
+            __sync_fetch_and_sub(&stack.depth, 1);
+            leave_reclaim_epoch(parity);
+            return unit;
+        }
+    }
+}
+
+void DistributedMemoryPool::push_batch_unit(BatchUnit* unit) {
+    // Cada unidad vuelve a la pila del nodo que posee su memoria
+    BatchStack& stack = heaps[unit->node].batch_stacks[unit->size_class];
+    
+    while (true) {
+        uint64_t old_head = stack.head;
+        unit->next_index = static_cast<unsigned int>(old_head & 0xFFFFFFFFu);
+        uint64_t version = (old_head >> 32) + 1;
+        uint64_t new_head = (version << 32) | (unit->index + 1);
+        
+        if (__sync_bool_compare_and_swap(&stack.head, old_head, new_head)) {
+            __sync_fetch_and_add(&stack.depth, 1);
+            return;
+        }
+    }
 }
 
 RecordBatch* DistributedMemoryPool::create_batch(size_t capacity) {
-    RecordBatch* batch = new RecordBatch();
-    batch->records = static_cast<DatabaseRecord*>(allocate(sizeof(DatabaseRecord) * capacity));
+    size_t bytes = BatchUnit::header_size() + sizeof(DatabaseRecord) * capacity;
+    size_t class_index = size_class_for(bytes);
+    
+    BatchUnit* unit = NULL;
+    if (class_index < NUM_SIZE_CLASSES) {
+        size_t node = thread_cache_enabled ? get_thread_cache()->node : current_node();
+        unit = pop_batch_unit(node, class_index);
+    }
+    
+    if (!unit) {
+        // Con la región agotada el lote vuelve a ser privado (camino serializado)
+        char* payload = NULL;
+        if (shared_region && class_index < NUM_SIZE_CLASSES) {
+            payload = take_shared_payload(class_index);
+        }
+        
+        size_t unit_bytes = class_index < NUM_SIZE_CLASSES ? MIN_CLASS_SIZE << class_index : bytes;
+        char* raw = static_cast<char*>(allocate(payload ? BatchUnit::header_size() : unit_bytes));
+        
+        unit = new (raw) BatchUnit();
+        unit->magic = BATCH_MAGIC;
+        unit->index = UNREGISTERED_UNIT;
+        unit->next_index = 0;
+        unit->size_class = class_index;
+        unit->node = Block::from_data(raw)->node;
+        unit->shared_payload = payload;
+        unit->shared_bytes = payload ? unit_bytes : 0;
+        if (payload) {
+            unit->max_capacity = unit_bytes / sizeof(DatabaseRecord);
+            unit->batch.records = reinterpret_cast<DatabaseRecord*>(payload);
+        } else {
+            unit->max_capacity = (unit_bytes - BatchUnit::header_size()) / sizeof(DatabaseRecord);
+            unit->batch.records = reinterpret_cast<DatabaseRecord*>(raw + BatchUnit::header_size());
+        }
+        
+        if (class_index == NUM_SIZE_CLASSES || !register_unit(unit)) {
+            unit->size_class = NUM_SIZE_CLASSES;
+        }
+        
+        pthread_mutex_lock(&mutex);
+        track_unit_locked(unit);
+        pthread_mutex_unlock(&mutex);
+    }
+    
+    RecordBatch* batch = &unit->batch;
     batch->capacity = capacity;
     batch->count = 0;
-    batch->batch_id = rand(); // ID único simple
+    batch->batch_id = __sync_add_and_fetch(&next_batch_id, 1);
     return batch;
 }
 
 void DistributedMemoryPool::free_batch(RecordBatch* batch) {
-    if (batch) {
-        deallocate(batch->records);
-        delete batch;
+    if (!batch) return;
+    
+    // Primero el directorio: un lote ajeno puede ser más pequeño que BatchUnit
+    if (!owns_unit(batch)) return;
+    
+    BatchUnit* unit = reinterpret_cast<BatchUnit*>(batch);
+    if (unit->magic != BATCH_MAGIC) return;
+    
+    if (unit->size_class < NUM_SIZE_CLASSES) {
+        push_batch_unit(unit);
+    } else {
+        pthread_mutex_lock(&mutex);
+        untrack_unit_locked(unit);
+        pthread_mutex_unlock(&mutex);
+        if (unit->shared_payload) {
+            release_shared_payload(unit->shared_payload, unit->shared_bytes);
+        }
+        unit->magic = 0;
+        deallocate(unit);
+    }
+}
+
+size_t DistributedMemoryPool::get_cached_batch_count() const {
+    size_t cached = 0;
+    for (size_t node = 0; node < node_count; ++node) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            cached += heaps[node].batch_stacks[i].depth;
+        }
     }
+    return cached;
 }
 
 size_t DistributedMemoryPool::get_total_blocks() const {
-    pthread_mutex_lock(&mutex);
-    size_t total = total_blocks;
-    pthread_mutex_unlock(&mutex);
+    size_t total, free, used;
+    get_statistics(total, free, used);
     return total;
 }
 
 void DistributedMemoryPool::get_statistics(size_t& total, size_t& free, size_t& used) const {
+    total = 0;
+    free = 0;
+    
+    for (size_t node = 0; node < node_count; ++node) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            SizeClass& size_class = heaps[node].classes[i];
+            pthread_mutex_lock(&size_class.mutex);
+            total += size_class.total_blocks;
+            free += size_class.free_count;
+            pthread_mutex_unlock(&size_class.mutex);
+        }
+    }
+    
     pthread_mutex_lock(&mutex);
     
-    total = total_blocks;
+    for (ThreadCache* cache = thread_caches; cache; cache = cache->next) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            free += cache->magazines[i].count;
+        }
+    }
+    total += large_object_count;
     
-    // Contar bloques libres
-    free = 0;
-    Block* current = free_blocks;
-    while (current) {
-        free++;
-        current = current->next;
+    pthread_mutex_unlock(&mutex);
+    
+    // Los lotes retenidos para reciclaje son memoria reutilizable
+    free += get_cached_batch_count();
+    
+    used = total - free;
+}
+
+size_t DistributedMemoryPool::get_arena_bytes_used() const {
+    size_t used = 0;
+    pthread_mutex_lock(&mutex);
+    for (size_t node = 0; node < node_count; ++node) {
+        used += heaps[node].arena_used;
+    }
+    pthread_mutex_unlock(&mutex);
+    return used;
+}
+
+void DistributedMemoryPool::expand_pool(size_t additional_blocks) {
+    if (default_class >= NUM_SIZE_CLASSES) return;
+    
+    size_t node = current_node();
+    SizeClass& size_class = heaps[node].classes[default_class];
+    pthread_mutex_lock(&size_class.mutex);
+    
+    size_t target = size_class.total_blocks + additional_blocks;
+    while (size_class.total_blocks < target) {
+        grow_class_locked(node, default_class);
+    }
+    
+    pthread_mutex_unlock(&size_class.mutex);
+    
+    notify_pressure();
+}
+
+void DistributedMemoryPool::add_reserved(size_t bytes) {
+    size_t reserved = __sync_add_and_fetch(&reserved_bytes, bytes);
+    
+    size_t high = high_water_bytes;
+    while (reserved > high && !__sync_bool_compare_and_swap(&high_water_bytes, high, reserved)) {
+        high = high_water_bytes;
+    }
+    
+    // 0 = armado, 1 = aviso pendiente, 2 = avisado
+    if (pressure_limit > 0 && reserved > pressure_limit) {
+        __sync_bool_compare_and_swap(&pressure_signaled, 0, 1);
+    }
+}
+
+void DistributedMemoryPool::remove_reserved(size_t bytes) {
+    size_t reserved = __sync_sub_and_fetch(&reserved_bytes, bytes);
+    
+    size_t low = low_water_bytes;
+    while (reserved < low && !__sync_bool_compare_and_swap(&low_water_bytes, low, reserved)) {
+        low = low_water_bytes;
     }
     
-    // Contar bloques usados
-    used = 0;
-    current = used_blocks;
-    while (current) {
-        used++;
-        current = current->next;
+    if (pressure_limit > 0 && reserved <= pressure_limit) {
+        __sync_bool_compare_and_swap(&pressure_signaled, 2, 0);
+    }
+}
+
+void DistributedMemoryPool::notify_pressure() {
+    if (pressure_signaled != 1 || !__sync_bool_compare_and_swap(&pressure_signaled, 1, 2)) {
+        return;
     }
     
+    pthread_mutex_lock(&mutex);
+    size_t count = pressure_callback_count;
     pthread_mutex_unlock(&mutex);
+    
+    for (size_t i = 0; i < count; ++i) {
+        pressure_callbacks[i](this, reserved_bytes, pressure_user_data[i]);
+    }
 }
 
-void DistributedMemoryPool::expand_pool(size_t additional_blocks) {
+bool DistributedMemoryPool::add_pressure_callback(MemoryPressureCallback callback, void* user_data) {
+    if (!callback) return false;
+    
+    pthread_mutex_lock(&mutex);
+    if (pressure_callback_count == MAX_PRESSURE_CALLBACKS) {
+        pthread_mutex_unlock(&mutex);
+        return false;
+    }
+    pressure_callbacks[pressure_callback_count] = callback;
+    pressure_user_data[pressure_callback_count] = user_data;
+    pressure_callback_count++;
+    pthread_mutex_unlock(&mutex);
+    return true;
+}
+
+char* DistributedMemoryPool::take_shared_payload(size_t class_index) {
+    size_t bytes = MIN_CLASS_SIZE << class_index;
+    SharedPayloadList& list = shared_payloads[class_index];
+    char* payload = NULL;
+    
     pthread_mutex_lock(&mutex);
+    if (list.count > 0) {
+        payload = list.chunks[--list.count];
+    } else if (shared_used + bytes <= shared_region->get_size()) {
+        // Las clases son potencias de dos desde 64 bytes: el corte queda alineado
+        payload = static_cast<char*>(shared_region->get_memory()) + shared_used;
+        shared_used += bytes;
+    }
+    pthread_mutex_unlock(&mutex);
     
-    for (size_t i = 0; i < additional_blocks; ++i) {
-        Block* block = new Block(block_size);
-        block->next = free_blocks;
-        free_blocks = block;
-        total_blocks++;
+    if (payload) {
+        add_reserved(bytes);
+        notify_pressure();
+    }
+    return payload;
+}
+
+size_t DistributedMemoryPool::release_shared_payload(char* payload, size_t bytes) {
+    // MADV_REMOVE libera las páginas del objeto compartido, no solo el mapeo
+    long page = sysconf(_SC_PAGESIZE);
+    size_t page_size = page > 0 ? static_cast<size_t>(page) : 4096;
+    uintptr_t first = round_up(reinterpret_cast<uintptr_t>(payload), page_size);
+    uintptr_t last = (reinterpret_cast<uintptr_t>(payload) + bytes) & ~(page_size - 1);
+    if (last > first) {
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_REMOVE);
     }
     
+    SharedPayloadList& list = shared_payloads[size_class_for(bytes)];
+    pthread_mutex_lock(&mutex);
+    if (list.count == list.capacity) {
+        size_t capacity = list.capacity ? list.capacity * 2 : 16;
+        char** grown = new char*[capacity];
+        for (size_t i = 0; i < list.count; ++i) {
+            grown[i] = list.chunks[i];
+        }
+        delete[] list.chunks;
+        list.chunks = grown;
+        list.capacity = capacity;
+    }
+    list.chunks[list.count++] = payload;
     pthread_mutex_unlock(&mutex);
+    
+    remove_reserved(bytes);
+    return bytes;
+}
+
+size_t DistributedMemoryPool::trim_batch_stack(size_t node, size_t class_index, size_t retain_units) {
+    size_t released = 0;
+    BatchUnit* popped[TRIM_UNIT_BATCH];
+    
+    while (heaps[node].batch_stacks[class_index].depth > retain_units) {
+        size_t count = 0;
+        while (count < TRIM_UNIT_BATCH && heaps[node].batch_stacks[class_index].depth > retain_units) {
+            BatchUnit* unit = pop_batch_unit(node, class_index);
+            if (!unit) break;
+            popped[count++] = unit;
+        }
+        if (count == 0) break;
+        
+        // Un pop concurrente pudo leer next_index de estas unidades antes de
+        // que las sacáramos: no se liberan hasta que su época termina
+        synchronize_reclaim();
+        
+        pthread_mutex_lock(&mutex);
+        for (size_t i = 0; i < count; ++i) {
+            if (retired_unit_count == retired_unit_capacity) {
+                size_t capacity = retired_unit_capacity ? retired_unit_capacity * 2 : 64;
+                unsigned int* grown = new unsigned int[capacity];
+                for (size_t j = 0; j < retired_unit_count; ++j) {
+                    grown[j] = retired_units[j];
+                }
+                delete[] retired_units;
+                retired_units = grown;
+                retired_unit_capacity = capacity;
+            }
+            retired_units[retired_unit_count++] = popped[i]->index;
+            untrack_unit_locked(popped[i]);
+        }
+        pthread_mutex_unlock(&mutex);
+        
+        for (size_t i = 0; i < count; ++i) {
+            BatchUnit* unit = popped[i];
+            if (unit->shared_payload) {
+                released += release_shared_payload(unit->shared_payload, unit->shared_bytes);
+            }
+            unit->magic = 0;
+            deallocate(unit);
+        }
+    }
+    return released;
+}
+
+size_t DistributedMemoryPool::trim() {
+    size_t released = 0;
+    for (size_t node = 0; node < node_count; ++node) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            released += trim_batch_stack(node, i, trim_watermark / heaps[node].classes[i].block_size);
+        }
+    }
+    
+    // Solo la cache del hilo llamante es accesible sin carreras
+    if (thread_cache_enabled) {
+        ThreadCache* cache = static_cast<ThreadCache*>(pthread_getspecific(thread_cache_key));
+        if (cache) {
+            for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+                if (cache->magazines[i].count > 0) {
+                    drain_magazine(&cache->magazines[i], cache->node, i, 0);
+                }
+            }
+        }
+    }
+    
+    for (size_t node = 0; node < node_count; ++node) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            SizeClass& size_class = heaps[node].classes[i];
+            pthread_mutex_lock(&size_class.mutex);
+            released += trim_class_locked(node, i, trim_watermark / size_class.block_size);
+            pthread_mutex_unlock(&size_class.mutex);
+        }
+    }
+    
+    // Los slabs del heap vuelven a malloc; malloc_trim devuelve sus páginas al sistema
+    if (released > 0) {
+        malloc_trim(0);
+    }
+    
+    __sync_fetch_and_add(&released_bytes, released);
+    __sync_fetch_and_add(&trim_count, 1);
+    return released;
+}
+
+void* DistributedMemoryPool::trim_thread_function(void* arg) {
+    DistributedMemoryPool* pool = static_cast<DistributedMemoryPool*>(arg);
+    
+    pthread_mutex_lock(&pool->trim_mutex);
+    while (!pool->trim_thread_stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += pool->trim_interval_ms / 1000;
+        deadline.tv_nsec += (pool->trim_interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        
+        int rc = 0;
+        while (!pool->trim_thread_stop && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&pool->trim_cond, &pool->trim_mutex, &deadline);
+        }
+        if (pool->trim_thread_stop) break;
+        
+        pthread_mutex_unlock(&pool->trim_mutex);
+        pool->trim();
+        pthread_mutex_lock(&pool->trim_mutex);
+    }
+    pthread_mutex_unlock(&pool->trim_mutex);
+    
+    return NULL;
+}
+
+bool DistributedMemoryPool::start_background_trim(unsigned int interval_ms) {
+    if (trim_thread_running || interval_ms == 0) return false;
+    
+    trim_interval_ms = interval_ms;
+    trim_thread_stop = false;
+    if (pthread_create(&trim_thread, NULL, trim_thread_function, this) != 0) {
+        return false;
+    }
+    trim_thread_running = true;
+    return true;
+}
+
+void DistributedMemoryPool::stop_background_trim() {
+    if (!trim_thread_running) return;
+    
+    pthread_mutex_lock(&trim_mutex);
+    trim_thread_stop = true;
+    pthread_cond_signal(&trim_cond);
+    pthread_mutex_unlock(&trim_mutex);
+    
+    pthread_join(trim_thread, NULL);
+    trim_thread_running = false;
+}
+
+void DistributedMemoryPool::get_usage(MemoryPoolUsage& usage) const {
+    usage.reserved_bytes = reserved_bytes;
+    usage.high_water_bytes = high_water_bytes;
+    usage.low_water_bytes = low_water_bytes;
+    usage.released_bytes = released_bytes;
+    usage.trim_count = trim_count;
+}
+
+void DistributedMemoryPool::reset_watermarks() {
+    size_t reserved = reserved_bytes;
+    high_water_bytes = reserved;
+    low_water_bytes = reserved;
+}
+
+bool DistributedMemoryPool::is_shared(const void* ptr, size_t bytes) const {
+    if (!shared_region || !ptr) return false;
+    
+    const char* base = static_cast<const char*>(shared_region->get_memory());
+    const char* begin = static_cast<const char*>(ptr);
+    return begin >= base && bytes <= shared_region->get_size() &&
+           static_cast<size_t>(begin - base) <= shared_region->get_size() - bytes;
+}
+
+size_t DistributedMemoryPool::usable_size(void* ptr) {
+    if (!ptr) return 0;
+    Block* block = Block::from_data(ptr);
+    return block ? block->size : 0;
 }
 
 } // namespace distributed
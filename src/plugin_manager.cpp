@@ -19,12 +19,16 @@
 
 // src/plugin_manager.cpp
 #include "plugin_manager.h"
+#include "memory_pool.h"
 #include <iostream>
 #include <algorithm>
 #include <sys/time.h>
 #include <signal.h>
 #include <setjmp.h>
 #include <sstream>
+#include <deque>
+#include <cstring>
+#include <pthread.h>
 
 namespace distributed {
 
@@ -38,7 +42,8 @@ static void timeout_signal_handler(int sig) {
 }
 
 ResilientPluginManager::ResilientPluginManager(IMemoryPool* memory_pool) 
-    : memory_pool(memory_pool) {
+    : memory_pool(memory_pool), execution_mode(PROCESS_PER_STAGE),
+      stage_queue_capacity(IsolatedPluginProcess::MAX_PIPELINE_DEPTH), preserve_order(true) {
     
     // Instalar handler de timeout
     signal(SIGALRM, timeout_signal_handler);
@@ -59,36 +64,140 @@ bool ResilientPluginManager::load_pipeline_config(const std::vector<PipelineStag
     }
     plugins.clear();
     
+    fused_configs.clear();
+    
     // Cargar nuevos plugins
     bool all_loaded = true;
+    std::vector<const PipelineStageConfig*> fused_run;
     for (size_t i = 0; i < pipeline_config.size(); ++i) {
-        if (pipeline_config[i].enabled) {
-            if (!add_plugin(pipeline_config[i])) {
-                std::cerr << "Error cargando plugin: " << pipeline_config[i].name << std::endl;
-                all_loaded = false;
-            }
+        const PipelineStageConfig& stage = pipeline_config[i];
+        if (!stage.enabled) continue;
+        
+        // Fusionado: las etapas aisladas consecutivas comparten proceso
+        if (execution_mode == FUSED_PROCESS && stage.isolation == ISOLATION_PROCESS) {
+            fused_run.push_back(&stage);
+            continue;
+        }
+        if (!fused_run.empty()) {
+            all_loaded = start_fused_host(fused_run) && all_loaded;
+            fused_run.clear();
+        }
+        
+        if (!add_plugin(stage)) {
+            std::cerr << "Error cargando plugin: " << stage.name << std::endl;
+            all_loaded = false;
         }
     }
+    if (!fused_run.empty()) {
+        all_loaded = start_fused_host(fused_run) && all_loaded;
+    }
     
     return all_loaded;
 }
 
 bool ResilientPluginManager::add_plugin(const PipelineStageConfig& config) {
-    IsolatedPluginProcess* plugin = new IsolatedPluginProcess(
-        config.name, config.library_path, config.parameters);
+    if (config.isolation == ISOLATION_NONE) {
+        InProcessPlugin* plugin = new InProcessPlugin(config.name, config.library_path, config.parameters);
+        if (!plugin->load()) {
+            delete plugin;
+            return false;
+        }
+        plugins.push_back(plugin);
+        std::cout << "Plugin en proceso agregado al manager: " << config.name << std::endl;
+        return true;
+    }
     
-    if (!plugin->start()) {
-        delete plugin;
+    HostedStage hosted;
+    hosted.name = config.name;
+    hosted.library_path = config.library_path;
+    hosted.config_params = config.parameters;
+    
+    IProcessingComponent* plugin = start_plugin_process(std::vector<HostedStage>(1, hosted), config);
+    if (!plugin) return false;
+    
+    plugins.push_back(plugin);
+    std::cout << "Plugin agregado al manager: " << config.name << std::endl;
+    return true;
+}
+
+bool ResilientPluginManager::start_fused_host(const std::vector<const PipelineStageConfig*>& stages) {
+    std::vector<HostedStage> hosted_stages;
+    PipelineStageConfig fused_config;
+    fused_config.failover_config.max_retries = 0;
+    fused_config.failover_config.timeout_ms = 0;
+    fused_config.pipeline_depth = static_cast<int>(IsolatedPluginProcess::MAX_PIPELINE_DEPTH);
+    fused_config.replicas = static_cast<int>(ReplicatedStage::MAX_REPLICAS);
+    
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const PipelineStageConfig& stage = *stages[i];
+        
+        HostedStage hosted;
+        hosted.name = stage.name;
+        hosted.library_path = stage.library_path;
+        hosted.config_params = stage.parameters;
+        hosted_stages.push_back(hosted);
+        
+        // El tramo fusionado es tan estricto como su etapa más estricta
+        FailoverConfig& fused = fused_config.failover_config;
+        if (i == 0) {
+            fused.policy = stage.failover_config.policy;
+            fused.initial_delay_ms = stage.failover_config.initial_delay_ms;
+            fused.max_delay_ms = stage.failover_config.max_delay_ms;
+            fused.backoff_multiplier = stage.failover_config.backoff_multiplier;
+        } else if (stage.failover_config.policy == FAIL_FAST) {
+            fused.policy = FAIL_FAST;
+        }
+        fused.max_retries = std::max(fused.max_retries, stage.failover_config.max_retries);
+        fused.timeout_ms += stage.failover_config.timeout_ms;
+        fused_config.pipeline_depth = std::min(fused_config.pipeline_depth, stage.pipeline_depth);
+        fused_config.replicas = std::min(fused_config.replicas, stage.replicas);
+        
+        fused_config.name += (i > 0 ? "+" : "") + stage.name;
+    }
+    
+    IProcessingComponent* plugin = start_plugin_process(hosted_stages, fused_config);
+    if (!plugin) {
+        std::cerr << "Error cargando pipeline fusionado: " << fused_config.name << std::endl;
         return false;
     }
     
     plugins.push_back(plugin);
-    std::cout << "Plugin agregado al manager: " << config.name << std::endl;
+    fused_configs.push_back(fused_config);
+    std::cout << "Pipeline fusionado agregado al manager: " << fused_config.name << std::endl;
     return true;
 }
 
+IProcessingComponent* ResilientPluginManager::start_plugin_process(const std::vector<HostedStage>& stages,
+                                                                   const PipelineStageConfig& config) {
+    size_t depth = static_cast<size_t>(std::max(config.pipeline_depth, 1));
+    DistributedMemoryPool* pool = dynamic_cast<DistributedMemoryPool*>(memory_pool);
+    const SharedMemoryRegion* region = pool ? pool->get_shared_region() : NULL;
+    
+    // Con un pool respaldado por memoria compartida los lotes pasan por desplazamiento
+    if (config.replicas > 1) {
+        ReplicatedStage* stage = new ReplicatedStage(config.name, stages,
+                                                     static_cast<size_t>(config.replicas));
+        stage->set_pipeline_depth(depth);
+        if (region) stage->attach_batch_region(region);
+        if (!stage->start()) {
+            delete stage;
+            return NULL;
+        }
+        return stage;
+    }
+    
+    IsolatedPluginProcess* plugin = new IsolatedPluginProcess(config.name, stages);
+    plugin->set_pipeline_depth(depth);
+    if (region) plugin->attach_batch_region(region);
+    if (!plugin->start()) {
+        delete plugin;
+        return NULL;
+    }
+    return plugin;
+}
+
 bool ResilientPluginManager::remove_plugin(const std::string& plugin_name) {
-    for (std::vector<IsolatedPluginProcess*>::iterator it = plugins.begin(); 
+    for (std::vector<IProcessingComponent*>::iterator it = plugins.begin(); 
          it != plugins.end(); ++it) {
         if ((*it)->get_name() == plugin_name) {
             delete *it;
@@ -109,39 +218,400 @@ bool ResilientPluginManager::process_batch_through_pipeline(RecordBatch* batch)
             continue;
         }
         
-        // Encontrar configuración del plugin
-        const PipelineStageConfig* config = NULL;
-        for (size_t j = 0; j < pipeline_config.size(); ++j) {
-            if (pipeline_config[j].name == plugins[i]->get_name()) {
-                config = &pipeline_config[j];
-                break;
-            }
+        const PipelineStageConfig* config = find_stage_config(plugins[i]->get_name());
+        if (!config) continue;
+        
+        // Ejecutar plugin con failover
+        if (!run_stage_with_failover(plugins[i], *config, batch)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// Un lote y la orden de parada
+static const size_t STAGE_WORKER_RING_CAPACITY = 2;
+
+// Hilo de una etapa en proceso en process_batches_through_pipeline: en el
+// propio bucle, un plugin lento dejaría sin lotes a los hijos de las demás
+// etapas. Toma los lotes de uno en uno por un ShmRing en memoria del nodo
+// y responde por otro, que el bucle espera junto a los de los hijos
+struct StageWorker {
+    ResilientPluginManager* manager;
+    IProcessingComponent* component;
+    const PipelineStageConfig* config;
+    std::vector<char> memory;
+    ShmRing requests;
+    ShmRing responses;
+    RecordBatch* batch;          ///< Lote de la petición en curso
+    uint32_t next_sequence;
+    pthread_t thread;
+    bool running;
+    
+    StageWorker(ResilientPluginManager* owner, IProcessingComponent* stage_component,
+                const PipelineStageConfig* stage_config)
+        : manager(owner), component(stage_component), config(stage_config),
+          memory(2 * ShmRing::required_size(STAGE_WORKER_RING_CAPACITY)),
+          batch(NULL), next_sequence(0), running(false) {}
+    
+    ~StageWorker() {
+        stop();
+    }
+    
+    bool start(void* (*function)(void*)) {
+        size_t size = ShmRing::required_size(STAGE_WORKER_RING_CAPACITY);
+        if (!requests.init(&memory[0], size, STAGE_WORKER_RING_CAPACITY) ||
+            !responses.init(&memory[size], size, STAGE_WORKER_RING_CAPACITY)) {
+            return false;
         }
         
+        // El hilo hereda SIGALRM bloqueada: la alarma de execute_plugin_with_timeout
+        // hace longjmp en el hilo del bucle y no debe caer en este
+        sigset_t alarm_mask, previous_mask;
+        sigemptyset(&alarm_mask);
+        sigaddset(&alarm_mask, SIGALRM);
+        pthread_sigmask(SIG_BLOCK, &alarm_mask, &previous_mask);
+        running = pthread_create(&thread, NULL, function, this) == 0;
+        pthread_sigmask(SIG_SETMASK, &previous_mask, NULL);
+        return running;
+    }
+    
+    // Solo con el hilo libre: el lote se publica antes de encolar la petición
+    uint32_t submit(RecordBatch* next) {
+        BatchDescriptor descriptor;
+        memset(&descriptor, 0, sizeof(descriptor));
+        descriptor.type = IPCMessage::PROCESS_BATCH;
+        if (++next_sequence == 0) ++next_sequence;
+        descriptor.sequence = next_sequence;
+        batch = next;
+        return requests.push(descriptor) ? descriptor.sequence : 0;
+    }
+    
+    uint32_t collect(int* result) {
+        BatchDescriptor descriptor;
+        if (!responses.pop(descriptor)) return 0;
+        *result = descriptor.result;
+        return descriptor.sequence;
+    }
+    
+    // Un lote en curso termina antes: un plugin en proceso no se interrumpe
+    void stop() {
+        if (!running) return;
+        
+        BatchDescriptor descriptor;
+        memset(&descriptor, 0, sizeof(descriptor));
+        descriptor.type = IPCMessage::SHUTDOWN;
+        requests.push(descriptor);
+        pthread_join(thread, NULL);
+        running = false;
+    }
+};
+
+void* ResilientPluginManager::stage_worker_function(void* arg) {
+    StageWorker* worker = static_cast<StageWorker*>(arg);
+    
+    BatchDescriptor descriptor;
+    while (worker->requests.wait_pop(descriptor, -1) && descriptor.type != IPCMessage::SHUTDOWN) {
+        bool handled = worker->manager->run_stage_with_failover(worker->component, *worker->config,
+                                                                worker->batch);
+        descriptor.type = IPCMessage::BATCH_RESULT;
+        descriptor.result = handled ? 0 : -1;
+        worker->responses.push(descriptor);
+    }
+    return NULL;
+}
+
+// Hilos de las etapas en proceso, parados al salir por cualquier camino
+struct StageWorkers {
+    std::vector<StageWorker*> workers;
+    
+    ~StageWorkers() {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            delete workers[i];
+        }
+    }
+};
+
+// Cola y estado de una etapa en process_batches_through_pipeline
+struct StageLane {
+    IProcessingComponent* component;
+    IPipelinedComponent* pipelined;      ///< NULL en proceso
+    StageWorker* worker;                 ///< Hilo de la etapa en proceso (NULL: en el propio bucle)
+    const PipelineStageConfig* config;
+    std::deque<size_t> queue;            ///< Lotes que esperan a esta etapa
+    std::vector<std::pair<uint32_t, size_t> > pending;  ///< Petición en vuelo -> lote
+    std::vector<bool> finished;          ///< Terminados aquí (solo con orden preservado)
+    size_t next_release;                 ///< Siguiente lote a entregar en orden
+    size_t held;                         ///< Terminados que esperan a uno anterior
+    long last_progress_ms;               ///< Último envío con la ventana vacía o última respuesta
+};
+
+static long monotonic_now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+// Pasar un lote terminado en la etapa stage a la siguiente (o a la salida)
+static void release_batch(std::vector<StageLane>& lanes, size_t stage, size_t index,
+                          bool preserve_order, std::vector<size_t>& output) {
+    StageLane& lane = lanes[stage];
+    std::vector<size_t> released;
+    if (!preserve_order) {
+        released.push_back(index);
+    } else {
+        lane.finished[index] = true;
+        ++lane.held;
+        while (lane.next_release < lane.finished.size() && lane.finished[lane.next_release]) {
+            released.push_back(lane.next_release++);
+            --lane.held;
+        }
+    }
+    
+    for (size_t i = 0; i < released.size(); ++i) {
+        if (stage + 1 < lanes.size()) {
+            lanes[stage + 1].queue.push_back(released[i]);
+        } else {
+            output.push_back(released[i]);
+        }
+    }
+}
+
+static void abandon_lanes(std::vector<StageLane>& lanes) {
+    for (size_t s = 0; s < lanes.size(); ++s) {
+        if (lanes[s].pipelined && !lanes[s].pending.empty()) {
+            lanes[s].pipelined->abandon_in_flight();
+        }
+    }
+}
+
+bool ResilientPluginManager::process_batches_through_pipeline(const std::vector<RecordBatch*>& batches,
+                                                              std::vector<RecordBatch*>* completed) {
+    for (size_t i = 0; i < batches.size(); ++i) {
+        if (!batches[i]) return false;
+    }
+    
+    std::vector<StageLane> lanes;
+    StageWorkers stage_workers;
+    for (size_t i = 0; i < plugins.size(); ++i) {
+        if (!plugins[i]->is_healthy()) {
+            std::cout << "Saltando plugin no saludable: " << plugins[i]->get_name() << std::endl;
+            continue;
+        }
+        
+        const PipelineStageConfig* config = find_stage_config(plugins[i]->get_name());
         if (!config) continue;
         
-        // Ejecutar plugin con failover
-        int result = execute_plugin_with_failover(plugins[i], batch, config->failover_config);
+        StageLane lane;
+        lane.component = plugins[i];
+        lane.pipelined = dynamic_cast<IPipelinedComponent*>(plugins[i]);
+        lane.worker = NULL;
+        lane.config = config;
+        lane.finished.assign(preserve_order ? batches.size() : 0, false);
+        lane.next_release = 0;
+        lane.held = 0;
+        lane.last_progress_ms = 0;
         
-        if (result != 0) {
-            result = handle_plugin_failure(plugins[i]->get_name(), batch, config->failover_config);
-            if (result != 0 && config->failover_config.policy == FAIL_FAST) {
-                return false;
+        if (!lane.pipelined) {
+            StageWorker* worker = new StageWorker(this, plugins[i], config);
+            if (worker->start(stage_worker_function)) {
+                stage_workers.workers.push_back(worker);
+                lane.worker = worker;
+            } else {
+                delete worker;
             }
         }
+        lanes.push_back(lane);
     }
     
+    std::vector<size_t> output;
+    size_t fed = 0;
+    while (output.size() < batches.size()) {
+        if (lanes.empty()) {
+            output.push_back(fed++);
+            continue;
+        }
+        
+        // La primera etapa también tiene cola acotada
+        while (fed < batches.size() && lanes[0].queue.size() < stage_queue_capacity) {
+            lanes[0].queue.push_back(fed++);
+        }
+        
+        // De la última etapa a la primera: lo que sale abajo hace sitio arriba
+        bool progressed = false;
+        for (size_t s = lanes.size(); s-- > 0; ) {
+            StageLane& lane = lanes[s];
+            while (!lane.queue.empty()) {
+                size_t downstream = s + 1 < lanes.size() ? lanes[s + 1].queue.size() : 0;
+                if (lane.held + lane.pending.size() + downstream >= stage_queue_capacity) break;
+                
+                size_t index = lane.queue.front();
+                if (lane.worker) {
+                    // De uno en uno: sus reintentos no se solapan con otro lote
+                    if (!lane.pending.empty()) break;
+                    uint32_t request = lane.worker->submit(batches[index]);
+                    if (request != 0) {
+                        lane.pending.push_back(std::make_pair(request, index));
+                        lane.queue.pop_front();
+                        break;
+                    }
+                }
+                if (lane.pipelined) {
+                    uint32_t request = 0;
+                    if (lane.pipelined->get_in_flight() < lane.pipelined->get_max_in_flight()) {
+                        request = lane.pipelined->submit_batch(batches[index]);
+                    }
+                    if (request != 0) {
+                        if (lane.pending.empty()) lane.last_progress_ms = monotonic_now_ms();
+                        lane.pending.push_back(std::make_pair(request, index));
+                        lane.queue.pop_front();
+                        continue;
+                    }
+                    // Ventana llena: esperar respuestas
+                    if (!lane.pending.empty()) break;
+                }
+                
+                // En proceso, o el plugin no admite el lote: camino con reintentos
+                lane.queue.pop_front();
+                if (!run_stage_with_failover(lane.component, *lane.config, batches[index])) {
+                    abandon_lanes(lanes);
+                    return false;
+                }
+                release_batch(lanes, s, index, preserve_order, output);
+                progressed = true;
+                
+                // Un lote en proceso por vuelta, para no dejar ociosos a los hijos
+                if (!lane.pipelined) break;
+            }
+        }
+        
+        // Recoger lo que ya terminó en cualquier etapa
+        std::vector<ShmRing*> rings;
+        for (size_t s = 0; s < lanes.size(); ++s) {
+            StageLane& lane = lanes[s];
+            while (!lane.pending.empty()) {
+                RecordBatch* done = NULL;
+                int result = -1;
+                uint32_t request = lane.worker ? lane.worker->collect(&result)
+                                               : lane.pipelined->collect_completion(0, &done, &result);
+                if (request == 0) break;
+                
+                size_t j = 0;
+                while (j < lane.pending.size() && lane.pending[j].first != request) ++j;
+                if (j == lane.pending.size()) continue;
+                size_t index = lane.pending[j].second;
+                lane.pending.erase(lane.pending.begin() + j);
+                lane.last_progress_ms = monotonic_now_ms();
+                
+                // El hilo de una etapa en proceso ya aplicó los reintentos
+                bool handled = lane.worker ? result == 0
+                    : result == 0 || run_stage_with_failover(lane.component, *lane.config, batches[index]);
+                if (!handled) {
+                    abandon_lanes(lanes);
+                    return false;
+                }
+                release_batch(lanes, s, index, preserve_order, output);
+                progressed = true;
+            }
+            if (lane.pending.empty()) continue;
+            if (lane.worker) {
+                rings.push_back(&lane.worker->responses);
+            } else {
+                lane.pipelined->get_response_rings(rings);
+            }
+        }
+        if (progressed || rings.empty()) continue;
+        
+        // Nada listo: dormir hasta la próxima respuesta o el primer timeout
+        // (en proceso no hay timeout: el lote cuesta lo que cuesta la llamada)
+        long now = monotonic_now_ms();
+        long wait_ms = -1;
+        for (size_t s = 0; s < lanes.size(); ++s) {
+            if (lanes[s].pending.empty() || lanes[s].worker) continue;
+            long remaining = lanes[s].last_progress_ms + lanes[s].config->failover_config.timeout_ms - now;
+            if (wait_ms < 0 || remaining < wait_ms) wait_ms = std::max(remaining, 0L);
+        }
+        if (ShmRing::wait_any(&rings[0], rings.size(), static_cast<int>(wait_ms)) >= 0) continue;
+        
+        // Sin respuestas a tiempo: lo pendiente pasa al camino con reintentos
+        now = monotonic_now_ms();
+        for (size_t s = 0; s < lanes.size(); ++s) {
+            StageLane& lane = lanes[s];
+            if (lane.pending.empty() || lane.worker ||
+                now - lane.last_progress_ms < lane.config->failover_config.timeout_ms) {
+                continue;
+            }
+            
+            std::cerr << "Timeout en plugin " << lane.component->get_name() << std::endl;
+            std::vector<RecordBatch*> touched;
+            lane.pipelined->abandon_in_flight(&touched);
+            std::vector<size_t> stalled;
+            for (size_t j = 0; j < lane.pending.size(); ++j) {
+                stalled.push_back(lane.pending[j].second);
+            }
+            lane.pending.clear();
+            std::sort(stalled.begin(), stalled.end());
+            for (size_t j = 0; j < stalled.size(); ++j) {
+                // Un lote en sitio pudo quedar procesado (o a medias) antes del
+                // timeout: no se repite la etapa, se aplica la política de fallo
+                RecordBatch* batch = batches[stalled[j]];
+                bool handled = std::find(touched.begin(), touched.end(), batch) == touched.end()
+                    ? run_stage_with_failover(lane.component, *lane.config, batch)
+                    : handle_plugin_failure(lane.component->get_name(), batch,
+                                            lane.config->failover_config) == 0;
+                if (!handled) {
+                    abandon_lanes(lanes);
+                    return false;
+                }
+                release_batch(lanes, s, stalled[j], preserve_order, output);
+            }
+        }
+    }
+    
+    if (completed) {
+        for (size_t i = 0; i < output.size(); ++i) {
+            completed->push_back(batches[output[i]]);
+        }
+    }
     return true;
 }
 
-int ResilientPluginManager::execute_plugin_with_failover(IsolatedPluginProcess* plugin, 
+bool ResilientPluginManager::run_stage_with_failover(IProcessingComponent* plugin,
+                                                     const PipelineStageConfig& config,
+                                                     RecordBatch* batch) {
+    int result = execute_plugin_with_failover(plugin, batch, config.failover_config);
+    if (result != 0) {
+        result = handle_plugin_failure(plugin->get_name(), batch, config.failover_config);
+        if (result != 0 && config.failover_config.policy == FAIL_FAST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const PipelineStageConfig* ResilientPluginManager::find_stage_config(const std::string& plugin_name) const {
+    for (size_t i = 0; i < fused_configs.size(); ++i) {
+        if (fused_configs[i].name == plugin_name) {
+            return &fused_configs[i];
+        }
+    }
+    for (size_t i = 0; i < pipeline_config.size(); ++i) {
+        if (pipeline_config[i].name == plugin_name) {
+            return &pipeline_config[i];
+        }
+    }
+    return NULL;
+}
+
+int ResilientPluginManager::execute_plugin_with_failover(IProcessingComponent* plugin, 
                                                         RecordBatch* batch, 
                                                         const FailoverConfig& config) {
     
     return apply_retry_policy(plugin, batch, config);
 }
 
-int ResilientPluginManager::apply_retry_policy(IsolatedPluginProcess* plugin, 
+int ResilientPluginManager::apply_retry_policy(IProcessingComponent* plugin, 
                                               RecordBatch* batch, 
                                               const FailoverConfig& config) {
     int attempt = 0;
@@ -169,9 +639,16 @@ int ResilientPluginManager::apply_retry_policy(IsolatedPluginProcess* plugin,
     return -1; // Todos los reintentos fallaron
 }
 
-int ResilientPluginManager::execute_plugin_with_timeout(IsolatedPluginProcess* plugin, 
+int ResilientPluginManager::execute_plugin_with_timeout(IProcessingComponent* plugin, 
                                                        RecordBatch* batch, 
                                                        int timeout_ms) {
+    // En proceso no hay nada que abortar con seguridad: un longjmp dejaría
+    // al plugin a medias dentro del nodo. Sin alarmas, el lote cuesta lo
+    // que cuesta la llamada
+    if (dynamic_cast<InProcessPlugin*>(plugin)) {
+        return plugin->process_batch(batch);
+    }
+    
     // Configurar timeout con setjmp/longjmp
     if (setjmp(g_timeout_env) != 0) {
         alarm(0); // Limpiar alarma
@@ -231,7 +708,12 @@ bool ResilientPluginManager::restart_plugin(const std::string& plugin_name) {
     for (size_t i = 0; i < plugins.size(); ++i) {
         if (plugins[i]->get_name() == plugin_name) {
             std::cout << "Reiniciando plugin: " << plugin_name << std::endl;
-            return plugins[i]->restart();
+            IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(plugins[i]);
+            if (process) return process->restart();
+            ReplicatedStage* replicated = dynamic_cast<ReplicatedStage*>(plugins[i]);
+            if (replicated) return replicated->restart();
+            InProcessPlugin* in_process = dynamic_cast<InProcessPlugin*>(plugins[i]);
+            return in_process && in_process->reload();
         }
     }
     return false;
@@ -276,6 +758,17 @@ bool ResilientPluginManager::hot_swap_plugin(const std::string& plugin_name,
     std::string old_path = config->library_path;
     config->library_path = new_library_path;
     
+    // Fusionado: la etapa vive en el proceso compartido, que se recarga entero
+    if (execution_mode == FUSED_PROCESS) {
+        if (!load_pipeline_config(pipeline_config)) {
+            config->library_path = old_path; // Restaurar
+            load_pipeline_config(pipeline_config);
+            return false;
+        }
+        std::cout << "Hot-swap completado para " << plugin_name << std::endl;
+        return true;
+    }
+    
     // Remover plugin actual
     if (!remove_plugin(plugin_name)) {
         config->library_path = old_path; // Restaurar
@@ -305,6 +798,16 @@ bool ResilientPluginManager::validate_pipeline_config(const std::vector<Pipeline
             stage.failover_config.timeout_ms <= 0) {
             return false;
         }
+        
+        if (stage.pipeline_depth < 1 ||
+            stage.pipeline_depth > static_cast<int>(IsolatedPluginProcess::MAX_PIPELINE_DEPTH)) {
+            return false;
+        }
+        
+        if (stage.replicas < 1 ||
+            stage.replicas > static_cast<int>(ReplicatedStage::MAX_REPLICAS)) {
+            return false;
+        }
     }
     
     return true;
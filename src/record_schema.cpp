@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/record_schema.cpp
+#include "record_schema.h"
+#include "crc32c.h"
+#include <cstring>
+#include <limits>
+
+namespace distributed {
+
+const SchemaFieldDescriptor RecordSchemaTraits<DatabaseRecord>::fields[] = {
+    SCHEMA_FIELD(DatabaseRecord, id),
+    SCHEMA_FIELD(DatabaseRecord, name),
+    SCHEMA_FIELD(DatabaseRecord, value),
+    SCHEMA_FIELD(DatabaseRecord, category)
+};
+const size_t RecordSchemaTraits<DatabaseRecord>::field_count =
+    sizeof(RecordSchemaTraits<DatabaseRecord>::fields) / sizeof(SchemaFieldDescriptor);
+
+const size_t RecordSchema::MAX_FIELDS;
+const size_t RecordSchema::MAX_NAME_LENGTH;
+const size_t RecordSchema::MAX_RECORD_SIZE;
+
+namespace {
+
+// Forma codificada (little-endian):
+//   u32 record_size, u16 field_count, u16 reservado
+//   por campo: u8 tipo, u8 largo del nombre, u16 reservado, u32 offset, u32 tamaño, nombre
+//   ceros hasta múltiplo de 8, para que los registros que siguen queden alineados
+const size_t SCHEMA_PREFIX_BYTES = 8;
+const size_t SCHEMA_FIELD_BYTES = 12;
+const size_t SCHEMA_ALIGNMENT = 8;
+
+void put_le(std::vector<char>& out, uint32_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint32_t get_le(const char* data, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+bool valid_field(const RecordSchema::Field& field, size_t record_size) {
+    if (field.name.empty() || field.name.size() > RecordSchema::MAX_NAME_LENGTH) return false;
+    if (field.offset > record_size || field.size > record_size - field.offset) return false;
+    
+    switch (field.type) {
+        case SCHEMA_INT32:   return field.size == sizeof(int32_t);
+        case SCHEMA_FLOAT64: return field.size == sizeof(double);
+        case SCHEMA_CHARS:   return field.size > 0;
+        default:             return false;
+    }
+}
+
+} // namespace
+
+// =============================================================================
+// RecordSchema
+// =============================================================================
+
+RecordSchema::RecordSchema() : record_size(0), fingerprint(0) {
+}
+
+RecordSchema::RecordSchema(const SchemaFieldDescriptor* descriptors, size_t count, size_t size)
+    : record_size(static_cast<uint32_t>(size)), fingerprint(0) {
+    if (!descriptors || count == 0 || count > MAX_FIELDS || size == 0 || size > MAX_RECORD_SIZE) return;
+    
+    fields.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        fields[i].name = descriptors[i].name ? descriptors[i].name : "";
+        fields[i].type = descriptors[i].type;
+        fields[i].offset = descriptors[i].offset;
+        fields[i].size = descriptors[i].size;
+    }
+    if (!seal()) fields.clear();
+}
+
+bool RecordSchema::seal() {
+    encoded.clear();
+    fingerprint = 0;
+    
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (!valid_field(fields[i], record_size) || find_field(fields[i].name) != &fields[i]) {
+            return false;
+        }
+    }
+    
+    put_le(encoded, record_size, 4);
+    put_le(encoded, static_cast<uint32_t>(fields.size()), 2);
+    put_le(encoded, 0, 2);
+    for (size_t i = 0; i < fields.size(); ++i) {
+        put_le(encoded, fields[i].type, 1);
+        put_le(encoded, static_cast<uint32_t>(fields[i].name.size()), 1);
+        put_le(encoded, 0, 2);
+        put_le(encoded, fields[i].offset, 4);
+        put_le(encoded, fields[i].size, 4);
+        encoded.insert(encoded.end(), fields[i].name.begin(), fields[i].name.end());
+    }
+    encoded.resize((encoded.size() + SCHEMA_ALIGNMENT - 1) / SCHEMA_ALIGNMENT * SCHEMA_ALIGNMENT, 0);
+    
+    fingerprint = Crc32c::compute(&encoded[0], encoded.size());
+    return true;
+}
+
+bool RecordSchema::decode(const char* data, size_t size) {
+    fields.clear();
+    encoded.clear();
+    fingerprint = 0;
+    record_size = 0;
+    
+    if (!data || size < SCHEMA_PREFIX_BYTES || size % SCHEMA_ALIGNMENT != 0) return false;
+    
+    record_size = get_le(data, 4);
+    size_t count = get_le(data + 4, 2);
+    if (record_size == 0 || record_size > MAX_RECORD_SIZE || count == 0 || count > MAX_FIELDS) return false;
+    
+    size_t pos = SCHEMA_PREFIX_BYTES;
+    fields.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (size - pos < SCHEMA_FIELD_BYTES) return false;
+        size_t name_length = get_le(data + pos + 1, 1);
+        fields[i].type = get_le(data + pos, 1);
+        fields[i].offset = get_le(data + pos + 4, 4);
+        fields[i].size = get_le(data + pos + 8, 4);
+        pos += SCHEMA_FIELD_BYTES;
+        
+        if (size - pos < name_length) return false;
+        fields[i].name.assign(data + pos, name_length);
+        pos += name_length;
+    }
+    
+    // La forma canónica es única: re-codificar debe dar los mismos bytes
+    if (!seal() || encoded.size() != size || memcmp(&encoded[0], data, size) != 0) {
+        fields.clear();
+        encoded.clear();
+        fingerprint = 0;
+        return false;
+    }
+    return true;
+}
+
+const RecordSchema::Field* RecordSchema::find_field(const std::string& name) const {
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].name == name) return &fields[i];
+    }
+    return NULL;
+}
+
+// =============================================================================
+// RecordConverter
+// =============================================================================
+
+RecordConverter::RecordConverter() : source_size(0), target_size(0), identity(false) {
+}
+
+bool RecordConverter::build(const RecordSchema& source, const RecordSchema& target, bool swap_bytes) {
+    steps.clear();
+    source_size = source.get_record_size();
+    target_size = target.get_record_size();
+    identity = false;
+    
+    if (!source.is_valid() || !target.is_valid()) return false;
+    
+    if (!swap_bytes && source.get_fingerprint() == target.get_fingerprint() &&
+        source.get_encoded_size() == target.get_encoded_size() &&
+        memcmp(source.get_encoded(), target.get_encoded(), source.get_encoded_size()) == 0) {
+        identity = true;
+        return true;
+    }
+    
+    for (size_t i = 0; i < target.get_field_count(); ++i) {
+        const RecordSchema::Field& to = target.get_field(i);
+        const RecordSchema::Field* from = source.find_field(to.name);
+        if (!from) continue;
+        
+        Step step;
+        step.source_offset = from->offset;
+        step.target_offset = to.offset;
+        step.source_size = from->size;
+        step.target_size = to.size;
+        step.swap = swap_bytes;
+        
+        if (from->type == SCHEMA_CHARS && to.type == SCHEMA_CHARS) {
+            step.kind = STEP_CHARS;
+        } else if (from->type == SCHEMA_CHARS || to.type == SCHEMA_CHARS) {
+            return false;
+        } else if (from->type == to.type) {
+            step.kind = !swap_bytes ? STEP_COPY : (to.type == SCHEMA_INT32 ? STEP_SWAP32 : STEP_SWAP64);
+        } else {
+            step.kind = to.type == SCHEMA_FLOAT64 ? STEP_INT_TO_DOUBLE : STEP_DOUBLE_TO_INT;
+        }
+        steps.push_back(step);
+    }
+    return true;
+}
+
+void RecordConverter::convert(const char* source, size_t count, char* target) const {
+    if (count == 0) return;
+    if (identity) {
+        memcpy(target, source, count * source_size);
+        return;
+    }
+    
+    for (size_t r = 0; r < count; ++r) {
+        const char* from = source + r * source_size;
+        char* to = target + r * target_size;
+        memset(to, 0, target_size);
+        
+        for (size_t s = 0; s < steps.size(); ++s) {
+            const Step& step = steps[s];
+            const char* in = from + step.source_offset;
+            char* out = to + step.target_offset;
+            
+            switch (step.kind) {
+                case STEP_COPY:
+                    memcpy(out, in, step.target_size);
+                    break;
+                case STEP_SWAP32: {
+                    uint32_t value;
+                    memcpy(&value, in, sizeof(value));
+                    value = __builtin_bswap32(value);
+                    memcpy(out, &value, sizeof(value));
+                    break;
+                }
+                case STEP_SWAP64: {
+                    uint64_t value;
+                    memcpy(&value, in, sizeof(value));
+                    value = __builtin_bswap64(value);
+                    memcpy(out, &value, sizeof(value));
+                    break;
+                }
+                case STEP_INT_TO_DOUBLE: {
+                    uint32_t bits;
+                    memcpy(&bits, in, sizeof(bits));
+                    if (step.swap) bits = __builtin_bswap32(bits);
+                    int32_t value;
+                    memcpy(&value, &bits, sizeof(value));
+                    double converted = value;
+                    memcpy(out, &converted, sizeof(converted));
+                    break;
+                }
+                case STEP_DOUBLE_TO_INT: {
+                    uint64_t bits;
+                    memcpy(&bits, in, sizeof(bits));
+                    if (step.swap) bits = __builtin_bswap64(bits);
+                    double value;
+                    memcpy(&value, &bits, sizeof(value));
+                    // Saturar: un double fuera de rango (o NaN) no es un int32 válido
+                    int32_t converted = 0;
+                    if (value >= std::numeric_limits<int32_t>::max()) {
+                        converted = std::numeric_limits<int32_t>::max();
+                    } else if (value <= std::numeric_limits<int32_t>::min()) {
+                        converted = std::numeric_limits<int32_t>::min();
+                    } else if (value == value) {
+                        converted = static_cast<int32_t>(value);
+                    }
+                    memcpy(out, &converted, sizeof(converted));
+                    break;
+                }
+                case STEP_CHARS: {
+                    // Copiar hasta el terminador y dejar siempre uno al final
+                    size_t length = strnlen(in, step.source_size);
+                    if (length > step.target_size - 1) length = step.target_size - 1;
+                    memcpy(out, in, length);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+} // namespace distributed
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// src/replicated_stage.cpp
+#include "replicated_stage.h"
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+namespace distributed {
+
+const size_t ReplicatedStage::MAX_REPLICAS;
+
+ReplicatedStage::ReplicatedStage(const std::string& name, const std::vector<HostedStage>& stages,
+                                 size_t replica_count)
+    : stage_name(name), next_request(0), next_replica(0) {
+    if (replica_count == 0) replica_count = 1;
+    
+    for (size_t i = 0; i < replica_count; ++i) {
+        // Cada réplica necesita su propio nombre: de él salen sus regiones de shm
+        std::ostringstream replica_name;
+        replica_name << name << "_r" << i;
+        replicas.push_back(new IsolatedPluginProcess(replica_name.str(), stages));
+        response_rings.push_back(replicas.back()->get_response_ring());
+    }
+}
+
+ReplicatedStage::~ReplicatedStage() {
+    terminate();
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        delete replicas[i];
+    }
+}
+
+void ReplicatedStage::set_pipeline_depth(size_t depth) {
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        replicas[i]->set_pipeline_depth(depth);
+    }
+}
+
+void ReplicatedStage::attach_batch_region(const SharedMemoryRegion* region) {
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        replicas[i]->attach_batch_region(region);
+    }
+}
+
+bool ReplicatedStage::start() {
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        if (!replicas[i]->start()) {
+            std::cerr << "Error iniciando réplica " << i << " de " << stage_name << std::endl;
+            return false;
+        }
+    }
+    std::cout << "Etapa replicada iniciada: " << stage_name << " (" << replicas.size()
+              << " réplicas)" << std::endl;
+    return true;
+}
+
+void ReplicatedStage::terminate() {
+    // La réplica principal se queda con el estado global antes de su cleanup
+    if (pending.empty() && replicas.size() > 1 && is_healthy()) {
+        reduce_state();
+    }
+    
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        replicas[i]->terminate();
+    }
+    pending.clear();
+}
+
+bool ReplicatedStage::restart() {
+    bool all_restarted = true;
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        if (replicas[i]->is_alive()) continue;
+        
+        // Lo que tenía en vuelo la réplica caída no va a volver
+        for (size_t j = pending.size(); j > 0; --j) {
+            if (pending[j - 1].replica == i) {
+                pending.erase(pending.begin() + (j - 1));
+            }
+        }
+        if (!replicas[i]->restart()) all_restarted = false;
+    }
+    return all_restarted;
+}
+
+bool ReplicatedStage::reduce_state() {
+    if (!pending.empty()) return false;
+    
+    bool success = true;
+    size_t stage_count = replicas[0]->get_hosted_stages().size();
+    std::vector<char> state;
+    for (size_t stage = 0; stage < stage_count; ++stage) {
+        for (size_t i = 1; i < replicas.size(); ++i) {
+            if (!replicas[i]->export_stage_state(stage, state) ||
+                !replicas[0]->merge_stage_state(stage, state)) {
+                std::cerr << "Error en reduce de " << stage_name << " (réplica " << i << ")" << std::endl;
+                success = false;
+            }
+        }
+    }
+    return success;
+}
+
+uint32_t ReplicatedStage::submit_batch(RecordBatch* batch) {
+    if (!batch) return 0;
+    
+    // Menos peticiones pendientes; en empate, la siguiente en round robin
+    size_t chosen = replicas.size();
+    for (size_t k = 0; k < replicas.size(); ++k) {
+        size_t i = (next_replica + k) % replicas.size();
+        IsolatedPluginProcess* replica = replicas[i];
+        if (replica->get_in_flight() >= replica->get_max_in_flight() || !replica->is_healthy()) {
+            continue;
+        }
+        if (chosen == replicas.size() || replica->get_in_flight() < replicas[chosen]->get_in_flight()) {
+            chosen = i;
+        }
+    }
+    if (chosen == replicas.size()) return 0;
+    
+    uint32_t replica_request = replicas[chosen]->submit_batch(batch);
+    if (replica_request == 0) return 0;
+    next_replica = (chosen + 1) % replicas.size();
+    
+    PendingRequest request;
+    if (++next_request == 0) ++next_request;
+    request.request = next_request;
+    request.replica = chosen;
+    request.replica_request = replica_request;
+    pending.push_back(request);
+    return request.request;
+}
+
+uint32_t ReplicatedStage::collect_completion(int timeout_ms, RecordBatch** batch, int* result) {
+    struct timeval start_time, now;
+    gettimeofday(&start_time, NULL);
+    
+    while (!pending.empty()) {
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            gettimeofday(&now, NULL);
+            long elapsed = (now.tv_sec - start_time.tv_sec) * 1000 +
+                           (now.tv_usec - start_time.tv_usec) / 1000;
+            remaining = elapsed >= timeout_ms ? 0 : static_cast<int>(timeout_ms - elapsed);
+        }
+        
+        int ready = ShmRing::wait_any(&response_rings[0], response_rings.size(), remaining);
+        if (ready < 0) return 0;
+        
+        // Una respuesta de un lote abandonado solo libera su slot
+        uint32_t replica_request = replicas[ready]->collect_completion(0, batch, result);
+        if (replica_request == 0) continue;
+        
+        for (size_t j = 0; j < pending.size(); ++j) {
+            if (pending[j].replica == static_cast<size_t>(ready) &&
+                pending[j].replica_request == replica_request) {
+                uint32_t request = pending[j].request;
+                pending.erase(pending.begin() + j);
+                return request;
+            }
+        }
+    }
+    return 0;
+}
+
+void ReplicatedStage::abandon_in_flight(std::vector<RecordBatch*>* touched) {
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        replicas[i]->abandon_in_flight(touched);
+    }
+    pending.clear();
+}
+
+size_t ReplicatedStage::get_max_in_flight() const {
+    size_t total = 0;
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        total += replicas[i]->get_max_in_flight();
+    }
+    return total;
+}
+
+void ReplicatedStage::get_response_rings(std::vector<ShmRing*>& rings) {
+    rings.insert(rings.end(), response_rings.begin(), response_rings.end());
+}
+
+int ReplicatedStage::process_batch(RecordBatch* batch) {
+    if (!batch) return -1;
+    
+    // Camino síncrono: la réplica menos cargada procesa el lote entero
+    size_t chosen = replicas.size();
+    for (size_t k = 0; k < replicas.size(); ++k) {
+        size_t i = (next_replica + k) % replicas.size();
+        if (!replicas[i]->is_healthy()) continue;
+        if (chosen == replicas.size() || replicas[i]->get_in_flight() < replicas[chosen]->get_in_flight()) {
+            chosen = i;
+        }
+    }
+    if (chosen == replicas.size()) return -1;
+    
+    next_replica = (chosen + 1) % replicas.size();
+    return replicas[chosen]->process_batch(batch);
+}
+
+bool ReplicatedStage::is_healthy() const {
+    // La etapa sirve mientras quede alguna réplica; el dispatcher evita las caídas
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        if (replicas[i]->is_healthy()) return true;
+    }
+    return false;
+}
+
+const ComponentMetrics* ReplicatedStage::get_metrics() const {
+    metrics = ComponentMetrics();
+    for (size_t i = 0; i < replicas.size(); ++i) {
+        const ComponentMetrics* replica = replicas[i]->get_metrics();
+        metrics.total_calls += replica->total_calls;
+        metrics.successful_calls += replica->successful_calls;
+        metrics.failed_calls += replica->failed_calls;
+        metrics.timeout_calls += replica->timeout_calls;
+        metrics.total_execution_time_ms += replica->total_execution_time_ms;
+        metrics.last_success_time = std::max(metrics.last_success_time, replica->last_success_time);
+        metrics.last_failure_time = std::max(metrics.last_failure_time, replica->last_failure_time);
+    }
+    return &metrics;
+}
+
+} // namespace distributed
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// src/scratch_arena.cpp
+#include "scratch_arena.h"
+#include <algorithm>
+
+namespace distributed {
+
+const size_t ScratchArena::DEFAULT_SIZE;
+
+ScratchArena::Chunk* ScratchArena::new_chunk(size_t size) {
+    char* raw = new char[sizeof(Chunk) + PLUGIN_SCRATCH_ALIGNMENT + size];
+    Chunk* chunk = reinterpret_cast<Chunk*>(raw);
+    chunk->next = NULL;
+    chunk->size = size;
+    return chunk;
+}
+
+char* ScratchArena::chunk_data(Chunk* chunk) {
+    // Los datos empiezan alineados tras la cabecera del bloque
+    size_t header = (sizeof(Chunk) + PLUGIN_SCRATCH_ALIGNMENT - 1) & ~static_cast<size_t>(PLUGIN_SCRATCH_ALIGNMENT - 1);
+    return reinterpret_cast<char*>(chunk) + header;
+}
+
+ScratchArena::ScratchArena(size_t initial_size) 
+    : primary(NULL), overflow(NULL), overflow_bytes(0), chunk_start(NULL), retired_bytes(0),
+      high_water(0), slow_allocations(0) {
+    primary = new_chunk(std::max(initial_size, static_cast<size_t>(PLUGIN_SCRATCH_ALIGNMENT)));
+    
+    scratch.allocate_slow = allocate_slow;
+    scratch.host_state = this;
+    chunk_start = chunk_data(primary);
+    scratch.cursor = chunk_start;
+    scratch.limit = chunk_start + primary->size;
+}
+
+ScratchArena::~ScratchArena() {
+    while (overflow) {
+        Chunk* next = overflow->next;
+        delete[] reinterpret_cast<char*>(overflow);
+        overflow = next;
+    }
+    delete[] reinterpret_cast<char*>(primary);
+}
+
+void* ScratchArena::allocate_slow(PluginScratch* scratch, size_t size) {
+    ScratchArena* arena = static_cast<ScratchArena*>(scratch->host_state);
+    
+    // Encadenar un bloque extra; al menos tan grande como el principal
+    size_t chunk_size = std::max(size, arena->primary->size);
+    Chunk* chunk = new_chunk(chunk_size);
+    chunk->next = arena->overflow;
+    arena->overflow = chunk;
+    arena->overflow_bytes += chunk_size;
+    arena->slow_allocations++;
+    
+    arena->retired_bytes += scratch->cursor - arena->chunk_start;
+    arena->chunk_start = chunk_data(chunk);
+    scratch->cursor = arena->chunk_start + size;
+    scratch->limit = arena->chunk_start + chunk_size;
+    return arena->chunk_start;
+}
+
+size_t ScratchArena::get_used() const {
+    return retired_bytes + (scratch.cursor - chunk_start);
+}
+
+void ScratchArena::reset() {
+    high_water = std::max(high_water, get_used());
+    
+    // Tras un desborde se consolida en un bloque principal mayor, de modo
+    // que el mismo volumen de trabajo no vuelva a salir del camino rápido
+    if (overflow) {
+        size_t grown = primary->size + overflow_bytes;
+        while (overflow) {
+            Chunk* next = overflow->next;
+            delete[] reinterpret_cast<char*>(overflow);
+            overflow = next;
+        }
+        overflow_bytes = 0;
+        delete[] reinterpret_cast<char*>(primary);
+        primary = new_chunk(grown);
+    }
+    
+    retired_bytes = 0;
+    chunk_start = chunk_data(primary);
+    scratch.cursor = chunk_start;
+    scratch.limit = chunk_start + primary->size;
+}
+
+} // namespace distributed
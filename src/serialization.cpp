@@ -19,71 +19,247 @@
 
 // src/serialization.cpp
 #include "serialization.h"
+#include "columnar_batch.h"
+#include "crc32c.h"
+#include "block_codec.h"
+#include "column_codec.h"
+#include "record_schema.h"
+#include <algorithm>
 #include <cstring>
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace distributed {
 
-size_t Serializer::serialize_batch(const RecordBatch* batch, char* buffer, size_t buffer_size) {
-    size_t needed = calculate_batch_size(batch);
-    if (buffer_size < needed || !batch || !buffer) {
-        return 0;
+// =============================================================================
+// FORMATO DE REGISTROS
+// =============================================================================
+
+static const uint32_t RECORD_BATCH_MAGIC = 0x42524244;  // "DBRB"
+static const uint32_t RECORD_BATCH_VERSION = 3;         // v2: sin esquema, layout nativo
+static const uint32_t RECORD_BATCH_VERSION_NATIVE = 2;
+static const size_t RECORD_SCHEMA_MAX_BYTES = 4096;
+
+// v3: [header][esquema codificado][registros en el layout del esquema]
+struct RecordBatchHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t capacity;
+    int32_t batch_id;
+    uint32_t payload_crc;        ///< CRC32C de los registros
+    uint32_t schema_fingerprint; ///< Huella de RecordSchema (CRC32C del esquema codificado)
+    uint32_t record_size;
+    uint32_t schema_bytes;       ///< Bytes del esquema codificado tras el header
+    uint32_t header_crc;         ///< CRC32C de los campos anteriores
+};
+
+// Header de la versión 2, que siguen enviando los nodos sin esquema
+struct NativeRecordBatchHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t capacity;
+    int32_t batch_id;
+    uint32_t payload_crc;
+    uint32_t header_crc;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Lote de registros ya validado hasta el header y el esquema
+ */
+struct RecordLayout {
+    RecordBatchHeader header;
+    bool swapped;            ///< Escrito por un host con el orden de bytes opuesto
+    bool native;             ///< Mismo esquema y orden: los registros se copian tal cual
+    const char* schema;
+    const char* records;
+    size_t payload_size;
+};
+
+static uint32_t record_header_crc(const RecordBatchHeader& header) {
+    return Crc32c::compute(&header, offsetof(RecordBatchHeader, header_crc));
+}
+
+static void swap_record_header(RecordBatchHeader& header) {
+    header.version = __builtin_bswap32(header.version);
+    header.count = __builtin_bswap64(header.count);
+    header.capacity = __builtin_bswap64(header.capacity);
+    header.batch_id = static_cast<int32_t>(__builtin_bswap32(static_cast<uint32_t>(header.batch_id)));
+    header.payload_crc = __builtin_bswap32(header.payload_crc);
+    header.schema_fingerprint = __builtin_bswap32(header.schema_fingerprint);
+    header.record_size = __builtin_bswap32(header.record_size);
+    header.schema_bytes = __builtin_bswap32(header.schema_bytes);
+    header.header_crc = __builtin_bswap32(header.header_crc);
+}
+
+static bool read_native_record_header(const char* buffer, size_t size, RecordLayout& layout) {
+    NativeRecordBatchHeader native;
+    if (size < sizeof(native)) return false;
+    memcpy(&native, buffer, sizeof(native));
+    if (native.header_crc != Crc32c::compute(&native, offsetof(NativeRecordBatchHeader, header_crc))) {
+        return false;
     }
     
-    char* ptr = buffer;
+    const RecordSchema& schema = RecordSchema::native();
+    layout.header.count = native.count;
+    layout.header.capacity = native.capacity;
+    layout.header.batch_id = native.batch_id;
+    layout.header.payload_crc = native.payload_crc;
+    layout.header.schema_fingerprint = schema.get_fingerprint();
+    layout.header.record_size = static_cast<uint32_t>(schema.get_record_size());
+    layout.header.schema_bytes = 0;
+    layout.swapped = false;
+    layout.native = true;
+    layout.schema = NULL;
+    layout.records = buffer + sizeof(native);
+    return true;
+}
+
+/**
+ * @brief Validar header y esquema; size acota registros y esquema
+ */
+static bool read_record_layout(const char* buffer, size_t size, RecordLayout& layout) {
+    if (!buffer || size < sizeof(uint32_t) * 2) return false;
     
-    // Header del batch
-    memcpy(ptr, &batch->count, sizeof(size_t)); ptr += sizeof(size_t);
-    memcpy(ptr, &batch->capacity, sizeof(size_t)); ptr += sizeof(size_t);
-    memcpy(ptr, &batch->batch_id, sizeof(int)); ptr += sizeof(int);
+    uint32_t magic, version;
+    memcpy(&magic, buffer, sizeof(magic));
+    memcpy(&version, buffer + sizeof(magic), sizeof(version));
+    
+    if (magic == RECORD_BATCH_MAGIC && version == RECORD_BATCH_VERSION_NATIVE) {
+        if (!read_native_record_header(buffer, size, layout)) return false;
+    } else {
+        RecordBatchHeader& header = layout.header;
+        if (size < sizeof(header)) return false;
+        memcpy(&header, buffer, sizeof(header));
+        
+        // El CRC se calcula sobre los bytes tal como llegaron
+        const uint32_t crc = record_header_crc(header);
+        layout.swapped = header.magic == __builtin_bswap32(RECORD_BATCH_MAGIC);
+        if (layout.swapped) swap_record_header(header);
+        if ((header.magic != RECORD_BATCH_MAGIC && !layout.swapped) ||
+            header.version != RECORD_BATCH_VERSION || header.header_crc != crc) {
+            return false;
+        }
+        if (header.schema_bytes > RECORD_SCHEMA_MAX_BYTES || header.schema_bytes > size - sizeof(header)) {
+            return false;
+        }
+        
+        layout.schema = buffer + sizeof(header);
+        layout.records = layout.schema + header.schema_bytes;
+        
+        // El esquema codificado es la huella: basta compararlo con el nativo
+        const RecordSchema& native = RecordSchema::native();
+        if (header.schema_bytes == 0 ||
+            Crc32c::compute(layout.schema, header.schema_bytes) != header.schema_fingerprint) {
+            return false;
+        }
+        layout.native = !layout.swapped && header.schema_fingerprint == native.get_fingerprint() &&
+                        header.record_size == native.get_record_size() &&
+                        header.schema_bytes == native.get_encoded_size() &&
+                        memcmp(layout.schema, native.get_encoded(), header.schema_bytes) == 0;
+        if (header.record_size == 0) return false;
+    }
+    
+    const RecordBatchHeader& header = layout.header;
+    const size_t available = size - static_cast<size_t>(layout.records - buffer);
+    if (header.count > header.capacity || header.count > available / header.record_size) return false;
+    
+    layout.payload_size = static_cast<size_t>(header.count) * header.record_size;
+    return true;
+}
+
+// Tamaño de buffer "desconocido" para las APIs que no lo reciben
+static const size_t UNBOUNDED_SIZE = static_cast<size_t>(-1) / 2;
+
+size_t Serializer::serialize_batch(const RecordBatch* batch, char* buffer, size_t buffer_size) {
+    if (!batch) return 0;
+    return serialize_records(batch->records, batch->count, batch->capacity, batch->batch_id,
+                             RecordSchema::native(), buffer, buffer_size);
+}
+
+size_t Serializer::calculate_record_batch_size(size_t count, const RecordSchema& schema) {
+    return sizeof(RecordBatchHeader) + schema.get_encoded_size() + schema.get_record_size() * count;
+}
+
+size_t Serializer::serialize_records(const void* records, size_t count, size_t capacity, int batch_id,
+                                     const RecordSchema& schema, char* buffer, size_t buffer_size) {
+    if (!buffer || !schema.is_valid() || (count > 0 && !records)) return 0;
+    
+    size_t needed = calculate_record_batch_size(count, schema);
+    if (buffer_size < needed) {
+        return 0;
+    }
     
-    // Checksum simple para validación
-    uint32_t checksum = batch->count ^ batch->capacity ^ batch->batch_id;
-    memcpy(ptr, &checksum, sizeof(uint32_t)); ptr += sizeof(uint32_t);
+    // Esquema y registros: los registros se copian tal cual en su layout
+    char* schema_data = buffer + sizeof(RecordBatchHeader);
+    memcpy(schema_data, schema.get_encoded(), schema.get_encoded_size());
     
-    // Records
-    if (batch->records && batch->count > 0) {
-        memcpy(ptr, batch->records, sizeof(DatabaseRecord) * batch->count);
+    const size_t payload_size = schema.get_record_size() * count;
+    char* payload = schema_data + schema.get_encoded_size();
+    if (count > 0) {
+        memcpy(payload, records, payload_size);
     }
     
+    // Header versionado con CRC32C del payload ya copiado
+    RecordBatchHeader header;
+    header.magic = RECORD_BATCH_MAGIC;
+    header.version = RECORD_BATCH_VERSION;
+    header.count = count;
+    header.capacity = capacity;
+    header.batch_id = batch_id;
+    header.payload_crc = Crc32c::compute(payload, payload_size);
+    header.schema_fingerprint = schema.get_fingerprint();
+    header.record_size = static_cast<uint32_t>(schema.get_record_size());
+    header.schema_bytes = static_cast<uint32_t>(schema.get_encoded_size());
+    header.header_crc = record_header_crc(header);
+    memcpy(buffer, &header, sizeof(header));
+    
     return needed;
 }
 
 bool Serializer::deserialize_batch(const char* buffer, RecordBatch* batch) {
     if (!buffer || !batch) return false;
     
-    const char* ptr = buffer;
-    
-    // Leer header
-    size_t count, capacity;
-    int batch_id;
-    uint32_t checksum;
-    
-    memcpy(&count, ptr, sizeof(size_t)); ptr += sizeof(size_t);
-    memcpy(&capacity, ptr, sizeof(size_t)); ptr += sizeof(size_t);
-    memcpy(&batch_id, ptr, sizeof(int)); ptr += sizeof(int);
-    memcpy(&checksum, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    
-    // Validar checksum
-    uint32_t expected_checksum = count ^ capacity ^ batch_id;
-    if (checksum != expected_checksum) {
+    RecordLayout layout;
+    if (!read_record_layout(buffer, UNBOUNDED_SIZE, layout)) {
         return false;
     }
     
     // Validar que el batch tenga suficiente capacidad
+    const size_t count = static_cast<size_t>(layout.header.count);
     if (!batch->records || batch->capacity < count) {
         return false;
     }
     
-    // Actualizar batch
-    batch->count = count;
-    batch->batch_id = batch_id;
+    // Validar el payload antes de tocar el batch destino
+    if (Crc32c::compute(layout.records, layout.payload_size) != layout.header.payload_crc) {
+        return false;
+    }
     
-    // Copiar records si hay datos
-    if (count > 0) {
-        memcpy(batch->records, ptr, sizeof(DatabaseRecord) * count);
+    // Camino rápido: mismo esquema y orden de bytes, los registros se copian
+    if (layout.native) {
+        if (count > 0) {
+            memcpy(batch->records, layout.records, layout.payload_size);
+        }
+    } else {
+        // Otro esquema u orden de bytes: convertir campo a campo
+        RecordSchema source;
+        RecordConverter converter;
+        if (!source.decode(layout.schema, layout.header.schema_bytes) ||
+            source.get_record_size() != layout.header.record_size ||
+            !converter.build(source, RecordSchema::native(), layout.swapped)) {
+            return false;
+        }
+        converter.convert(layout.records, count, reinterpret_cast<char*>(batch->records));
     }
     
+    // Actualizar batch
+    batch->count = count;
+    batch->batch_id = layout.header.batch_id;
+    
     return true;
 }
 
@@ -146,30 +322,810 @@ bool Serializer::deserialize_node_info(const char* buffer, NodeInfo& node) {
 size_t Serializer::calculate_batch_size(const RecordBatch* batch) {
     if (!batch) return 0;
     
-    return sizeof(size_t) * 2 + sizeof(int) + sizeof(uint32_t) + 
-           sizeof(DatabaseRecord) * batch->count;
+    return calculate_record_batch_size(batch->count, RecordSchema::native());
 }
 
 bool Serializer::validate_serialized_data(const char* buffer, size_t size) {
-    if (!buffer || size < sizeof(size_t) * 2 + sizeof(int) + sizeof(uint32_t)) {
+    RecordLayout layout;
+    if (!read_record_layout(buffer, size, layout)) {
         return false;
     }
     
-    const char* ptr = buffer;
-    size_t count, capacity;
+    // Validaciones básicas
+    if (layout.header.capacity > 100000) { // Límites razonables
+        return false;
+    }
+    
+    return Crc32c::compute(layout.records, layout.payload_size) == layout.header.payload_crc;
+}
+
+// =============================================================================
+// FORMATO COMPACTO
+// =============================================================================
+
+static const uint32_t COMPACT_BATCH_MAGIC = 0x42434244;  // "DBCB"
+static const uint32_t COMPACT_BATCH_VERSION = 2;         // v1: checksum xor del header
+static const uint32_t COMPACT_FLAG_NAME_DICTIONARY = 1u << 0;
+static const uint32_t COMPACT_FLAG_COMPRESSED = 1u << 1;
+static const uint32_t COMPACT_FLAG_ENCODED_COLUMNS = 1u << 2;
+static const uint32_t COMPACT_KNOWN_FLAGS =
+    COMPACT_FLAG_NAME_DICTIONARY | COMPACT_FLAG_COMPRESSED | COMPACT_FLAG_ENCODED_COLUMNS;
+
+// Comprimir solo compensa si ahorra al menos 1/8 del payload
+static const size_t COMPACT_MIN_SAVING_DIVISOR = 8;
+
+struct CompactBatchHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    int32_t batch_id;
+    uint32_t flags;
+    uint32_t name_entries;   ///< Igual a count sin diccionario
+    uint32_t name_bytes;
+    uint32_t encoded_bytes;     ///< Payload con columnas codificadas (0 sin COMPACT_FLAG_ENCODED_COLUMNS)
+    uint32_t compressed_bytes;  ///< Payload en BlockCodec (0 sin COMPACT_FLAG_COMPRESSED)
+    uint32_t reserved;
+    uint32_t payload_crc;    ///< CRC32C de todas las secciones tal como viajan
+    uint32_t header_crc;     ///< CRC32C de los campos anteriores
+};
+
+// Inicio del payload con COMPACT_FLAG_ENCODED_COLUMNS; siguen ids, categorías
+// y values codificados y luego el resto de secciones sin cambios
+struct EncodedColumnsHeader {
+    uint32_t id_bytes;
+    uint32_t category_bytes;
+    uint32_t value_bytes;
+    int32_t category_base;
+    uint32_t category_bits;
+    uint32_t value_xor;      ///< 0: doubles tal cual
+};
+
+struct CompactLayout {
+    CompactBatchHeader header;
+    const char* values;
+    const char* ids;
+    const char* categories;
+    const char* codes;       ///< NULL sin diccionario
+    const char* offsets;
+    const char* names;
+};
+
+static uint32_t compact_header_crc(const CompactBatchHeader& header) {
+    return Crc32c::compute(&header, offsetof(CompactBatchHeader, header_crc));
+}
+
+// values va primero tras el header de 48 bytes para quedar alineado a 8
+static size_t compact_size(size_t count, bool dictionary, size_t entries, size_t name_bytes) {
+    return sizeof(CompactBatchHeader) + count * (sizeof(double) + 2 * sizeof(int32_t)) +
+           (dictionary ? count * sizeof(uint32_t) : 0) +
+           (entries + 1) * sizeof(uint32_t) + name_bytes;
+}
+
+// Tamaño del lote sin comprimir
+static size_t plain_compact_size(const CompactBatchHeader& header) {
+    return compact_size(header.count, (header.flags & COMPACT_FLAG_NAME_DICTIONARY) != 0,
+                        header.name_entries, header.name_bytes);
+}
+
+// Tamaño sin comprimir, con las columnas codificadas si lo están
+static size_t uncompressed_compact_size(const CompactBatchHeader& header) {
+    if (header.flags & COMPACT_FLAG_ENCODED_COLUMNS) {
+        return sizeof(CompactBatchHeader) + header.encoded_bytes;
+    }
+    return plain_compact_size(header);
+}
+
+// Tamaño en el wire
+static size_t compact_size(const CompactBatchHeader& header) {
+    if (header.flags & COMPACT_FLAG_COMPRESSED) {
+        return sizeof(CompactBatchHeader) + header.compressed_bytes;
+    }
+    return uncompressed_compact_size(header);
+}
+
+static size_t record_name_length(const DatabaseRecord& record) {
+    return strnlen(record.name, sizeof(record.name));
+}
+
+static void write_compact_header(char* buffer, size_t count, int batch_id, bool dictionary,
+                                 size_t entries, size_t name_bytes) {
+    CompactBatchHeader header;
+    header.magic = COMPACT_BATCH_MAGIC;
+    header.version = COMPACT_BATCH_VERSION;
+    header.count = static_cast<uint32_t>(count);
+    header.batch_id = batch_id;
+    header.flags = dictionary ? COMPACT_FLAG_NAME_DICTIONARY : 0;
+    header.name_entries = static_cast<uint32_t>(entries);
+    header.name_bytes = static_cast<uint32_t>(name_bytes);
+    header.encoded_bytes = 0;
+    header.compressed_bytes = 0;
+    header.reserved = 0;
+    header.payload_crc = 0;
+    header.header_crc = 0;
+    memcpy(buffer, &header, sizeof(header));
+}
+
+// Una vez escritas todas las secciones: CRC del payload y luego del header
+static void seal_compact_header(char* buffer) {
+    CompactBatchHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    header.payload_crc = Crc32c::compute(buffer + sizeof(CompactBatchHeader),
+                                         compact_size(header) - sizeof(CompactBatchHeader));
+    header.header_crc = compact_header_crc(header);
+    memcpy(buffer, &header, sizeof(header));
+}
+
+static bool read_compact_header(const char* buffer, size_t size, CompactBatchHeader& header) {
+    if (!buffer || size < sizeof(CompactBatchHeader)) return false;
     
-    memcpy(&count, ptr, sizeof(size_t)); ptr += sizeof(size_t);
-    memcpy(&capacity, ptr, sizeof(size_t));
+    memcpy(&header, buffer, sizeof(header));
+    if (header.magic != COMPACT_BATCH_MAGIC || header.version != COMPACT_BATCH_VERSION ||
+        header.header_crc != compact_header_crc(header)) {
+        return false;
+    }
+    if ((header.flags & ~COMPACT_KNOWN_FLAGS) != 0) return false;
+    if (!(header.flags & COMPACT_FLAG_NAME_DICTIONARY) && header.name_entries != header.count) {
+        return false;
+    }
+    if (header.reserved != 0) return false;
     
-    // Validaciones básicas
-    if (count > capacity || capacity > 100000) { // Límites razonables
+    // Acotar lo que se reserva al deshacer cada etapa: un bloque expande como
+    // mucho ~255 veces y las columnas codificadas ocupan al menos un byte por
+    // fila de ids, con el resto de secciones sin cambios
+    if (header.flags & COMPACT_FLAG_ENCODED_COLUMNS) {
+        size_t plain_payload = plain_compact_size(header) - sizeof(CompactBatchHeader);
+        if (header.encoded_bytes < sizeof(EncodedColumnsHeader) ||
+            plain_payload / 32 > static_cast<size_t>(header.encoded_bytes)) {
+            return false;
+        }
+    } else if (header.encoded_bytes != 0) {
         return false;
     }
+    if (header.flags & COMPACT_FLAG_COMPRESSED) {
+        size_t payload = uncompressed_compact_size(header) - sizeof(CompactBatchHeader);
+        return header.compressed_bytes > 0 &&
+               payload / 255 <= static_cast<size_t>(header.compressed_bytes);
+    }
+    return header.compressed_bytes == 0;
+}
+
+static bool compact_payload_intact(const char* buffer, const CompactBatchHeader& header) {
+    return Crc32c::compute(buffer + sizeof(CompactBatchHeader),
+                           compact_size(header) - sizeof(CompactBatchHeader)) == header.payload_crc;
+}
+
+// Valida header, tamaño total, CRC, desplazamientos y códigos; deja los punteros a cada sección.
+// Un lote comprimido o codificado no tiene secciones en sitio: hay que expandirlo antes.
+static bool read_compact_layout(const char* buffer, size_t size, CompactLayout& layout) {
+    CompactBatchHeader& header = layout.header;
+    if (!read_compact_header(buffer, size, header) || size < compact_size(header)) return false;
+    if ((header.flags & (COMPACT_FLAG_COMPRESSED | COMPACT_FLAG_ENCODED_COLUMNS)) ||
+        !compact_payload_intact(buffer, header)) {
+        return false;
+    }
+    
+    const char* ptr = buffer + sizeof(CompactBatchHeader);
+    layout.values = ptr;      ptr += header.count * sizeof(double);
+    layout.ids = ptr;         ptr += header.count * sizeof(int32_t);
+    layout.categories = ptr;  ptr += header.count * sizeof(int32_t);
+    layout.codes = NULL;
+    if (header.flags & COMPACT_FLAG_NAME_DICTIONARY) {
+        layout.codes = ptr;   ptr += header.count * sizeof(uint32_t);
+    }
+    layout.offsets = ptr;     ptr += (header.name_entries + 1) * sizeof(uint32_t);
+    layout.names = ptr;
+    
+    // Los desplazamientos deben ser no decrecientes y cerrar en name_bytes
+    uint32_t previous = 0;
+    for (size_t e = 0; e <= header.name_entries; ++e) {
+        uint32_t offset;
+        memcpy(&offset, layout.offsets + e * sizeof(uint32_t), sizeof(offset));
+        if ((e == 0 && offset != 0) || offset < previous) return false;
+        previous = offset;
+    }
+    if (previous != header.name_bytes) return false;
+    
+    if (layout.codes) {
+        for (size_t i = 0; i < header.count; ++i) {
+            uint32_t code;
+            memcpy(&code, layout.codes + i * sizeof(uint32_t), sizeof(code));
+            if (code >= header.name_entries) return false;
+        }
+    }
+    return true;
+}
+
+size_t Serializer::calculate_compact_batch_size(const RecordBatch* batch) {
+    if (!batch) return 0;
+    
+    size_t name_bytes = 0;
+    for (size_t i = 0; i < batch->count; ++i) {
+        name_bytes += record_name_length(batch->records[i]);
+    }
+    return compact_size(batch->count, false, batch->count, name_bytes);
+}
+
+size_t Serializer::serialize_batch_compact(const RecordBatch* batch, char* buffer, size_t buffer_size) {
+    if (!batch || !buffer || (batch->count > 0 && !batch->records)) return 0;
+    
+    const size_t count = batch->count;
+    const DatabaseRecord* records = batch->records;
+    
+    size_t name_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        name_bytes += record_name_length(records[i]);
+    }
+    size_t needed = compact_size(count, false, count, name_bytes);
+    if (buffer_size < needed || count > 0xFFFFFFFFu || name_bytes > 0xFFFFFFFFu) return 0;
+    
+    write_compact_header(buffer, count, batch->batch_id, false, count, name_bytes);
+    
+    // Una pasada por columna: escrituras secuenciales en el destino
+    char* ptr = buffer + sizeof(CompactBatchHeader);
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(ptr, &records[i].value, sizeof(double)); ptr += sizeof(double);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        int32_t id = records[i].id;
+        memcpy(ptr, &id, sizeof(id)); ptr += sizeof(id);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        int32_t category = records[i].category;
+        memcpy(ptr, &category, sizeof(category)); ptr += sizeof(category);
+    }
+    
+    char* offsets = ptr;
+    char* names = ptr + (count + 1) * sizeof(uint32_t);
+    uint32_t offset = 0;
+    memcpy(offsets, &offset, sizeof(offset));
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = record_name_length(records[i]);
+        memcpy(names + offset, records[i].name, length);
+        offset += static_cast<uint32_t>(length);
+        memcpy(offsets + (i + 1) * sizeof(uint32_t), &offset, sizeof(offset));
+    }
+    
+    seal_compact_header(buffer);
+    return needed;
+}
+
+bool Serializer::deserialize_batch_compact(const char* buffer, size_t size, RecordBatch* batch) {
+    if (!batch) return false;
+    
+    if (is_compressed_batch(buffer, size) || is_encoded_batch(buffer, size)) {
+        std::vector<char> storage;
+        size_t plain_size = 0;
+        const char* plain = expand_compact_batch(buffer, size, storage, plain_size);
+        return plain && deserialize_batch_compact(plain, plain_size, batch);
+    }
     
-    size_t expected_size = sizeof(size_t) * 2 + sizeof(int) + sizeof(uint32_t) + 
-                          sizeof(DatabaseRecord) * count;
+    CompactLayout layout;
+    if (!read_compact_layout(buffer, size, layout)) return false;
     
-    return size >= expected_size;
+    const size_t count = layout.header.count;
+    if (!batch->records || batch->capacity < count) return false;
+    
+    // Una pasada por fila: cada registro destino se escribe completo una vez
+    DatabaseRecord* records = batch->records;
+    for (size_t i = 0; i < count; ++i) {
+        DatabaseRecord& record = records[i];
+        int32_t id, category;
+        memcpy(&record.value, layout.values + i * sizeof(double), sizeof(double));
+        memcpy(&id, layout.ids + i * sizeof(int32_t), sizeof(id));
+        memcpy(&category, layout.categories + i * sizeof(int32_t), sizeof(category));
+        record.id = id;
+        record.category = category;
+        
+        uint32_t entry = static_cast<uint32_t>(i);
+        if (layout.codes) {
+            memcpy(&entry, layout.codes + i * sizeof(uint32_t), sizeof(entry));
+        }
+        uint32_t begin, end;
+        memcpy(&begin, layout.offsets + entry * sizeof(uint32_t), sizeof(begin));
+        memcpy(&end, layout.offsets + (entry + 1) * sizeof(uint32_t), sizeof(end));
+        
+        record.set_name(layout.names + begin, end - begin);
+    }
+    
+    batch->count = count;
+    batch->batch_id = layout.header.batch_id;
+    return true;
+}
+
+size_t Serializer::calculate_columnar_batch_size(const ColumnarBatch& batch) {
+    return compact_size(batch.get_count(), batch.has_name_dictionary(),
+                        batch.get_name_entries(), batch.get_name_bytes());
+}
+
+size_t Serializer::serialize_columnar_batch(const ColumnarBatch& batch, char* buffer, size_t buffer_size) {
+    const size_t count = batch.get_count();
+    const size_t entries = batch.get_name_entries();
+    const bool dictionary = batch.has_name_dictionary();
+    size_t needed = calculate_columnar_batch_size(batch);
+    if (!buffer || buffer_size < needed) return 0;
+    
+    write_compact_header(buffer, count, batch.get_batch_id(), dictionary, entries, batch.get_name_bytes());
+    
+    // El layout en memoria coincide con el wire: una copia por columna
+    char* ptr = buffer + sizeof(CompactBatchHeader);
+    memcpy(ptr, batch.value_column(), count * sizeof(double));     ptr += count * sizeof(double);
+    memcpy(ptr, batch.id_column(), count * sizeof(int32_t));       ptr += count * sizeof(int32_t);
+    memcpy(ptr, batch.category_column(), count * sizeof(int32_t)); ptr += count * sizeof(int32_t);
+    if (dictionary) {
+        memcpy(ptr, batch.name_code_column(), count * sizeof(uint32_t));
+        ptr += count * sizeof(uint32_t);
+    }
+    memcpy(ptr, batch.name_offset_column(), (entries + 1) * sizeof(uint32_t));
+    ptr += (entries + 1) * sizeof(uint32_t);
+    if (batch.get_name_bytes() > 0) {
+        memcpy(ptr, batch.name_bytes_data(), batch.get_name_bytes());
+    }
+    
+    seal_compact_header(buffer);
+    return needed;
+}
+
+bool Serializer::deserialize_columnar_batch(const char* buffer, size_t size, ColumnarBatch& batch) {
+    if (is_compressed_batch(buffer, size) || is_encoded_batch(buffer, size)) {
+        std::vector<char> storage;
+        size_t plain_size = 0;
+        const char* plain = expand_compact_batch(buffer, size, storage, plain_size);
+        return plain && deserialize_columnar_batch(plain, plain_size, batch);
+    }
+    
+    CompactLayout layout;
+    if (!read_compact_layout(buffer, size, layout)) return false;
+    
+    if (!batch.load_columns(layout.header.count,
+                            reinterpret_cast<const int*>(layout.ids),
+                            reinterpret_cast<const double*>(layout.values),
+                            reinterpret_cast<const int*>(layout.categories),
+                            reinterpret_cast<const uint32_t*>(layout.codes),
+                            layout.header.name_entries,
+                            reinterpret_cast<const uint32_t*>(layout.offsets),
+                            layout.names, layout.header.name_bytes)) {
+        return false;
+    }
+    batch.set_batch_id(layout.header.batch_id);
+    return true;
+}
+
+bool Serializer::is_compact_batch(const char* buffer, size_t size) {
+    if (!buffer || size < sizeof(CompactBatchHeader)) return false;
+    
+    uint32_t magic;
+    memcpy(&magic, buffer, sizeof(magic));
+    return magic == COMPACT_BATCH_MAGIC;
+}
+
+size_t Serializer::get_compact_batch_count(const char* buffer, size_t size) {
+    CompactBatchHeader header;
+    return read_compact_header(buffer, size, header) ? header.count : 0;
+}
+
+size_t Serializer::get_compact_batch_size(const char* buffer, size_t size) {
+    CompactBatchHeader header;
+    return read_compact_header(buffer, size, header) ? compact_size(header) : 0;
+}
+
+size_t Serializer::get_compact_header_size() {
+    return sizeof(CompactBatchHeader);
+}
+
+bool Serializer::is_compressed_batch(const char* buffer, size_t size) {
+    CompactBatchHeader header;
+    return read_compact_header(buffer, size, header) && (header.flags & COMPACT_FLAG_COMPRESSED) != 0;
+}
+
+size_t Serializer::get_uncompressed_batch_size(const char* buffer, size_t size) {
+    CompactBatchHeader header;
+    return read_compact_header(buffer, size, header) ? uncompressed_compact_size(header) : 0;
+}
+
+size_t Serializer::compress_compact_batch(const char* buffer, size_t size, char* out, size_t out_size) {
+    CompactBatchHeader header;
+    if (!out || !read_compact_header(buffer, size, header) || size < compact_size(header)) return 0;
+    if ((header.flags & COMPACT_FLAG_COMPRESSED) || !compact_payload_intact(buffer, header)) return 0;
+    if (out_size <= sizeof(CompactBatchHeader)) return 0;
+    
+    // El presupuesto de salida hace de bypass: BlockCodec aborta en cuanto
+    // lo excede, sin terminar de recorrer datos incompresibles
+    const size_t payload = compact_size(header) - sizeof(CompactBatchHeader);
+    size_t budget = payload - payload / COMPACT_MIN_SAVING_DIVISOR;
+    budget = std::min(budget, out_size - sizeof(CompactBatchHeader));
+    size_t compressed = BlockCodec::compress(buffer + sizeof(CompactBatchHeader), payload,
+                                             out + sizeof(CompactBatchHeader), budget);
+    if (compressed == 0) return 0;
+    
+    header.flags |= COMPACT_FLAG_COMPRESSED;
+    header.compressed_bytes = static_cast<uint32_t>(compressed);
+    memcpy(out, &header, sizeof(header));
+    seal_compact_header(out);
+    return sizeof(CompactBatchHeader) + compressed;
+}
+
+size_t Serializer::decompress_compact_batch(const char* buffer, size_t size, char* out, size_t out_size) {
+    CompactBatchHeader header;
+    if (!out || !read_compact_header(buffer, size, header)) return 0;
+    if (!(header.flags & COMPACT_FLAG_COMPRESSED) || size < compact_size(header)) return 0;
+    if (!compact_payload_intact(buffer, header)) return 0;
+    
+    const size_t expanded = uncompressed_compact_size(header);
+    if (out_size < expanded) return 0;
+    if (!BlockCodec::decompress(buffer + sizeof(CompactBatchHeader), header.compressed_bytes,
+                                out + sizeof(CompactBatchHeader), expanded - sizeof(CompactBatchHeader))) {
+        return 0;
+    }
+    
+    header.flags &= ~COMPACT_FLAG_COMPRESSED;
+    header.compressed_bytes = 0;
+    memcpy(out, &header, sizeof(header));
+    seal_compact_header(out);
+    return expanded;
+}
+
+bool Serializer::is_encoded_batch(const char* buffer, size_t size) {
+    CompactBatchHeader header;
+    return read_compact_header(buffer, size, header) && (header.flags & COMPACT_FLAG_ENCODED_COLUMNS) != 0;
+}
+
+size_t Serializer::get_decoded_batch_size(const char* buffer, size_t size) {
+    CompactBatchHeader header;
+    return read_compact_header(buffer, size, header) ? plain_compact_size(header) : 0;
+}
+
+size_t Serializer::encode_compact_batch(const char* buffer, size_t size, char* out, size_t out_size,
+                                        bool xor_values) {
+    CompactLayout layout;
+    if (!out || !read_compact_layout(buffer, size, layout)) return 0;
+    
+    // Solo compensa si el payload codificado es menor que el original
+    const CompactBatchHeader& plain = layout.header;
+    const size_t count = plain.count;
+    const size_t payload = compact_size(plain) - sizeof(CompactBatchHeader);
+    const size_t rest = payload - count * (sizeof(double) + 2 * sizeof(int32_t));
+    if (out_size <= sizeof(CompactBatchHeader)) return 0;
+    const size_t budget = std::min(payload - 1, out_size - sizeof(CompactBatchHeader));
+    if (budget < sizeof(EncodedColumnsHeader) + rest) return 0;
+    
+    unsigned char* const start = reinterpret_cast<unsigned char*>(out + sizeof(CompactBatchHeader));
+    unsigned char* ptr = start + sizeof(EncodedColumnsHeader);
+    size_t available = budget - sizeof(EncodedColumnsHeader) - rest;
+    
+    EncodedColumnsHeader columns;
+    size_t written;
+    if (!ColumnCodec::encode_deltas(layout.ids, count, ptr, available, written)) return 0;
+    columns.id_bytes = static_cast<uint32_t>(written);
+    ptr += written;
+    available -= written;
+    
+    if (!ColumnCodec::pack_bits(layout.categories, count, ptr, available,
+                                columns.category_base, columns.category_bits, written)) {
+        return 0;
+    }
+    columns.category_bytes = static_cast<uint32_t>(written);
+    ptr += written;
+    available -= written;
+    
+    // values con XOR solo si ocupa menos que los doubles tal cual
+    const size_t raw_values = count * sizeof(double);
+    columns.value_xor = 0;
+    if (xor_values && raw_values > 0 &&
+        ColumnCodec::encode_xor(layout.values, count, ptr, std::min(available, raw_values - 1), written)) {
+        columns.value_xor = 1;
+    } else {
+        if (available < raw_values) return 0;
+        memcpy(ptr, layout.values, raw_values);
+        written = raw_values;
+    }
+    columns.value_bytes = static_cast<uint32_t>(written);
+    ptr += written;
+    
+    // name_codes, name_offsets y name_data viajan sin cambios
+    memcpy(ptr, layout.categories + count * sizeof(int32_t), rest);
+    ptr += rest;
+    memcpy(start, &columns, sizeof(columns));
+    
+    CompactBatchHeader header = plain;
+    header.flags |= COMPACT_FLAG_ENCODED_COLUMNS;
+    header.encoded_bytes = static_cast<uint32_t>(ptr - start);
+    memcpy(out, &header, sizeof(header));
+    seal_compact_header(out);
+    return sizeof(CompactBatchHeader) + header.encoded_bytes;
+}
+
+size_t Serializer::decode_compact_batch(const char* buffer, size_t size, char* out, size_t out_size) {
+    CompactBatchHeader header;
+    if (!out || !read_compact_header(buffer, size, header) || size < compact_size(header)) return 0;
+    if ((header.flags & COMPACT_FLAG_COMPRESSED) || !(header.flags & COMPACT_FLAG_ENCODED_COLUMNS)) return 0;
+    if (!compact_payload_intact(buffer, header)) return 0;
+    
+    const size_t count = header.count;
+    const size_t plain = plain_compact_size(header);
+    const size_t rest = plain - sizeof(CompactBatchHeader) - count * (sizeof(double) + 2 * sizeof(int32_t));
+    if (out_size < plain) return 0;
+    
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(buffer + sizeof(CompactBatchHeader));
+    EncodedColumnsHeader columns;
+    memcpy(&columns, in, sizeof(columns));
+    in += sizeof(columns);
+    
+    // Las secciones deben sumar exactamente el payload codificado
+    uint64_t sections = static_cast<uint64_t>(columns.id_bytes) + columns.category_bytes +
+                        columns.value_bytes + rest + sizeof(EncodedColumnsHeader);
+    if (sections != header.encoded_bytes) return 0;
+    
+    char* values = out + sizeof(CompactBatchHeader);
+    char* ids = values + count * sizeof(double);
+    char* categories = ids + count * sizeof(int32_t);
+    if (!ColumnCodec::decode_deltas(in, columns.id_bytes, ids, count)) return 0;
+    in += columns.id_bytes;
+    if (!ColumnCodec::unpack_bits(in, columns.category_bytes, columns.category_base,
+                                  columns.category_bits, categories, count)) {
+        return 0;
+    }
+    in += columns.category_bytes;
+    if (columns.value_xor) {
+        if (!ColumnCodec::decode_xor(in, columns.value_bytes, values, count)) return 0;
+    } else {
+        if (columns.value_bytes != count * sizeof(double)) return 0;
+        memcpy(values, in, columns.value_bytes);
+    }
+    in += columns.value_bytes;
+    memcpy(categories + count * sizeof(int32_t), in, rest);
+    
+    header.flags &= ~COMPACT_FLAG_ENCODED_COLUMNS;
+    header.encoded_bytes = 0;
+    memcpy(out, &header, sizeof(header));
+    seal_compact_header(out);
+    return plain;
+}
+
+const char* Serializer::expand_compact_batch(const char* buffer, size_t size, std::vector<char>& storage,
+                                             size_t& plain_size) {
+    CompactBatchHeader header;
+    if (!read_compact_header(buffer, size, header) || size < compact_size(header)) return NULL;
+    
+    // Primero la compresión, luego la codificación de columnas
+    std::vector<char> decompressed;
+    if (header.flags & COMPACT_FLAG_COMPRESSED) {
+        decompressed.resize(uncompressed_compact_size(header));
+        size = decompress_compact_batch(buffer, size, &decompressed[0], decompressed.size());
+        if (size == 0) return NULL;
+        buffer = &decompressed[0];
+    }
+    if (header.flags & COMPACT_FLAG_ENCODED_COLUMNS) {
+        storage.resize(plain_compact_size(header));
+        plain_size = decode_compact_batch(buffer, size, &storage[0], storage.size());
+        return plain_size > 0 ? &storage[0] : NULL;
+    }
+    if (header.flags & COMPACT_FLAG_COMPRESSED) {
+        storage.swap(decompressed);
+        plain_size = size;
+        return &storage[0];
+    }
+    
+    plain_size = compact_size(header);
+    return buffer;
+}
+
+bool Serializer::reseal_compact_batch(char* buffer, size_t size) {
+    CompactBatchHeader header;
+    if (!read_compact_header(buffer, size, header) || size < compact_size(header)) return false;
+    
+    seal_compact_header(buffer);
+    return true;
+}
+
+// =============================================================================
+// VISTA SIN COPIA
+// =============================================================================
+
+// DatabaseRecord tiene constructor, así que offsetof no es válido en C++98
+static const DatabaseRecord record_layout;
+static const char* const record_base = reinterpret_cast<const char*>(&record_layout);
+static const size_t RECORD_ID_OFFSET = reinterpret_cast<const char*>(&record_layout.id) - record_base;
+static const size_t RECORD_NAME_OFFSET = reinterpret_cast<const char*>(record_layout.name) - record_base;
+static const size_t RECORD_VALUE_OFFSET = reinterpret_cast<const char*>(&record_layout.value) - record_base;
+static const size_t RECORD_CATEGORY_OFFSET = reinterpret_cast<const char*>(&record_layout.category) - record_base;
+
+SerializedBatchView::SerializedBatchView() {
+    reset();
+}
+
+SerializedBatchView::SerializedBatchView(const char* data, size_t size) {
+    open(data, size);
+}
+
+void SerializedBatchView::reset() {
+    buffer = NULL;
+    serialized_size = 0;
+    format = NO_FORMAT;
+    count = 0;
+    batch_id = 0;
+    aligned = false;
+    records = values = ids = categories = codes = offsets = names = NULL;
+    name_entries = 0;
+}
+
+bool SerializedBatchView::open(const char* data, size_t size) {
+    reset();
+    if (!data) return false;
+    
+    bool opened = Serializer::is_compact_batch(data, size) ? open_compact_format(data, size)
+                                                           : open_record_format(data, size);
+    if (!opened) {
+        reset();
+        return false;
+    }
+    
+    buffer = data;
+    aligned = (reinterpret_cast<uintptr_t>(data) % sizeof(double)) == 0;
+    return true;
+}
+
+bool SerializedBatchView::open_record_format(const char* data, size_t size) {
+    // Solo el esquema nativo puede leerse en sitio; los demás se convierten
+    // con Serializer::deserialize_batch
+    RecordLayout layout;
+    if (!read_record_layout(data, size, layout) || !layout.native) return false;
+    
+    if (Crc32c::compute(layout.records, layout.payload_size) != layout.header.payload_crc) {
+        return false;
+    }
+    
+    format = RECORD_FORMAT;
+    count = static_cast<size_t>(layout.header.count);
+    batch_id = layout.header.batch_id;
+    records = layout.records;
+    serialized_size = static_cast<size_t>(layout.records - data) + layout.payload_size;
+    return true;
+}
+
+bool SerializedBatchView::open_compact_format(const char* data, size_t size) {
+    CompactLayout layout;
+    if (!read_compact_layout(data, size, layout)) return false;
+    
+    format = COMPACT_FORMAT;
+    count = layout.header.count;
+    batch_id = layout.header.batch_id;
+    values = layout.values;
+    ids = layout.ids;
+    categories = layout.categories;
+    codes = layout.codes;
+    offsets = layout.offsets;
+    names = layout.names;
+    name_entries = layout.header.name_entries;
+    serialized_size = compact_size(layout.header);
+    return true;
+}
+
+const DatabaseRecord* SerializedBatchView::get_records() const {
+    if (format != RECORD_FORMAT || !aligned) return NULL;
+    return reinterpret_cast<const DatabaseRecord*>(records);
+}
+
+const double* SerializedBatchView::value_column() const {
+    if (format != COMPACT_FORMAT || !aligned) return NULL;
+    return reinterpret_cast<const double*>(values);
+}
+
+const int* SerializedBatchView::id_column() const {
+    if (format != COMPACT_FORMAT || !aligned) return NULL;
+    return reinterpret_cast<const int*>(ids);
+}
+
+const int* SerializedBatchView::category_column() const {
+    if (format != COMPACT_FORMAT || !aligned) return NULL;
+    return reinterpret_cast<const int*>(categories);
+}
+
+const uint32_t* SerializedBatchView::name_code_column() const {
+    if (format != COMPACT_FORMAT || !aligned) return NULL;
+    return reinterpret_cast<const uint32_t*>(codes);
+}
+
+const uint32_t* SerializedBatchView::name_offset_column() const {
+    if (format != COMPACT_FORMAT || !aligned) return NULL;
+    return reinterpret_cast<const uint32_t*>(offsets);
+}
+
+const char* SerializedBatchView::name_bytes_data() const {
+    return format == COMPACT_FORMAT ? names : NULL;
+}
+
+size_t SerializedBatchView::name_entry(size_t row) const {
+    if (!codes) return row;
+    
+    uint32_t code;
+    memcpy(&code, codes + row * sizeof(uint32_t), sizeof(code));
+    return code;
+}
+
+int SerializedBatchView::id_at(size_t row) const {
+    if (row >= count) return 0;
+    
+    int32_t id;
+    if (format == RECORD_FORMAT) {
+        memcpy(&id, records + row * sizeof(DatabaseRecord) + RECORD_ID_OFFSET, sizeof(id));
+    } else {
+        memcpy(&id, ids + row * sizeof(int32_t), sizeof(id));
+    }
+    return id;
+}
+
+double SerializedBatchView::value_at(size_t row) const {
+    if (row >= count) return 0.0;
+    
+    double value;
+    if (format == RECORD_FORMAT) {
+        memcpy(&value, records + row * sizeof(DatabaseRecord) + RECORD_VALUE_OFFSET, sizeof(value));
+    } else {
+        memcpy(&value, values + row * sizeof(double), sizeof(value));
+    }
+    return value;
+}
+
+int SerializedBatchView::category_at(size_t row) const {
+    if (row >= count) return 0;
+    
+    int32_t category;
+    if (format == RECORD_FORMAT) {
+        memcpy(&category, records + row * sizeof(DatabaseRecord) + RECORD_CATEGORY_OFFSET,
+               sizeof(category));
+    } else {
+        memcpy(&category, categories + row * sizeof(int32_t), sizeof(category));
+    }
+    return category;
+}
+
+const char* SerializedBatchView::name_at(size_t row, size_t& length) const {
+    length = 0;
+    if (row >= count) return NULL;
+    
+    if (format == RECORD_FORMAT) {
+        const char* name = records + row * sizeof(DatabaseRecord) + RECORD_NAME_OFFSET;
+        length = strnlen(name, sizeof(((DatabaseRecord*)0)->name));
+        return name;
+    }
+    
+    size_t entry = name_entry(row);
+    uint32_t begin, end;
+    memcpy(&begin, offsets + entry * sizeof(uint32_t), sizeof(begin));
+    memcpy(&end, offsets + (entry + 1) * sizeof(uint32_t), sizeof(end));
+    length = end - begin;
+    return names + begin;
+}
+
+bool SerializedBatchView::get_record(size_t row, DatabaseRecord& record) const {
+    if (row >= count) return false;
+    
+    record.id = id_at(row);
+    record.value = value_at(row);
+    record.category = category_at(row);
+    
+    size_t length;
+    const char* name = name_at(row, length);
+    record.set_name(name, length);
+    return true;
+}
+
+bool SerializedBatchView::copy_to(RecordBatch* batch) const {
+    if (!is_valid() || !batch || !batch->records || batch->capacity < count) return false;
+    
+    if (format == RECORD_FORMAT) {
+        if (count > 0) {
+            memcpy(batch->records, records, count * sizeof(DatabaseRecord));
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            get_record(i, batch->records[i]);
+        }
+    }
+    
+    batch->count = count;
+    batch->batch_id = batch_id;
+    return true;
 }
 
 } // namespace distributed
@@ -20,11 +20,38 @@
 // src/supervisor.cpp
 #include "supervisor.h"
 #include "isolated_process.h"
+#include "replicated_stage.h"
+#include "in_process_plugin.h"
 #include <iostream>
 #include <algorithm>
 
 namespace distributed {
 
+// Arrancar un componente según su tipo (los plugins en proceso ya vienen cargados)
+static bool start_supervised(IProcessingComponent* component) {
+    IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(component);
+    if (process) return process->start();
+    ReplicatedStage* stage = dynamic_cast<ReplicatedStage*>(component);
+    if (stage) return stage->start();
+    return true;
+}
+
+static void stop_supervised(IProcessingComponent* component) {
+    IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(component);
+    if (process) process->terminate();
+    ReplicatedStage* stage = dynamic_cast<ReplicatedStage*>(component);
+    if (stage) stage->terminate();
+}
+
+static void restart_supervised(IProcessingComponent* component) {
+    IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(component);
+    if (process) process->restart();
+    ReplicatedStage* stage = dynamic_cast<ReplicatedStage*>(component);
+    if (stage) stage->restart();
+    InProcessPlugin* in_process = dynamic_cast<InProcessPlugin*>(component);
+    if (in_process) in_process->reload();
+}
+
 SupervisorSpec::SupervisorSpec() 
     : restart_policy(ONE_FOR_ONE), max_restarts(5), restart_period(60), shutdown_timeout(10) {}
 
@@ -81,9 +108,8 @@ bool ProcessSupervisor::start_all_components() {
     
     bool all_started = true;
     for (size_t i = 0; i < supervised_components.size(); ++i) {
-        IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(supervised_components[i]);
-        if (process && !process->start()) {
-            std::cerr << "Error iniciando componente " << process->get_name() << std::endl;
+        if (!start_supervised(supervised_components[i])) {
+            std::cerr << "Error iniciando componente " << supervised_components[i]->get_name() << std::endl;
             all_started = false;
         }
     }
@@ -96,10 +122,7 @@ void ProcessSupervisor::stop_all_components() {
     pthread_mutex_lock(&supervisor_mutex);
     
     for (size_t i = 0; i < supervised_components.size(); ++i) {
-        IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(supervised_components[i]);
-        if (process) {
-            process->terminate();
-        }
+        stop_supervised(supervised_components[i]);
     }
     
     pthread_mutex_unlock(&supervisor_mutex);
@@ -173,10 +196,7 @@ void ProcessSupervisor::restart_component(const std::string& component_name) {
         if (supervised_components[i]->get_name() == component_name) {
             std::cout << "Reiniciando componente: " << component_name << std::endl;
             
-            IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(supervised_components[i]);
-            if (process) {
-                process->restart();
-            }
+            restart_supervised(supervised_components[i]);
             break;
         }
     }
@@ -186,10 +206,7 @@ void ProcessSupervisor::restart_all_components() {
     std::cout << "Reiniciando todos los componentes en supervisor " << supervisor_name << std::endl;
     
     for (size_t i = 0; i < supervised_components.size(); ++i) {
-        IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(supervised_components[i]);
-        if (process) {
-            process->restart();
-        }
+        restart_supervised(supervised_components[i]);
     }
 }
 
@@ -198,10 +215,7 @@ void ProcessSupervisor::restart_remaining_components(size_t from_index) {
               << " en supervisor " << supervisor_name << std::endl;
     
     for (size_t i = from_index; i < supervised_components.size(); ++i) {
-        IsolatedPluginProcess* process = dynamic_cast<IsolatedPluginProcess*>(supervised_components[i]);
-        if (process) {
-            process->restart();
-        }
+        restart_supervised(supervised_components[i]);
     }
 }
 
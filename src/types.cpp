@@ -21,6 +21,7 @@
 #include "types.h"
 #include <cstring>
 #include <ctime>
+#include <stdint.h>
 
 namespace distributed {
 
@@ -28,6 +29,23 @@ DatabaseRecord::DatabaseRecord() : id(0), value(0.0), category(0) {
     memset(name, 0, sizeof(name));
 }
 
+void DatabaseRecord::set_name(const char* text, size_t length) {
+    if (length > sizeof(name) - 1) {
+        length = sizeof(name) - 1;
+    }
+    
+    // Por palabras: con la longitud acotada, GCC expande memcpy a rep movsq,
+    // cuyo arranque cuesta más que copiar un nombre corto entero
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        memcpy(name + i, text + i, sizeof(uint64_t));
+    }
+    for (; i < length; ++i) {
+        name[i] = text[i];
+    }
+    name[length] = '\0';
+}
+
 RecordBatch::RecordBatch() : records(NULL), count(0), capacity(0), batch_id(0) {}
 
 void RecordBatch::add_record(const DatabaseRecord& record) {
@@ -20,11 +20,41 @@
 // tests/test_all.cpp
 #include <iostream>
 #include <cassert>
+#include <cstring>
 
 // Headers de todos los tests unitarios
 extern int test_memory_pool_main();
 extern int test_serialization_main();
 extern int test_configuration_main();
+extern int test_scratch_arena_main();
+extern int test_columnar_batch_main();
+extern int test_crc32c_main();
+extern int test_block_codec_main();
+extern int test_column_codec_main();
+extern int test_batch_stream_main();
+extern int test_record_schema_main();
+extern int test_shm_ring_main();
+extern int test_fused_pipeline_main();
+extern int test_in_process_plugin_main();
+extern int test_replicated_stage_main();
+extern int test_stage_pipeline_main();
+extern int test_process_restart_main();
+
+// Benchmarks, solo con --bench
+extern int benchmark_memory_pool_main();
+extern int benchmark_serialization_main();
+extern int benchmark_scratch_arena_main();
+extern int benchmark_columnar_batch_main();
+extern int benchmark_crc32c_main();
+extern int benchmark_block_codec_main();
+extern int benchmark_column_codec_main();
+extern int benchmark_record_schema_main();
+extern int benchmark_shm_ring_main();
+extern int benchmark_fused_pipeline_main();
+extern int benchmark_in_process_plugin_main();
+extern int benchmark_replicated_stage_main();
+extern int benchmark_stage_pipeline_main();
+extern int benchmark_process_restart_main();
 
 // Tests adicionales de integración
 #include "../include/distributed_system.h"
@@ -172,10 +202,11 @@ void test_error_conditions() {
     
     DistributedMemoryPool pool(1024, 2);
     
-    // Intentar asignar más memoria de la disponible
-    void* ptr = pool.allocate(2048); // Más grande que block_size
-    assert(ptr == NULL);
-    std::cout << "✓ Memory Pool rechaza asignaciones grandes correctamente" << std::endl;
+    // Tamaños mayores que block_size se sirven desde clases más grandes
+    void* ptr = pool.allocate(2048);
+    assert(ptr != NULL);
+    pool.deallocate(ptr);
+    std::cout << "✓ Memory Pool sirve asignaciones mayores que block_size correctamente" << std::endl;
     
     // Test de Serialization con datos inválidos
     std::cout << "Test: Serialization con datos inválidos..." << std::endl;
@@ -250,13 +281,15 @@ void test_performance_characteristics() {
         batch->add_record(record);
     }
     
-    char* buffer = new char[64 * 1024]; // 64KB
+    // El batch ya tiene memoria real para sus 1000 registros (~120KB)
+    size_t buffer_size = Serializer::calculate_batch_size(batch);
+    char* buffer = new char[buffer_size];
     
     gettimeofday(&start, NULL);
     
     const int serialization_iterations = 1000;
     for (int i = 0; i < serialization_iterations; ++i) {
-        size_t size = Serializer::serialize_batch(batch, buffer, 64 * 1024);
+        size_t size = Serializer::serialize_batch(batch, buffer, buffer_size);
         assert(size > 0);
     }
     
@@ -274,7 +307,34 @@ void test_performance_characteristics() {
     std::cout << "✓ Test de performance completado" << std::endl;
 }
 
-int main() {
+// Los benchmarks tardan y sus números solo sirven en una máquina tranquila,
+// así que no forman parte de la ejecución normal de los tests
+int run_benchmarks() {
+    std::cout << "=== BENCHMARKS DEL SISTEMA DISTRIBUIDO MODULAR ===" << std::endl;
+    
+    int failed = 0;
+    if (benchmark_memory_pool_main() != 0) failed++;
+    if (benchmark_serialization_main() != 0) failed++;
+    if (benchmark_scratch_arena_main() != 0) failed++;
+    if (benchmark_columnar_batch_main() != 0) failed++;
+    if (benchmark_crc32c_main() != 0) failed++;
+    if (benchmark_block_codec_main() != 0) failed++;
+    if (benchmark_column_codec_main() != 0) failed++;
+    if (benchmark_record_schema_main() != 0) failed++;
+    if (benchmark_shm_ring_main() != 0) failed++;
+    if (benchmark_fused_pipeline_main() != 0) failed++;
+    if (benchmark_in_process_plugin_main() != 0) failed++;
+    if (benchmark_replicated_stage_main() != 0) failed++;
+    if (benchmark_stage_pipeline_main() != 0) failed++;
+    if (benchmark_process_restart_main() != 0) failed++;
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bench") == 0) return run_benchmarks();
+    }
+    
     std::cout << "=== TESTS COMPLETOS DEL SISTEMA DISTRIBUIDO MODULAR ===" << std::endl;
     std::cout << std::endl;
     
@@ -287,6 +347,19 @@ int main() {
         if (test_memory_pool_main() != 0) failed_tests++;
         if (test_serialization_main() != 0) failed_tests++;
         if (test_configuration_main() != 0) failed_tests++;
+        if (test_scratch_arena_main() != 0) failed_tests++;
+        if (test_columnar_batch_main() != 0) failed_tests++;
+        if (test_crc32c_main() != 0) failed_tests++;
+        if (test_block_codec_main() != 0) failed_tests++;
+        if (test_column_codec_main() != 0) failed_tests++;
+        if (test_batch_stream_main() != 0) failed_tests++;
+        if (test_record_schema_main() != 0) failed_tests++;
+        if (test_shm_ring_main() != 0) failed_tests++;
+        if (test_fused_pipeline_main() != 0) failed_tests++;
+        if (test_in_process_plugin_main() != 0) failed_tests++;
+        if (test_replicated_stage_main() != 0) failed_tests++;
+        if (test_stage_pipeline_main() != 0) failed_tests++;
+        if (test_process_restart_main() != 0) failed_tests++;
         
         std::cout << std::endl;
         
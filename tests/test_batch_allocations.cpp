@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// tests/test_batch_allocations.cpp
+//
+// Binario propio (no forma parte de test_all): reemplaza el operator new
+// global, y ese reemplazo afectaría a todos los tests enlazados con él.
+#include "../include/memory_pool.h"
+#include <cassert>
+#include <iostream>
+#include <cstdlib>
+#include <new>
+
+using namespace distributed;
+
+// La especificación dinámica de excepciones está obsoleta desde C++11
+#if __cplusplus >= 201103L
+#define ALLOCATOR_THROWS
+#define ALLOCATOR_NOTHROW noexcept
+#else
+#define ALLOCATOR_THROWS throw(std::bad_alloc)
+#define ALLOCATOR_NOTHROW throw()
+#endif
+
+// Contador de llamadas al allocator global. noinline evita falsos positivos
+// de -Wmismatched-new-delete al inlinear los reemplazos.
+static volatile size_t g_allocator_calls = 0;
+
+__attribute__((noinline)) void* operator new(size_t size) ALLOCATOR_THROWS {
+    __sync_fetch_and_add(&g_allocator_calls, 1);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) ALLOCATOR_NOTHROW {
+    std::free(ptr);
+}
+
+void test_steady_state_batches() {
+    std::cout << "Test: Steady-state batch allocations..." << std::endl;
+    
+    DistributedMemoryPool pool(sizeof(DatabaseRecord) * 100, 2);
+    
+    // Calentar las clases usadas y luego medir el régimen estacionario
+    for (int i = 0; i < 4; ++i) {
+        RecordBatch* a = pool.create_batch(100);
+        RecordBatch* b = pool.create_batch(1000);
+        pool.free_batch(a);
+        pool.free_batch(b);
+    }
+    
+    size_t calls_before = g_allocator_calls;
+    int last_id = 0;
+    for (int i = 0; i < 10000; ++i) {
+        RecordBatch* a = pool.create_batch(100);
+        RecordBatch* b = pool.create_batch(1000);
+        assert(a->records && b->records);
+        assert(b->batch_id > a->batch_id && a->batch_id > last_id);
+        last_id = b->batch_id;
+        pool.free_batch(b);
+        pool.free_batch(a);
+    }
+    size_t calls_after = g_allocator_calls;
+    
+    std::cout << "  Llamadas al allocator en 10000 ciclos create/free: "
+              << (calls_after - calls_before) << std::endl;
+    assert(calls_after == calls_before);
+    
+    std::cout << "✓ Steady-state batch allocations passed" << std::endl;
+}
+
+int main() {
+    std::cout << "=== Batch Allocation Tests ===" << std::endl;
+    
+    test_steady_state_batches();
+    
+    std::cout << "All batch allocation tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_batch_stream.cpp
+#include "../include/batch_stream.h"
+#include "../include/distributed_node.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace distributed;
+
+static void fill_batch(RecordBatch& batch, size_t count, int batch_id) {
+    batch.records = new DatabaseRecord[count];
+    batch.capacity = count;
+    batch.count = count;
+    batch.batch_id = batch_id;
+    for (size_t i = 0; i < count; ++i) {
+        batch.records[i].id = static_cast<int>(i);
+        batch.records[i].category = static_cast<int>(i % 7);
+        batch.records[i].value = i * 0.25;
+        sprintf(batch.records[i].name, "Record_%lu", static_cast<unsigned long>(i % 1000));
+    }
+}
+
+static void assert_same_records(const RecordBatch& expected, const RecordBatch& actual) {
+    assert(actual.count == expected.count);
+    assert(actual.batch_id == expected.batch_id);
+    for (size_t i = 0; i < expected.count; ++i) {
+        assert(actual.records[i].id == expected.records[i].id);
+        assert(actual.records[i].category == expected.records[i].category);
+        assert(actual.records[i].value == expected.records[i].value);
+        assert(strcmp(actual.records[i].name, expected.records[i].name) == 0);
+    }
+}
+
+// Alimenta el parser en trozos de step bytes (0 = tamaños pseudoaleatorios)
+static BatchStreamParser::Status parse_in_steps(const std::vector<char>& stream, size_t step,
+                                                RecordBatch& target) {
+    BatchStreamParser parser;
+    BatchStreamParser::Status status = BatchStreamParser::NEED_MORE;
+    uint32_t seed = 11;
+    size_t offset = 0;
+    
+    while (offset <= stream.size()) {
+        size_t size = step;
+        if (step == 0) {
+            seed = seed * 1103515245u + 12345u;
+            size = 1 + (seed >> 16) % 5000;
+        }
+        size = std::min(size, stream.size() - offset);
+        
+        size_t consumed = 0;
+        status = parser.feed(stream.empty() ? NULL : &stream[0] + offset, size, consumed);
+        offset += consumed;
+        
+        if (status == BatchStreamParser::HEADER_READY) {
+            assert(parser.get_total_count() <= target.capacity);
+            assert(parser.set_target(&target));
+            continue;
+        }
+        if (status != BatchStreamParser::NEED_MORE || size == 0) break;
+    }
+    return status;
+}
+
+void test_batch_stream_round_trip() {
+    std::cout << "Test: Batch stream round trip..." << std::endl;
+    
+    RecordBatch batch;
+    fill_batch(batch, 10000, 42);
+    
+    const bool modes[][2] = { { false, false }, { true, false }, { false, true }, { true, true } };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+        std::vector<char> stream;
+        BufferChunkWriter buffer_writer(stream);
+        BatchStreamWriter writer(&buffer_writer, 1000);
+        writer.set_column_encoding(modes[m][0]);
+        writer.set_compression(modes[m][1]);
+        assert(writer.write_batch(&batch));
+        assert(writer.get_bytes_written() == stream.size());
+        
+        const size_t steps[] = { 1, 7, 0, 65536 };
+        for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); ++s) {
+            // 1 byte por llamada es lento: basta con el modo sin codificar
+            if (steps[s] == 1 && m != 0) continue;
+            
+            RecordBatch target;
+            target.records = new DatabaseRecord[batch.count];
+            target.capacity = batch.count;
+            assert(parse_in_steps(stream, steps[s], target) == BatchStreamParser::COMPLETE);
+            assert_same_records(batch, target);
+            delete[] target.records;
+        }
+    }
+    
+    // Un lote vacío es solo el header
+    RecordBatch empty;
+    std::vector<char> stream;
+    BufferChunkWriter buffer_writer(stream);
+    BatchStreamWriter writer(&buffer_writer);
+    assert(writer.write_batch(&empty));
+    RecordBatch target;
+    assert(parse_in_steps(stream, 0, target) == BatchStreamParser::COMPLETE);
+    assert(target.count == 0);
+    
+    // Lo que sigue a un stream completo no se consume
+    fill_batch(empty, 10, 5);
+    stream.clear();
+    assert(writer.write_batch(&empty));
+    size_t stream_size = stream.size();
+    stream.push_back('x');
+    BatchStreamParser parser;
+    RecordBatch small;
+    small.records = new DatabaseRecord[10];
+    small.capacity = 10;
+    size_t consumed = 0;
+    assert(parser.feed(&stream[0], stream.size(), consumed) == BatchStreamParser::HEADER_READY);
+    assert(parser.get_total_count() == 10 && parser.get_batch_id() == 5);
+    assert(parser.set_target(&small));
+    size_t rest = 0;
+    assert(parser.feed(&stream[consumed], stream.size() - consumed, rest) == BatchStreamParser::COMPLETE);
+    assert(consumed + rest == stream_size);
+    assert_same_records(empty, small);
+    
+    delete[] small.records;
+    delete[] empty.records;
+    delete[] batch.records;
+    std::cout << "✓ Batch stream round trip passed" << std::endl;
+}
+
+void test_batch_stream_file_writer() {
+    std::cout << "Test: Batch stream file writer..." << std::endl;
+    
+    RecordBatch batch;
+    fill_batch(batch, 5000, 9);
+    
+    FILE* file = tmpfile();
+    assert(file);
+    FileChunkWriter file_writer(file);
+    BatchStreamWriter writer(&file_writer, 512);
+    writer.set_compression(true);
+    assert(writer.write_batch(&batch));
+    
+    std::vector<char> stream(static_cast<size_t>(writer.get_bytes_written()));
+    rewind(file);
+    assert(fread(&stream[0], 1, stream.size(), file) == stream.size());
+    fclose(file);
+    
+    RecordBatch target;
+    target.records = new DatabaseRecord[batch.count];
+    target.capacity = batch.count;
+    assert(parse_in_steps(stream, 4096, target) == BatchStreamParser::COMPLETE);
+    assert_same_records(batch, target);
+    
+    delete[] target.records;
+    delete[] batch.records;
+    std::cout << "✓ Batch stream file writer passed" << std::endl;
+}
+
+void test_batch_stream_corruption() {
+    std::cout << "Test: Batch stream corruption..." << std::endl;
+    
+    RecordBatch batch;
+    fill_batch(batch, 3000, 17);
+    std::vector<char> stream;
+    BufferChunkWriter buffer_writer(stream);
+    BatchStreamWriter writer(&buffer_writer, 1000);
+    assert(writer.write_batch(&batch));
+    
+    RecordBatch target;
+    target.records = new DatabaseRecord[batch.count];
+    target.capacity = batch.count;
+    
+    // Cualquier byte alterado (header del stream, header o payload de un
+    // chunk) se detecta antes de aceptar el chunk
+    const size_t positions[] = { 0, 12, 31, 40, 100, stream.size() / 2, stream.size() - 1 };
+    for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); ++p) {
+        std::vector<char> corrupted(stream);
+        corrupted[positions[p]] ^= 0x20;
+        assert(parse_in_steps(corrupted, 0, target) == BatchStreamParser::FAILED);
+    }
+    
+    // Un stream truncado nunca se da por completo
+    std::vector<char> truncated(stream.begin(), stream.end() - 1);
+    assert(parse_in_steps(truncated, 0, target) == BatchStreamParser::NEED_MORE);
+    
+    // El destino debe tener capacidad para el total anunciado
+    BatchStreamParser parser;
+    size_t consumed = 0;
+    assert(parser.feed(&stream[0], stream.size(), consumed) == BatchStreamParser::HEADER_READY);
+    RecordBatch small;
+    small.records = target.records;
+    small.capacity = batch.count - 1;
+    assert(!parser.set_target(&small));
+    
+    delete[] target.records;
+    delete[] batch.records;
+    std::cout << "✓ Batch stream corruption passed" << std::endl;
+}
+
+// Alimentar el stream en trozos sobre un destino que crece con los chunks
+static BatchStreamParser::Status parse_growable(const std::vector<char>& stream, size_t length,
+                                                RecordBatch& target, std::vector<DatabaseRecord>& storage) {
+    BatchStreamParser parser;
+    BatchStreamParser::Status status = BatchStreamParser::NEED_MORE;
+    size_t offset = 0;
+    
+    while (offset <= length) {
+        size_t consumed = 0;
+        status = parser.feed(&stream[0] + offset, std::min(static_cast<size_t>(777), length - offset), consumed);
+        offset += consumed;
+        
+        if (status == BatchStreamParser::HEADER_READY) {
+            target.records = NULL;
+            target.capacity = 0;
+            assert(parser.set_target(&target, true));
+            continue;
+        }
+        if (status == BatchStreamParser::NEED_CAPACITY) {
+            storage.resize(parser.get_required_capacity());
+            target.records = &storage[0];
+            target.capacity = storage.size();
+            continue;
+        }
+        if (status != BatchStreamParser::NEED_MORE || offset == length) break;
+    }
+    return status;
+}
+
+void test_batch_stream_growable_target() {
+    std::cout << "Test: Batch stream growable target..." << std::endl;
+    
+    RecordBatch batch;
+    fill_batch(batch, 5000, 23);
+    std::vector<char> stream;
+    BufferChunkWriter buffer_writer(stream);
+    BatchStreamWriter writer(&buffer_writer, 500);
+    writer.set_compression(true);
+    assert(writer.write_batch(&batch));
+    
+    RecordBatch target;
+    std::vector<DatabaseRecord> storage;
+    assert(parse_growable(stream, stream.size(), target, storage) == BatchStreamParser::COMPLETE);
+    assert(storage.size() == batch.count);
+    assert_same_records(batch, target);
+    
+    // Un emisor que anuncia más de lo que envía no obtiene esa memoria
+    storage.clear();
+    assert(parse_growable(stream, stream.size() / 2, target, storage) == BatchStreamParser::NEED_MORE);
+    assert(storage.size() < batch.count && target.count <= storage.size());
+    
+    delete[] batch.records;
+    std::cout << "✓ Batch stream growable target passed" << std::endl;
+}
+
+void test_batch_stream_loopback() {
+    std::cout << "Test: Batch stream over loopback..." << std::endl;
+    
+    DistributedNode receiver("stream_b", "127.0.0.1", 39611);
+    DistributedNode sender("stream_a", "127.0.0.1", 39612);
+    assert(receiver.start());
+    assert(sender.start());
+    usleep(100000);
+    assert(sender.join_cluster("127.0.0.1", 39611));
+    
+    // Varios MB serializados: muy por encima de cualquier buffer fijo
+    const size_t count = 200000;
+    RecordBatch expected;
+    fill_batch(expected, count, 77);
+    
+    for (int mode = 0; mode < 2; ++mode) {
+        sender.set_link_column_encoding("stream_b", mode == 1);
+        sender.set_link_compression("stream_b", mode == 1);
+        
+        RecordBatch batch;
+        fill_batch(batch, count, 77);
+        
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+        assert(sender.send_batch_to_node("stream_b", &batch));
+        gettimeofday(&end, NULL);
+        
+        assert_same_records(expected, batch);
+        double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+        std::cout << "  " << count << " registros ida y vuelta"
+                  << (mode == 1 ? " (codificado+comprimido)" : "") << ": " << ms << " ms" << std::endl;
+        delete[] batch.records;
+    }
+    
+    sender.shutdown();
+    receiver.shutdown();
+    delete[] expected.records;
+    std::cout << "✓ Batch stream over loopback passed" << std::endl;
+}
+
+int test_batch_stream_main() {
+    std::cout << "=== Batch Stream Tests ===" << std::endl;
+    
+    test_batch_stream_round_trip();
+    test_batch_stream_file_writer();
+    test_batch_stream_corruption();
+    test_batch_stream_growable_target();
+    test_batch_stream_loopback();
+    
+    std::cout << "All batch stream tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_block_codec.cpp
+#include "test_helpers.h"
+#include "../include/block_codec.h"
+#include "../include/serialization.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+
+using namespace distributed;
+
+static void assert_round_trip(const std::vector<char>& input) {
+    std::vector<char> compressed(BlockCodec::max_compressed_size(input.size()));
+    const char* src = input.empty() ? "" : &input[0];
+    size_t compressed_size = BlockCodec::compress(src, input.size(), &compressed[0], compressed.size());
+    assert(compressed_size > 0);
+    
+    std::vector<char> output(input.size() + 1);
+    assert(BlockCodec::decompress(&compressed[0], compressed_size, &output[0], input.size()));
+    assert(input.empty() || memcmp(&input[0], &output[0], input.size()) == 0);
+    
+    // El tamaño original es parte del contrato
+    assert(!BlockCodec::decompress(&compressed[0], compressed_size, &output[0], input.size() + 1));
+}
+
+void test_block_codec_round_trip() {
+    std::cout << "Test: Block codec round trip..." << std::endl;
+    
+    uint32_t seed = 7;
+    const size_t sizes[] = { 0, 1, 12, 13, 64, 1000, 65536, 300000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        std::vector<char> zeros(sizes[s], 0);
+        assert_round_trip(zeros);
+        
+        std::vector<char> random(sizes[s]);
+        for (size_t i = 0; i < random.size(); ++i) {
+            seed = seed * 1103515245u + 12345u;
+            random[i] = static_cast<char>(seed >> 16);
+        }
+        assert_round_trip(random);
+        
+        // Texto repetitivo con coincidencias largas, cortas y solapadas
+        std::vector<char> text(sizes[s]);
+        for (size_t i = 0; i < text.size(); ++i) {
+            seed = seed * 1103515245u + 12345u;
+            text[i] = (seed >> 28) == 0 ? static_cast<char>('a' + (seed >> 16) % 26)
+                                        : "Record_12345 "[i % 13];
+        }
+        assert_round_trip(text);
+    }
+    
+    // Datos compresibles caben en mucho menos espacio; los aleatorios no
+    std::vector<char> zeros(100000, 0);
+    std::vector<char> small(1000);
+    assert(BlockCodec::compress(&zeros[0], zeros.size(), &small[0], small.size()) > 0);
+    std::vector<char> random(100000);
+    for (size_t i = 0; i < random.size(); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        random[i] = static_cast<char>(seed >> 16);
+    }
+    std::vector<char> budget(random.size() - random.size() / 8);
+    assert(BlockCodec::compress(&random[0], random.size(), &budget[0], budget.size()) == 0);
+    
+    std::cout << "✓ Block codec round trip test passed" << std::endl;
+}
+
+void test_block_codec_corrupt_input() {
+    std::cout << "Test: Block codec corrupt input..." << std::endl;
+    
+    std::vector<char> input(20000);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = "Record_ CAT 0123"[(i * 7 + i / 100) % 16];
+    }
+    std::vector<char> compressed(BlockCodec::max_compressed_size(input.size()));
+    size_t compressed_size = BlockCodec::compress(&input[0], input.size(), &compressed[0], compressed.size());
+    assert(compressed_size > 0);
+    
+    // Bloques truncados o alterados nunca escriben fuera de la salida
+    std::vector<char> output(input.size());
+    for (size_t cut = 0; cut < compressed_size; cut += 7) {
+        assert(!BlockCodec::decompress(&compressed[0], cut, &output[0], output.size()));
+    }
+    uint32_t seed = 99;
+    for (int trial = 0; trial < 2000; ++trial) {
+        std::vector<char> damaged(compressed.begin(), compressed.begin() + compressed_size);
+        seed = seed * 1103515245u + 12345u;
+        damaged[(seed >> 8) % compressed_size] ^= static_cast<char>(1 + (seed >> 24) % 255);
+        BlockCodec::decompress(&damaged[0], damaged.size(), &output[0], output.size());
+    }
+    
+    std::cout << "✓ Block codec corrupt input test passed" << std::endl;
+}
+
+static void report_codec(const char* label, const char* data, size_t size) {
+    std::vector<char> compressed(BlockCodec::max_compressed_size(size));
+    std::vector<char> output(size);
+    const int iterations = static_cast<int>(std::max(static_cast<size_t>(1), (256u * 1024 * 1024) / size));
+    size_t compressed_size = 0;
+    double start = now_us();
+    for (int it = 0; it < iterations; ++it) {
+        compressed_size = BlockCodec::compress(data, size, &compressed[0], compressed.size());
+    }
+    // Bytes por microsegundo son MB/s
+    double compress_mbps = static_cast<double>(size) * iterations / (now_us() - start);
+    
+    start = now_us();
+    for (int it = 0; it < iterations; ++it) {
+        BlockCodec::decompress(&compressed[0], compressed_size, &output[0], size);
+    }
+    double decompress_mbps = static_cast<double>(size) * iterations / (now_us() - start);
+    assert(memcmp(data, &output[0], size) == 0);
+    
+    std::cout << "  " << label << ": " << size / 1024 << " KB -> " << compressed_size / 1024
+              << " KB (ratio " << static_cast<double>(size) / compressed_size << "), compresión "
+              << compress_mbps << " MB/s, descompresión " << decompress_mbps << " MB/s" << std::endl;
+}
+
+void benchmark_block_codec() {
+    std::cout << "Benchmark: block codec sobre lotes representativos..." << std::endl;
+    
+    const size_t record_count = 10000;
+    RecordBatch rows;
+    rows.records = new DatabaseRecord[record_count];
+    rows.capacity = record_count;
+    rows.count = record_count;
+    rows.batch_id = 1;
+    for (size_t i = 0; i < record_count; ++i) {
+        rows.records[i].id = static_cast<int>(i + 1);
+        rows.records[i].value = (i % 1000) * 1.5;
+        rows.records[i].category = static_cast<int>(i % 5) + 1;
+        sprintf(rows.records[i].name, "Record_%lu", static_cast<unsigned long>(i + 1));
+    }
+    
+    std::vector<char> fixed(Serializer::calculate_batch_size(&rows));
+    size_t fixed_size = Serializer::serialize_batch(&rows, &fixed[0], fixed.size());
+    report_codec("Registros fijos", &fixed[0], fixed_size);
+    
+    std::vector<char> compact(Serializer::calculate_compact_batch_size(&rows));
+    size_t compact_size = Serializer::serialize_batch_compact(&rows, &compact[0], compact.size());
+    report_codec("Compacto", &compact[0], compact_size);
+    
+    // Valores aleatorios: lo peor para el codec, decide el bypass
+    uint32_t seed = 3;
+    for (size_t i = 0; i < record_count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        rows.records[i].value = seed * 1e-3;
+        rows.records[i].id = static_cast<int>(seed);
+    }
+    compact_size = Serializer::serialize_batch_compact(&rows, &compact[0], compact.size());
+    report_codec("Compacto con valores aleatorios", &compact[0], compact_size);
+    
+    std::vector<char> random(1024 * 1024);
+    for (size_t i = 0; i < random.size(); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        random[i] = static_cast<char>(seed >> 16);
+    }
+    report_codec("Aleatorio", &random[0], random.size());
+    
+    delete[] rows.records;
+}
+
+int benchmark_block_codec_main() {
+    benchmark_block_codec();
+    return 0;
+}
+
+int test_block_codec_main() {
+    std::cout << "=== Block Codec Tests ===" << std::endl;
+    
+    test_block_codec_round_trip();
+    test_block_codec_corrupt_input();
+    
+    std::cout << "All block codec tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_column_codec.cpp
+#include "test_helpers.h"
+#include "../include/column_codec.h"
+#include "../include/serialization.h"
+#include "../include/columnar_batch.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+using namespace distributed;
+
+void test_delta_encoding() {
+    std::cout << "Test: Delta varint encoding..." << std::endl;
+    
+    // Secuencial con saltos, negativos y extremos de int32
+    std::vector<int32_t> ids;
+    for (int i = 0; i < 1000; ++i) ids.push_back(i * 100 + (i % 7));
+    ids.push_back(-5);
+    ids.push_back(2147483647);
+    ids.push_back(-2147483647 - 1);
+    for (int i = 0; i < 37; ++i) ids.push_back(500 + i);
+    
+    const char* column = reinterpret_cast<const char*>(&ids[0]);
+    std::vector<unsigned char> encoded(ids.size() * 5);
+    size_t written = 0;
+    assert(ColumnCodec::encode_deltas(column, ids.size(), &encoded[0], encoded.size(), written));
+    assert(written < ids.size() * 2);
+    
+    // SSE2 y escalar dan lo mismo, con la salida en cualquier alineación
+    std::vector<char> decoded(ids.size() * sizeof(int32_t) + 1);
+    std::vector<char> portable(ids.size() * sizeof(int32_t));
+    assert(ColumnCodec::decode_deltas(&encoded[0], written, &decoded[1], ids.size()));
+    assert(ColumnCodec::decode_deltas_portable(&encoded[0], written, &portable[0], ids.size()));
+    assert(memcmp(&decoded[1], column, portable.size()) == 0);
+    assert(memcmp(&portable[0], column, portable.size()) == 0);
+    
+    // Entrada truncada, sobrante o salida sin espacio
+    assert(!ColumnCodec::decode_deltas(&encoded[0], written - 1, &portable[0], ids.size()));
+    assert(!ColumnCodec::decode_deltas(&encoded[0], written, &portable[0], ids.size() - 1));
+    assert(!ColumnCodec::encode_deltas(column, ids.size(), &encoded[0], written - 1, written));
+    
+    std::cout << "✓ Delta varint encoding test passed" << std::endl;
+}
+
+void test_bit_packing() {
+    std::cout << "Test: Bit packing..." << std::endl;
+    
+    const int32_t domains[][2] = { { 7, 7 }, { 1, 10 }, { -3, 200 }, { 0, 65535 }, { -2147483647 - 1, 2147483647 } };
+    for (size_t d = 0; d < sizeof(domains) / sizeof(domains[0]); ++d) {
+        const uint32_t span = static_cast<uint32_t>(domains[d][1]) - static_cast<uint32_t>(domains[d][0]);
+        std::vector<int32_t> values(1001);
+        for (size_t i = 0; i < values.size(); ++i) {
+            uint32_t offset = static_cast<uint32_t>(i) * 2654435761u;
+            if (span != 0xFFFFFFFFu) offset %= span + 1;
+            values[i] = static_cast<int32_t>(static_cast<uint32_t>(domains[d][0]) + offset);
+        }
+        values[0] = domains[d][0];
+        values[1] = domains[d][1];
+        
+        std::vector<unsigned char> packed(values.size() * 4 + 8);
+        int32_t base;
+        uint32_t bits;
+        size_t written;
+        assert(ColumnCodec::pack_bits(reinterpret_cast<const char*>(&values[0]), values.size(),
+                                      &packed[0], packed.size(), base, bits, written));
+        assert(base == domains[d][0]);
+        assert(written == ColumnCodec::packed_size(values.size(), bits));
+        
+        std::vector<int32_t> unpacked(values.size());
+        assert(ColumnCodec::unpack_bits(&packed[0], written, base, bits,
+                                        reinterpret_cast<char*>(&unpacked[0]), unpacked.size()));
+        assert(unpacked == values);
+    }
+    
+    // Categorías 1..10: 4 bits por fila
+    std::vector<int32_t> categories(100);
+    for (size_t i = 0; i < categories.size(); ++i) categories[i] = static_cast<int32_t>(i % 10) + 1;
+    std::vector<unsigned char> packed(64);
+    int32_t base;
+    uint32_t bits;
+    size_t written;
+    assert(ColumnCodec::pack_bits(reinterpret_cast<const char*>(&categories[0]), categories.size(),
+                                  &packed[0], packed.size(), base, bits, written));
+    assert(base == 1 && bits == 4 && written == 50);
+    
+    std::cout << "✓ Bit packing test passed" << std::endl;
+}
+
+void test_xor_encoding() {
+    std::cout << "Test: XOR double encoding..." << std::endl;
+    
+    std::vector<double> values;
+    for (int i = 0; i < 500; ++i) values.push_back(42.5);
+    for (int i = 0; i < 500; ++i) values.push_back((i % 100) * 0.25);
+    for (int i = 0; i < 500; ++i) values.push_back(rand() / 3.0);
+    values.push_back(-0.0);
+    values.push_back(1e308);
+    values.push_back(-1e-308);
+    
+    std::vector<unsigned char> encoded(values.size() * 10);
+    size_t written;
+    assert(ColumnCodec::encode_xor(reinterpret_cast<const char*>(&values[0]), values.size(),
+                                   &encoded[0], encoded.size(), written));
+    
+    std::vector<double> decoded(values.size());
+    assert(ColumnCodec::decode_xor(&encoded[0], written, reinterpret_cast<char*>(&decoded[0]), decoded.size()));
+    assert(memcmp(&decoded[0], &values[0], values.size() * sizeof(double)) == 0);
+    assert(!ColumnCodec::decode_xor(&encoded[0], written - 1, reinterpret_cast<char*>(&decoded[0]), decoded.size()));
+    
+    // Un valor repetido ocupa un bit
+    std::vector<double> constant(8001, 3.25);
+    assert(ColumnCodec::encode_xor(reinterpret_cast<const char*>(&constant[0]), constant.size(),
+                                   &encoded[0], encoded.size(), written));
+    assert(written == 8 + 1000);
+    
+    std::cout << "✓ XOR double encoding test passed" << std::endl;
+}
+
+void test_encoded_batch_serialization() {
+    std::cout << "Test: Encoded batch serialization..." << std::endl;
+    
+    // Lote como los de main.cpp
+    const size_t record_count = 1000;
+    RecordBatch rows;
+    rows.records = new DatabaseRecord[record_count];
+    rows.capacity = record_count;
+    rows.count = record_count;
+    rows.batch_id = 21;
+    for (size_t i = 0; i < record_count; ++i) {
+        rows.records[i].id = static_cast<int>(700 + i);
+        sprintf(rows.records[i].name, "Record_%05d", rows.records[i].id);
+        rows.records[i].value = (rand() % 10000) / 100.0;
+        rows.records[i].category = (rand() % 10) + 1;
+    }
+    
+    std::vector<char> plain(Serializer::calculate_compact_batch_size(&rows));
+    size_t plain_size = Serializer::serialize_batch_compact(&rows, &plain[0], plain.size());
+    std::vector<char> encoded(plain_size);
+    size_t encoded_size = Serializer::encode_compact_batch(&plain[0], plain_size, &encoded[0], encoded.size());
+    assert(encoded_size > 0 && encoded_size < plain_size);
+    assert(Serializer::is_encoded_batch(&encoded[0], encoded_size));
+    assert(Serializer::get_decoded_batch_size(&encoded[0], encoded_size) == plain_size);
+    assert(!SerializedBatchView(&encoded[0], encoded_size).is_valid());
+    
+    // Decodificar reproduce el lote byte a byte
+    std::vector<char> decoded(plain_size);
+    assert(Serializer::decode_compact_batch(&encoded[0], encoded_size, &decoded[0], decoded.size()) == plain_size);
+    assert(memcmp(&decoded[0], &plain[0], plain_size) == 0);
+    
+    // Codificado y comprimido: expand_compact_batch deshace ambas etapas
+    std::vector<char> compressed(encoded_size);
+    size_t compressed_size = Serializer::compress_compact_batch(&encoded[0], encoded_size,
+                                                                &compressed[0], compressed.size());
+    assert(compressed_size > 0);
+    std::vector<char> storage;
+    size_t expanded_size = 0;
+    const char* expanded = Serializer::expand_compact_batch(&compressed[0], compressed_size, storage, expanded_size);
+    assert(expanded && expanded_size == plain_size && memcmp(expanded, &plain[0], plain_size) == 0);
+    assert(Serializer::expand_compact_batch(&plain[0], plain_size, storage, expanded_size) == &plain[0]);
+    
+    RecordBatch copy;
+    copy.records = new DatabaseRecord[record_count];
+    copy.capacity = record_count;
+    assert(Serializer::deserialize_batch_compact(&compressed[0], compressed_size, &copy));
+    assert(copy.count == record_count && copy.batch_id == 21);
+    for (size_t i = 0; i < record_count; ++i) {
+        assert(copy.records[i].id == rows.records[i].id);
+        assert(copy.records[i].value == rows.records[i].value);
+        assert(copy.records[i].category == rows.records[i].category);
+        assert(strcmp(copy.records[i].name, rows.records[i].name) == 0);
+    }
+    
+    // Con diccionario de nombres las demás secciones viajan intactas
+    ColumnarBatch columns(record_count);
+    assert(columns.from_record_batch(rows, true));
+    std::vector<char> dictionary(Serializer::calculate_columnar_batch_size(columns));
+    size_t dictionary_size = Serializer::serialize_columnar_batch(columns, &dictionary[0], dictionary.size());
+    encoded_size = Serializer::encode_compact_batch(&dictionary[0], dictionary_size, &encoded[0], encoded.size(), false);
+    assert(encoded_size > 0);
+    ColumnarBatch restored(record_count);
+    assert(Serializer::deserialize_columnar_batch(&encoded[0], encoded_size, restored));
+    assert(restored.has_name_dictionary() && restored.get_count() == record_count);
+    
+    // Un byte alterado se detecta por CRC
+    encoded[encoded_size - 3] ^= 4;
+    assert(!Serializer::deserialize_batch_compact(&encoded[0], encoded_size, &copy));
+    
+    delete[] copy.records;
+    delete[] rows.records;
+    
+    std::cout << "✓ Encoded batch serialization test passed" << std::endl;
+}
+
+void benchmark_column_encoding() {
+    std::cout << "Benchmark: columnas codificadas en el wire..." << std::endl;
+    
+    const size_t record_count = 100000;
+    RecordBatch rows;
+    rows.records = new DatabaseRecord[record_count];
+    rows.capacity = record_count;
+    rows.count = record_count;
+    for (size_t i = 0; i < record_count; ++i) {
+        rows.records[i].id = static_cast<int>((i / 100) * 100 + i % 100);
+        sprintf(rows.records[i].name, "Record_%05d", rows.records[i].id % 100000);
+        rows.records[i].value = (rand() % 10000) / 100.0;
+        rows.records[i].category = (rand() % 10) + 1;
+    }
+    
+    std::vector<char> fixed(Serializer::calculate_batch_size(&rows));
+    size_t fixed_size = Serializer::serialize_batch(&rows, &fixed[0], fixed.size());
+    std::vector<char> plain(Serializer::calculate_compact_batch_size(&rows));
+    size_t plain_size = Serializer::serialize_batch_compact(&rows, &plain[0], plain.size());
+    std::vector<char> encoded(plain_size);
+    size_t encoded_size = Serializer::encode_compact_batch(&plain[0], plain_size, &encoded[0], encoded.size());
+    std::vector<char> compressed(encoded_size);
+    size_t compressed_size = Serializer::compress_compact_batch(&encoded[0], encoded_size,
+                                                                &compressed[0], compressed.size());
+    
+    std::cout << "  Bytes por fila: registros fijos " << static_cast<double>(fixed_size) / record_count
+              << ", compacto " << static_cast<double>(plain_size) / record_count
+              << ", codificado " << static_cast<double>(encoded_size) / record_count
+              << ", codificado + comprimido " << static_cast<double>(compressed_size) / record_count << std::endl;
+    
+    // Decodificación de la columna de ids: SSE2 vs escalar
+    std::vector<int32_t> ids(record_count);
+    for (size_t i = 0; i < record_count; ++i) ids[i] = rows.records[i].id;
+    std::vector<unsigned char> deltas(record_count * 5);
+    size_t delta_bytes = 0;
+    ColumnCodec::encode_deltas(reinterpret_cast<const char*>(&ids[0]), record_count, &deltas[0], deltas.size(), delta_bytes);
+    std::vector<int32_t> out(record_count);
+    const int iterations = 200;
+    double start = now_us();
+    for (int it = 0; it < iterations; ++it) {
+        ColumnCodec::decode_deltas(&deltas[0], delta_bytes, reinterpret_cast<char*>(&out[0]), record_count);
+    }
+    double vector_us = (now_us() - start) / iterations;
+    
+    start = now_us();
+    for (int it = 0; it < iterations; ++it) {
+        ColumnCodec::decode_deltas_portable(&deltas[0], delta_bytes, reinterpret_cast<char*>(&out[0]), record_count);
+    }
+    double portable_us = (now_us() - start) / iterations;
+    assert(out == ids);
+    
+    start = now_us();
+    for (int it = 0; it < iterations / 10; ++it) {
+        Serializer::decode_compact_batch(&encoded[0], encoded_size, &plain[0], plain.size());
+    }
+    double batch_us = (now_us() - start) / (iterations / 10);
+    
+    std::cout << "  Ids (" << record_count << "): " << vector_us << " us SSE2 vs " << portable_us
+              << " us escalar; lote completo decodificado en " << batch_us << " us" << std::endl;
+    
+    delete[] rows.records;
+}
+
+int benchmark_column_codec_main() {
+    benchmark_column_encoding();
+    return 0;
+}
+
+int test_column_codec_main() {
+    std::cout << "=== Column Codec Tests ===" << std::endl;
+    
+    test_delta_encoding();
+    test_bit_packing();
+    test_xor_encoding();
+    test_encoded_batch_serialization();
+    
+    std::cout << "All column codec tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// tests/test_columnar_batch.cpp
+#include "test_helpers.h"
+#include "../include/columnar_batch.h"
+#include "../include/memory_pool.h"
+#include "../include/serialization.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+#include <cctype>
+#include <vector>
+
+using namespace distributed;
+
+static void fill_record(DatabaseRecord& record, size_t i) {
+    record.id = static_cast<int>(i);
+    record.value = (i % 1000) * 0.5;
+    record.category = static_cast<int>(i % 7);
+    snprintf(record.name, sizeof(record.name), "Record_%lu", static_cast<unsigned long>(i));
+}
+
+void test_columnar_round_trip() {
+    std::cout << "Test: Columnar round trip..." << std::endl;
+    
+    DistributedMemoryPool pool(1024, 10);
+    RecordBatch* rows = pool.create_batch(500);
+    for (size_t i = 0; i < 500; ++i) {
+        fill_record(rows->records[i], i);
+    }
+    rows->count = 500;
+    
+    ColumnarBatch columns(500, &pool);
+    assert(columns.is_valid());
+    assert(columns.from_record_batch(*rows));
+    assert(columns.get_count() == 500);
+    assert(columns.get_batch_id() == rows->batch_id);
+    
+    // Columnas contiguas y alineadas
+    assert(reinterpret_cast<uintptr_t>(columns.value_column()) % 64 == 0);
+    assert(columns.value_column()[10] == rows->records[10].value);
+    assert(columns.id_column()[499] == 499);
+    assert(columns.category_column()[15] == 1);
+    assert(columns.name_length(42) == strlen("Record_42"));
+    assert(memcmp(columns.name_at(42), "Record_42", columns.name_length(42)) == 0);
+    assert(columns.get_name_bytes() < 500 * sizeof(rows->records[0].name) / 8);
+    
+    RecordBatch* back = pool.create_batch(500);
+    assert(columns.to_record_batch(*back));
+    assert(back->count == 500);
+    for (size_t i = 0; i < 500; ++i) {
+        assert(back->records[i].id == rows->records[i].id);
+        assert(back->records[i].value == rows->records[i].value);
+        assert(back->records[i].category == rows->records[i].category);
+        assert(strcmp(back->records[i].name, rows->records[i].name) == 0);
+    }
+    
+    // Capacidad insuficiente en cualquier dirección
+    ColumnarBatch small(10);
+    assert(!small.from_record_batch(*rows));
+    RecordBatch* small_rows = pool.create_batch(10);
+    assert(!columns.to_record_batch(*small_rows));
+    
+    // Append de nombres largos: el arena crece y el truncado ocurre al volver a filas
+    DatabaseRecord record;
+    fill_record(record, 7);
+    assert(small.append(record));
+    char long_name[2000];
+    memset(long_name, 'x', sizeof(long_name));
+    assert(small.append(8, 1.0, 2, long_name, sizeof(long_name)));
+    assert(small.name_length(1) == sizeof(long_name));
+    small.get_record(1, record);
+    assert(strlen(record.name) == ColumnarBatch::MAX_NAME_LENGTH);
+    small.get_record(0, record);
+    assert(strcmp(record.name, "Record_7") == 0);
+    
+    pool.free_batch(small_rows);
+    pool.free_batch(back);
+    pool.free_batch(rows);
+    
+    std::cout << "✓ Columnar round trip test passed" << std::endl;
+}
+
+void test_name_dictionary() {
+    std::cout << "Test: Name dictionary..." << std::endl;
+    
+    DistributedMemoryPool pool(1024, 10);
+    RecordBatch* rows = pool.create_batch(300);
+    for (size_t i = 0; i < 300; ++i) {
+        fill_record(rows->records[i], i);
+        snprintf(rows->records[i].name, sizeof(rows->records[i].name), "Name_%lu",
+                 static_cast<unsigned long>(i % 3));
+    }
+    rows->count = 300;
+    
+    // Tres nombres distintos: tres entradas y un código por fila
+    ColumnarBatch columns(300, &pool);
+    assert(columns.from_record_batch(*rows, true));
+    assert(columns.has_name_dictionary());
+    assert(columns.get_name_entries() == 3);
+    assert(columns.get_name_bytes() == 3 * strlen("Name_0"));
+    assert(columns.name_code_column()[4] == 1);
+    assert(columns.name_length(5) == 6 && memcmp(columns.name_at(5), "Name_2", 6) == 0);
+    
+    // Renombrar una fila interna el nombre nuevo sin tocar las demás
+    assert(columns.set_name(7, "Other", 5));
+    assert(columns.get_name_entries() == 4);
+    assert(columns.set_name(8, "Name_0", 6));
+    assert(columns.get_name_entries() == 4);
+    assert(columns.name_code_column()[8] == 0);
+    DatabaseRecord record;
+    columns.get_record(7, record);
+    assert(strcmp(record.name, "Other") == 0);
+    columns.get_record(10, record);
+    assert(strcmp(record.name, "Name_1") == 0);
+    
+    // Sin diccionario, set_name lo activa
+    ColumnarBatch plain(300, &pool);
+    assert(plain.from_record_batch(*rows));
+    assert(!plain.has_name_dictionary() && plain.get_name_entries() == 300);
+    assert(plain.set_name(0, "First", 5));
+    assert(plain.has_name_dictionary() && plain.get_name_entries() == 4);
+    plain.get_record(0, record);
+    assert(strcmp(record.name, "First") == 0);
+    plain.get_record(299, record);
+    assert(strcmp(record.name, "Name_2") == 0);
+    
+    // El wire con diccionario llega igual a filas y a columnas
+    std::vector<char> wire(Serializer::calculate_columnar_batch_size(columns));
+    assert(Serializer::serialize_columnar_batch(columns, &wire[0], wire.size()) == wire.size());
+    RecordBatch* back = pool.create_batch(300);
+    assert(Serializer::deserialize_batch_compact(&wire[0], wire.size(), back));
+    assert(strcmp(back->records[7].name, "Other") == 0);
+    assert(strcmp(back->records[8].name, "Name_0") == 0);
+    assert(strcmp(back->records[299].name, "Name_2") == 0);
+    
+    ColumnarBatch received(300);
+    assert(Serializer::deserialize_columnar_batch(&wire[0], wire.size(), received));
+    assert(received.has_name_dictionary() && received.get_name_entries() == 4);
+    
+    // La vista del plugin ve el diccionario y puede renombrar filas
+    PluginColumnarBatch view;
+    received.get_plugin_view(view);
+    assert(view.name_codes != NULL && view.name_entries == 4);
+    assert(view.set_name(&view, 1, "Name_2", 6) == 0);
+    assert(view.name_codes[1] == view.name_codes[2]);
+    assert(view.set_name(&view, 2, "Fresh", 5) == 0);
+    assert(view.name_entries == 5);
+    received.get_record(2, record);
+    assert(strcmp(record.name, "Fresh") == 0);
+    
+    // Códigos fuera del diccionario se rechazan
+    size_t codes_offset = wire.size() - columns.get_name_bytes() -
+                          (columns.get_name_entries() + 1) * sizeof(uint32_t) - 300 * sizeof(uint32_t);
+    uint32_t bad_code = 99;
+    memcpy(&wire[codes_offset], &bad_code, sizeof(bad_code));
+    assert(!Serializer::deserialize_batch_compact(&wire[0], wire.size(), back));
+    
+    pool.free_batch(back);
+    pool.free_batch(rows);
+    
+    std::cout << "✓ Name dictionary test passed" << std::endl;
+}
+
+void benchmark_aggregation_scan() {
+    std::cout << "Benchmark: escaneo de agregación AoS vs columnar (10M registros)..." << std::endl;
+    
+    const size_t record_count = 10000000;
+    RecordBatch rows;
+    rows.records = new DatabaseRecord[record_count];
+    rows.capacity = record_count;
+    for (size_t i = 0; i < record_count; ++i) {
+        fill_record(rows.records[i], i);
+    }
+    rows.count = record_count;
+    
+    // Mismo cálculo que aggregation_plugin: suma, suma de cuadrados, min y max
+    double start = now_us();
+    double sum = 0, sum_squared = 0, min_value = 1e9, max_value = -1e9;
+    for (size_t i = 0; i < rows.count; ++i) {
+        double value = rows.records[i].value;
+        sum += value;
+        sum_squared += value * value;
+        if (value < min_value) min_value = value;
+        if (value > max_value) max_value = value;
+    }
+    double aos_ms = (now_us() - start) / 1e3;
+    
+    start = now_us();
+    ColumnarBatch* columns = new ColumnarBatch(record_count);
+    columns->from_record_batch(rows);
+    double convert_ms = (now_us() - start) / 1e3;
+    delete[] rows.records;
+    
+    start = now_us();
+    const double* values = columns->value_column();
+    double col_sum = 0, col_sum_squared = 0, col_min = 1e9, col_max = -1e9;
+    for (size_t i = 0; i < columns->get_count(); ++i) {
+        double value = values[i];
+        col_sum += value;
+        col_sum_squared += value * value;
+        if (value < col_min) col_min = value;
+        if (value > col_max) col_max = value;
+    }
+    double columnar_ms = (now_us() - start) / 1e3;
+    
+    assert(col_sum == sum && col_sum_squared == sum_squared);
+    assert(col_min == min_value && col_max == max_value);
+    
+    std::cout << "  AoS: " << aos_ms << " ms (" << record_count * sizeof(DatabaseRecord) / (1024 * 1024) 
+              << " MB recorridos)" << std::endl;
+    std::cout << "  Columnar: " << columnar_ms << " ms (" << record_count * sizeof(double) / (1024 * 1024)
+              << " MB recorridos), conversión " << convert_ms << " ms" << std::endl;
+    
+    delete columns;
+}
+
+// Mismo criterio que is_valid_name de validation_plugin
+static bool check_name(const char* name, size_t length) {
+    if (length == 0 || !isalpha(static_cast<unsigned char>(name[0]))) return false;
+    for (size_t i = 1; i < length; ++i) {
+        if (!isalnum(static_cast<unsigned char>(name[i])) && name[i] != '_') return false;
+    }
+    return true;
+}
+
+void benchmark_name_dictionary() {
+    std::cout << "Benchmark: nombres con diccionario sobre datos sesgados (1M registros)..." << std::endl;
+    
+    // 10k nombres distintos con distribución fuertemente sesgada (u^4)
+    const size_t record_count = 1000000;
+    const size_t distinct_names = 10000;
+    RecordBatch rows;
+    rows.records = new DatabaseRecord[record_count];
+    rows.capacity = record_count;
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < record_count; ++i) {
+        fill_record(rows.records[i], i);
+        seed = seed * 1103515245u + 12345u;
+        double u = (seed >> 8) / 16777216.0;
+        size_t rank = static_cast<size_t>(u * u * u * u * distinct_names);
+        snprintf(rows.records[i].name, sizeof(rows.records[i].name), "Customer_Account_%lu",
+                 static_cast<unsigned long>(rank));
+    }
+    rows.count = record_count;
+    
+    ColumnarBatch* columns = new ColumnarBatch(record_count);
+    std::vector<char> wire;
+    double plain_ms, dictionary_ms;
+    size_t plain_bytes, dictionary_bytes;
+    
+    double start = now_us();
+    columns->from_record_batch(rows);
+    wire.resize(Serializer::calculate_columnar_batch_size(*columns));
+    plain_bytes = Serializer::serialize_columnar_batch(*columns, &wire[0], wire.size());
+    plain_ms = (now_us() - start) / 1e3;
+    
+    // Trabajo por nombre como en validation_plugin: una vez por fila
+    start = now_us();
+    size_t valid_rows = 0;
+    for (size_t i = 0; i < columns->get_count(); ++i) {
+        valid_rows += check_name(columns->name_at(i), columns->name_length(i)) ? 1 : 0;
+    }
+    double per_row_ms = (now_us() - start) / 1e3;
+    
+    start = now_us();
+    columns->from_record_batch(rows, true);
+    wire.resize(Serializer::calculate_columnar_batch_size(*columns));
+    dictionary_bytes = Serializer::serialize_columnar_batch(*columns, &wire[0], wire.size());
+    dictionary_ms = (now_us() - start) / 1e3;
+    
+    // Con diccionario: una vez por entrada y un lookup por fila
+    start = now_us();
+    std::vector<unsigned char> entry_valid(columns->get_name_entries());
+    const uint32_t* offsets = columns->name_offset_column();
+    for (size_t e = 0; e < entry_valid.size(); ++e) {
+        entry_valid[e] = check_name(columns->name_bytes_data() + offsets[e], offsets[e + 1] - offsets[e]);
+    }
+    size_t dictionary_valid_rows = 0;
+    const uint32_t* codes = columns->name_code_column();
+    for (size_t i = 0; i < columns->get_count(); ++i) {
+        dictionary_valid_rows += entry_valid[codes[i]];
+    }
+    double per_entry_ms = (now_us() - start) / 1e3;
+    
+    assert(valid_rows == record_count && dictionary_valid_rows == valid_rows);
+    assert(columns->get_name_entries() <= distinct_names);
+    assert(dictionary_bytes < plain_bytes);
+    
+    size_t fixed_bytes = record_count * sizeof(DatabaseRecord);
+    std::cout << "  Entradas de diccionario: " << columns->get_name_entries() << std::endl;
+    std::cout << "  Registros fijos: " << fixed_bytes / 1024 << " KB" << std::endl;
+    std::cout << "  Compacto sin diccionario: " << plain_bytes / 1024 << " KB ("
+              << static_cast<double>(fixed_bytes) / plain_bytes << "x), "
+              << plain_ms << " ms en convertir y serializar" << std::endl;
+    std::cout << "  Compacto con diccionario: " << dictionary_bytes / 1024 << " KB ("
+              << static_cast<double>(fixed_bytes) / dictionary_bytes << "x), "
+              << dictionary_ms << " ms en convertir y serializar" << std::endl;
+    std::cout << "  Validación de nombres: " << per_row_ms << " ms por fila vs "
+              << per_entry_ms << " ms por entrada" << std::endl;
+    
+    delete columns;
+    delete[] rows.records;
+}
+
+int benchmark_columnar_batch_main() {
+    benchmark_aggregation_scan();
+    benchmark_name_dictionary();
+    return 0;
+}
+
+int test_columnar_batch_main() {
+    std::cout << "=== Columnar Batch Tests ===" << std::endl;
+    
+    test_columnar_round_trip();
+    test_name_dictionary();
+    
+    std::cout << "All columnar batch tests passed!" << std::endl;
+    return 0;
+}
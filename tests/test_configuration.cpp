@@ -51,6 +51,7 @@ void test_config_parsing() {
     assert(stages[0].failover_config.policy == RETRY_WITH_BACKOFF);
     assert(stages[0].failover_config.max_retries == 3);
     assert(stages[0].failover_config.timeout_ms == 5000);
+    assert(stages[0].pipeline_depth == 1);
     
     // Verificar segundo stage
     assert(stages[1].name == "disabled_plugin");
@@ -98,11 +99,123 @@ void test_config_save_load() {
     std::cout << "✓ Configuration save/load test passed" << std::endl;
 }
 
+void test_config_pipeline_depth() {
+    std::cout << "Test: Configuration pipeline depth..." << std::endl;
+    
+    const char* test_config = "test_pipeline_depth.txt";
+    std::ofstream file(test_config);
+    file << "deep_plugin|./deep.so|param=value|true|RETRY_WITH_BACKOFF|3|5000|8\n";
+    file << "shallow_plugin|./shallow.so|param=value|true|FAIL_FAST|1|1000\n";
+    file.close();
+    
+    ConfigurationManager config(test_config);
+    assert(config.load_configuration(test_config));
+    const std::vector<PipelineStageConfig>& stages = config.get_pipeline_stages();
+    assert(stages.size() == 2);
+    assert(stages[0].pipeline_depth == 8);
+    assert(stages[1].pipeline_depth == 1);
+    
+    // La profundidad sobrevive a save/load
+    const char* output_config = "test_pipeline_depth_out.txt";
+    assert(config.save_configuration(output_config));
+    ConfigurationManager reloaded(output_config);
+    assert(reloaded.load_configuration(output_config));
+    assert(reloaded.get_pipeline_stages()[0].pipeline_depth == 8);
+    
+    // Fuera de rango: sin slots o más lotes que los que admite el proceso
+    std::vector<PipelineStageConfig> invalid(1, stages[0]);
+    invalid[0].pipeline_depth = 0;
+    assert(!ResilientPluginManager::validate_pipeline_config(invalid));
+    invalid[0].pipeline_depth = static_cast<int>(IsolatedPluginProcess::MAX_PIPELINE_DEPTH) + 1;
+    assert(!ResilientPluginManager::validate_pipeline_config(invalid));
+    invalid[0].pipeline_depth = static_cast<int>(IsolatedPluginProcess::MAX_PIPELINE_DEPTH);
+    assert(ResilientPluginManager::validate_pipeline_config(invalid));
+    
+    file.open(test_config);
+    file << "bad_plugin|./bad.so|param=value|true|FAIL_FAST|1|1000|0\n";
+    file.close();
+    assert(!config.load_configuration(test_config));
+    
+    unlink(test_config);
+    unlink(output_config);
+    
+    std::cout << "✓ Configuration pipeline depth test passed" << std::endl;
+}
+
+void test_config_isolation() {
+    std::cout << "Test: Configuration isolation..." << std::endl;
+    
+    const char* test_config = "test_isolation.txt";
+    std::ofstream file(test_config);
+    file << "trusted_plugin|./trusted.so|param=value|true|RETRY_WITH_BACKOFF|3|5000|1|none\n";
+    file << "isolated_plugin|./isolated.so|param=value|true|FAIL_FAST|1|1000|4|process\n";
+    file << "default_plugin|./default.so|param=value|true|FAIL_FAST|1|1000\n";
+    file.close();
+    
+    ConfigurationManager config(test_config);
+    assert(config.load_configuration(test_config));
+    const std::vector<PipelineStageConfig>& stages = config.get_pipeline_stages();
+    assert(stages.size() == 3);
+    assert(stages[0].isolation == ISOLATION_NONE);
+    assert(stages[1].isolation == ISOLATION_PROCESS);
+    assert(stages[2].isolation == ISOLATION_PROCESS);
+    
+    const char* output_config = "test_isolation_out.txt";
+    assert(config.save_configuration(output_config));
+    ConfigurationManager reloaded(output_config);
+    assert(reloaded.load_configuration(output_config));
+    assert(reloaded.get_pipeline_stages()[0].isolation == ISOLATION_NONE);
+    assert(reloaded.get_pipeline_stages()[1].isolation == ISOLATION_PROCESS);
+    
+    unlink(test_config);
+    unlink(output_config);
+    
+    std::cout << "✓ Configuration isolation test passed" << std::endl;
+}
+
+void test_config_replicas() {
+    std::cout << "Test: Configuration replicas..." << std::endl;
+    
+    const char* test_config = "test_replicas.txt";
+    std::ofstream file(test_config);
+    file << "heavy_plugin|./heavy.so|param=value|true|RETRY_WITH_BACKOFF|3|5000|4||4\n";
+    file << "light_plugin|./light.so|param=value|true|FAIL_FAST|1|1000|1|process\n";
+    file.close();
+    
+    ConfigurationManager config(test_config);
+    assert(config.load_configuration(test_config));
+    const std::vector<PipelineStageConfig>& stages = config.get_pipeline_stages();
+    assert(stages.size() == 2);
+    assert(stages[0].replicas == 4);
+    assert(stages[0].isolation == ISOLATION_PROCESS);
+    assert(stages[1].replicas == 1);
+    
+    const char* output_config = "test_replicas_out.txt";
+    assert(config.save_configuration(output_config));
+    ConfigurationManager reloaded(output_config);
+    assert(reloaded.load_configuration(output_config));
+    assert(reloaded.get_pipeline_stages()[0].replicas == 4);
+    
+    std::vector<PipelineStageConfig> invalid(1, stages[0]);
+    invalid[0].replicas = 0;
+    assert(!ResilientPluginManager::validate_pipeline_config(invalid));
+    invalid[0].replicas = static_cast<int>(ReplicatedStage::MAX_REPLICAS) + 1;
+    assert(!ResilientPluginManager::validate_pipeline_config(invalid));
+    
+    unlink(test_config);
+    unlink(output_config);
+    
+    std::cout << "✓ Configuration replicas test passed" << std::endl;
+}
+
 int test_configuration_main() {
     std::cout << "=== Configuration Tests ===" << std::endl;
     
     test_config_parsing();
     test_config_save_load();
+    test_config_pipeline_depth();
+    test_config_isolation();
+    test_config_replicas();
     
     std::cout << "All configuration tests passed!" << std::endl;
     return 0;
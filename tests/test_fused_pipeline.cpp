@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_fused_pipeline.cpp
+#include "test_helpers.h"
+#include "../include/plugin_manager.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <vector>
+
+using namespace distributed;
+
+void test_fused_pipeline_matches_per_stage() {
+    std::cout << "Test: Fused pipeline matches per-stage processes..." << std::endl;
+    
+    ResilientPluginManager per_stage(NULL);
+    ResilientPluginManager fused(NULL);
+    fused.set_execution_mode(FUSED_PROCESS);
+    assert(per_stage.load_pipeline_config(three_stage_pipeline()));
+    assert(fused.load_pipeline_config(three_stage_pipeline()));
+    
+    // Un solo proceso con las tres etapas en orden
+    size_t total = 0, healthy = 0;
+    double success_rate = 0.0;
+    fused.get_pipeline_metrics(total, healthy, success_rate);
+    assert(total == 1);
+    per_stage.get_pipeline_metrics(total, healthy, success_rate);
+    assert(total == 3);
+    
+    for (int seed = 0; seed < 5; ++seed) {
+        std::vector<DatabaseRecord> expected_records(1000), fused_records(1000);
+        RecordBatch expected, actual;
+        fill_batch(expected, expected_records, seed);
+        fill_batch(actual, fused_records, seed);
+        
+        assert(per_stage.process_batch_through_pipeline(&expected));
+        assert(fused.process_batch_through_pipeline(&actual));
+        
+        assert(actual.count == expected.count);
+        for (size_t i = 0; i < expected.count; ++i) {
+            assert(fused_records[i].id == expected_records[i].id);
+            assert(fused_records[i].value == expected_records[i].value);
+            assert(fused_records[i].category == expected_records[i].category);
+            assert(strcmp(fused_records[i].name, expected_records[i].name) == 0);
+        }
+    }
+    
+    // Los lotes encadenados también recorren las tres etapas
+    std::vector<std::vector<DatabaseRecord> > records(8, std::vector<DatabaseRecord>(500));
+    std::vector<RecordBatch> batches(8);
+    std::vector<RecordBatch*> pointers;
+    for (size_t i = 0; i < batches.size(); ++i) {
+        fill_batch(batches[i], records[i], static_cast<int>(i));
+        pointers.push_back(&batches[i]);
+    }
+    assert(fused.process_batches_through_pipeline(pointers));
+    std::vector<DatabaseRecord> check_records(500);
+    RecordBatch check;
+    fill_batch(check, check_records, 3);
+    assert(per_stage.process_batch_through_pipeline(&check));
+    assert(batches[3].count == check.count);
+    assert(strcmp(records[3][1].name, check_records[1].name) == 0);
+    
+    std::cout << "✓ Fused pipeline matches per-stage processes passed" << std::endl;
+}
+
+void test_fused_pipeline_stops_at_failed_stage() {
+    std::cout << "Test: Fused pipeline stops at the failing stage..." << std::endl;
+    
+    // Con enrichment el hijo usa registros; sin él, las columnas del wire en sitio
+    const char* middle[] = { "enrichment", NULL };
+    for (size_t m = 0; m < sizeof(middle) / sizeof(middle[0]); ++m) {
+        std::vector<HostedStage> hosted;
+        const char* names[] = { "validation", middle[m], "aggregation" };
+        const char* params[] = { "strict_mode=true", "factor=1.1", "compute_stats=true" };
+        for (size_t i = 0; i < 3; ++i) {
+            if (!names[i]) continue;
+            HostedStage stage;
+            stage.name = names[i];
+            stage.library_path = plugin_path(names[i]);
+            stage.config_params = params[i];
+            hosted.push_back(stage);
+        }
+        IsolatedPluginProcess process("fused", hosted);
+        assert(process.start());
+        size_t aggregation = hosted.size() - 1;
+        
+        // validation rechaza el lote: ni enrichment ni aggregation lo ven
+        std::vector<DatabaseRecord> records(100);
+        RecordBatch batch;
+        fill_batch(batch, records, 0);
+        std::vector<DatabaseRecord> original(records);
+        assert(process.process_batch(&batch) != 0);
+        assert(same_records(records, original, records.size()));
+        std::vector<char> state;
+        assert(process.export_stage_state(aggregation, state));
+        assert(state.empty());
+        
+        // Un lote válido sí recorre todas las etapas
+        fill_batch(batch, records, 0, false);
+        assert(process.process_batch(&batch) == 0);
+        assert(process.export_stage_state(aggregation, state));
+        assert(!state.empty());
+        process.terminate();
+    }
+    
+    std::cout << "✓ Fused pipeline stops at the failing stage passed" << std::endl;
+}
+
+static double run_pipeline_benchmark(ResilientPluginManager& manager, size_t batch_count,
+                                     size_t batch_size) {
+    std::vector<DatabaseRecord> records(batch_size);
+    RecordBatch batch;
+    double start = now_us();
+    for (size_t i = 0; i < batch_count; ++i) {
+        fill_batch(batch, records, static_cast<int>(i));
+        assert(manager.process_batch_through_pipeline(&batch));
+    }
+    return now_us() - start;
+}
+
+int benchmark_fused_pipeline_main() {
+    std::cout << "Benchmark: 3-stage pipeline, fused vs per-stage processes..." << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", benchmark omitido" << std::endl;
+        return 0;
+    }
+    
+    size_t sizes[] = { 10, 1000, 10000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        const size_t batch_count = sizes[s] >= 10000 ? 50 : 500;
+        
+        ResilientPluginManager per_stage(NULL);
+        ResilientPluginManager fused(NULL);
+        fused.set_execution_mode(FUSED_PROCESS);
+        assert(per_stage.load_pipeline_config(three_stage_pipeline()));
+        assert(fused.load_pipeline_config(three_stage_pipeline()));
+        
+        double per_stage_us = run_pipeline_benchmark(per_stage, batch_count, sizes[s]);
+        double fused_us = run_pipeline_benchmark(fused, batch_count, sizes[s]);
+        std::cout << "  " << sizes[s] << " registros/lote: por etapa "
+                  << per_stage_us / batch_count << " us/lote, fusionado "
+                  << fused_us / batch_count << " us/lote ("
+                  << per_stage_us / fused_us << "x)" << std::endl;
+    }
+    return 0;
+}
+
+int test_fused_pipeline_main() {
+    std::cout << "=== Fused Pipeline Tests ===" << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", tests omitidos" << std::endl;
+        return 0;
+    }
+    
+    test_fused_pipeline_matches_per_stage();
+    test_fused_pipeline_stops_at_failed_stage();
+    
+    std::cout << "All fused pipeline tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_helpers.h
+//
+// Fixtures compartidos por los tests que cargan los plugins de ejemplo.
+#ifndef DISTRIBUTED_TEST_HELPERS_H
+#define DISTRIBUTED_TEST_HELPERS_H
+
+#include "../include/plugin_manager.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+
+namespace distributed {
+
+// Los plugins se compilan aparte (make plugins); sin ellos esos tests se omiten
+static const char* const PLUGIN_DIR = "../plugins/";
+
+inline std::string plugin_path(const char* name) {
+    return std::string(PLUGIN_DIR) + "lib" + name + ".so";
+}
+
+inline bool plugins_available() {
+    const char* names[] = { "validation", "enrichment", "aggregation" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (access(plugin_path(names[i]).c_str(), R_OK) != 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Llenar un lote de prueba sobre records, determinista según seed
+ *
+ * Con with_bad_names uno de cada siete nombres no pasa la validación
+ * estricta.
+ */
+inline void fill_batch(RecordBatch& batch, std::vector<DatabaseRecord>& records, int seed,
+                       bool with_bad_names = true) {
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i].id = static_cast<int>(i) + 1;
+        sprintf(records[i].name, with_bad_names && (i + seed) % 7 == 0 ? "bad name %d" : "Name_%d",
+                static_cast<int>((i + seed) % 50));
+        records[i].value = static_cast<double>((i * 7 + seed) % 1000);
+        records[i].category = static_cast<int>(i % 10) + 1;
+    }
+    batch.records = &records[0];
+    batch.count = records.size();
+    batch.capacity = records.size();
+    batch.batch_id = seed;
+}
+
+inline bool same_records(const std::vector<DatabaseRecord>& a, const std::vector<DatabaseRecord>& b,
+                         size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (a[i].id != b[i].id || a[i].value != b[i].value || a[i].category != b[i].category ||
+            strcmp(a[i].name, b[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief validation → enrichment → aggregation con FAIL_FAST y sin reintentos
+ *
+ * Cada test ajusta después los campos que le interesan (aislamiento,
+ * réplicas, profundidad, modo estricto).
+ */
+inline std::vector<PipelineStageConfig> three_stage_pipeline() {
+    const char* names[] = { "validation", "enrichment", "aggregation" };
+    const char* params[] = { "strict_mode=false", "factor=1.1", "compute_stats=true" };
+    
+    std::vector<PipelineStageConfig> stages;
+    for (size_t i = 0; i < 3; ++i) {
+        PipelineStageConfig stage;
+        stage.name = names[i];
+        stage.library_path = plugin_path(names[i]);
+        stage.parameters = params[i];
+        stage.failover_config.policy = FAIL_FAST;
+        stage.failover_config.max_retries = 0;
+        stage.failover_config.timeout_ms = 10000;
+        stages.push_back(stage);
+    }
+    return stages;
+}
+
+// Reloj monótono en microsegundos para los benchmarks
+inline double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+} // namespace distributed
+
+#endif // DISTRIBUTED_TEST_HELPERS_H
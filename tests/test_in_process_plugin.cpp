@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_in_process_plugin.cpp
+#include "test_helpers.h"
+#include "../include/in_process_plugin.h"
+#include "../include/plugin_manager.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <dlfcn.h>
+
+using namespace distributed;
+
+// Pipeline de tres etapas con el aislamiento indicado para cada una
+static std::vector<PipelineStageConfig> pipeline_with_isolation(StageIsolation validation,
+                                                                StageIsolation enrichment,
+                                                                StageIsolation aggregation) {
+    std::vector<PipelineStageConfig> stages = three_stage_pipeline();
+    stages[0].isolation = validation;
+    stages[1].isolation = enrichment;
+    stages[2].isolation = aggregation;
+    return stages;
+}
+
+void test_in_process_load_failure() {
+    std::cout << "Test: In-process plugin load failure..." << std::endl;
+    
+    InProcessPlugin plugin("missing", "./no_such_plugin.so", "");
+    assert(!plugin.load());
+    assert(!plugin.is_loaded() && !plugin.is_healthy());
+    
+    std::vector<DatabaseRecord> records(4);
+    RecordBatch batch;
+    fill_batch(batch, records, 0);
+    assert(plugin.process_batch(&batch) == -1);
+    assert(plugin.get_metrics()->total_calls == 0);
+    
+    std::cout << "✓ In-process plugin load failure passed" << std::endl;
+}
+
+void test_in_process_matches_isolated() {
+    std::cout << "Test: In-process plugin matches isolated process..." << std::endl;
+    
+    InProcessPlugin plugin("enrichment", plugin_path("enrichment"), "factor=1.1");
+    assert(plugin.load() && plugin.is_healthy());
+    
+    std::vector<DatabaseRecord> expected_records(1000), records(1000);
+    RecordBatch expected, batch;
+    fill_batch(expected, expected_records, 1);
+    fill_batch(batch, records, 1);
+    assert(plugin.process_batch(&batch) == 0);
+    assert(plugin.get_metrics()->successful_calls == 1);
+    
+    // Recargar equivale a reiniciar el proceso: el plugin sigue operativo
+    assert(plugin.reload());
+    fill_batch(batch, records, 1);
+    assert(plugin.process_batch(&batch) == 0);
+    
+    {
+        IsolatedPluginProcess isolated("enrichment", plugin_path("enrichment"), "factor=1.1");
+        assert(isolated.start());
+        assert(isolated.process_batch(&expected) == 0);
+    }
+    assert(batch.count == expected.count);
+    assert(same_records(records, expected_records, batch.count));
+    
+    // El pipeline mezcla etapas en proceso y aisladas, también fusionado
+    ResilientPluginManager isolated_pipeline(NULL);
+    ResilientPluginManager mixed(NULL);
+    ResilientPluginManager mixed_fused(NULL);
+    mixed_fused.set_execution_mode(FUSED_PROCESS);
+    assert(isolated_pipeline.load_pipeline_config(
+        pipeline_with_isolation(ISOLATION_PROCESS, ISOLATION_PROCESS, ISOLATION_PROCESS)));
+    assert(mixed.load_pipeline_config(
+        pipeline_with_isolation(ISOLATION_NONE, ISOLATION_PROCESS, ISOLATION_NONE)));
+    assert(mixed_fused.load_pipeline_config(
+        pipeline_with_isolation(ISOLATION_PROCESS, ISOLATION_PROCESS, ISOLATION_NONE)));
+    
+    size_t total = 0, healthy = 0;
+    double success_rate = 0.0;
+    mixed_fused.get_pipeline_metrics(total, healthy, success_rate);
+    assert(total == 2 && healthy == 2);
+    
+    fill_batch(expected, expected_records, 2);
+    assert(isolated_pipeline.process_batch_through_pipeline(&expected));
+    
+    fill_batch(batch, records, 2);
+    assert(mixed.process_batch_through_pipeline(&batch));
+    assert(batch.count == expected.count && same_records(records, expected_records, batch.count));
+    
+    std::vector<RecordBatch*> batches(1, &batch);
+    fill_batch(batch, records, 2);
+    assert(mixed_fused.process_batches_through_pipeline(batches));
+    assert(batch.count == expected.count && same_records(records, expected_records, batch.count));
+    
+    assert(mixed.restart_plugin("validation"));
+    
+    std::cout << "✓ In-process plugin matches isolated process passed" << std::endl;
+}
+
+void test_plugin_without_scratch() {
+    std::cout << "Test: Plugin on a host without scratch..." << std::endl;
+    
+    // Hosts anteriores dejan scratch a NULL: el plugin no puede rechazarlos
+    void* handle = dlopen(plugin_path("enrichment").c_str(), RTLD_NOW | RTLD_LOCAL);
+    assert(handle);
+    typedef int (*InitPluginFunc)(PluginContext* context);
+    typedef int (*ProcessBatchFunc)(RecordBatch* batch, PluginContext* context);
+    typedef void (*CleanupPluginFunc)(PluginContext* context);
+    InitPluginFunc init_func = (InitPluginFunc) dlsym(handle, "init_plugin");
+    ProcessBatchFunc process_func = (ProcessBatchFunc) dlsym(handle, "process_batch");
+    CleanupPluginFunc cleanup_func = (CleanupPluginFunc) dlsym(handle, "cleanup_plugin");
+    
+    PluginContext context;
+    memset(&context, 0, sizeof(context));
+    context.config_params = "factor=2.0,suffix_format=_C%d";
+    assert(init_func(&context) == 0);
+    
+    std::vector<DatabaseRecord> records(100), expected(100);
+    RecordBatch batch, expected_batch;
+    fill_batch(batch, records, 3);
+    fill_batch(expected_batch, expected, 3);
+    assert(process_func(&batch, &context) == 0);
+    cleanup_func(&context);
+    
+    // Mismo resultado que con el scratch del adaptador en proceso
+    InProcessPlugin plugin("enrichment", plugin_path("enrichment"), "factor=2.0,suffix_format=_C%d");
+    assert(plugin.load());
+    assert(plugin.process_batch(&expected_batch) == 0);
+    assert(same_records(records, expected, records.size()));
+    assert(strstr(records[0].name, "_C") != NULL);
+    dlclose(handle);
+    
+    std::cout << "✓ Plugin on a host without scratch passed" << std::endl;
+}
+
+int benchmark_in_process_plugin_main() {
+    std::cout << "Benchmark: Per-batch overhead, in-process vs isolated..." << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", benchmark omitido" << std::endl;
+        return 0;
+    }
+    
+    const size_t iterations = 200000;
+    std::vector<DatabaseRecord> records(1);
+    RecordBatch batch;
+    
+    // Referencia: llamada directa a la función del plugin
+    void* handle = dlopen(plugin_path("enrichment").c_str(), RTLD_NOW | RTLD_LOCAL);
+    assert(handle);
+    typedef int (*InitPluginFunc)(PluginContext* context);
+    typedef int (*ProcessBatchFunc)(RecordBatch* batch, PluginContext* context);
+    typedef void (*CleanupPluginFunc)(PluginContext* context);
+    InitPluginFunc init_func = (InitPluginFunc) dlsym(handle, "init_plugin");
+    ProcessBatchFunc process_func = (ProcessBatchFunc) dlsym(handle, "process_batch");
+    CleanupPluginFunc cleanup_func = (CleanupPluginFunc) dlsym(handle, "cleanup_plugin");
+    ScratchArena arena;
+    PluginContext context;
+    memset(&context, 0, sizeof(context));
+    context.config_params = "factor=1.0";
+    context.scratch = arena.get_scratch();
+    assert(init_func(&context) == 0);
+    
+    fill_batch(batch, records, 0);
+    double start = now_us();
+    for (size_t i = 0; i < iterations; ++i) {
+        records[0].name[8] = '\0';
+        process_func(&batch, &context);
+        arena.reset();
+    }
+    double direct_ns = (now_us() - start) * 1e3 / iterations;
+    cleanup_func(&context);
+    dlclose(handle);
+    
+    InProcessPlugin plugin("enrichment", plugin_path("enrichment"), "factor=1.0");
+    assert(plugin.load());
+    fill_batch(batch, records, 0);
+    start = now_us();
+    for (size_t i = 0; i < iterations; ++i) {
+        records[0].name[8] = '\0';
+        assert(plugin.process_batch(&batch) == 0);
+    }
+    double adapter_ns = (now_us() - start) * 1e3 / iterations;
+    
+    std::vector<PipelineStageConfig> stages(1);
+    stages[0].name = "enrichment";
+    stages[0].library_path = plugin_path("enrichment");
+    stages[0].parameters = "factor=1.0";
+    stages[0].isolation = ISOLATION_NONE;
+    ResilientPluginManager in_process_manager(NULL);
+    assert(in_process_manager.load_pipeline_config(stages));
+    start = now_us();
+    for (size_t i = 0; i < iterations; ++i) {
+        records[0].name[8] = '\0';
+        assert(in_process_manager.process_batch_through_pipeline(&batch));
+    }
+    double manager_ns = (now_us() - start) * 1e3 / iterations;
+    
+    const size_t isolated_iterations = 5000;
+    stages[0].isolation = ISOLATION_PROCESS;
+    ResilientPluginManager isolated_manager(NULL);
+    assert(isolated_manager.load_pipeline_config(stages));
+    start = now_us();
+    for (size_t i = 0; i < isolated_iterations; ++i) {
+        records[0].name[8] = '\0';
+        assert(isolated_manager.process_batch_through_pipeline(&batch));
+    }
+    double isolated_ns = (now_us() - start) * 1e3 / isolated_iterations;
+    
+    std::cout << "  lote de 1 registro: llamada directa " << direct_ns << " ns, adaptador "
+              << adapter_ns << " ns (+" << adapter_ns - direct_ns << "), manager en proceso "
+              << manager_ns << " ns (+" << manager_ns - direct_ns << "), manager aislado "
+              << isolated_ns << " ns" << std::endl;
+    return 0;
+}
+
+int test_in_process_plugin_main() {
+    std::cout << "=== In-Process Plugin Tests ===" << std::endl;
+    
+    test_in_process_load_failure();
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", tests omitidos" << std::endl;
+        return 0;
+    }
+    
+    test_in_process_matches_isolated();
+    test_plugin_without_scratch();
+    
+    std::cout << "All in-process plugin tests passed!" << std::endl;
+    return 0;
+}
@@ -22,6 +22,18 @@
 #include <cassert>
 #include <iostream>
 #include <pthread.h>
+#include <sys/time.h>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include "../include/ipc.h"
 
 using namespace distributed;
 
@@ -65,6 +77,21 @@ void test_batch_creation() {
     
     pool.free_batch(batch);
     
+    // Lotes ajenos (heap, pila u otro pool) se ignoran sin tocar su memoria
+    size_t cached = pool.get_cached_batch_count();
+    RecordBatch* foreign = new RecordBatch();
+    RecordBatch local;
+    DistributedMemoryPool other(sizeof(DatabaseRecord) * 100, 1);
+    RecordBatch* other_batch = other.create_batch(10);
+    pool.free_batch(foreign);
+    pool.free_batch(&local);
+    pool.free_batch(other_batch);
+    assert(pool.get_cached_batch_count() == cached);
+    assert(other.get_cached_batch_count() == 0);
+    other.free_batch(other_batch);
+    assert(other.get_cached_batch_count() == 1);
+    delete foreign;
+    
     std::cout << "✓ Batch creation test passed" << std::endl;
 }
 
@@ -112,15 +139,657 @@ void test_thread_safety() {
         pthread_join(threads[i], NULL);
     }
     
+    // Las caches de los hilos terminados deben haber vuelto al pool
+    size_t total, free, used;
+    pool.get_statistics(total, free, used);
+    assert(used == 0 && free == total);
+    
     std::cout << "✓ Thread safety test passed" << std::endl;
 }
 
+void test_statistics_counters() {
+    std::cout << "Test: Statistics counters..." << std::endl;
+    
+    DistributedMemoryPool pool(256, 4);
+    size_t total, free, used;
+    
+    // Los bloques se pre-asignan por slabs: al menos los pedidos
+    pool.get_statistics(total, free, used);
+    size_t initial_total = total;
+    assert(total >= 4 && free == total && used == 0);
+    
+    void* ptrs[6];
+    for (int i = 0; i < 6; ++i) {
+        ptrs[i] = pool.allocate(200);
+        assert(ptrs[i] != NULL);
+    }
+    
+    pool.get_statistics(total, free, used);
+    assert(total == initial_total && used == 6 && free == total - 6);
+    
+    // Liberar en orden arbitrario, incluyendo doble free y punteros ajenos
+    pool.deallocate(ptrs[3]);
+    pool.deallocate(ptrs[0]);
+    pool.deallocate(ptrs[3]);
+    char foreign[512];
+    pool.deallocate(foreign + 128);
+    
+    pool.get_statistics(total, free, used);
+    assert(total == initial_total && used == 4);
+    
+    for (int i = 1; i < 6; ++i) {
+        if (i != 3) pool.deallocate(ptrs[i]);
+    }
+    
+    pool.get_statistics(total, free, used);
+    assert(total == initial_total && free == total && used == 0);
+    
+    std::cout << "✓ Statistics counters test passed" << std::endl;
+}
+
+void test_size_classes() {
+    std::cout << "Test: Size classes..." << std::endl;
+    
+    DistributedMemoryPool pool(1024, 2);
+    
+    // Tamaños mayores que block_size se sirven desde otras clases
+    void* small = pool.allocate(1);
+    void* medium = pool.allocate(3000);
+    void* big = pool.allocate(5 * 1024 * 1024);
+    assert(small && medium && big);
+    assert(DistributedMemoryPool::usable_size(small) == DistributedMemoryPool::MIN_CLASS_SIZE);
+    assert(DistributedMemoryPool::usable_size(medium) == 4096);
+    assert(DistributedMemoryPool::usable_size(big) == 8 * 1024 * 1024);
+    memset(big, 0x5A, 5 * 1024 * 1024);
+    
+    // Camino de objetos grandes
+    size_t large_size = DistributedMemoryPool::MAX_CLASS_SIZE + 1;
+    char* large = static_cast<char*>(pool.allocate(large_size));
+    assert(large != NULL);
+    assert(DistributedMemoryPool::usable_size(large) == large_size);
+    large[0] = 1;
+    large[large_size - 1] = 1;
+    
+    size_t total, free, used;
+    pool.get_statistics(total, free, used);
+    assert(used == 4);
+    
+    pool.deallocate(large);
+    pool.deallocate(big);
+    pool.deallocate(medium);
+    pool.deallocate(small);
+    
+    pool.get_statistics(total, free, used);
+    assert(used == 0);
+    
+    // Un bloque liberado se reutiliza dentro de su clase
+    void* again = pool.allocate(2500);
+    assert(again == medium);
+    pool.deallocate(again);
+    
+    // Lotes de cualquier capacidad obtienen memoria del pool
+    RecordBatch* batch = pool.create_batch(5000);
+    assert(batch->records != NULL);
+    for (int i = 0; i < 5000; ++i) {
+        DatabaseRecord record;
+        record.id = i;
+        batch->add_record(record);
+    }
+    assert(batch->count == 5000);
+    assert(batch->records[4999].id == 4999);
+    pool.free_batch(batch);
+    
+    std::cout << "✓ Size classes test passed" << std::endl;
+}
+
+void test_batch_recycling() {
+    std::cout << "Test: Batch recycling..." << std::endl;
+    
+    DistributedMemoryPool pool(sizeof(DatabaseRecord) * 100, 2);
+    
+    // IDs monótonos
+    RecordBatch* first = pool.create_batch(100);
+    RecordBatch* second = pool.create_batch(100);
+    assert(second->batch_id > first->batch_id);
+    
+    // Cabecera y registros se reciclan juntos como una unidad
+    RecordBatch* first_header = first;
+    DatabaseRecord* first_records = first->records;
+    pool.free_batch(first);
+    assert(pool.get_cached_batch_count() == 1);
+    RecordBatch* reused = pool.create_batch(80);
+    assert(reused == first_header && reused->records == first_records);
+    assert(reused->capacity == 80 && reused->count == 0);
+    assert(pool.get_cached_batch_count() == 0);
+    pool.free_batch(reused);
+    pool.free_batch(second);
+    
+    // Que el régimen estacionario no llama al allocator global se comprueba
+    // en test_batch_allocations, que reemplaza operator new en su binario
+    std::cout << "✓ Batch recycling test passed" << std::endl;
+}
+
+struct BatchStressData {
+    DistributedMemoryPool* pool;
+    int iterations;
+    bool corrupted;
+};
+
+void* batch_stress_thread(void* arg) {
+    BatchStressData* data = (BatchStressData*)arg;
+    RecordBatch* held[4];
+    
+    for (int i = 0; i < data->iterations; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            held[j] = data->pool->create_batch(50 + j);
+            for (size_t k = 0; k < held[j]->capacity; ++k) {
+                DatabaseRecord record;
+                record.id = held[j]->batch_id;
+                held[j]->add_record(record);
+            }
+        }
+        for (int j = 0; j < 4; ++j) {
+            for (size_t k = 0; k < held[j]->count; ++k) {
+                if (held[j]->records[k].id != held[j]->batch_id) {
+                    data->corrupted = true;
+                }
+            }
+            data->pool->free_batch(held[j]);
+        }
+    }
+    
+    return NULL;
+}
+
+void test_batch_recycling_concurrent() {
+    std::cout << "Test: Concurrent batch recycling..." << std::endl;
+    
+    DistributedMemoryPool pool(sizeof(DatabaseRecord) * 64, 0);
+    const int num_threads = 4;
+    pthread_t threads[num_threads];
+    BatchStressData data[num_threads];
+    
+    // trim() libera unidades mientras otros hilos hacen pop de las mismas pilas
+    pool.set_trim_watermark(0);
+    assert(pool.start_background_trim(1));
+    
+    for (int i = 0; i < num_threads; ++i) {
+        data[i].pool = &pool;
+        data[i].iterations = 20000;
+        data[i].corrupted = false;
+        pthread_create(&threads[i], NULL, batch_stress_thread, &data[i]);
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        pthread_join(threads[i], NULL);
+        assert(!data[i].corrupted);
+    }
+    pool.stop_background_trim();
+    
+    // Todas las unidades vuelven a las pilas libres
+    size_t total, free, used;
+    pool.get_statistics(total, free, used);
+    assert(used == 0);
+    assert(pool.get_cached_batch_count() <= num_threads * 4);
+    
+    std::cout << "✓ Concurrent batch recycling test passed" << std::endl;
+}
+
+void test_arena_backing() {
+    std::cout << "Test: Arena backing..." << std::endl;
+    
+    MemoryPoolBacking backing;
+    backing.mode = MemoryPoolBacking::ARENA_BACKING;
+    backing.huge_pages = MemoryPoolBacking::TRANSPARENT_HUGE_PAGES;
+    backing.arena_size = 4 * 1024 * 1024;
+    
+    DistributedMemoryPool pool(256, 16, DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH, backing);
+    assert(pool.get_numa_node_count() >= 1);
+    assert(pool.get_arena_bytes_used() > 0);
+    
+    // Los slabs del arena se comportan igual que los del heap
+    std::vector<void*> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        void* ptr = pool.allocate(256);
+        assert(ptr != NULL);
+        memset(ptr, i & 0xFF, 256);
+        blocks.push_back(ptr);
+    }
+    
+    // Agotar el arena: las clases grandes pasan a slabs del heap
+    for (int i = 0; i < 8; ++i) {
+        void* ptr = pool.allocate(1024 * 1024);
+        assert(ptr != NULL);
+        memset(ptr, 0, 1024 * 1024);
+        blocks.push_back(ptr);
+    }
+    assert(pool.get_arena_bytes_used() <= 4 * 1024 * 1024);
+    
+    RecordBatch* batch = pool.create_batch(1000);
+    assert(batch != NULL);
+    batch->records[999].value = 1.0;
+    pool.free_batch(batch);
+    
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        pool.deallocate(blocks[i]);
+    }
+    
+    size_t total, free, used;
+    pool.get_statistics(total, free, used);
+    assert(used == 0);
+    
+    std::cout << "✓ Arena backing test passed" << std::endl;
+}
+
+void test_shared_memory_backing() {
+    std::cout << "Test: Shared memory backing..." << std::endl;
+    
+    MemoryPoolBacking backing;
+    backing.mode = MemoryPoolBacking::SHARED_MEMORY_BACKING;
+    backing.arena_size = 8 * 1024 * 1024;
+    
+    DistributedMemoryPool pool(1024, 4, DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH, backing);
+    const SharedMemoryRegion* region = pool.get_shared_region();
+    assert(region != NULL);
+    
+    // Lotes mayores que la antigua región de 1 MB por plugin
+    RecordBatch* batch = pool.create_batch(20000);
+    assert(batch != NULL);
+    assert(pool.is_shared(batch->records, batch->capacity * sizeof(DatabaseRecord)));
+    
+    // Solo los registros son visibles para el hijo: cabecera y bloques son privados
+    assert(!pool.is_shared(batch, sizeof(RecordBatch)));
+    void* block = pool.allocate(512);
+    assert(!pool.is_shared(block, 512));
+    pool.deallocate(block);
+    
+    for (size_t i = 0; i < batch->capacity; ++i) {
+        batch->records[i].id = static_cast<int>(i);
+        batch->records[i].value = 1.0;
+    }
+    batch->count = batch->capacity;
+    
+    // El hijo solo recibe el desplazamiento y modifica los registros en sitio
+    size_t offset = reinterpret_cast<char*>(batch->records) - static_cast<char*>(region->get_memory());
+    size_t count = batch->count;
+    
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        DatabaseRecord* records = reinterpret_cast<DatabaseRecord*>(
+            static_cast<char*>(region->get_memory()) + offset);
+        for (size_t i = 0; i < count; ++i) {
+            records[i].value = records[i].id * 2.0;
+        }
+        _exit(0);
+    }
+    
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    
+    for (size_t i = 0; i < batch->count; ++i) {
+        assert(batch->records[i].value == batch->records[i].id * 2.0);
+    }
+    DatabaseRecord* shared_records = batch->records;
+    pool.free_batch(batch);
+    
+    // trim() devuelve las páginas de los registros y el trozo se reutiliza
+    pool.set_trim_watermark(0);
+    assert(pool.trim() >= 20000 * sizeof(DatabaseRecord));
+    batch = pool.create_batch(20000);
+    assert(batch->records == shared_records);
+    pool.free_batch(batch);
+    
+    // Un puntero del heap nunca se considera compartido
+    DatabaseRecord local;
+    assert(!pool.is_shared(&local, sizeof(local)));
+    
+    std::cout << "✓ Shared memory backing test passed" << std::endl;
+}
+
+struct PressureProbe {
+    int calls;
+    size_t reserved;
+};
+
+static void pressure_probe_callback(DistributedMemoryPool* pool, size_t reserved_bytes, void* user_data) {
+    PressureProbe* probe = static_cast<PressureProbe*>(user_data);
+    probe->calls++;
+    probe->reserved = reserved_bytes;
+    pool->trim();
+}
+
+void test_trim_and_pressure() {
+    std::cout << "Test: Trim and memory pressure..." << std::endl;
+    
+    DistributedMemoryPool pool(1024, 0);
+    pool.set_trim_watermark(64 * 1024);
+    
+    PressureProbe probe;
+    probe.calls = 0;
+    probe.reserved = 0;
+    assert(pool.add_pressure_callback(pressure_probe_callback, &probe));
+    pool.set_pressure_limit(2 * 1024 * 1024);
+    
+    std::vector<void*> blocks;
+    for (int i = 0; i < 4096; ++i) {
+        blocks.push_back(pool.allocate(1024));
+    }
+    
+    // Un solo aviso por cruce del límite
+    assert(probe.calls == 1);
+    assert(probe.reserved > 2 * 1024 * 1024);
+    
+    MemoryPoolUsage usage;
+    pool.get_usage(usage);
+    assert(usage.high_water_bytes >= 4096 * 1024);
+    
+    // Las marcas se miden desde el pico de la ráfaga
+    pool.reset_watermarks();
+    
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        pool.deallocate(blocks[i]);
+    }
+    
+    size_t released = pool.trim();
+    assert(released > 0);
+    
+    pool.get_usage(usage);
+    assert(usage.reserved_bytes < 256 * 1024);
+    assert(usage.low_water_bytes == usage.reserved_bytes);
+    assert(usage.high_water_bytes >= 4096 * 1024);
+    assert(usage.released_bytes >= released);
+    
+    // Tras bajar del límite el aviso se rearma
+    for (int i = 0; i < 4096; ++i) {
+        blocks[i] = pool.allocate(1024);
+    }
+    assert(probe.calls == 2);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        pool.deallocate(blocks[i]);
+    }
+    
+    // Los lotes retenidos también se liberan y sus índices se reutilizan
+    std::vector<RecordBatch*> batches;
+    for (int i = 0; i < 64; ++i) {
+        batches.push_back(pool.create_batch(100));
+    }
+    for (size_t i = 0; i < batches.size(); ++i) {
+        pool.free_batch(batches[i]);
+    }
+    pool.trim();
+    assert(pool.get_cached_batch_count() <= 64 * 1024 / 16384 + 1);
+    for (size_t i = 0; i < batches.size(); ++i) {
+        batches[i] = pool.create_batch(100);
+        batches[i]->count = 0;
+    }
+    for (size_t i = 0; i < batches.size(); ++i) {
+        pool.free_batch(batches[i]);
+    }
+    
+    size_t total, free, used;
+    pool.get_statistics(total, free, used);
+    assert(used == 0);
+    
+    std::cout << "✓ Trim and memory pressure test passed" << std::endl;
+}
+
+/**
+ * @brief Memoria residente del proceso según /proc/self/statm
+ */
+static size_t resident_bytes() {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    
+    unsigned long size = 0, resident = 0;
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void test_rss_soak() {
+    std::cout << "Test: RSS soak tras ráfagas..." << std::endl;
+    
+    DistributedMemoryPool pool(4096, 0);
+    pool.trim();
+    size_t baseline = resident_bytes();
+    
+    const size_t burst_blocks = 32768;  // 128 MB de datos
+    std::vector<void*> blocks(burst_blocks);
+    size_t peak = 0;
+    
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < burst_blocks; ++i) {
+            blocks[i] = pool.allocate(4096);
+            memset(blocks[i], round + 1, 4096);
+        }
+        peak = std::max(peak, resident_bytes());
+        
+        for (size_t i = 0; i < burst_blocks; ++i) {
+            pool.deallocate(blocks[i]);
+        }
+        pool.trim();
+        
+        size_t after = resident_bytes();
+        std::cout << "  ráfaga " << round + 1 << ": base " << baseline / 1024 << " KB, pico "
+                  << peak / 1024 << " KB, tras trim " << after / 1024 << " KB" << std::endl;
+        
+        // Tras el trim el RSS vuelve a la base (margen de 8 MB para malloc y caches)
+        assert(peak > baseline + 64 * 1024 * 1024);
+        assert(after < baseline + 8 * 1024 * 1024);
+    }
+    
+    std::cout << "✓ RSS soak test passed" << std::endl;
+}
+
+void benchmark_outstanding_blocks() {
+    std::cout << "Benchmark: alloc/free con bloques pendientes..." << std::endl;
+    
+    const size_t outstanding_counts[] = { 10, 100, 1000, 10000, 100000 };
+    const int operations = 200000;
+    
+    for (size_t c = 0; c < sizeof(outstanding_counts) / sizeof(outstanding_counts[0]); ++c) {
+        size_t outstanding = outstanding_counts[c];
+        DistributedMemoryPool pool(64, outstanding);
+        std::vector<void*> ring(outstanding);
+        
+        for (size_t i = 0; i < outstanding; ++i) {
+            ring[i] = pool.allocate(64);
+        }
+        
+        // Liberar siempre el bloque más antiguo: el peor caso para una lista de usados
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+        
+        for (int i = 0; i < operations; ++i) {
+            size_t slot = i % outstanding;
+            pool.deallocate(ring[slot]);
+            ring[slot] = pool.allocate(64);
+        }
+        
+        gettimeofday(&end, NULL);
+        double elapsed_ns = (end.tv_sec - start.tv_sec) * 1e9 + 
+                            (end.tv_usec - start.tv_usec) * 1e3;
+        
+        std::cout << "  " << outstanding << " bloques pendientes: " 
+                  << elapsed_ns / operations << " ns por par alloc/free" << std::endl;
+        
+        for (size_t i = 0; i < outstanding; ++i) {
+            pool.deallocate(ring[i]);
+        }
+    }
+}
+
+struct ScalingBenchData {
+    DistributedMemoryPool* pool;
+    int operations;
+};
+
+void* scaling_bench_thread(void* arg) {
+    ScalingBenchData* data = (ScalingBenchData*)arg;
+    void* held[8];
+    
+    for (int i = 0; i < data->operations; i += 8) {
+        for (int j = 0; j < 8; ++j) held[j] = data->pool->allocate(256);
+        for (int j = 0; j < 8; ++j) data->pool->deallocate(held[j]);
+    }
+    
+    return NULL;
+}
+
+void benchmark_thread_cache_scaling() {
+    std::cout << "Benchmark: escalado por hilos con y sin cache por hilo..." << std::endl;
+    
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) cores = 1;
+    const int operations_per_thread = 400000;
+    
+    std::vector<long> thread_counts;
+    for (long threads = 1; threads < cores; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(cores);
+    
+    for (size_t c = 0; c < thread_counts.size(); ++c) {
+        long threads = thread_counts[c];
+        double rates[2];
+        
+        for (int with_cache = 0; with_cache < 2; ++with_cache) {
+            DistributedMemoryPool pool(256, 64, with_cache ? DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH : 0);
+            std::vector<pthread_t> workers(threads);
+            ScalingBenchData data;
+            data.pool = &pool;
+            data.operations = operations_per_thread;
+            
+            struct timeval start, end;
+            gettimeofday(&start, NULL);
+            
+            for (long t = 0; t < threads; ++t) {
+                pthread_create(&workers[t], NULL, scaling_bench_thread, &data);
+            }
+            for (long t = 0; t < threads; ++t) {
+                pthread_join(workers[t], NULL);
+            }
+            
+            gettimeofday(&end, NULL);
+            double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+            rates[with_cache] = (threads * (double)operations_per_thread) / elapsed;
+        }
+        
+        std::cout << "  " << threads << " hilos: " << (long)(rates[0] / 1e3) << " K allocs/s sin cache, "
+                  << (long)(rates[1] / 1e3) << " K allocs/s con cache" << std::endl;
+    }
+}
+
+/**
+ * @brief Contador de fallos de dTLB vía perf_event_open (-1 si no está disponible)
+ */
+static int open_dtlb_miss_counter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+void benchmark_record_scan_backing() {
+    std::cout << "Benchmark: recorrido de registros heap vs arena con huge pages..." << std::endl;
+    
+    const size_t batch_count = 512;
+    const size_t records_per_batch = 1000;
+    const int passes = 4;
+    const char* labels[] = { "heap", "arena+THP" };
+    
+    for (int variant = 0; variant < 2; ++variant) {
+        MemoryPoolBacking backing;
+        if (variant == 1) {
+            backing.mode = MemoryPoolBacking::ARENA_BACKING;
+            backing.huge_pages = MemoryPoolBacking::TRANSPARENT_HUGE_PAGES;
+            backing.arena_size = 128 * 1024 * 1024;
+        }
+        DistributedMemoryPool pool(1024, 0, DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH, backing);
+        
+        std::vector<RecordBatch*> batches(batch_count);
+        for (size_t b = 0; b < batch_count; ++b) {
+            batches[b] = pool.create_batch(records_per_batch);
+            for (size_t r = 0; r < records_per_batch; ++r) {
+                batches[b]->records[r].value = static_cast<double>(r);
+            }
+            batches[b]->count = records_per_batch;
+        }
+        
+        int counter = open_dtlb_miss_counter();
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        
+        // Orden pseudoaleatorio entre lotes y registros para castigar la TLB
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+        
+        double sum = 0;
+        unsigned int state = 12345;
+        for (int pass = 0; pass < passes; ++pass) {
+            for (size_t i = 0; i < batch_count * records_per_batch; ++i) {
+                state = state * 1103515245u + 12345u;
+                size_t b = (state >> 8) % batch_count;
+                size_t r = (state >> 4) % records_per_batch;
+                sum += batches[b]->records[r].value;
+            }
+        }
+        
+        gettimeofday(&end, NULL);
+        
+        long long misses = -1;
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) {
+                misses = -1;
+            }
+            close(counter);
+        }
+        
+        double elapsed_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_usec - start.tv_usec) / 1e3;
+        std::cout << "  " << labels[variant] << ": " << elapsed_ms << " ms, dTLB misses: ";
+        if (misses >= 0) std::cout << misses;
+        else std::cout << "no disponible";
+        std::cout << " (suma " << sum << ")" << std::endl;
+        
+        for (size_t b = 0; b < batch_count; ++b) {
+            pool.free_batch(batches[b]);
+        }
+    }
+}
+
+int benchmark_memory_pool_main() {
+    benchmark_outstanding_blocks();
+    benchmark_thread_cache_scaling();
+    benchmark_record_scan_backing();
+    return 0;
+}
+
 int test_memory_pool_main() {
     std::cout << "=== Memory Pool Tests ===" << std::endl;
     
     test_basic_allocation();
     test_batch_creation();
     test_thread_safety();
+    test_statistics_counters();
+    test_size_classes();
+    test_batch_recycling();
+    test_batch_recycling_concurrent();
+    test_arena_backing();
+    test_shared_memory_backing();
+    test_trim_and_pressure();
+    test_rss_soak();
     
     std::cout << "All memory pool tests passed!" << std::endl;
     return 0;
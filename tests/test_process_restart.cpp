@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_process_restart.cpp
+#include "test_helpers.h"
+#include "../include/isolated_process.h"
+#include "../include/memory_pool.h"
+#include "../include/ipc.h"
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+using namespace distributed;
+
+// Matar al hijo y esperar a que is_alive() lo vea caído
+static void kill_child(IsolatedPluginProcess& process) {
+    kill(process.get_pid(), SIGKILL);
+    for (int i = 0; i < 1000 && process.is_alive(); ++i) {
+        usleep(1000);
+    }
+    assert(!process.is_alive());
+}
+
+void test_restart_after_kill() {
+    std::cout << "Test: Plugin process restart after SIGKILL..." << std::endl;
+    
+    IsolatedPluginProcess process("validation", plugin_path("validation"), "strict_mode=false");
+    assert(process.start());
+    pid_t first_child = process.get_pid();
+    
+    const int rounds = 5;
+    double total_us = 0.0;
+    std::vector<DatabaseRecord> records(500);
+    RecordBatch batch;
+    for (int i = 0; i < rounds; ++i) {
+        kill_child(process);
+        double start = now_us();
+        assert(process.restart());
+        total_us += now_us() - start;
+    
+        // El hijo nuevo sirve lotes con las bibliotecas que precargó el zygote
+        assert(process.is_alive() && process.get_pid() != first_child);
+        fill_batch(batch, records, i);
+        assert(process.process_batch(&batch) == 0);
+    }
+    
+    // Margen amplio para máquinas cargadas; el objetivo son unos pocos ms
+    assert(total_us / rounds < 100000.0);
+    
+    // Terminar un hijo sano no espera plazos fijos
+    double start = now_us();
+    process.terminate();
+    assert(now_us() - start < 500000.0);
+    assert(!process.is_alive());
+    
+    // Sin zygote el reinicio rehace todo con start()
+    assert(process.restart());
+    fill_batch(batch, records, 0);
+    assert(process.process_batch(&batch) == 0);
+    
+    std::cout << "✓ Plugin process restart after SIGKILL passed" << std::endl;
+}
+
+void test_kill_mid_stream() {
+    std::cout << "Test: Plugin killed mid-stream..." << std::endl;
+    
+    const size_t batch_count = 200, batch_size = 400, kill_every = 50;
+    std::vector<std::vector<DatabaseRecord> > records(batch_count,
+                                                      std::vector<DatabaseRecord>(batch_size));
+    std::vector<std::vector<DatabaseRecord> > expected(batch_count,
+                                                       std::vector<DatabaseRecord>(batch_size));
+    std::vector<RecordBatch> batches(batch_count), expected_batches(batch_count);
+    
+    IsolatedPluginProcess reference("validation", plugin_path("validation"), "strict_mode=false");
+    assert(reference.start());
+    for (size_t i = 0; i < batch_count; ++i) {
+        fill_batch(expected_batches[i], expected[i], static_cast<int>(i));
+        assert(reference.process_batch(&expected_batches[i]) == 0);
+        fill_batch(batches[i], records[i], static_cast<int>(i));
+    }
+    
+    IsolatedPluginProcess process("validation", plugin_path("validation"), "strict_mode=false");
+    process.set_pipeline_depth(4);
+    assert(process.start());
+    
+    // Lotes pendientes de enviar (los abandonados vuelven a la cola) y en vuelo
+    std::vector<size_t> pending;
+    for (size_t i = batch_count; i > 0; --i) pending.push_back(i - 1);
+    std::map<uint32_t, size_t> in_flight;
+    std::vector<bool> done(batch_count, false);
+    size_t completed = 0, kills = 0, resubmitted = 0;
+    double killed_at = 0.0, total_gap_us = 0.0, max_gap_us = 0.0;
+    bool restarted = false;
+    
+    while (completed < batch_count) {
+        while (!pending.empty()) {
+            uint32_t request = process.submit_batch(&batches[pending.back()]);
+            if (request == 0) break;
+            in_flight[request] = pending.back();
+            pending.pop_back();
+        }
+    
+        RecordBatch* batch = NULL;
+        int result = -1;
+        // La espera corta acota lo que tarda en notarse la caída del hijo
+        uint32_t request = process.collect_completion(5, &batch, &result);
+        if (request != 0) {
+            assert(result == 0 && in_flight.count(request) == 1);
+            size_t index = in_flight[request];
+            assert(batch == &batches[index] && !done[index]);
+            in_flight.erase(request);
+            done[index] = true;
+            ++completed;
+    
+            // Tiempo sin servicio: del SIGKILL al primer lote del hijo nuevo
+            if (restarted) {
+                double gap_us = now_us() - killed_at;
+                total_gap_us += gap_us;
+                max_gap_us = std::max(max_gap_us, gap_us);
+                restarted = false;
+            }
+    
+            if (completed % kill_every == 0 && completed < batch_count && !in_flight.empty()) {
+                killed_at = now_us();
+                kill(process.get_pid(), SIGKILL);
+                ++kills;
+            }
+            continue;
+        }
+    
+        // Sin respuesta: si el hijo cayó, lo en vuelo se reenvía tras reiniciar
+        if (process.is_alive()) continue;
+        process.abandon_in_flight();
+        for (std::map<uint32_t, size_t>::iterator it = in_flight.begin(); it != in_flight.end(); ++it) {
+            fill_batch(batches[it->second], records[it->second], static_cast<int>(it->second));
+            pending.push_back(it->second);
+            ++resubmitted;
+        }
+        in_flight.clear();
+        assert(process.restart());
+        restarted = killed_at > 0.0;
+    }
+    
+    assert(kills == (batch_count - 1) / kill_every);
+    assert(resubmitted >= kills);
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(batches[i].count == expected_batches[i].count);
+        assert(same_records(records[i], expected[i], expected_batches[i].count));
+    }
+    std::cout << "  " << kills << " SIGKILL, " << resubmitted << " lotes reenviados, hueco de servicio: media "
+              << total_gap_us / kills / 1000.0 << " ms, máximo " << max_gap_us / 1000.0 << " ms"
+              << std::endl;
+    
+    std::cout << "✓ Plugin killed mid-stream passed" << std::endl;
+}
+
+void test_abandon_in_place_batch() {
+    std::cout << "Test: Abandoned in-place batch restarts the child..." << std::endl;
+    
+    MemoryPoolBacking backing;
+    backing.mode = MemoryPoolBacking::SHARED_MEMORY_BACKING;
+    backing.arena_size = 8 * 1024 * 1024;
+    DistributedMemoryPool pool(1024, 4, DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH, backing);
+    assert(pool.get_shared_region() != NULL);
+    
+    IsolatedPluginProcess process("validation", plugin_path("validation"), "strict_mode=false");
+    process.attach_batch_region(pool.get_shared_region());
+    process.set_pipeline_depth(2);
+    assert(process.start());
+    
+    RecordBatch* batch = pool.create_batch(400);
+    for (size_t i = 0; i < batch->capacity; ++i) {
+        batch->records[i].id = static_cast<int>(i) + 1;
+        sprintf(batch->records[i].name, "Name_%d", static_cast<int>(i % 50));
+        batch->records[i].value = static_cast<double>(i);
+        batch->records[i].category = 1;
+    }
+    batch->count = batch->capacity;
+    
+    // Un lote serializado abandonado solo retiene su slot: el hijo sigue
+    std::vector<DatabaseRecord> records(400);
+    RecordBatch copy;
+    fill_batch(copy, records, 1);
+    pid_t child = process.get_pid();
+    assert(process.submit_batch(&copy) != 0);
+    process.abandon_in_flight();
+    assert(process.is_alive() && process.get_pid() == child);
+    
+    // Uno en sitio no se suelta con el hijo vivo, que podría seguir escribiéndolo
+    assert(process.submit_batch(batch) != 0);
+    process.abandon_in_flight();
+    assert(process.is_alive() && process.get_pid() != child);
+    
+    assert(process.process_batch(batch) == 0);
+    assert(batch->count == 400);
+    pool.free_batch(batch);
+    process.terminate();
+    
+    std::cout << "✓ Abandoned in-place batch restarts the child passed" << std::endl;
+}
+
+void test_plugin_error_result() {
+    std::cout << "Test: Plugin error codes reach the caller..." << std::endl;
+    
+    IsolatedPluginProcess process("validation", plugin_path("validation"), "strict_mode=true");
+    process.set_pipeline_depth(2);
+    assert(process.start());
+    
+    // En modo estricto un nombre inválido es un error del plugin, no un éxito
+    std::vector<DatabaseRecord> records(100);
+    RecordBatch batch;
+    fill_batch(batch, records, 0);
+    std::vector<DatabaseRecord> original(records);
+    int result = process.process_batch(&batch);
+    assert(result < 0 && result != -1);
+    assert(same_records(records, original, records.size()));
+    
+    RecordBatch* done = NULL;
+    uint32_t request = process.submit_batch(&batch);
+    assert(request != 0);
+    assert(process.collect_completion(5000, &done, &result) == request);
+    assert(done == &batch && result < 0 && result != -1);
+    
+    std::vector<DatabaseRecord> valid(1);
+    fill_batch(batch, valid, 1);
+    assert(process.process_batch(&batch) == 0);
+    process.terminate();
+    
+    std::cout << "✓ Plugin error codes reach the caller passed" << std::endl;
+}
+
+void test_short_lived_child_reaped() {
+    std::cout << "Test: Short-lived plugin children are reaped..." << std::endl;
+    
+    // Sin biblioteca el hijo sale nada más arrancar, a veces antes de que el
+    // padre abra su pidfd
+    IsolatedPluginProcess process("missing", "./no_such_plugin.so", "");
+    assert(process.start());
+    for (int round = 0; round < 20; ++round) {
+        if (round > 0) assert(process.restart());
+        pid_t child = process.get_pid();
+        for (int i = 0; i < 1000 && process.is_alive(); ++i) {
+            usleep(1000);
+        }
+        assert(!process.is_alive());
+        
+        // El zygote lo recoge tras la confirmación del padre: no quedan zombis
+        char proc_path[64];
+        sprintf(proc_path, "/proc/%d", static_cast<int>(child));
+        for (int i = 0; i < 1000 && access(proc_path, F_OK) == 0; ++i) {
+            usleep(1000);
+        }
+        assert(access(proc_path, F_OK) != 0);
+    }
+    process.terminate();
+    
+    std::cout << "✓ Short-lived plugin children are reaped passed" << std::endl;
+}
+
+int benchmark_process_restart_main() {
+    std::cout << "Benchmark: Plugin process restart latency..." << std::endl;
+    
+    if (access(plugin_path("validation").c_str(), R_OK) != 0) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", benchmark omitido" << std::endl;
+        return 0;
+    }
+    
+    IsolatedPluginProcess process("validation", plugin_path("validation"), "strict_mode=false");
+    assert(process.start());
+    
+    const int rounds = 100;
+    double total_us = 0.0, max_us = 0.0;
+    for (int i = 0; i < rounds; ++i) {
+        kill_child(process);
+        double start = now_us();
+        assert(process.restart());
+        double elapsed_us = now_us() - start;
+        total_us += elapsed_us;
+        max_us = std::max(max_us, elapsed_us);
+    }
+    
+    double start = now_us();
+    process.terminate();
+    double terminate_us = now_us() - start;
+    
+    std::cout << "  reinicio tras SIGKILL: media " << total_us / rounds / 1000.0 << " ms, máximo "
+              << max_us / 1000.0 << " ms; terminate(): " << terminate_us / 1000.0 << " ms" << std::endl;
+    return 0;
+}
+
+int test_process_restart_main() {
+    std::cout << "=== Process Restart Tests ===" << std::endl;
+    
+    if (access(plugin_path("validation").c_str(), R_OK) != 0) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", tests omitidos" << std::endl;
+        return 0;
+    }
+    
+    test_restart_after_kill();
+    test_kill_mid_stream();
+    test_abandon_in_place_batch();
+    test_plugin_error_result();
+    test_short_lived_child_reaped();
+    
+    std::cout << "All process restart tests passed!" << std::endl;
+    return 0;
+}
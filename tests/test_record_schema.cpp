@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_record_schema.cpp
+#include "../include/record_schema.h"
+#include "../include/serialization.h"
+#include "../include/crc32c.h"
+#include <cassert>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/time.h>
+#include <stdint.h>
+
+using namespace distributed;
+
+// Registro de un nodo más antiguo: otro orden, nombre corto, sin value
+struct RecordV1 {
+    int category;
+    char name[40];
+    int id;
+};
+
+// Registro de un nodo más nuevo: id ahora es double y hay un campo extra
+struct RecordV3 {
+    double value;
+    double id;
+    int category;
+    int priority;
+    char name[128];
+};
+
+namespace distributed {
+
+template <> struct RecordSchemaTraits<RecordV1> {
+    static const SchemaFieldDescriptor fields[];
+    static const size_t field_count;
+};
+const SchemaFieldDescriptor RecordSchemaTraits<RecordV1>::fields[] = {
+    SCHEMA_FIELD(RecordV1, category),
+    SCHEMA_FIELD(RecordV1, name),
+    SCHEMA_FIELD(RecordV1, id)
+};
+const size_t RecordSchemaTraits<RecordV1>::field_count = 3;
+
+template <> struct RecordSchemaTraits<RecordV3> {
+    static const SchemaFieldDescriptor fields[];
+    static const size_t field_count;
+};
+const SchemaFieldDescriptor RecordSchemaTraits<RecordV3>::fields[] = {
+    SCHEMA_FIELD(RecordV3, value),
+    SCHEMA_FIELD(RecordV3, id),
+    SCHEMA_FIELD(RecordV3, category),
+    SCHEMA_FIELD(RecordV3, priority),
+    SCHEMA_FIELD(RecordV3, name)
+};
+const size_t RecordSchemaTraits<RecordV3>::field_count = 5;
+
+} // namespace distributed
+
+static void fill_records(RecordBatch& batch, size_t count) {
+    batch.records = new DatabaseRecord[count];
+    batch.capacity = count;
+    batch.count = count;
+    batch.batch_id = 31;
+    for (size_t i = 0; i < count; ++i) {
+        batch.records[i].id = static_cast<int>(i * 3 + 1);
+        batch.records[i].value = i * 1.5 - 7;
+        batch.records[i].category = static_cast<int>(i % 9);
+        sprintf(batch.records[i].name, "Record_%lu", static_cast<unsigned long>(i));
+    }
+}
+
+void test_record_schema_descriptors() {
+    std::cout << "Test: Record schema descriptors..." << std::endl;
+    
+    const RecordSchema& native = RecordSchema::native();
+    assert(native.is_valid());
+    assert(native.get_record_size() == sizeof(DatabaseRecord));
+    assert(native.get_field_count() == 4);
+    
+    const RecordSchema::Field* name = native.find_field("name");
+    assert(name && name->type == SCHEMA_CHARS && name->size == sizeof(((DatabaseRecord*)0)->name));
+    assert(name->offset == offsetof(DatabaseRecord, name));
+    const RecordSchema::Field* value = native.find_field("value");
+    assert(value && value->type == SCHEMA_FLOAT64 && value->offset == offsetof(DatabaseRecord, value));
+    assert(native.find_field("id")->type == SCHEMA_INT32);
+    assert(!native.find_field("missing"));
+    
+    // La forma codificada ida y vuelta da el mismo esquema y la misma huella
+    RecordSchema decoded;
+    assert(decoded.decode(native.get_encoded(), native.get_encoded_size()));
+    assert(decoded.get_fingerprint() == native.get_fingerprint());
+    assert(decoded.get_encoded_size() % 8 == 0);
+    
+    // Layouts distintos, huellas distintas
+    assert(RecordSchema::of<RecordV1>().get_fingerprint() != native.get_fingerprint());
+    assert(RecordSchema::of<RecordV3>().get_fingerprint() != native.get_fingerprint());
+    
+    // Esquemas mal formados se rechazan
+    std::vector<char> bytes(native.get_encoded(), native.get_encoded() + native.get_encoded_size());
+    assert(!decoded.decode(&bytes[0], bytes.size() - 8));
+    bytes[8] = 9;   // tipo desconocido
+    assert(!decoded.decode(&bytes[0], bytes.size()));
+    assert(!decoded.is_valid());
+    
+    const SchemaFieldDescriptor overlapping[] = { { "id", SCHEMA_INT32, 6, 4 } };
+    assert(!RecordSchema(overlapping, 1, 8).is_valid());
+    const SchemaFieldDescriptor duplicated[] = { { "id", SCHEMA_INT32, 0, 4 }, { "id", SCHEMA_INT32, 4, 4 } };
+    assert(!RecordSchema(duplicated, 2, 8).is_valid());
+    
+    std::cout << "✓ Record schema descriptors passed" << std::endl;
+}
+
+void test_record_schema_mixed_versions() {
+    std::cout << "Test: Record schema mixed versions..." << std::endl;
+    
+    // Un nodo antiguo envía RecordV1: id, category y name se emparejan por
+    // nombre y value queda en cero
+    std::vector<RecordV1> old_records(50);
+    for (size_t i = 0; i < old_records.size(); ++i) {
+        memset(&old_records[i], 0, sizeof(RecordV1));
+        old_records[i].id = static_cast<int>(i + 100);
+        old_records[i].category = static_cast<int>(i % 4);
+        sprintf(old_records[i].name, "Old_%lu", static_cast<unsigned long>(i));
+    }
+    const RecordSchema& v1 = RecordSchema::of<RecordV1>();
+    std::vector<char> wire(Serializer::calculate_record_batch_size(old_records.size(), v1));
+    assert(Serializer::serialize_records(&old_records[0], old_records.size(), 64, 12, v1,
+                                         &wire[0], wire.size()) == wire.size());
+    assert(Serializer::validate_serialized_data(&wire[0], wire.size()));
+    // Otro layout no puede leerse en sitio
+    assert(!SerializedBatchView(&wire[0], wire.size()).is_valid());
+    
+    RecordBatch batch;
+    batch.records = new DatabaseRecord[old_records.size()];
+    batch.capacity = old_records.size();
+    assert(Serializer::deserialize_batch(&wire[0], &batch));
+    assert(batch.count == old_records.size() && batch.batch_id == 12);
+    for (size_t i = 0; i < batch.count; ++i) {
+        assert(batch.records[i].id == old_records[i].id);
+        assert(batch.records[i].category == old_records[i].category);
+        assert(strcmp(batch.records[i].name, old_records[i].name) == 0);
+        assert(batch.records[i].value == 0);
+    }
+    delete[] batch.records;
+    
+    // Un nodo nuevo envía RecordV3: id double -> int, nombre largo truncado,
+    // priority se descarta
+    std::vector<RecordV3> new_records(20);
+    for (size_t i = 0; i < new_records.size(); ++i) {
+        memset(&new_records[i], 0, sizeof(RecordV3));
+        new_records[i].id = i * 10 + 0.75;
+        new_records[i].value = i * 0.5;
+        new_records[i].category = static_cast<int>(i);
+        new_records[i].priority = 7;
+        memset(new_records[i].name, 'n', sizeof(new_records[i].name) - 1);
+    }
+    new_records[3].id = 1e12;  // Fuera de rango: satura
+    const RecordSchema& v3 = RecordSchema::of<RecordV3>();
+    wire.resize(Serializer::calculate_record_batch_size(new_records.size(), v3));
+    assert(Serializer::serialize_records(&new_records[0], new_records.size(), new_records.size(), 13, v3,
+                                         &wire[0], wire.size()) > 0);
+    
+    batch.records = new DatabaseRecord[new_records.size()];
+    batch.capacity = new_records.size();
+    assert(Serializer::deserialize_batch(&wire[0], &batch));
+    for (size_t i = 0; i < batch.count; ++i) {
+        assert(batch.records[i].id == (i == 3 ? 2147483647 : static_cast<int>(i * 10)));
+        assert(batch.records[i].value == new_records[i].value);
+        assert(batch.records[i].category == new_records[i].category);
+        assert(strlen(batch.records[i].name) == sizeof(batch.records[i].name) - 1);
+    }
+    delete[] batch.records;
+    
+    // Tipos incompatibles (número <-> texto) se rechazan
+    const SchemaFieldDescriptor text_id[] = { { "id", SCHEMA_CHARS, 0, 16 } };
+    RecordConverter converter;
+    assert(!converter.build(RecordSchema(text_id, 1, 16), RecordSchema::native(), false));
+    
+    std::cout << "✓ Record schema mixed versions passed" << std::endl;
+}
+
+// Reescribir un lote serializado como lo haría un host big-endian
+static void swap_serialized_batch(std::vector<char>& wire) {
+    const size_t u32_fields[] = { 0, 4, 24, 28, 32, 36, 40, 44 };
+    const size_t u64_fields[] = { 8, 16 };
+    uint32_t schema_bytes, record_size;
+    uint64_t count;
+    memcpy(&record_size, &wire[36], sizeof(record_size));
+    memcpy(&schema_bytes, &wire[40], sizeof(schema_bytes));
+    memcpy(&count, &wire[8], sizeof(count));
+    
+    char* records = &wire[48 + schema_bytes];
+    RecordConverter swapper;
+    assert(swapper.build(RecordSchema::native(), RecordSchema::native(), true));
+    std::vector<char> swapped(static_cast<size_t>(count) * record_size);
+    swapper.convert(records, static_cast<size_t>(count), &swapped[0]);
+    memcpy(records, &swapped[0], swapped.size());
+    
+    uint32_t payload_crc = Crc32c::compute(records, swapped.size());
+    memcpy(&wire[28], &payload_crc, sizeof(payload_crc));
+    for (size_t i = 0; i < sizeof(u32_fields) / sizeof(u32_fields[0]); ++i) {
+        uint32_t value;
+        memcpy(&value, &wire[u32_fields[i]], sizeof(value));
+        value = __builtin_bswap32(value);
+        memcpy(&wire[u32_fields[i]], &value, sizeof(value));
+    }
+    for (size_t i = 0; i < sizeof(u64_fields) / sizeof(u64_fields[0]); ++i) {
+        uint64_t value;
+        memcpy(&value, &wire[u64_fields[i]], sizeof(value));
+        value = __builtin_bswap64(value);
+        memcpy(&wire[u64_fields[i]], &value, sizeof(value));
+    }
+    uint32_t header_crc = __builtin_bswap32(Crc32c::compute(&wire[0], 44));
+    memcpy(&wire[44], &header_crc, sizeof(header_crc));
+}
+
+void test_record_schema_byte_order() {
+    std::cout << "Test: Record schema byte order..." << std::endl;
+    
+    RecordBatch original;
+    fill_records(original, 100);
+    std::vector<char> wire(Serializer::calculate_batch_size(&original));
+    assert(Serializer::serialize_batch(&original, &wire[0], wire.size()) == wire.size());
+    swap_serialized_batch(wire);
+    
+    assert(Serializer::validate_serialized_data(&wire[0], wire.size()));
+    assert(!SerializedBatchView(&wire[0], wire.size()).is_valid());
+    
+    RecordBatch copy;
+    copy.records = new DatabaseRecord[original.count];
+    copy.capacity = original.count;
+    assert(Serializer::deserialize_batch(&wire[0], &copy));
+    assert(copy.count == original.count && copy.batch_id == original.batch_id);
+    for (size_t i = 0; i < copy.count; ++i) {
+        assert(copy.records[i].id == original.records[i].id);
+        assert(copy.records[i].value == original.records[i].value);
+        assert(copy.records[i].category == original.records[i].category);
+        assert(strcmp(copy.records[i].name, original.records[i].name) == 0);
+    }
+    
+    delete[] copy.records;
+    delete[] original.records;
+    std::cout << "✓ Record schema byte order passed" << std::endl;
+}
+
+void test_record_schema_legacy_batches() {
+    std::cout << "Test: Record schema legacy batches..." << std::endl;
+    
+    // Versión 2: header de 40 bytes y DatabaseRecord[] nativos, sin esquema
+    RecordBatch original;
+    fill_records(original, 10);
+    std::vector<char> wire(40 + sizeof(DatabaseRecord) * original.count);
+    uint32_t magic = 0x42524244, version = 2, reserved = 0;
+    uint64_t count = original.count, capacity = original.capacity;
+    int32_t batch_id = original.batch_id;
+    memcpy(&wire[40], original.records, sizeof(DatabaseRecord) * original.count);
+    uint32_t payload_crc = Crc32c::compute(&wire[40], sizeof(DatabaseRecord) * original.count);
+    memcpy(&wire[0], &magic, 4);
+    memcpy(&wire[4], &version, 4);
+    memcpy(&wire[8], &count, 8);
+    memcpy(&wire[16], &capacity, 8);
+    memcpy(&wire[24], &batch_id, 4);
+    memcpy(&wire[28], &payload_crc, 4);
+    uint32_t header_crc = Crc32c::compute(&wire[0], 32);
+    memcpy(&wire[32], &header_crc, 4);
+    memcpy(&wire[36], &reserved, 4);
+    
+    assert(Serializer::validate_serialized_data(&wire[0], wire.size()));
+    assert(SerializedBatchView(&wire[0], wire.size()).is_valid());
+    
+    RecordBatch copy;
+    copy.records = new DatabaseRecord[original.count];
+    copy.capacity = original.count;
+    assert(Serializer::deserialize_batch(&wire[0], &copy));
+    assert(copy.count == original.count);
+    assert(memcmp(copy.records, original.records, sizeof(DatabaseRecord) * copy.count) == 0);
+    
+    delete[] copy.records;
+    delete[] original.records;
+    std::cout << "✓ Record schema legacy batches passed" << std::endl;
+}
+
+void benchmark_record_schema() {
+    std::cout << "Benchmark: Record schema fast path vs conversion..." << std::endl;
+    
+    RecordBatch original;
+    fill_records(original, 50000);
+    RecordBatch copy;
+    copy.records = new DatabaseRecord[original.count];
+    copy.capacity = original.count;
+    
+    std::vector<char> native(Serializer::calculate_batch_size(&original));
+    Serializer::serialize_batch(&original, &native[0], native.size());
+    std::vector<char> swapped(native);
+    swap_serialized_batch(swapped);
+    
+    const int iterations = 20;
+    const std::vector<char>* inputs[] = { &native, &swapped };
+    const char* labels[] = { "mismo esquema (memcpy)", "orden de bytes opuesto" };
+    for (int k = 0; k < 2; ++k) {
+        struct timeval start, end;
+        gettimeofday(&start, NULL);
+        for (int it = 0; it < iterations; ++it) {
+            assert(Serializer::deserialize_batch(&(*inputs[k])[0], &copy));
+        }
+        gettimeofday(&end, NULL);
+        double us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+        std::cout << "  " << labels[k] << ": " << us / iterations << " us/lote de "
+                  << original.count << " registros" << std::endl;
+    }
+    
+    delete[] copy.records;
+    delete[] original.records;
+}
+
+int benchmark_record_schema_main() {
+    benchmark_record_schema();
+    return 0;
+}
+
+int test_record_schema_main() {
+    std::cout << "=== Record Schema Tests ===" << std::endl;
+    
+    test_record_schema_descriptors();
+    test_record_schema_mixed_versions();
+    test_record_schema_byte_order();
+    test_record_schema_legacy_batches();
+    
+    std::cout << "All record schema tests passed!" << std::endl;
+    return 0;
+}
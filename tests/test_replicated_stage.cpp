@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_replicated_stage.cpp
+#include "test_helpers.h"
+#include "../include/replicated_stage.h"
+#include "../include/plugin_manager.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+
+using namespace distributed;
+
+static std::vector<HostedStage> hosted(const char* name, const char* params) {
+    HostedStage stage;
+    stage.name = name;
+    stage.library_path = plugin_path(name);
+    stage.config_params = params;
+    return std::vector<HostedStage>(1, stage);
+}
+
+void test_replicated_dispatch() {
+    std::cout << "Test: Replicated stage dispatch..." << std::endl;
+    
+    const size_t replica_count = 3, depth = 2, batch_count = replica_count * depth;
+    ReplicatedStage stage("validation", hosted("validation", "strict_mode=false"), replica_count);
+    stage.set_pipeline_depth(depth);
+    assert(stage.start());
+    assert(stage.get_replica_count() == replica_count);
+    assert(stage.get_max_in_flight() == batch_count);
+    
+    std::vector<std::vector<DatabaseRecord> > records(batch_count, std::vector<DatabaseRecord>(500));
+    std::vector<RecordBatch> batches(batch_count);
+    std::vector<uint32_t> requests(batch_count);
+    for (size_t i = 0; i < batch_count; ++i) {
+        fill_batch(batches[i], records[i], static_cast<int>(i));
+        requests[i] = stage.submit_batch(&batches[i]);
+        assert(requests[i] != 0);
+    }
+    
+    // Menos pendientes primero: la ventana se llena por igual en todas las réplicas
+    for (size_t i = 0; i < replica_count; ++i) {
+        assert(stage.get_replica(i)->get_in_flight() == depth);
+    }
+    assert(stage.get_in_flight() == batch_count);
+    std::vector<DatabaseRecord> extra_records(10);
+    RecordBatch extra;
+    fill_batch(extra, extra_records, 99);
+    assert(stage.submit_batch(&extra) == 0);
+    
+    std::vector<bool> done(batch_count, false);
+    for (size_t n = 0; n < batch_count; ++n) {
+        RecordBatch* completed = NULL;
+        int result = -1;
+        uint32_t request = stage.collect_completion(5000, &completed, &result);
+        assert(request != 0 && result == 0);
+        size_t index = static_cast<size_t>(completed - &batches[0]);
+        assert(index < batch_count && !done[index] && requests[index] == request);
+        done[index] = true;
+    }
+    assert(stage.get_in_flight() == 0);
+    assert(stage.get_metrics()->successful_calls == batch_count);
+    
+    // Mismo resultado que un único proceso
+    IsolatedPluginProcess single("validation", plugin_path("validation"), "strict_mode=false");
+    assert(single.start());
+    for (size_t i = 0; i < batch_count; ++i) {
+        std::vector<DatabaseRecord> expected_records(500);
+        RecordBatch expected;
+        fill_batch(expected, expected_records, static_cast<int>(i));
+        assert(single.process_batch(&expected) == 0);
+        assert(batches[i].count == expected.count);
+        assert(same_records(records[i], expected_records, expected.count));
+    }
+    
+    // Una réplica caída no recibe lotes hasta que se reinicia
+    kill(stage.get_replica(1)->get_pid(), SIGKILL);
+    for (int i = 0; i < 1000 && stage.get_replica(1)->is_healthy(); ++i) {
+        usleep(1000);
+    }
+    assert(stage.is_healthy() && !stage.get_replica(1)->is_healthy());
+    for (size_t i = 0; i < replica_count; ++i) {
+        fill_batch(batches[i], records[i], static_cast<int>(i));
+        assert(stage.process_batch(&batches[i]) == 0);
+    }
+    assert(stage.restart());
+    assert(stage.get_replica(1)->is_healthy());
+    
+    std::cout << "✓ Replicated stage dispatch passed" << std::endl;
+}
+
+// Misma disposición que el estado que exporta el plugin de agregación
+struct AggregationState {
+    double total_sum;
+    double total_sum_squared;
+    uint64_t total_count;
+    double min_value;
+    double max_value;
+};
+
+void test_replicated_reduce() {
+    std::cout << "Test: Replicated stage state reduce..." << std::endl;
+    
+    const size_t replica_count = 3, batch_count = 9, batch_size = 200;
+    ReplicatedStage stage("aggregation", hosted("aggregation", "compute_stats=true"), replica_count);
+    stage.set_pipeline_depth(1);
+    assert(stage.start());
+    
+    std::vector<std::vector<DatabaseRecord> > records(batch_count,
+                                                      std::vector<DatabaseRecord>(batch_size));
+    std::vector<RecordBatch> batches(batch_count);
+    double expected_sum = 0.0, expected_min = 1e9, expected_max = -1e9;
+    for (size_t i = 0; i < batch_count; ++i) {
+        fill_batch(batches[i], records[i], static_cast<int>(i));
+        for (size_t j = 0; j < batch_size; ++j) {
+            expected_sum += records[i][j].value;
+            expected_min = std::min(expected_min, records[i][j].value);
+            expected_max = std::max(expected_max, records[i][j].value);
+        }
+    }
+    
+    size_t submitted = 0, completed = 0;
+    while (completed < batch_count) {
+        while (submitted < batch_count && stage.submit_batch(&batches[submitted]) != 0) {
+            ++submitted;
+        }
+        RecordBatch* batch = NULL;
+        int result = -1;
+        assert(stage.collect_completion(5000, &batch, &result) != 0 && result == 0);
+        ++completed;
+    }
+    for (size_t i = 0; i < replica_count; ++i) {
+        assert(stage.get_replica(i)->get_metrics()->successful_calls > 0);
+    }
+    
+    // Tras el reduce la réplica principal tiene los totales de todas
+    assert(stage.reduce_state());
+    std::vector<char> state;
+    for (size_t i = 1; i < replica_count; ++i) {
+        assert(stage.get_replica(i)->export_stage_state(0, state));
+        assert(state.empty());
+    }
+    assert(stage.get_replica(0)->export_stage_state(0, state));
+    assert(state.size() == sizeof(AggregationState));
+    AggregationState totals;
+    memcpy(&totals, &state[0], sizeof(totals));
+    assert(totals.total_count == batch_count * batch_size);
+    assert(totals.total_sum > expected_sum - 1e-6 && totals.total_sum < expected_sum + 1e-6);
+    assert(totals.min_value == expected_min && totals.max_value == expected_max);
+    
+    // Un plugin sin hooks no tiene estado que mover: el reduce es un no-op
+    ReplicatedStage stateless("validation", hosted("validation", "strict_mode=false"), 2);
+    assert(stateless.start());
+    assert(stateless.reduce_state());
+    
+    std::cout << "✓ Replicated stage state reduce passed" << std::endl;
+}
+
+int benchmark_replicated_stage_main() {
+    std::cout << "Benchmark: Replicated stage scaling..." << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", benchmark omitido" << std::endl;
+        return 0;
+    }
+    
+    const size_t batch_count = 64, batch_size = 4000;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_replicas = static_cast<size_t>(std::max(cores, 2L));
+    if (max_replicas > 8) max_replicas = 8;
+    std::cout << "  núcleos en línea: " << cores << std::endl;
+    
+    std::vector<std::vector<DatabaseRecord> > records(batch_count,
+                                                      std::vector<DatabaseRecord>(batch_size));
+    std::vector<RecordBatch> batches(batch_count);
+    std::vector<RecordBatch*> batch_ptrs(batch_count);
+    
+    double baseline_us = 0.0;
+    for (size_t replicas = 1; replicas <= max_replicas; replicas *= 2) {
+        std::vector<PipelineStageConfig> stages(1);
+        stages[0].name = "validation";
+        stages[0].library_path = plugin_path("validation");
+        stages[0].parameters = "strict_mode=false";
+        stages[0].pipeline_depth = 2;
+        stages[0].replicas = static_cast<int>(replicas);
+        stages[0].failover_config.policy = FAIL_FAST;
+        stages[0].failover_config.timeout_ms = 10000;
+        ResilientPluginManager manager(NULL);
+        assert(manager.load_pipeline_config(stages));
+    
+        for (size_t i = 0; i < batch_count; ++i) {
+            fill_batch(batches[i], records[i], static_cast<int>(i));
+            batch_ptrs[i] = &batches[i];
+        }
+        double start = now_us();
+        assert(manager.process_batches_through_pipeline(batch_ptrs));
+        double elapsed_us = now_us() - start;
+        if (replicas == 1) baseline_us = elapsed_us;
+    
+        std::cout << "  " << replicas << " réplica(s): "
+                  << static_cast<long>(batch_count * batch_size / (elapsed_us / 1e6)) << " registros/s"
+                  << " (x" << baseline_us / elapsed_us << ")" << std::endl;
+    }
+    return 0;
+}
+
+int test_replicated_stage_main() {
+    std::cout << "=== Replicated Stage Tests ===" << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", tests omitidos" << std::endl;
+        return 0;
+    }
+    
+    test_replicated_dispatch();
+    test_replicated_reduce();
+    
+    std::cout << "All replicated stage tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// tests/test_scratch_arena.cpp
+#include "../include/scratch_arena.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+#include <sys/time.h>
+
+using namespace distributed;
+
+void test_scratch_bump_and_reset() {
+    std::cout << "Test: Scratch bump allocation and reset..." << std::endl;
+    
+    ScratchArena arena(4096);
+    PluginContext context;
+    memset(&context, 0, sizeof(context));
+    context.scratch = arena.get_scratch();
+    
+    char* first = static_cast<char*>(plugin_scratch_alloc(&context, 10));
+    char* second = static_cast<char*>(plugin_scratch_alloc(&context, 33));
+    assert(first && second);
+    assert(reinterpret_cast<uintptr_t>(first) % PLUGIN_SCRATCH_ALIGNMENT == 0);
+    assert(reinterpret_cast<uintptr_t>(second) % PLUGIN_SCRATCH_ALIGNMENT == 0);
+    assert(second == first + 16);
+    assert(arena.get_used() == 16 + 48);
+    
+    // El reset solo reposiciona el cursor
+    arena.reset();
+    assert(arena.get_used() == 0);
+    assert(plugin_scratch_alloc(&context, 10) == first);
+    
+    char* copy = plugin_scratch_strdup(&context, "registro");
+    assert(strcmp(copy, "registro") == 0);
+    
+    char* formatted = plugin_scratch_format(&context, "_CAT%d_%s", 42, "largo");
+    assert(strcmp(formatted, "_CAT42_largo") == 0);
+    
+    // Sin scratch (host antiguo) los helpers devuelven NULL
+    PluginContext legacy;
+    memset(&legacy, 0, sizeof(legacy));
+    assert(plugin_scratch_alloc(&legacy, 16) == NULL);
+    
+    std::cout << "✓ Scratch bump allocation test passed" << std::endl;
+}
+
+void test_scratch_overflow_growth() {
+    std::cout << "Test: Scratch overflow and growth..." << std::endl;
+    
+    ScratchArena arena(1024);
+    PluginContext context;
+    memset(&context, 0, sizeof(context));
+    context.scratch = arena.get_scratch();
+    
+    // Un lote que necesita más que el bloque principal
+    for (int i = 0; i < 100; ++i) {
+        char* ptr = static_cast<char*>(plugin_scratch_alloc(&context, 100));
+        assert(ptr != NULL);
+        memset(ptr, i, 100);
+    }
+    char* big = static_cast<char*>(plugin_scratch_alloc(&context, 64 * 1024));
+    assert(big != NULL);
+    memset(big, 0, 64 * 1024);
+    assert(arena.get_slow_allocations() > 0);
+    
+    size_t used = arena.get_used();
+    arena.reset();
+    assert(arena.get_high_water() == used);
+    assert(arena.get_capacity() >= used);
+    
+    // Tras consolidar, el mismo trabajo queda en el camino rápido
+    size_t slow_before = arena.get_slow_allocations();
+    for (int batch = 0; batch < 10; ++batch) {
+        for (int i = 0; i < 100; ++i) {
+            assert(plugin_scratch_alloc(&context, 100) != NULL);
+        }
+        assert(plugin_scratch_alloc(&context, 64 * 1024) != NULL);
+        arena.reset();
+    }
+    assert(arena.get_slow_allocations() == slow_before);
+    
+    std::cout << "✓ Scratch overflow test passed" << std::endl;
+}
+
+void benchmark_scratch_vs_malloc() {
+    std::cout << "Benchmark: scratch por lote vs malloc/free..." << std::endl;
+    
+    const int batches = 2000;
+    const int allocations_per_batch = 1000;
+    ScratchArena arena;
+    PluginContext context;
+    memset(&context, 0, sizeof(context));
+    context.scratch = arena.get_scratch();
+    
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    size_t checksum = 0;
+    for (int b = 0; b < batches; ++b) {
+        for (int i = 0; i < allocations_per_batch; ++i) {
+            char* ptr = static_cast<char*>(plugin_scratch_alloc(&context, 24 + (i & 63)));
+            ptr[0] = static_cast<char>(i);
+            checksum += static_cast<unsigned char>(ptr[0]);
+        }
+        arena.reset();
+    }
+    gettimeofday(&end, NULL);
+    double scratch_ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_usec - start.tv_usec) * 1e3) /
+                        (static_cast<double>(batches) * allocations_per_batch);
+    
+    char* held[allocations_per_batch];
+    gettimeofday(&start, NULL);
+    for (int b = 0; b < batches; ++b) {
+        for (int i = 0; i < allocations_per_batch; ++i) {
+            held[i] = static_cast<char*>(malloc(24 + (i & 63)));
+            held[i][0] = static_cast<char>(i);
+            checksum += static_cast<unsigned char>(held[i][0]);
+        }
+        for (int i = 0; i < allocations_per_batch; ++i) {
+            free(held[i]);
+        }
+    }
+    gettimeofday(&end, NULL);
+    double malloc_ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_usec - start.tv_usec) * 1e3) /
+                       (static_cast<double>(batches) * allocations_per_batch);
+    
+    std::cout << "  scratch: " << scratch_ns << " ns/asignación, malloc/free: " << malloc_ns 
+              << " ns/asignación (checksum " << checksum << ")" << std::endl;
+}
+
+int benchmark_scratch_arena_main() {
+    benchmark_scratch_vs_malloc();
+    return 0;
+}
+
+int test_scratch_arena_main() {
+    std::cout << "=== Scratch Arena Tests ===" << std::endl;
+    
+    test_scratch_bump_and_reset();
+    test_scratch_overflow_growth();
+    
+    std::cout << "All scratch arena tests passed!" << std::endl;
+    return 0;
+}
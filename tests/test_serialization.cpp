@@ -18,10 +18,13 @@
  */
 
 // tests/test_serialization.cpp
+#include "test_helpers.h"
 #include "../include/serialization.h"
 #include "../include/memory_pool.h"
+#include "../include/columnar_batch.h"
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 using namespace distributed;
 
@@ -62,6 +65,15 @@ void test_batch_serialization() {
         assert(copy->records[i].value == original->records[i].value);
         assert(copy->records[i].category == original->records[i].category);
     }
+    assert(Serializer::validate_serialized_data(buffer, serialized_size));
+    
+    // Un byte alterado en el payload se detecta por CRC32C
+    buffer[serialized_size - sizeof(DatabaseRecord) + 5] ^= 0x20;
+    assert(!Serializer::deserialize_batch(buffer, copy));
+    assert(!Serializer::validate_serialized_data(buffer, serialized_size));
+    assert(!SerializedBatchView(buffer, serialized_size).is_valid());
+    buffer[serialized_size - sizeof(DatabaseRecord) + 5] ^= 0x20;
+    assert(Serializer::deserialize_batch(buffer, copy));
     
     pool.free_batch(original);
     pool.free_batch(copy);
@@ -101,11 +113,315 @@ void test_node_info_serialization() {
     std::cout << "✓ NodeInfo serialization test passed" << std::endl;
 }
 
+void test_compact_batch_serialization() {
+    std::cout << "Test: Compact batch serialization..." << std::endl;
+    
+    const size_t record_count = 1000;
+    DistributedMemoryPool pool(sizeof(DatabaseRecord) * record_count, 4);
+    
+    RecordBatch* original = pool.create_batch(record_count);
+    for (size_t i = 0; i < record_count; ++i) {
+        DatabaseRecord record;
+        record.id = static_cast<int>(i + 1);
+        sprintf(record.name, "Record_%lu", static_cast<unsigned long>(i + 1));
+        record.value = (i + 1) * 10.5;
+        record.category = static_cast<int>(i % 5);
+        original->add_record(record);
+    }
+    // Un nombre que ocupa los 100 bytes sin terminador
+    memset(original->records[7].name, 'n', sizeof(original->records[7].name));
+    original->batch_id = 77;
+    
+    size_t fixed_size = Serializer::calculate_batch_size(original);
+    size_t compact_size = Serializer::calculate_compact_batch_size(original);
+    std::cout << "  Bytes por lote (" << record_count << " registros): fijo=" << fixed_size
+              << ", compacto=" << compact_size
+              << " (" << static_cast<double>(fixed_size) / compact_size << "x)" << std::endl;
+    assert(compact_size * 3 < fixed_size);
+    
+    std::vector<char> buffer(compact_size);
+    assert(Serializer::serialize_batch_compact(original, &buffer[0], compact_size - 1) == 0);
+    assert(Serializer::serialize_batch_compact(original, &buffer[0], buffer.size()) == compact_size);
+    assert(Serializer::is_compact_batch(&buffer[0], buffer.size()));
+    assert(Serializer::get_compact_batch_count(&buffer[0], buffer.size()) == record_count);
+    assert(Serializer::get_compact_batch_size(&buffer[0], Serializer::get_compact_header_size()) == compact_size);
+    
+    // Filas -> wire -> filas
+    RecordBatch* copy = pool.create_batch(record_count);
+    assert(!Serializer::deserialize_batch_compact(&buffer[0], compact_size - 1, copy));
+    assert(Serializer::deserialize_batch_compact(&buffer[0], buffer.size(), copy));
+    assert(copy->count == record_count);
+    assert(copy->batch_id == 77);
+    for (size_t i = 0; i < record_count; ++i) {
+        assert(copy->records[i].id == original->records[i].id);
+        assert(copy->records[i].value == original->records[i].value);
+        assert(copy->records[i].category == original->records[i].category);
+        if (i != 7) {
+            assert(strcmp(copy->records[i].name, original->records[i].name) == 0);
+        }
+    }
+    assert(strlen(copy->records[7].name) == sizeof(copy->records[7].name) - 1);
+    
+    // Wire -> columnar -> wire produce los mismos bytes
+    ColumnarBatch columns(record_count, &pool);
+    assert(Serializer::deserialize_columnar_batch(&buffer[0], buffer.size(), columns));
+    assert(columns.get_count() == record_count);
+    assert(columns.get_batch_id() == 77);
+    assert(columns.name_length(7) == sizeof(original->records[7].name));
+    assert(Serializer::calculate_columnar_batch_size(columns) == compact_size);
+    std::vector<char> columnar_buffer(compact_size);
+    assert(Serializer::serialize_columnar_batch(columns, &columnar_buffer[0], columnar_buffer.size()) == compact_size);
+    assert(memcmp(&buffer[0], &columnar_buffer[0], compact_size) == 0);
+    
+    // Un byte de nombre alterado invalida el CRC32C del payload; un
+    // cambio en sitio vuelve a ser legible tras reseal_compact_batch
+    buffer[compact_size - 1] ^= 1;
+    assert(!Serializer::deserialize_batch_compact(&buffer[0], buffer.size(), copy));
+    assert(!SerializedBatchView(&buffer[0], buffer.size()).is_valid());
+    assert(Serializer::reseal_compact_batch(&buffer[0], buffer.size()));
+    assert(Serializer::deserialize_batch_compact(&buffer[0], buffer.size(), copy));
+    
+    // Datos corruptos
+    buffer[Serializer::get_compact_header_size() - 8] ^= 1;
+    assert(!Serializer::deserialize_batch_compact(&buffer[0], buffer.size(), copy));
+    assert(Serializer::get_compact_batch_size(&buffer[0], buffer.size()) == 0);
+    
+    ColumnarBatch small(10);
+    assert(!Serializer::deserialize_columnar_batch(&columnar_buffer[0], columnar_buffer.size(), small));
+    
+    pool.free_batch(original);
+    pool.free_batch(copy);
+    
+    std::cout << "✓ Compact batch serialization test passed" << std::endl;
+}
+
+void test_serialized_batch_view() {
+    std::cout << "Test: Serialized batch view..." << std::endl;
+    
+    DistributedMemoryPool pool(sizeof(DatabaseRecord) * 100, 4);
+    RecordBatch* original = pool.create_batch(100);
+    for (int i = 0; i < 100; ++i) {
+        DatabaseRecord record;
+        record.id = i + 1;
+        sprintf(record.name, "View_%d", i % 10);
+        record.value = i * 1.5;
+        record.category = i % 4;
+        original->add_record(record);
+    }
+    original->batch_id = 9;
+    
+    // Formato de registros fijos: los registros se ven en sitio
+    std::vector<double> aligned_buffer(Serializer::calculate_batch_size(original) / sizeof(double) + 2);
+    char* buffer = reinterpret_cast<char*>(&aligned_buffer[0]);
+    size_t record_size = Serializer::serialize_batch(original, buffer, aligned_buffer.size() * sizeof(double));
+    
+    SerializedBatchView view(buffer, record_size);
+    assert(view.is_valid() && view.get_format() == SerializedBatchView::RECORD_FORMAT);
+    assert(view.get_count() == 100 && view.get_batch_id() == 9);
+    assert(view.get_serialized_size() == record_size);
+    assert(view.get_records() == reinterpret_cast<const DatabaseRecord*>(buffer + record_size - 100 * sizeof(DatabaseRecord)));
+    assert(view.get_records()[42].id == 43);
+    assert(view.value_column() == NULL);
+    assert(view.value_at(10) == 15.0 && view.category_at(7) == 3);
+    size_t length;
+    assert(memcmp(view.name_at(13, length), "View_3", 6) == 0 && length == 6);
+    assert(view.id_at(100) == 0 && view.name_at(100, length) == NULL);
+    DatabaseRecord record;
+    assert(!view.get_record(100, record));
+    assert(!view.open(buffer, record_size - 1));
+    
+    // Formato compacto con diccionario: columnas en sitio
+    ColumnarBatch columns(100);
+    assert(columns.from_record_batch(*original, true));
+    std::vector<double> compact_storage(Serializer::calculate_columnar_batch_size(columns) / sizeof(double) + 2);
+    char* compact = reinterpret_cast<char*>(&compact_storage[0]);
+    size_t compact_size = Serializer::serialize_columnar_batch(columns, compact, compact_storage.size() * sizeof(double));
+    
+    assert(view.open(compact, compact_size));
+    assert(view.get_format() == SerializedBatchView::COMPACT_FORMAT);
+    assert(view.get_count() == 100 && view.get_name_entries() == 10);
+    assert(view.get_records() == NULL);
+    assert(view.value_column()[20] == 30.0);
+    assert(view.id_column()[99] == 100);
+    assert(view.name_code_column()[25] == 5);
+    assert(memcmp(view.name_at(25, length), "View_5", 6) == 0 && length == 6);
+    assert(view.get_record(31, record) && strcmp(record.name, "View_1") == 0 && record.id == 32);
+    
+    RecordBatch* copy = pool.create_batch(100);
+    assert(view.copy_to(copy) && copy->count == 100 && copy->batch_id == 9);
+    assert(strcmp(copy->records[58].name, "View_8") == 0);
+    
+    // Sin alineación solo hay acceso por fila
+    std::vector<char> shifted(compact_size + 1);
+    memcpy(&shifted[1], compact, compact_size);
+    assert(view.open(&shifted[1], compact_size));
+    assert(!view.is_aligned() && view.value_column() == NULL);
+    assert(view.value_at(20) == 30.0);
+    
+    // Buffers truncados o corruptos no se abren
+    assert(!view.open(compact, compact_size - 1));
+    assert(!view.is_valid() && view.get_count() == 0);
+    compact[0] ^= 0x10;
+    assert(!view.open(compact, compact_size));
+    
+    pool.free_batch(copy);
+    pool.free_batch(original);
+    
+    std::cout << "✓ Serialized batch view test passed" << std::endl;
+}
+void test_compressed_batch_serialization() {
+    std::cout << "Test: Compressed batch serialization..." << std::endl;
+    
+    const size_t record_count = 2000;
+    DistributedMemoryPool pool(sizeof(DatabaseRecord) * record_count, 2);
+    RecordBatch* original = pool.create_batch(record_count);
+    for (size_t i = 0; i < record_count; ++i) {
+        DatabaseRecord record;
+        record.id = static_cast<int>(i);
+        sprintf(record.name, "Record_%lu", static_cast<unsigned long>(i % 50));
+        record.value = (i % 10) * 2.5;
+        record.category = static_cast<int>(i % 5);
+        original->add_record(record);
+    }
+    original->batch_id = 9;
+    
+    std::vector<char> plain(Serializer::calculate_compact_batch_size(original));
+    size_t plain_size = Serializer::serialize_batch_compact(original, &plain[0], plain.size());
+    assert(plain_size > 0 && !Serializer::is_compressed_batch(&plain[0], plain_size));
+    
+    std::vector<char> compressed(plain_size);
+    size_t compressed_size = Serializer::compress_compact_batch(&plain[0], plain_size,
+                                                                &compressed[0], compressed.size());
+    assert(compressed_size > 0 && compressed_size < plain_size / 2);
+    assert(Serializer::is_compressed_batch(&compressed[0], compressed_size));
+    assert(Serializer::get_uncompressed_batch_size(&compressed[0], compressed_size) == plain_size);
+    
+    // El header basta para saber cuántos bytes leer del socket
+    assert(Serializer::get_compact_batch_size(&compressed[0], Serializer::get_compact_header_size()) ==
+           compressed_size);
+    
+    // Descomprimir reproduce el lote original byte a byte
+    std::vector<char> restored(plain_size);
+    assert(Serializer::decompress_compact_batch(&compressed[0], compressed_size,
+                                                &restored[0], restored.size()) == plain_size);
+    assert(memcmp(&plain[0], &restored[0], plain_size) == 0);
+    
+    // Los deserializadores aceptan el lote comprimido; la vista no
+    RecordBatch* copy = pool.create_batch(record_count);
+    assert(Serializer::deserialize_batch_compact(&compressed[0], compressed_size, copy));
+    assert(copy->count == record_count && copy->batch_id == 9);
+    assert(strcmp(copy->records[1234].name, "Record_34") == 0);
+    ColumnarBatch columns(record_count);
+    assert(Serializer::deserialize_columnar_batch(&compressed[0], compressed_size, columns));
+    assert(columns.get_count() == record_count);
+    assert(!SerializedBatchView(&compressed[0], compressed_size).is_valid());
+    
+    // Un byte alterado en el bloque comprimido se detecta antes de descomprimir
+    compressed[compressed_size / 2] ^= 0x10;
+    assert(!Serializer::deserialize_batch_compact(&compressed[0], compressed_size, copy));
+    
+    // Datos incompresibles: compress_compact_batch renuncia y se envían tal cual
+    uint32_t seed = 1;
+    for (size_t i = 0; i < record_count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        original->records[i].id = static_cast<int>(seed);
+        original->records[i].value = seed * 0.37;
+        sprintf(original->records[i].name, "%08x%08x", seed, seed * 2654435761u);
+    }
+    plain_size = Serializer::serialize_batch_compact(original, &plain[0], plain.size());
+    assert(Serializer::compress_compact_batch(&plain[0], plain_size, &compressed[0], compressed.size()) == 0);
+    
+    pool.free_batch(original);
+    pool.free_batch(copy);
+    
+    std::cout << "✓ Compressed batch serialization test passed" << std::endl;
+}
+
+void benchmark_deserialize_vs_view() {
+    std::cout << "Benchmark: deserializar vs vista sin copia..." << std::endl;
+    
+    const size_t sizes[] = { 1000, 10000, 100000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        const size_t record_count = sizes[s];
+        const int iterations = static_cast<int>(2000000 / record_count);
+        
+        RecordBatch rows;
+        rows.records = new DatabaseRecord[record_count];
+        rows.capacity = record_count;
+        for (size_t i = 0; i < record_count; ++i) {
+            rows.records[i].id = static_cast<int>(i);
+            rows.records[i].value = static_cast<double>(i % 100);
+            rows.records[i].category = static_cast<int>(i % 5);
+            sprintf(rows.records[i].name, "Record_%lu", static_cast<unsigned long>(i));
+        }
+        rows.count = record_count;
+        
+        RecordBatch target;
+        target.records = new DatabaseRecord[record_count];
+        target.capacity = record_count;
+        
+        std::vector<double> record_storage(Serializer::calculate_batch_size(&rows) / sizeof(double) + 1);
+        char* record_wire = reinterpret_cast<char*>(&record_storage[0]);
+        size_t record_size = Serializer::serialize_batch(&rows, record_wire, record_storage.size() * sizeof(double));
+        std::vector<double> compact_storage(Serializer::calculate_compact_batch_size(&rows) / sizeof(double) + 1);
+        char* compact_wire = reinterpret_cast<char*>(&compact_storage[0]);
+        size_t compact_size = Serializer::serialize_batch_compact(&rows, compact_wire, compact_storage.size() * sizeof(double));
+        
+        // Consumidor de solo lectura: suma de value
+        double checksum = 0;
+        
+        double start = now_us();
+        for (int it = 0; it < iterations; ++it) {
+            Serializer::deserialize_batch(record_wire, &target);
+            for (size_t i = 0; i < target.count; ++i) checksum += target.records[i].value;
+        }
+        double copy_us = (now_us() - start) / iterations;
+        
+        start = now_us();
+        for (int it = 0; it < iterations; ++it) {
+            SerializedBatchView view(record_wire, record_size);
+            const DatabaseRecord* records = view.get_records();
+            for (size_t i = 0; i < view.get_count(); ++i) checksum += records[i].value;
+        }
+        double view_us = (now_us() - start) / iterations;
+        
+        start = now_us();
+        for (int it = 0; it < iterations; ++it) {
+            Serializer::deserialize_batch_compact(compact_wire, compact_size, &target);
+            for (size_t i = 0; i < target.count; ++i) checksum += target.records[i].value;
+        }
+        double compact_copy_us = (now_us() - start) / iterations;
+        
+        start = now_us();
+        for (int it = 0; it < iterations; ++it) {
+            SerializedBatchView view(compact_wire, compact_size);
+            const double* values = view.value_column();
+            for (size_t i = 0; i < view.get_count(); ++i) checksum += values[i];
+        }
+        double compact_view_us = (now_us() - start) / iterations;
+        
+        std::cout << "  " << record_count << " registros: registros fijos " << copy_us << " us copiando vs "
+                  << view_us << " us con vista; compacto " << compact_copy_us << " us copiando vs "
+                  << compact_view_us << " us con vista (checksum " << checksum << ")" << std::endl;
+        
+        delete[] target.records;
+        delete[] rows.records;
+    }
+}
+
+int benchmark_serialization_main() {
+    benchmark_deserialize_vs_view();
+    return 0;
+}
+
 int test_serialization_main() {
     std::cout << "=== Serialization Tests ===" << std::endl;
     
     test_batch_serialization();
     test_node_info_serialization();
+    test_compact_batch_serialization();
+    test_compressed_batch_serialization();
+    test_serialized_batch_view();
     
     std::cout << "All serialization tests passed!" << std::endl;
     return 0;
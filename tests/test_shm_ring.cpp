@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_shm_ring.cpp
+#include "test_helpers.h"
+#include "../include/ipc.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace distributed;
+
+static std::string ring_region_name() {
+    std::ostringstream name;
+    name << "/test_shm_ring_" << getpid();
+    return name.str();
+}
+
+void test_shm_ring_basic() {
+    std::cout << "Test: Shm ring basic..." << std::endl;
+    
+    std::vector<char> memory(ShmRing::required_size(8));
+    ShmRing ring;
+    assert(!ring.init(&memory[0], memory.size(), 6));     // No es potencia de 2
+    assert(!ring.init(&memory[0], memory.size() - 1, 8)); // No alcanza
+    assert(ring.init(&memory[0], memory.size(), 8));
+    assert(ring.get_capacity() == 8 && ring.get_event_fd() != -1);
+    
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    assert(!ring.pop(descriptor));
+    assert(!ring.wait_pop(descriptor, 5));
+    
+    // FIFO a través de muchas vueltas del índice, con la cola llena cada vez
+    uint32_t produced = 0, consumed = 0;
+    for (int round = 0; round < 1000; ++round) {
+        while (true) {
+            descriptor.sequence = produced;
+            descriptor.offset = produced * 3;
+            if (!ring.push(descriptor)) break;
+            ++produced;
+        }
+        assert(produced - consumed == 8);
+        size_t take = 1 + round % 8;
+        for (size_t i = 0; i < take; ++i) {
+            assert(ring.pop(descriptor));
+            assert(descriptor.sequence == consumed && descriptor.offset == consumed * 3u);
+            ++consumed;
+        }
+    }
+    while (ring.wait_pop(descriptor, 0)) {
+        assert(descriptor.sequence == consumed++);
+    }
+    assert(consumed == produced);
+    
+    std::cout << "✓ Shm ring basic passed" << std::endl;
+}
+
+// Hijo de eco: devuelve cada descriptor con result = sequence * 2
+static void ring_echo_child(ShmRing& requests, ShmRing& responses) {
+    BatchDescriptor descriptor;
+    while (requests.wait_pop(descriptor, -1)) {
+        if (descriptor.type == IPCMessage::SHUTDOWN) break;
+        descriptor.type = IPCMessage::BATCH_RESULT;
+        descriptor.result = static_cast<int32_t>(descriptor.sequence * 2);
+        while (!responses.push(descriptor)) {}
+    }
+    _exit(0);
+}
+
+static void stop_echo_child(ShmRing& requests, pid_t child) {
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.type = IPCMessage::SHUTDOWN;
+    assert(requests.push(descriptor));
+    int status;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+void test_shm_ring_cross_process() {
+    std::cout << "Test: Shm ring cross process..." << std::endl;
+    
+    const size_t ring_size = ShmRing::required_size(4);
+    SharedMemoryRegion region(ring_region_name(), 2 * ring_size);
+    assert(region.is_valid());
+    char* base = static_cast<char*>(region.get_memory());
+    ShmRing requests, responses;
+    assert(requests.init(base, ring_size, 4) && responses.init(base + ring_size, ring_size, 4));
+    
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) ring_echo_child(requests, responses);
+    
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    for (uint32_t i = 0; i < 20000; ++i) {
+        // De vez en cuando el hijo ya está dormido en el eventfd
+        if (i % 5000 == 0) usleep(20000);
+        descriptor.type = IPCMessage::PROCESS_BATCH;
+        descriptor.sequence = i;
+        assert(requests.push(descriptor));
+        assert(responses.wait_pop(descriptor, 5000));
+        assert(descriptor.type == IPCMessage::BATCH_RESULT && descriptor.sequence == i);
+        assert(descriptor.result == static_cast<int32_t>(i * 2));
+    }
+    
+    stop_echo_child(requests, child);
+    SharedMemoryRegion::cleanup(ring_region_name());
+    std::cout << "✓ Shm ring cross process passed" << std::endl;
+}
+
+// Loop del hijo de un plugin: lotes por el ring, control por el pipe,
+// todo en una sola espera. Responde HEALTH_CHECK por el ring de respuestas
+static void control_loop_child(ShmRing& requests, ShmRing& responses, IPCChannel& control) {
+    while (true) {
+        ShmRing::WaitResult ready = requests.wait(-1, control.get_read_fd());
+        
+        BatchDescriptor descriptor;
+        while (requests.pop(descriptor)) {
+            descriptor.type = IPCMessage::BATCH_RESULT;
+            while (!responses.push(descriptor)) {}
+        }
+        
+        IPCMessage* msg = NULL;
+        if (ready == ShmRing::WAIT_FD_READY && control.receive_message(&msg, 1024)) {
+            bool stop = msg->type == IPCMessage::SHUTDOWN;
+            memset(&descriptor, 0, sizeof(descriptor));
+            descriptor.type = msg->type;
+            free(msg);
+            if (stop) break;
+            while (!responses.push(descriptor)) {}
+        }
+    }
+    _exit(0);
+}
+
+static void send_control(IPCChannel& control, IPCMessage::MessageType type) {
+    IPCMessage msg;
+    msg.type = type;
+    msg.sender_id = 0;
+    msg.receiver_id = 0;
+    msg.data_size = 0;
+    assert(control.send_message(&msg));
+}
+
+void test_shm_ring_idle_wait() {
+    std::cout << "Test: Shm ring idle wait..." << std::endl;
+    
+    const size_t ring_size = ShmRing::required_size(4);
+    SharedMemoryRegion region(ring_region_name(), 2 * ring_size);
+    assert(region.is_valid());
+    char* base = static_cast<char*>(region.get_memory());
+    ShmRing requests, responses;
+    assert(requests.init(base, ring_size, 4) && responses.init(base + ring_size, ring_size, 4));
+    IPCChannel control;
+    assert(control.create_pipe());
+    
+    // Un hijo ocioso no despierta: el loop anterior lo hacía cada 10 ms
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) control_loop_child(requests, responses, control);
+    usleep(500000);
+    send_control(control, IPCMessage::SHUTDOWN);
+    
+    int status;
+    struct rusage usage;
+    assert(wait4(child, &status, 0, &usage) == child && WIFEXITED(status));
+    double cpu_ms = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+                    (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+    std::cout << "  500 ms ocioso: " << usage.ru_nvcsw << " cambios de contexto voluntarios, "
+              << cpu_ms << " ms de CPU" << std::endl;
+    assert(usage.ru_nvcsw < 10);
+    
+    // Con el hijo dormido, tanto un lote como un mensaje de control se
+    // atienden sin esperar a ningún intervalo de sondeo
+    child = fork();
+    assert(child >= 0);
+    if (child == 0) control_loop_child(requests, responses, control);
+    
+    std::vector<double> ring_samples, control_samples;
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    for (int i = 0; i < 40; ++i) {
+        usleep(5000);
+        double start = now_us();
+        if (i % 2 == 0) {
+            descriptor.type = IPCMessage::PROCESS_BATCH;
+            assert(requests.push(descriptor));
+            assert(responses.wait_pop(descriptor, 5000));
+            assert(descriptor.type == IPCMessage::BATCH_RESULT);
+            ring_samples.push_back(now_us() - start);
+        } else {
+            send_control(control, IPCMessage::HEALTH_CHECK);
+            assert(responses.wait_pop(descriptor, 5000));
+            assert(descriptor.type == IPCMessage::HEALTH_CHECK);
+            control_samples.push_back(now_us() - start);
+        }
+    }
+    send_control(control, IPCMessage::SHUTDOWN);
+    waitpid(child, NULL, 0);
+    SharedMemoryRegion::cleanup(ring_region_name());
+    
+    std::sort(ring_samples.begin(), ring_samples.end());
+    std::sort(control_samples.begin(), control_samples.end());
+    std::cout << "  despertar del hijo dormido: lote p50 " << ring_samples[ring_samples.size() / 2]
+              << " us, control p50 " << control_samples[control_samples.size() / 2] << " us" << std::endl;
+    // Holgado para máquinas cargadas; con sondeo cada 10 ms la mediana rondaba 5 ms
+    assert(ring_samples[ring_samples.size() / 2] < 2000);
+    assert(control_samples[control_samples.size() / 2] < 2000);
+    
+    std::cout << "✓ Shm ring idle wait passed" << std::endl;
+}
+
+static void print_percentiles(const char* label, std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    std::cout << "  " << label << ": p50 " << samples[samples.size() / 2] << " us, p99 "
+              << samples[samples.size() * 99 / 100] << " us (" << samples.size() << " idas y vueltas)"
+              << std::endl;
+}
+
+// Eco por pipes como el camino anterior de IsolatedPluginProcess; con
+// poll_sleep el hijo duerme 10 ms cuando no hay mensaje, como su loop
+static void pipe_echo_child(IPCChannel& requests, IPCChannel& responses, bool poll_sleep) {
+    while (true) {
+        IPCMessage* msg = NULL;
+        if (!poll_sleep) requests.wait_readable(-1);
+        if (requests.receive_message(&msg, 1024)) {
+            bool stop = msg->type == IPCMessage::SHUTDOWN;
+            msg->type = IPCMessage::BATCH_RESULT;
+            if (!stop) responses.send_message(msg);
+            free(msg);
+            if (stop) break;
+        } else if (poll_sleep) {
+            usleep(10000);
+        }
+    }
+    _exit(0);
+}
+
+static void benchmark_pipe_round_trip(const char* label, bool poll_sleep, int iterations) {
+    IPCChannel requests, responses;
+    assert(requests.create_pipe() && responses.create_pipe());
+    
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) pipe_echo_child(requests, responses, poll_sleep);
+    
+    IPCMessage* msg = (IPCMessage*)malloc(sizeof(IPCMessage) + sizeof(BatchDescriptor));
+    msg->type = IPCMessage::PROCESS_BATCH;
+    msg->sender_id = 0;
+    msg->receiver_id = 0;
+    msg->data_size = sizeof(BatchDescriptor);
+    
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        double start = now_us();
+        assert(requests.send_message(msg));
+        IPCMessage* response = NULL;
+        assert(responses.wait_readable(5000) && responses.receive_message(&response, 1024));
+        samples.push_back(now_us() - start);
+        free(response);
+    }
+    
+    msg->type = IPCMessage::SHUTDOWN;
+    msg->data_size = 0;
+    requests.send_message(msg);
+    free(msg);
+    waitpid(child, NULL, 0);
+    print_percentiles(label, samples);
+}
+
+void benchmark_shm_ring_latency() {
+    std::cout << "Benchmark: Round trip latency, shm ring vs pipes..." << std::endl;
+    
+    const size_t ring_size = ShmRing::required_size(4);
+    SharedMemoryRegion region(ring_region_name(), 2 * ring_size);
+    assert(region.is_valid());
+    char* base = static_cast<char*>(region.get_memory());
+    ShmRing requests, responses;
+    assert(requests.init(base, ring_size, 4) && responses.init(base + ring_size, ring_size, 4));
+    
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) ring_echo_child(requests, responses);
+    
+    std::vector<double> samples;
+    BatchDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    for (uint32_t i = 0; i < 5000; ++i) {
+        descriptor.type = IPCMessage::PROCESS_BATCH;
+        descriptor.sequence = i;
+        double start = now_us();
+        assert(requests.push(descriptor));
+        assert(responses.wait_pop(descriptor, 5000));
+        samples.push_back(now_us() - start);
+    }
+    stop_echo_child(requests, child);
+    SharedMemoryRegion::cleanup(ring_region_name());
+    print_percentiles("shm ring + eventfd", samples);
+    
+    benchmark_pipe_round_trip("pipes + poll", false, 5000);
+    benchmark_pipe_round_trip("pipes + usleep(10ms) (loop anterior)", true, 100);
+}
+
+// Hijo que simula un plugin: cada lote le cuesta work_us de CPU
+static void ring_worker_child(ShmRing& requests, ShmRing& responses, double work_us) {
+    BatchDescriptor descriptor;
+    while (requests.wait_pop(descriptor, -1)) {
+        if (descriptor.type == IPCMessage::SHUTDOWN) break;
+        double start = now_us();
+        while (now_us() - start < work_us) {}
+        descriptor.type = IPCMessage::BATCH_RESULT;
+        while (!responses.push(descriptor)) {}
+    }
+    _exit(0);
+}
+
+void benchmark_shm_ring_pipeline_depth() {
+    std::cout << "Benchmark: Throughput vs pipeline depth..." << std::endl;
+    
+    const size_t capacity = 16;
+    const uint32_t batches = 5000;
+    const double child_work_us = 20.0;   // Procesar el lote en el plugin
+    const double parent_work_us = 10.0;  // Serializar y deserializar en el padre
+    const size_t ring_size = ShmRing::required_size(capacity);
+    
+    size_t depths[] = { 1, 2, 4, 8, 16 };
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+        SharedMemoryRegion region(ring_region_name(), 2 * ring_size);
+        assert(region.is_valid());
+        char* base = static_cast<char*>(region.get_memory());
+        ShmRing requests, responses;
+        assert(requests.init(base, ring_size, capacity) &&
+               responses.init(base + ring_size, ring_size, capacity));
+        
+        pid_t child = fork();
+        assert(child >= 0);
+        if (child == 0) ring_worker_child(requests, responses, child_work_us);
+        
+        // Ventana de depths[d] lotes en vuelo; las respuestas se emparejan
+        // por secuencia como en IsolatedPluginProcess
+        std::vector<bool> done(batches, false);
+        uint32_t submitted = 0, completed = 0;
+        double start = now_us();
+        BatchDescriptor descriptor;
+        memset(&descriptor, 0, sizeof(descriptor));
+        while (completed < batches) {
+            while (submitted < batches && submitted - completed < depths[d]) {
+                double prepare = now_us();
+                while (now_us() - prepare < parent_work_us / 2) {}
+                descriptor.type = IPCMessage::PROCESS_BATCH;
+                descriptor.sequence = submitted++;
+                assert(requests.push(descriptor));
+            }
+            assert(responses.wait_pop(descriptor, 5000));
+            assert(descriptor.sequence < batches && !done[descriptor.sequence]);
+            done[descriptor.sequence] = true;
+            ++completed;
+            double finish = now_us();
+            while (now_us() - finish < parent_work_us / 2) {}
+        }
+        double elapsed_us = now_us() - start;
+        
+        stop_echo_child(requests, child);
+        SharedMemoryRegion::cleanup(ring_region_name());
+        std::cout << "  profundidad " << depths[d] << ": "
+                  << static_cast<long>(batches / (elapsed_us / 1e6)) << " lotes/s ("
+                  << elapsed_us / batches << " us por lote)" << std::endl;
+    }
+}
+
+int benchmark_shm_ring_main() {
+    benchmark_shm_ring_latency();
+    benchmark_shm_ring_pipeline_depth();
+    return 0;
+}
+
+int test_shm_ring_main() {
+    std::cout << "=== Shm Ring Tests ===" << std::endl;
+    
+    test_shm_ring_basic();
+    test_shm_ring_cross_process();
+    test_shm_ring_idle_wait();
+    
+    std::cout << "All shm ring tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2025 Miguel Mamani <miguel.coder.per@gmail.com>
+ *
+ * This file is part of the Distributed Processing System.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// tests/test_stage_pipeline.cpp
+#include "test_helpers.h"
+#include "../include/plugin_manager.h"
+#include "../include/memory_pool.h"
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace distributed;
+
+// Pipeline de tres etapas con dos lotes en vuelo por proceso
+static std::vector<PipelineStageConfig> stage_pipeline(bool strict, int enrichment_replicas) {
+    std::vector<PipelineStageConfig> stages = three_stage_pipeline();
+    for (size_t i = 0; i < stages.size(); ++i) {
+        stages[i].pipeline_depth = 2;
+    }
+    if (strict) stages[0].parameters = "strict_mode=true";
+    stages[1].replicas = enrichment_replicas;
+    return stages;
+}
+
+// Lotes de prueba y su resultado pasando uno a uno por el pipeline
+struct BatchSet {
+    std::vector<std::vector<DatabaseRecord> > records;
+    std::vector<RecordBatch> batches;
+    std::vector<RecordBatch*> pointers;
+    
+    BatchSet(size_t count, size_t size) : records(count, std::vector<DatabaseRecord>(size)),
+                                          batches(count), pointers(count) {}
+    
+    void fill(bool with_bad_names) {
+        for (size_t i = 0; i < batches.size(); ++i) {
+            fill_batch(batches[i], records[i], static_cast<int>(i), with_bad_names);
+            pointers[i] = &batches[i];
+        }
+    }
+};
+
+void test_stage_parallel_matches_sequential() {
+    std::cout << "Test: Stage-parallel pipeline matches batch-at-a-time..." << std::endl;
+    
+    const size_t batch_count = 24, batch_size = 300;
+    BatchSet expected(batch_count, batch_size), actual(batch_count, batch_size);
+    
+    ResilientPluginManager sequential(NULL);
+    assert(sequential.load_pipeline_config(stage_pipeline(false, 1)));
+    expected.fill(true);
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(sequential.process_batch_through_pipeline(expected.pointers[i]));
+    }
+    
+    // Con réplicas en enrichment los lotes terminan desordenados en esa etapa
+    ResilientPluginManager manager(NULL);
+    assert(manager.load_pipeline_config(stage_pipeline(false, 2)));
+    assert(manager.get_preserve_order());
+    
+    size_t capacities[] = { 1, 3, IsolatedPluginProcess::MAX_PIPELINE_DEPTH };
+    for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); ++c) {
+        manager.set_stage_queue_capacity(capacities[c]);
+        actual.fill(true);
+        std::vector<RecordBatch*> completed;
+        assert(manager.process_batches_through_pipeline(actual.pointers, &completed));
+        assert(completed == actual.pointers);
+        for (size_t i = 0; i < batch_count; ++i) {
+            assert(actual.batches[i].count == expected.batches[i].count);
+            assert(same_records(actual.records[i], expected.records[i], expected.batches[i].count));
+        }
+    }
+    
+    // Sin orden: los mismos lotes, en el orden en que salen
+    manager.set_preserve_order(false);
+    manager.set_stage_queue_capacity(4);
+    actual.fill(true);
+    std::vector<RecordBatch*> completed;
+    assert(manager.process_batches_through_pipeline(actual.pointers, &completed));
+    assert(completed.size() == batch_count);
+    std::sort(completed.begin(), completed.end());
+    assert(std::unique(completed.begin(), completed.end()) == completed.end());
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(same_records(actual.records[i], expected.records[i], expected.batches[i].count));
+    }
+    
+    // Una etapa en proceso entre etapas aisladas
+    std::vector<PipelineStageConfig> mixed_stages = stage_pipeline(false, 1);
+    mixed_stages[1].isolation = ISOLATION_NONE;
+    ResilientPluginManager mixed(NULL);
+    assert(mixed.load_pipeline_config(mixed_stages));
+    mixed.set_stage_queue_capacity(2);
+    actual.fill(true);
+    assert(mixed.process_batches_through_pipeline(actual.pointers));
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(same_records(actual.records[i], expected.records[i], expected.batches[i].count));
+    }
+    
+    std::cout << "✓ Stage-parallel pipeline matches batch-at-a-time passed" << std::endl;
+}
+
+void test_stage_parallel_fail_fast() {
+    std::cout << "Test: Stage-parallel pipeline FAIL_FAST..." << std::endl;
+    
+    // validation en proceso devuelve el código del plugin; las etapas
+    // aisladas siguientes tienen lotes en vuelo cuando el pipeline aborta
+    std::vector<PipelineStageConfig> stages = stage_pipeline(true, 1);
+    stages[0].isolation = ISOLATION_NONE;
+    ResilientPluginManager manager(NULL);
+    assert(manager.load_pipeline_config(stages));
+    
+    // En modo estricto validation rechaza los nombres inválidos
+    BatchSet set(12, 100);
+    set.fill(false);
+    fill_batch(set.batches[7], set.records[7], 7, true);
+    assert(!manager.process_batches_through_pipeline(set.pointers));
+    
+    // Lo abandonado no bloquea la siguiente pasada
+    set.fill(false);
+    std::vector<RecordBatch*> completed;
+    assert(manager.process_batches_through_pipeline(set.pointers, &completed));
+    assert(completed == set.pointers);
+    
+    std::cout << "✓ Stage-parallel pipeline FAIL_FAST passed" << std::endl;
+}
+
+void test_stage_slow_in_process() {
+    std::cout << "Test: Slow in-process stage between isolated stages..." << std::endl;
+    
+    // Con lotes grandes enrichment en proceso es la etapa lenta: corre en
+    // su hilo mientras los hijos de validation y aggregation toman otros
+    const size_t batch_count = 16, batch_size = 20000;
+    std::vector<PipelineStageConfig> stages = stage_pipeline(false, 1);
+    stages[1].isolation = ISOLATION_NONE;
+    BatchSet expected(batch_count, batch_size), actual(batch_count, batch_size);
+    
+    ResilientPluginManager sequential(NULL);
+    assert(sequential.load_pipeline_config(stages));
+    expected.fill(true);
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(sequential.process_batch_through_pipeline(expected.pointers[i]));
+    }
+    
+    ResilientPluginManager manager(NULL);
+    assert(manager.load_pipeline_config(stages));
+    size_t capacities[] = { 1, 4 };
+    for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); ++c) {
+        manager.set_stage_queue_capacity(capacities[c]);
+        actual.fill(true);
+        std::vector<RecordBatch*> completed;
+        assert(manager.process_batches_through_pipeline(actual.pointers, &completed));
+        assert(completed == actual.pointers);
+        for (size_t i = 0; i < batch_count; ++i) {
+            assert(actual.batches[i].count == expected.batches[i].count);
+            assert(same_records(actual.records[i], expected.records[i], expected.batches[i].count));
+        }
+    }
+    
+    // Dos etapas en proceso seguidas, cada una con su hilo
+    stages[2].isolation = ISOLATION_NONE;
+    ResilientPluginManager in_process(NULL);
+    assert(in_process.load_pipeline_config(stages));
+    actual.fill(true);
+    std::vector<RecordBatch*> completed;
+    assert(in_process.process_batches_through_pipeline(actual.pointers, &completed));
+    assert(completed == actual.pointers);
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(same_records(actual.records[i], expected.records[i], expected.batches[i].count));
+    }
+    
+    std::cout << "✓ Slow in-process stage between isolated stages passed" << std::endl;
+}
+
+void test_stage_timeout_in_place() {
+    std::cout << "Test: Stage timeout on in-place batches..." << std::endl;
+    
+    MemoryPoolBacking backing;
+    backing.mode = MemoryPoolBacking::SHARED_MEMORY_BACKING;
+    backing.arena_size = 32 * 1024 * 1024;
+    DistributedMemoryPool pool(1024, 4, DistributedMemoryPool::DEFAULT_THREAD_CACHE_DEPTH, backing);
+    assert(pool.get_shared_region() != NULL);
+    
+    // Un plazo de 1 ms vence con el hijo enriqueciendo el lote en sitio
+    std::vector<PipelineStageConfig> stages(1, three_stage_pipeline()[1]);
+    stages[0].pipeline_depth = 2;
+    stages[0].failover_config.policy = SKIP_AND_CONTINUE;
+    stages[0].failover_config.timeout_ms = 1;
+    ResilientPluginManager manager(&pool);
+    assert(manager.load_pipeline_config(stages));
+    
+    std::vector<RecordBatch*> batches;
+    for (int b = 0; b < 2; ++b) {
+        RecordBatch* batch = pool.create_batch(20000);
+        std::vector<DatabaseRecord> records(batch->capacity);
+        RecordBatch filled;
+        fill_batch(filled, records, b, false);
+        memcpy(batch->records, &records[0], records.size() * sizeof(DatabaseRecord));
+        batch->count = batch->capacity;
+        batches.push_back(batch);
+    }
+    assert(manager.process_batches_through_pipeline(batches));
+    
+    // La etapa no se repite sobre lo que el hijo ya pudo escribir
+    for (size_t b = 0; b < batches.size(); ++b) {
+        for (size_t i = 0; i < batches[b]->count; ++i) {
+            const char* suffix = strstr(batches[b]->records[i].name, "_CAT");
+            assert(suffix == NULL || strstr(suffix + 1, "_CAT") == NULL);
+        }
+        pool.free_batch(batches[b]);
+    }
+    
+    std::cout << "✓ Stage timeout on in-place batches passed" << std::endl;
+}
+
+int benchmark_stage_pipeline_main() {
+    std::cout << "Benchmark: Batch-at-a-time vs stage-parallel pipeline..." << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", benchmark omitido" << std::endl;
+        return 0;
+    }
+    
+    const size_t batch_count = 64, batch_size = 2000;
+    std::cout << "  núcleos en línea: " << sysconf(_SC_NPROCESSORS_ONLN) << std::endl;
+    
+    ResilientPluginManager manager(NULL);
+    assert(manager.load_pipeline_config(stage_pipeline(false, 1)));
+    BatchSet set(batch_count, batch_size);
+    
+    set.fill(true);
+    double start = now_us();
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(manager.process_batch_through_pipeline(set.pointers[i]));
+    }
+    double sequential_us = (now_us() - start) / batch_count;
+    
+    set.fill(true);
+    start = now_us();
+    assert(manager.process_batches_through_pipeline(set.pointers));
+    double parallel_us = (now_us() - start) / batch_count;
+    
+    std::cout << "  3 etapas, " << batch_size << " registros/lote: lote a lote " << sequential_us
+              << " us/lote, por etapas " << parallel_us << " us/lote ("
+              << sequential_us / parallel_us << "x)" << std::endl;
+    
+    // enrichment en proceso, en su hilo
+    std::vector<PipelineStageConfig> mixed_stages = stage_pipeline(false, 1);
+    mixed_stages[1].isolation = ISOLATION_NONE;
+    ResilientPluginManager mixed(NULL);
+    assert(mixed.load_pipeline_config(mixed_stages));
+    
+    set.fill(true);
+    start = now_us();
+    for (size_t i = 0; i < batch_count; ++i) {
+        assert(mixed.process_batch_through_pipeline(set.pointers[i]));
+    }
+    sequential_us = (now_us() - start) / batch_count;
+    
+    set.fill(true);
+    start = now_us();
+    assert(mixed.process_batches_through_pipeline(set.pointers));
+    parallel_us = (now_us() - start) / batch_count;
+    
+    std::cout << "  enrichment en proceso: lote a lote " << sequential_us
+              << " us/lote, por etapas " << parallel_us << " us/lote ("
+              << sequential_us / parallel_us << "x)" << std::endl;
+    return 0;
+}
+
+int test_stage_pipeline_main() {
+    std::cout << "=== Stage Pipeline Tests ===" << std::endl;
+    
+    if (!plugins_available()) {
+        std::cout << "Plugins no compilados en " << PLUGIN_DIR << ", tests omitidos" << std::endl;
+        return 0;
+    }
+    
+    test_stage_parallel_matches_sequential();
+    test_stage_parallel_fail_fast();
+    test_stage_slow_in_process();
+    test_stage_timeout_in_place();
+    
+    std::cout << "All stage pipeline tests passed!" << std::endl;
+    return 0;
+}